@@ -21,17 +21,106 @@ struct wl_input_device;
 struct wl_surface;
 struct wl_seat;
 struct input_proxy;
+struct utils_clock;
 
 /**
  * Get the global input proxy used by compositor hooks (if initialized).
  *
- * This keeps cross-module coupling out of global variables while still
- * allowing surface tracking to trigger reconciliation.
+ * This is the default pipeline's proxy, which handles devices that were
+ * not registered (see compositor_get_input_proxy()).
  *
  * @return Input proxy pointer or NULL if not initialized
  */
 struct input_proxy *compositor_get_global_input_proxy(void);
 
+/**
+ * Get the input proxy that handles a device's events
+ *
+ * The proxy runs on the device's input thread; only read its state
+ * (e.g. input_proxy_get_prediction_state()) once the thread is idle.
+ *
+ * @param device Input device
+ * @return The device's own proxy, or the global proxy for unregistered
+ *         devices and keyboards (NULL if hooks are not initialized)
+ */
+struct input_proxy *compositor_get_input_proxy(struct wl_input_device *device);
+
+/**
+ * Set the clock that stamps intercepted input and frame IDs
+ *
+ * Also used by every input pipeline, which takes the clock when it is
+ * created; call before compositor_hooks_init() (or after
+ * compositor_hooks_cleanup()), while no input thread is running. Bracket
+ * each event-loop dispatch with utils_clock_begin_iteration() and
+ * utils_clock_end_iteration() so every event of one iteration shares a
+ * single clock read.
+ *
+ * @param clock Clock provider (must outlive the hooks), or NULL for the
+ *              system monotonic clock
+ * @return 0 on success, -1 if the hooks are initialized
+ */
+int compositor_set_clock(struct utils_clock *clock);
+
+/**
+ * Current time on the compositor clock, in microseconds
+ */
+uint64_t compositor_now_us(void);
+
+/**
+ * Record everything handed to the input pipeline to a trace file
+ *
+ * Intercepted events, frame acknowledgments and frame ticks are
+ * appended in submission order (see input/input_trace.h); replay the
+ * file with lt-input-replay. Each event records the pipeline it went to
+ * as its device (0 = the default pipeline of keyboards and unregistered
+ * devices) and its device type as COMPOSITOR_TRACE_DEVICE_TYPE() (0 =
+ * unregistered). Recording replaces any trace in progress.
+ *
+ * @param path Trace file (truncated)
+ * @return 0 on success, -1 if hooks are not initialized or the file cannot be created
+ */
+int compositor_input_trace_start(const char *path);
+
+/**
+ * Stop recording and close the trace file
+ *
+ * @return 0 on success, -1 if nothing was recorded or the file could not be written
+ */
+int compositor_input_trace_stop(void);
+
+/**
+ * Reconcile predictions against a presented frame
+ *
+ * Queued behind pending input so it runs on the input thread, in order.
+ *
+ * @param frame_id Presented frame ID
+ * @return 0 on success, -1 if hooks are not initialized or the queue is full
+ */
+int compositor_reconcile_input(uint64_t frame_id);
+
+/**
+ * Advance frame-driven input processing (kinetic scroll) to a frame time
+ *
+ * Queued like compositor_reconcile_input().
+ *
+ * @param frame_time_us Frame presentation time in microseconds (monotonic)
+ * @return 0 on success, -1 if hooks are not initialized or the queue is full
+ */
+int compositor_input_frame(uint64_t frame_time_us);
+
+/**
+ * Advance frame-driven input processing to a presented vblank
+ *
+ * Like compositor_input_frame(), and with a refresh period the input
+ * proxy aims its predictions at the following vblanks
+ * (input_proxy_set_display_timing()).
+ *
+ * @param vblank_us Presentation time in microseconds (compositor clock)
+ * @param refresh_us Refresh period in microseconds (0 = unknown)
+ * @return 0 on success, -1 if hooks are not initialized or the queue is full
+ */
+int compositor_input_vblank(uint64_t vblank_us, uint64_t refresh_us);
+
 /**
  * Input device types
  */
@@ -39,12 +128,40 @@ typedef enum {
     COMPOSITOR_INPUT_POINTER,
     COMPOSITOR_INPUT_KEYBOARD,
     COMPOSITOR_INPUT_TOUCHPAD,
-    COMPOSITOR_INPUT_TOUCHSCREEN
+    COMPOSITOR_INPUT_TOUCHSCREEN,
+    COMPOSITOR_INPUT_TABLET
 } compositor_input_type_t;
 
+/* Trace record device type of a registered device (0 = unregistered) */
+#define COMPOSITOR_TRACE_DEVICE_TYPE(type) ((uint8_t)((type) + 1))
+
+/**
+ * Create an input proxy configured like a device type's pipeline
+ *
+ * Same predictor, prediction window, scroll smoothing, scroll prediction
+ * and kinetic scrolling the hooks give the pipeline of a device of this
+ * type; keyboards get the default pipeline's. Events are not resampled:
+ * the resampler sits in front of the proxy, in the pipeline's queue. The
+ * proxy reads the compositor clock (compositor_set_clock()). Used by the
+ * hooks and by lt-input-replay.
+ *
+ * @param type Device type
+ * @param window_ms Prediction window in milliseconds (0 = the type's)
+ * @param proxy_out Output proxy handle
+ * @return 0 on success, -1 on failure
+ */
+int compositor_input_proxy_create(compositor_input_type_t type, uint32_t window_ms,
+                                  struct input_proxy **proxy_out);
+
 /**
  * Initialize compositor hooks
  *
+ * Call from the compositor thread, bound with metrics_bind() to the
+ * collector of the session it serves. Frame accounting records into that
+ * collector (an unbound thread records into the process default, if
+ * any), and the input threads of pipelines created from it record into
+ * the same one.
+ *
  * @return 0 on success, negative error code on failure
  */
 int compositor_hooks_init(void);
@@ -57,6 +174,8 @@ void compositor_hooks_cleanup(void);
 /**
  * Register input device for interception
  *
+ * Same as compositor_register_seat_input_device() on the default seat.
+ *
  * @param device Input device handle
  * @param type Device type
  * @return 0 on success, negative error code on failure
@@ -64,6 +183,24 @@ void compositor_hooks_cleanup(void);
 int compositor_register_input_device(struct wl_input_device *device,
                                      compositor_input_type_t type);
 
+/**
+ * Register input device on a seat
+ *
+ * Pointers, touchpads and touchscreens get their own input proxy and
+ * input thread with parameters for their type: touchpads predict and
+ * fling continuous scroll, mice only smooth wheel scroll, touchscreens
+ * predict over a shorter window. Keyboards use the global proxy. A
+ * button on any device of the seat stops flings on the others.
+ *
+ * @param seat Seat the device belongs to (NULL = default seat)
+ * @param device Input device handle
+ * @param type Device type
+ * @return 0 on success (or if already registered), -1 on failure
+ */
+int compositor_register_seat_input_device(struct wl_seat *seat,
+                                          struct wl_input_device *device,
+                                          compositor_input_type_t type);
+
 /**
  * Unregister input device
  *
@@ -80,12 +217,15 @@ void compositor_unregister_input_device(struct wl_input_device *device);
  * @param absolute Whether this is absolute positioning
  * @param x Absolute X (if absolute)
  * @param y Absolute Y (if absolute)
+ * @param timestamp_us Device event time in microseconds on the compositor
+ *                     clock's timebase, or 0 to stamp it with compositor_now_us()
  * @return 0 if event should be processed, negative to drop
  */
 int compositor_intercept_pointer_motion(struct wl_input_device *device,
                                        double dx, double dy,
                                        bool absolute,
-                                       double x, double y);
+                                       double x, double y,
+                                       uint64_t timestamp_us);
 
 /**
  * Intercept scroll event
@@ -94,11 +234,14 @@ int compositor_intercept_pointer_motion(struct wl_input_device *device,
  * @param dx Scroll delta X
  * @param dy Scroll delta Y
  * @param discrete Whether this is a discrete scroll event
+ * @param timestamp_us Device event time in microseconds on the compositor
+ *                     clock's timebase, or 0 to stamp it with compositor_now_us()
  * @return 0 if event should be processed, negative to drop
  */
 int compositor_intercept_scroll(struct wl_input_device *device,
                                double dx, double dy,
-                               bool discrete);
+                               bool discrete,
+                               uint64_t timestamp_us);
 
 /**
  * Intercept button event
@@ -106,11 +249,52 @@ int compositor_intercept_scroll(struct wl_input_device *device,
  * @param device Input device
  * @param button Button number
  * @param pressed Whether button is pressed
+ * @param timestamp_us Device event time in microseconds on the compositor
+ *                     clock's timebase, or 0 to stamp it with compositor_now_us()
  * @return 0 if event should be processed, negative to drop
  */
 int compositor_intercept_button(struct wl_input_device *device,
                                uint32_t button,
-                               bool pressed);
+                               bool pressed,
+                               uint64_t timestamp_us);
+
+/**
+ * Intercept key event
+ *
+ * A key press also stops kinetic scrolling on the device's seat.
+ *
+ * @param device Input device
+ * @param key Key code
+ * @param pressed Whether key is pressed
+ * @param timestamp_us Device event time in microseconds on the compositor
+ *                     clock's timebase, or 0 to stamp it with compositor_now_us()
+ * @return 0 if event should be processed, negative to drop
+ */
+int compositor_intercept_key(struct wl_input_device *device,
+                            uint32_t key,
+                            bool pressed,
+                            uint64_t timestamp_us);
+
+/**
+ * Intercept touch event
+ *
+ * Touch down and touch motion are reported pressed with the point's
+ * position; touch up and cancel are reported released.
+ *
+ * @param device Input device
+ * @param touch_id Touch point ID
+ * @param x Absolute X (normalized 0..1)
+ * @param y Absolute Y (normalized 0..1)
+ * @param pressed Whether the touch point is down
+ * @param timestamp_us Device event time in microseconds on the compositor
+ *                     clock's timebase, or 0 to stamp it with compositor_now_us()
+ * @return 0 if event should be processed, negative to drop
+ */
+int compositor_intercept_touch(struct wl_input_device *device,
+                              uint32_t touch_id,
+                              double x, double y,
+                              bool pressed,
+                              uint64_t timestamp_us);
 
 /**
  * Register surface for frame tracking
@@ -128,25 +312,124 @@ int compositor_register_surface(struct wl_surface *surface);
 void compositor_unregister_surface(struct wl_surface *surface);
 
 /**
- * Notify frame presentation
+ * Presentation feedback flags (wp_presentation_feedback kind bits)
+ */
+typedef enum {
+    COMPOSITOR_PRESENTATION_VSYNC = 0x1,            /* Tied to the display's vblank */
+    COMPOSITOR_PRESENTATION_HW_CLOCK = 0x2,         /* Timestamp taken by the display hardware */
+    COMPOSITOR_PRESENTATION_HW_COMPLETION = 0x4,    /* Completion signalled by the hardware */
+    COMPOSITOR_PRESENTATION_ZERO_COPY = 0x8         /* Client buffer scanned out directly */
+} compositor_presentation_flags_t;
+
+/**
+ * Presentation feedback for one frame (wp_presentation_feedback.presented)
+ */
+struct compositor_presentation_feedback {
+    uint64_t present_us;    /* When the frame turned into light, on the compositor clock */
+    uint64_t refresh_ns;    /* Refresh period (0 = unknown or variable refresh) */
+    uint64_t msc;           /* Vertical retrace counter */
+    uint32_t flags;         /* compositor_presentation_flags_t */
+};
+
+/**
+ * Per-surface commit accounting
+ */
+struct compositor_surface_stats {
+    uint64_t committed;         /* Frame IDs issued */
+    uint64_t presented;
+    uint64_t merged;            /* Superseded by a newer commit before presentation */
+    uint64_t dropped;           /* Never presented and not superseded */
+    uint64_t in_flight;         /* Committed, no feedback yet */
+    uint64_t zero_copy;         /* Presented with COMPOSITOR_PRESENTATION_ZERO_COPY */
+    uint64_t last_latency_us;   /* Commit-to-present latency of the last presented frame */
+    uint64_t last_present_us;   /* Presentation time of the last presented frame */
+    uint64_t last_refresh_ns;   /* Refresh period reported with it (0 = unknown) */
+    uint32_t last_flags;        /* Presentation flags reported with it */
+};
+
+/**
+ * Notify frame presentation with wp_presentation feedback
+ *
+ * Consumes the surface's in-flight commits up to frame_id: the frame's
+ * commit-to-present latency is measured to the real presentation time
+ * and older commits still in flight are counted as merged into it. The
+ * refresh period becomes the frame pacing target in the metrics, and
+ * for vsync'd presentation the vblank time and refresh period are
+ * handed to the input pipeline (compositor_input_vblank()). Pacing and
+ * the vblank are taken once per output frame: further surfaces
+ * presented within a millisecond of the first only add their latency.
  *
  * @param surface Wayland surface
- * @param frame_id Frame identifier
+ * @param frame_id Frame ID issued at commit
+ * @param feedback Presentation feedback
+ * @return 0 on success, -1 if the surface is unknown or frame_id is not in flight
+ */
+int compositor_notify_frame_feedback(struct wl_surface *surface,
+                                     uint64_t frame_id,
+                                     const struct compositor_presentation_feedback *feedback);
+
+/**
+ * Notify frame presentation without presentation feedback
+ *
+ * Same as compositor_notify_frame_feedback() with only a presentation
+ * time (no refresh period or flags).
+ *
+ * @param surface Wayland surface
+ * @param frame_id Frame ID issued at commit
  * @param timestamp_us Presentation timestamp in microseconds
- * @return 0 on success, negative error code on failure
+ * @return 0 on success, -1 if the surface is unknown or frame_id is not in flight
  */
 int compositor_notify_frame_presented(struct wl_surface *surface,
                                      uint64_t frame_id,
                                      uint64_t timestamp_us);
 
 /**
- * Generate and track new frame ID for surface
+ * Notify that a commit was discarded without being presented
+ *
+ * The commit and older ones still in flight are merged if a newer
+ * commit is in flight; otherwise the commit is counted as dropped.
+ *
+ * @param surface Wayland surface
+ * @param frame_id Frame ID issued at commit
+ * @return 0 on success, -1 if the surface is unknown or frame_id is not in flight
+ */
+int compositor_notify_frame_discarded(struct wl_surface *surface, uint64_t frame_id);
+
+/**
+ * Notify a frame-done callback for a surface
+ *
+ * Without per-commit feedback the frame shows the surface's newest
+ * commit, which is presented (see compositor_notify_frame_presented()).
+ * With nothing in flight only the input frame tick is forwarded, once
+ * for all the surfaces of one output frame.
+ *
+ * @param surface Wayland surface
+ * @param timestamp_us Frame-done timestamp in microseconds
+ * @return 0 on success, -1 if the surface is unknown
+ */
+int compositor_notify_frame_done(struct wl_surface *surface, uint64_t timestamp_us);
+
+/**
+ * Generate a frame ID for a surface commit and queue it in flight
+ *
+ * When the surface already has a full queue of commits without
+ * feedback, the oldest is counted as dropped.
  *
  * @param surface Wayland surface
  * @return Frame ID (0 on error)
  */
 uint64_t compositor_generate_frame_id(struct wl_surface *surface);
 
+/**
+ * Get a surface's commit accounting
+ *
+ * @param surface Wayland surface
+ * @param stats_out Output statistics
+ * @return 0 on success, -1 if the surface is unknown
+ */
+int compositor_get_surface_stats(struct wl_surface *surface,
+                                 struct compositor_surface_stats *stats_out);
+
 /**
  * wlroots Integration Functions
  *
@@ -172,11 +455,34 @@ void compositor_wlroots_cleanup(void);
 /**
  * Register wlroots surface for frame tracking
  *
+ * Registering a surface that is already tracked does nothing.
+ *
  * @param wlr_surface wlroots surface pointer
  * @return 0 on success, negative on error
  */
 int compositor_wlroots_register_surface(void *wlr_surface);
 
+/**
+ * Register wlroots output for presentation feedback
+ *
+ * From then on frames are accounted at the output's present event with
+ * its vblank timestamp, refresh period and flags, not at frame done.
+ *
+ * @param wlr_output wlroots output pointer
+ * @return 0 on success, negative on error
+ */
+int compositor_wlroots_register_output(void *wlr_output);
+
+/**
+ * Report that a surface's current state was rendered on an output
+ *
+ * Call where wlr_presentation_surface_sampled_on_output() is called.
+ *
+ * @param wlr_surface wlroots surface pointer
+ * @param wlr_output wlroots output pointer
+ */
+void compositor_wlroots_surface_sampled(void *wlr_surface, void *wlr_output);
+
 #ifdef __cplusplus
 }
 #endif
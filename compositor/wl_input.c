@@ -1,8 +1,11 @@
 #include "compositor.h"
 #include "../input/input.h"
+#include "../input/input_queue.h"
+#include "../input/input_resampler.h"
+#include "../input/input_trace.h"
+#include "../core/utils.h"
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 /**
  * Wayland input interception implementation
@@ -10,22 +13,216 @@
  * This module provides hooks for intercepting Wayland input events
  * from wlroots-based compositors. The framework is ready for wlroots
  * integration - actual Wayland connection would be added in production.
+ *
+ * Every pointer-class device gets its own pipeline (proxy, resampler
+ * and input thread) configured for its type, so a mouse, a touchpad and
+ * a tablet never share predictor history or a scroll smoother. Devices
+ * live in an open-addressing hash table keyed by the device pointer
+ * (same scheme as the surface table in wl_surface.c). Events from
+ * devices that were never registered, and from keyboards, go to the
+ * default pipeline. Devices are grouped by seat: a button on one device
+ * stops a fling on the other devices of its seat, as it would with one
+ * shared proxy.
+ *
+ * Intercepted events are only copied into the pipeline's SPSC input
+ * queue on the compositor thread; prediction, smoothing and
+ * reconciliation run on the queue's input thread so a slow predictor
+ * never stalls the compositor. Relative motion and touchpad scroll are
+ * resampled to one sample per presented frame before prediction. Frame
+ * acknowledgments and ticks go to every pipeline.
+ *
+ * When a trace is being recorded, the same stream is appended to it on
+ * the compositor thread before queueing, each event tagged with its
+ * device type and the pipeline it went to, so a replay can split it the
+ * same way.
  */
 
+#define INPUT_DEVICE_TABLE_MIN_CAPACITY 16  /* Power of two */
+
+/* Per-device input pipeline */
+struct input_pipeline {
+    struct input_proxy *proxy;
+    struct input_resampler *resampler;
+    struct input_queue *queue;
+    uint32_t id;                /* Trace device ID (0 = default pipeline) */
+    bool kinetic;               /* Flings to stop on seat input */
+};
+
+/* Predictor and smoother parameters by device type */
+struct input_device_profile {
+    bool pipeline;              /* Gets its own pipeline */
+    uint32_t window_ms;
+    bool scroll_smoothing;
+    bool scroll_prediction;     /* Continuous scroll is extrapolated */
+    bool kinetic;               /* Scroll carries on after lift-off */
+    input_predictor_backend_t predictor;
+};
+
+static const struct input_device_profile g_device_profiles[] = {
+    /*
+     * Wheel clicks are discrete: smoothed, never extrapolated or flung.
+     * Mouse and touchpad motion speeds up and reverses freely, so they
+     * use the alpha-beta filter that learns from its errors.
+     */
+    [COMPOSITOR_INPUT_POINTER] = {true, 16, true, false, false, INPUT_PREDICTOR_ADAPTIVE},
+    [COMPOSITOR_INPUT_KEYBOARD] = {false, 0, false, false, false, INPUT_PREDICTOR_AUTO},
+    [COMPOSITOR_INPUT_TOUCHPAD] = {true, 16, true, true, true, INPUT_PREDICTOR_ADAPTIVE},
+    /* The finger is on the content: a short window keeps overshoot small */
+    [COMPOSITOR_INPUT_TOUCHSCREEN] = {true, 8, false, false, false, INPUT_PREDICTOR_AUTO},
+    [COMPOSITOR_INPUT_TABLET] = {true, 16, false, false, false, INPUT_PREDICTOR_AUTO},
+};
+
 /* Input device tracking */
 struct input_device_entry {
     struct wl_input_device *device;
     compositor_input_type_t type;
-    struct input_proxy *proxy;
-    struct input_device_entry *next;
+    struct wl_seat *seat;
+    struct input_pipeline *pipeline;    /* NULL = default pipeline */
 };
 
 static bool g_hooks_initialized = false;
-static struct input_device_entry *g_input_devices = NULL;
-static struct input_proxy *g_global_input_proxy = NULL;
+static struct input_device_entry *g_input_devices = NULL;   /* Hash table (device NULL = empty) */
+static size_t g_input_device_capacity = 0;                  /* Power of two */
+static size_t g_input_device_count = 0;
+static struct input_pipeline g_default_pipeline;
+static struct utils_clock *g_compositor_clock = NULL;
+static struct input_trace_writer *g_input_trace = NULL;
+static uint32_t g_next_pipeline_id = 1;
 
 struct input_proxy *compositor_get_global_input_proxy(void) {
-    return g_global_input_proxy;
+    return g_default_pipeline.proxy;
+}
+
+static inline size_t input_device_hash(const struct wl_input_device *device) {
+    uint64_t key = (uint64_t)(uintptr_t)device;
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+/* Slot holding device, or the empty slot where it would go */
+static size_t input_device_probe(const struct input_device_entry *table, size_t capacity,
+                                 const struct wl_input_device *device) {
+    size_t mask = capacity - 1;
+    size_t i = input_device_hash(device) & mask;
+    while (table[i].device && table[i].device != device) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int input_device_table_resize(size_t capacity) {
+    struct input_device_entry *table = calloc(capacity, sizeof(struct input_device_entry));
+    if (!table) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < g_input_device_capacity; i++) {
+        if (g_input_devices[i].device) {
+            table[input_device_probe(table, capacity, g_input_devices[i].device)] = g_input_devices[i];
+        }
+    }
+    
+    free(g_input_devices);
+    g_input_devices = table;
+    g_input_device_capacity = capacity;
+    return 0;
+}
+
+static struct input_device_entry *find_input_device(const struct wl_input_device *device) {
+    if (!device || g_input_device_count == 0) {
+        return NULL;
+    }
+    
+    struct input_device_entry *entry =
+        &g_input_devices[input_device_probe(g_input_devices, g_input_device_capacity, device)];
+    return entry->device ? entry : NULL;
+}
+
+static void input_pipeline_destroy(struct input_pipeline *pipeline) {
+    /* Stop the input thread before the proxy it feeds goes away */
+    input_queue_destroy(pipeline->queue);
+    input_resampler_destroy(pipeline->resampler);
+    input_proxy_destroy(pipeline->proxy);
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+/* Profile of the pipeline a device type's events go to */
+static const struct input_device_profile *input_device_profile(compositor_input_type_t type) {
+    if (!g_device_profiles[type].pipeline) {
+        return &g_device_profiles[COMPOSITOR_INPUT_TOUCHPAD];  /* The default pipeline's */
+    }
+    return &g_device_profiles[type];
+}
+
+int compositor_input_proxy_create(compositor_input_type_t type, uint32_t window_ms,
+                                  struct input_proxy **proxy_out) {
+    if (!proxy_out || (size_t)type >= sizeof(g_device_profiles) / sizeof(g_device_profiles[0])) {
+        return -1;
+    }
+    
+    const struct input_device_profile *profile = input_device_profile(type);
+    struct input_proxy *proxy = NULL;
+    if (input_proxy_create(true, window_ms ? window_ms : profile->window_ms,
+                           profile->scroll_smoothing, &proxy) < 0) {
+        return -1;
+    }
+    
+    input_proxy_set_clock(proxy, g_compositor_clock);
+    if (input_proxy_set_predictor(proxy, profile->predictor) < 0) {
+        input_proxy_destroy(proxy);
+        return -1;
+    }
+    if (profile->scroll_prediction) {
+        input_proxy_set_scroll_prediction(proxy, true);
+    }
+    if (profile->kinetic) {
+        struct scroll_kinetic_config kinetic;
+        scroll_smoother_kinetic_defaults(&kinetic);
+        input_proxy_set_kinetic_scroll(proxy, &kinetic);
+    }
+    *proxy_out = proxy;
+    return 0;
+}
+
+static int input_pipeline_init(struct input_pipeline *pipeline, compositor_input_type_t type, uint32_t id) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    if (compositor_input_proxy_create(type, 0, &pipeline->proxy) < 0) {
+        return -1;
+    }
+    pipeline->id = id;
+    pipeline->kinetic = input_device_profile(type)->kinetic;
+    
+    /* Remote transport is handled by lens adapters, so no sink here */
+    /* Frame ticks come from presentation, so the resampler follows the measured vsync */
+    if (input_resampler_create(0, &pipeline->resampler) < 0 ||
+        input_queue_create(pipeline->proxy, INPUT_QUEUE_DEFAULT_CAPACITY,
+                           NULL, NULL, &pipeline->queue) < 0 ||
+        input_queue_set_resampler(pipeline->queue, pipeline->resampler) < 0 ||
+        input_queue_start(pipeline->queue) < 0) {
+        input_pipeline_destroy(pipeline);
+        return -1;
+    }
+    return 0;
+}
+
+static void input_device_entry_free(struct input_device_entry *entry) {
+    if (entry->pipeline) {
+        input_pipeline_destroy(entry->pipeline);
+        free(entry->pipeline);
+    }
+}
+
+int compositor_set_clock(struct utils_clock *clock) {
+    /* Input threads read the clock their proxy was created with; never swap it under them */
+    if (g_hooks_initialized) {
+        return -1;
+    }
+    
+    g_compositor_clock = clock;
+    return 0;
+}
+
+uint64_t compositor_now_us(void) {
+    return utils_clock_now_us(g_compositor_clock);
 }
 
 int compositor_hooks_init(void) {
@@ -33,11 +230,10 @@ int compositor_hooks_init(void) {
         return -1;  /* Already initialized */
     }
     
-    /* Initialize input proxy with default settings */
+    /* Unregistered devices get the touchpad configuration (the old shared proxy) */
     /* In production, these would come from configuration */
-    int ret = input_proxy_create(true, 16, true, &g_global_input_proxy);
-    if (ret < 0) {
-        return ret;
+    if (input_pipeline_init(&g_default_pipeline, COMPOSITOR_INPUT_TOUCHPAD, 0) < 0) {
+        return -1;
     }
     
     /* wlroots integration is handled by compositor_wlroots_init() */
@@ -52,20 +248,22 @@ void compositor_hooks_cleanup(void) {
         return;
     }
     
+    if (g_input_trace) {
+        compositor_input_trace_stop();
+    }
+    
     /* Unregister all input devices */
-    struct input_device_entry *entry = g_input_devices;
-    while (entry) {
-        struct input_device_entry *next = entry->next;
-        free(entry);
-        entry = next;
+    for (size_t i = 0; i < g_input_device_capacity; i++) {
+        if (g_input_devices[i].device) {
+            input_device_entry_free(&g_input_devices[i]);
+        }
     }
+    free(g_input_devices);
     g_input_devices = NULL;
+    g_input_device_capacity = 0;
+    g_input_device_count = 0;
     
-    /* Destroy input proxy */
-    if (g_global_input_proxy) {
-        input_proxy_destroy(g_global_input_proxy);
-        g_global_input_proxy = NULL;
-    }
+    input_pipeline_destroy(&g_default_pipeline);
     
     /* wlroots cleanup is handled by compositor_wlroots_cleanup() */
     
@@ -74,30 +272,52 @@ void compositor_hooks_cleanup(void) {
 
 int compositor_register_input_device(struct wl_input_device *device,
                                      compositor_input_type_t type) {
-    if (!g_hooks_initialized || !device) {
+    return compositor_register_seat_input_device(NULL, device, type);
+}
+
+int compositor_register_seat_input_device(struct wl_seat *seat,
+                                          struct wl_input_device *device,
+                                          compositor_input_type_t type) {
+    if (!g_hooks_initialized || !device ||
+        (size_t)type >= sizeof(g_device_profiles) / sizeof(g_device_profiles[0])) {
         return -1;
     }
     
     /* Check if device already registered */
-    struct input_device_entry *entry = g_input_devices;
-    while (entry) {
-        if (entry->device == device) {
-            return 0;  /* Already registered */
+    if (find_input_device(device)) {
+        return 0;  /* Already registered */
+    }
+    
+    /* Keep the table at most half full */
+    if ((g_input_device_count + 1) * 2 > g_input_device_capacity) {
+        size_t capacity = g_input_device_capacity ? g_input_device_capacity * 2
+                                                  : INPUT_DEVICE_TABLE_MIN_CAPACITY;
+        if (input_device_table_resize(capacity) < 0) {
+            return -1;
         }
-        entry = entry->next;
     }
     
-    /* Create new device entry */
-    entry = malloc(sizeof(struct input_device_entry));
-    if (!entry) {
-        return -1;
+    /* Create the device's own pipeline */
+    struct input_pipeline *pipeline = NULL;
+    if (g_device_profiles[type].pipeline) {
+        pipeline = malloc(sizeof(struct input_pipeline));
+        if (!pipeline) {
+            return -1;
+        }
+        if (input_pipeline_init(pipeline, type, g_next_pipeline_id) < 0) {
+            free(pipeline);
+            return -1;
+        }
+        g_next_pipeline_id++;
     }
     
+    struct input_device_entry *entry =
+        &g_input_devices[input_device_probe(g_input_devices, g_input_device_capacity, device)];
     entry->device = device;
     entry->type = type;
-    entry->proxy = g_global_input_proxy;  /* Use global proxy for now */
-    entry->next = g_input_devices;
-    g_input_devices = entry;
+    entry->seat = seat;
+    entry->pipeline = pipeline;
+    g_input_device_count++;
     
     /* wlroots event callbacks are set up by compositor_wlroots_init() */
     /* when a new input device is detected */
@@ -106,42 +326,156 @@ int compositor_register_input_device(struct wl_input_device *device,
 }
 
 void compositor_unregister_input_device(struct wl_input_device *device) {
-    if (!g_hooks_initialized || !device) {
+    if (!g_hooks_initialized || !find_input_device(device)) {
         return;
     }
     
-    /* Find and remove device entry */
-    struct input_device_entry **entry_ptr = &g_input_devices;
-    while (*entry_ptr) {
-        if ((*entry_ptr)->device == device) {
-            struct input_device_entry *to_free = *entry_ptr;
-            *entry_ptr = (*entry_ptr)->next;
-            free(to_free);
-            return;
+    size_t mask = g_input_device_capacity - 1;
+    size_t hole = input_device_probe(g_input_devices, g_input_device_capacity, device);
+    input_device_entry_free(&g_input_devices[hole]);
+    
+    /* Backward-shift deletion: pull later entries of the run into the hole */
+    for (size_t i = (hole + 1) & mask; g_input_devices[i].device; i = (i + 1) & mask) {
+        size_t home = input_device_hash(g_input_devices[i].device) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            g_input_devices[hole] = g_input_devices[i];
+            hole = i;
         }
-        entry_ptr = &(*entry_ptr)->next;
+    }
+    memset(&g_input_devices[hole], 0, sizeof(g_input_devices[hole]));
+    
+    if (--g_input_device_count == 0) {
+        free(g_input_devices);
+        g_input_devices = NULL;
+        g_input_device_capacity = 0;
     }
     
     /* wlroots event callbacks are cleaned up by compositor_wlroots_cleanup() */
 }
 
+struct input_proxy *compositor_get_input_proxy(struct wl_input_device *device) {
+    struct input_device_entry *entry = find_input_device(device);
+    if (entry && entry->pipeline) {
+        return entry->pipeline->proxy;
+    }
+    return g_default_pipeline.proxy;
+}
+
+int compositor_input_trace_start(const char *path) {
+    if (!g_hooks_initialized) {
+        return -1;
+    }
+    
+    if (g_input_trace) {
+        compositor_input_trace_stop();
+    }
+    return input_trace_writer_open(path, &g_input_trace);
+}
+
+int compositor_input_trace_stop(void) {
+    if (!g_input_trace) {
+        return -1;
+    }
+    
+    int ret = input_trace_writer_close(g_input_trace);
+    g_input_trace = NULL;
+    return ret;
+}
+
+/* Hand an event to its device's input thread */
+static int compositor_submit_input(struct wl_input_device *device, const struct input_event *event) {
+    struct input_device_entry *entry = find_input_device(device);
+    struct input_pipeline *pipeline = entry && entry->pipeline ? entry->pipeline : &g_default_pipeline;
+    
+    if (g_input_trace) {
+        struct input_trace_record record = {
+            .kind = INPUT_TRACE_EVENT,
+            .timestamp_us = event->timestamp_us,
+            .event = *event,
+            .device = pipeline->id,
+            .device_type = entry ? COMPOSITOR_TRACE_DEVICE_TYPE(entry->type) : 0,
+        };
+        (void)input_trace_write(g_input_trace, &record);
+    }
+    
+    /* Overflow is accounted in the queue stats; never stall the compositor */
+    (void)input_queue_push(pipeline->queue, event);
+    return 0;
+}
+
+/* Stop flings on the other devices of a device's seat (the device's own proxy sees its event) */
+static void compositor_seat_cancel_flings(struct wl_input_device *device) {
+    struct input_device_entry *source = find_input_device(device);
+    if (!source) {
+        return;
+    }
+    
+    for (size_t i = 0; i < g_input_device_capacity; i++) {
+        struct input_device_entry *entry = &g_input_devices[i];
+        if (entry->device && entry != source && entry->seat == source->seat &&
+            entry->pipeline && entry->pipeline->kinetic) {
+            (void)input_queue_push_cancel(entry->pipeline->queue);
+        }
+    }
+}
+
+/* Apply fn to every pipeline; -1 if any of them failed */
+static int compositor_for_each_pipeline(int (*fn)(struct input_queue *queue, uint64_t a, uint64_t b),
+                                        uint64_t a, uint64_t b) {
+    if (!g_hooks_initialized) {
+        return -1;
+    }
+    
+    int ret = fn(g_default_pipeline.queue, a, b);
+    for (size_t i = 0; i < g_input_device_capacity; i++) {
+        if (g_input_devices[i].pipeline && fn(g_input_devices[i].pipeline->queue, a, b) < 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+static int push_reconcile(struct input_queue *queue, uint64_t frame_id, uint64_t unused) {
+    (void)unused;
+    return input_queue_push_reconcile(queue, frame_id);
+}
+
+int compositor_reconcile_input(uint64_t frame_id) {
+    if (g_input_trace) {
+        (void)input_trace_write_ack(g_input_trace, frame_id, compositor_now_us());
+    }
+    return compositor_for_each_pipeline(push_reconcile, frame_id, 0);
+}
+
+int compositor_input_frame(uint64_t frame_time_us) {
+    return compositor_input_vblank(frame_time_us, 0);
+}
+
+int compositor_input_vblank(uint64_t vblank_us, uint64_t refresh_us) {
+    if (g_input_trace) {
+        (void)input_trace_write_vblank(g_input_trace, vblank_us, refresh_us);
+    }
+    return compositor_for_each_pipeline(input_queue_push_vblank, vblank_us, refresh_us);
+}
+
+/* The device's own event time, else the compositor clock (cached per iteration) */
+static inline uint64_t compositor_event_time_us(uint64_t timestamp_us) {
+    return timestamp_us ? timestamp_us : compositor_now_us();
+}
+
 int compositor_intercept_pointer_motion(struct wl_input_device *device,
                                        double dx, double dy,
                                        bool absolute,
-                                       double x, double y) {
-    if (!g_hooks_initialized || !device || !g_global_input_proxy) {
+                                       double x, double y,
+                                       uint64_t timestamp_us) {
+    if (!g_hooks_initialized || !device) {
         return -1;
     }
     
-    /* Get current timestamp */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t timestamp_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
     /* Create input event */
     struct input_event event = {
         .type = INPUT_EVENT_POINTER_MOTION,
-        .timestamp_us = timestamp_us,
+        .timestamp_us = compositor_event_time_us(timestamp_us),
         .pointer_motion = {
             .dx = dx,
             .dy = dy,
@@ -151,40 +485,28 @@ int compositor_intercept_pointer_motion(struct wl_input_device *device,
         }
     };
     
-    /* Process through input proxy for prediction */
-    struct input_event *predicted = NULL;
-    int ret = input_proxy_process(g_global_input_proxy, &event, &predicted);
+    /* Queue for prediction on the input thread */
+    /* Remote transport: Lens adapter is responsible for sending events to remote */
+    int ret = compositor_submit_input(device, &event);
     if (ret < 0) {
         return ret;
     }
     
-    /* Local feedback: Input proxy applies immediate local feedback for predicted events */
-    /* Remote transport: Lens adapter is responsible for sending events to remote */
-    /* This function only processes through input proxy for prediction */
-    
-    if (predicted) {
-        free(predicted);
-    }
-    
     return 0;  /* Allow event to proceed */
 }
 
 int compositor_intercept_scroll(struct wl_input_device *device,
                                double dx, double dy,
-                               bool discrete) {
-    if (!g_hooks_initialized || !device || !g_global_input_proxy) {
+                               bool discrete,
+                               uint64_t timestamp_us) {
+    if (!g_hooks_initialized || !device) {
         return -1;
     }
     
-    /* Get current timestamp */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t timestamp_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
     /* Create input event */
     struct input_event event = {
         .type = INPUT_EVENT_SCROLL,
-        .timestamp_us = timestamp_us,
+        .timestamp_us = compositor_event_time_us(timestamp_us),
         .scroll = {
             .dx = dx,
             .dy = dy,
@@ -194,39 +516,28 @@ int compositor_intercept_scroll(struct wl_input_device *device,
         }
     };
     
-    /* Process through input proxy (includes scroll smoothing) */
-    struct input_event *smoothed = NULL;
-    int ret = input_proxy_process(g_global_input_proxy, &event, &smoothed);
+    /* Queue for the input proxy (includes scroll smoothing) */
+    /* Remote transport is handled by lens adapters */
+    int ret = compositor_submit_input(device, &event);
     if (ret < 0) {
         return ret;
     }
     
-    /* Remote transport is handled by lens adapters */
-    /* This function only processes through input proxy for smoothing */
-    
-    if (smoothed) {
-        free(smoothed);
-    }
-    
     return 0;  /* Allow event to proceed */
 }
 
 int compositor_intercept_button(struct wl_input_device *device,
                                uint32_t button,
-                               bool pressed) {
-    if (!g_hooks_initialized || !device || !g_global_input_proxy) {
+                               bool pressed,
+                               uint64_t timestamp_us) {
+    if (!g_hooks_initialized || !device) {
         return -1;
     }
     
-    /* Get current timestamp */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t timestamp_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
     /* Create input event */
     struct input_event event = {
         .type = INPUT_EVENT_POINTER_BUTTON,
-        .timestamp_us = timestamp_us,
+        .timestamp_us = compositor_event_time_us(timestamp_us),
         .pointer_button = {
             .button = button,
             .pressed = pressed
@@ -234,15 +545,82 @@ int compositor_intercept_button(struct wl_input_device *device,
     };
     
     /* Button events are not predicted, but track for reconciliation */
-    /* Process without prediction */
-    int ret = input_proxy_process(g_global_input_proxy, &event, NULL);
+    /* Queued in order with motion so the proxy sees the real sequence */
+    int ret = compositor_submit_input(device, &event);
     if (ret < 0) {
         return ret;
     }
     
+    /* A click anywhere on the seat stops a touchpad fling */
+    compositor_seat_cancel_flings(device);
+    
     /* Remote transport is handled by lens adapters */
     /* Button events are sent immediately without prediction */
     
     return 0;  /* Allow event to proceed */
 }
 
+int compositor_intercept_key(struct wl_input_device *device,
+                            uint32_t key,
+                            bool pressed,
+                            uint64_t timestamp_us) {
+    if (!g_hooks_initialized || !device) {
+        return -1;
+    }
+    
+    struct input_event event = {
+        .type = INPUT_EVENT_KEY,
+        .timestamp_us = compositor_event_time_us(timestamp_us),
+        .key = {
+            .key = key,
+            .pressed = pressed
+        }
+    };
+    
+    /* Keyboards share the default pipeline; keys keep their order with pointer input */
+    int ret = compositor_submit_input(device, &event);
+    if (ret < 0) {
+        return ret;
+    }
+    
+    /* Typing stops a fling on the seat's touchpads */
+    if (pressed) {
+        compositor_seat_cancel_flings(device);
+    }
+    
+    return 0;  /* Allow event to proceed */
+}
+
+int compositor_intercept_touch(struct wl_input_device *device,
+                              uint32_t touch_id,
+                              double x, double y,
+                              bool pressed,
+                              uint64_t timestamp_us) {
+    if (!g_hooks_initialized || !device) {
+        return -1;
+    }
+    
+    struct input_event event = {
+        .type = INPUT_EVENT_TOUCH,
+        .timestamp_us = compositor_event_time_us(timestamp_us),
+        .touch = {
+            .touch_id = touch_id,
+            .x = x,
+            .y = y,
+            .pressed = pressed
+        }
+    };
+    
+    int ret = compositor_submit_input(device, &event);
+    if (ret < 0) {
+        return ret;
+    }
+    
+    /* A finger on the screen stops a touchpad fling, like a click */
+    if (pressed) {
+        compositor_seat_cancel_flings(device);
+    }
+    
+    return 0;  /* Allow event to proceed */
+}
+
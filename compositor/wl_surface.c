@@ -1,65 +1,174 @@
 #include "compositor.h"
 #include "../input/input.h"
+#include "../core/metrics.h"
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 /**
  * Wayland surface tracking implementation
  *
  * This module tracks Wayland surfaces and frame presentation events
  * for latency measurement and input reconciliation.
+ *
+ * Surfaces live in an open-addressing hash table keyed by the surface
+ * pointer (linear probing, backward-shift deletion, at most half full),
+ * so commits and frame-done lookups are O(1) however many subsurfaces
+ * and popups exist.
+ *
+ * Each surface keeps an in-flight queue of its commits. Frame IDs are
+ * issued in commit order, so the queue is the ID range
+ * [first_pending, frame_id_counter] and the commit times live in a fixed
+ * power-of-two ring indexed by frame_id & mask. Feedback consumes the
+ * queue in order:
+ *
+ *   presented  the frame's commit-to-present latency is recorded; older
+ *              commits still in flight never reached the screen on their
+ *              own and are counted as merged into it
+ *   discarded  the commit (and everything older) was superseded; it is
+ *              merged if a newer commit is in flight, dropped otherwise
+ *   overflow   a commit pushed out of a full queue never got feedback
+ *              and is dropped
+ *
+ * Only presented and dropped frames reach the frame metrics; merged
+ * commits are counted per surface (compositor_get_surface_stats()).
+ *
+ * Latency is measured to the presentation time given by the caller:
+ * with wp_presentation feedback that is the vblank the frame was
+ * scanned out on, not the frame-done callback that merely lets the
+ * client draw again. The reported refresh period also drives the frame
+ * pacing target and the input predictor's vblank horizon.
+ * Memory per surface is constant for the whole session.
+ *
+ * Latency is per surface, but pacing and input frame ticks are per
+ * output frame: every surface shown by one frame reports (about) the
+ * same time, so only the first report of a frame feeds the pacing
+ * window and the input pipelines. Reports closer together than
+ * OUTPUT_FRAME_MIN_INTERVAL_US belong to the same frame.
  */
 
+#define SURFACE_FRAME_RING 64           /* In-flight commits per surface (power of two) */
+#define SURFACE_FRAME_MASK (SURFACE_FRAME_RING - 1)
+#define SURFACE_TABLE_MIN_CAPACITY 64   /* Power of two */
+#define OUTPUT_FRAME_MIN_INTERVAL_US 1000   /* No display refreshes faster than 1 kHz */
+
+_Static_assert((SURFACE_FRAME_RING & SURFACE_FRAME_MASK) == 0,
+               "commit time ring must be a power of two");
+
 /* Surface tracking entry */
 struct surface_entry {
     struct wl_surface *surface;
-    uint64_t frame_id_counter;
-    uint64_t *frame_timestamps;  /* Map frame_id to creation timestamp */
-    size_t frame_capacity;
-    size_t frame_count;
-    struct surface_entry *next;
+    uint64_t frame_id_counter;                  /* Newest commit */
+    uint64_t first_pending;                     /* Oldest commit in flight */
+    uint64_t commit_us[SURFACE_FRAME_RING];     /* Commit time by frame_id & mask */
+    struct compositor_surface_stats stats;
+};
+
+/* Hash table slot; the key is kept inline so probing never dereferences entries */
+struct surface_slot {
+    struct wl_surface *surface;     /* NULL = empty */
+    struct surface_entry *entry;
 };
 
-static bool g_surfaces_initialized = false;
-static struct surface_entry *g_surfaces = NULL;
+static struct surface_slot *g_surface_table = NULL;
+static size_t g_surface_capacity = 0;   /* Power of two */
+static size_t g_surface_count = 0;
+
+/* Output frame tracking (see above) */
+static uint64_t g_paced_frame_us = 0;       /* Last frame fed to the pacing window */
+static uint64_t g_ticked_frame_us = 0;      /* Last frame ticked to the input pipelines */
+static uint64_t g_pacing_refresh_ns = 0;    /* Refresh period the pacing target was set from */
+
+/* Whether timestamp_us starts a new output frame after *last_us; records it if so */
+static bool output_frame_begin(uint64_t *last_us, uint64_t timestamp_us) {
+    if (*last_us != 0 && timestamp_us >= *last_us &&
+        timestamp_us - *last_us < OUTPUT_FRAME_MIN_INTERVAL_US) {
+        return false;
+    }
+    *last_us = timestamp_us;
+    return true;
+}
+
+/* Tick the input pipelines once per output frame */
+static void output_frame_tick(uint64_t timestamp_us, uint64_t refresh_us) {
+    if (output_frame_begin(&g_ticked_frame_us, timestamp_us)) {
+        (void)compositor_input_vblank(timestamp_us, refresh_us);
+    }
+}
+
+static inline size_t surface_hash(const struct wl_surface *surface) {
+    /* Fibonacci hashing; allocator alignment leaves the low bits empty */
+    uint64_t key = (uint64_t)(uintptr_t)surface;
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+/* Slot holding surface, or the empty slot where it would go */
+static size_t surface_probe(const struct surface_slot *table, size_t capacity,
+                            const struct wl_surface *surface) {
+    size_t mask = capacity - 1;
+    size_t i = surface_hash(surface) & mask;
+    while (table[i].surface && table[i].surface != surface) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int surface_table_resize(size_t capacity) {
+    struct surface_slot *table = calloc(capacity, sizeof(struct surface_slot));
+    if (!table) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < g_surface_capacity; i++) {
+        if (g_surface_table[i].surface) {
+            table[surface_probe(table, capacity, g_surface_table[i].surface)] = g_surface_table[i];
+        }
+    }
+    
+    free(g_surface_table);
+    g_surface_table = table;
+    g_surface_capacity = capacity;
+    return 0;
+}
+
+/* Find surface entry */
+static struct surface_entry *find_surface_entry(struct wl_surface *surface) {
+    if (!surface || g_surface_count == 0) {
+        return NULL;
+    }
+    
+    return g_surface_table[surface_probe(g_surface_table, g_surface_capacity, surface)].entry;
+}
 
 int compositor_register_surface(struct wl_surface *surface) {
     if (!surface) {
         return -1;
     }
     
-    if (!g_surfaces_initialized) {
-        g_surfaces_initialized = true;
+    /* Check if surface already registered */
+    if (find_surface_entry(surface)) {
+        return 0;  /* Already registered */
     }
     
-    /* Check if surface already registered */
-    struct surface_entry *entry = g_surfaces;
-    while (entry) {
-        if (entry->surface == surface) {
-            return 0;  /* Already registered */
+    /* Keep the table at most half full */
+    if ((g_surface_count + 1) * 2 > g_surface_capacity) {
+        size_t capacity = g_surface_capacity ? g_surface_capacity * 2 : SURFACE_TABLE_MIN_CAPACITY;
+        if (surface_table_resize(capacity) < 0) {
+            return -1;
         }
-        entry = entry->next;
     }
     
     /* Create new surface entry */
-    entry = calloc(1, sizeof(struct surface_entry));
+    struct surface_entry *entry = calloc(1, sizeof(struct surface_entry));
     if (!entry) {
         return -1;
     }
-    
     entry->surface = surface;
-    entry->frame_id_counter = 0;
-    entry->frame_capacity = 64;  /* Initial capacity */
-    entry->frame_count = 0;
-    entry->frame_timestamps = calloc(entry->frame_capacity, sizeof(uint64_t));
-    if (!entry->frame_timestamps) {
-        free(entry);
-        return -1;
-    }
+    entry->first_pending = 1;
     
-    entry->next = g_surfaces;
-    g_surfaces = entry;
+    size_t slot = surface_probe(g_surface_table, g_surface_capacity, surface);
+    g_surface_table[slot].surface = surface;
+    g_surface_table[slot].entry = entry;
+    g_surface_count++;
     
     /* wlroots frame callbacks are set up by compositor_wlroots_register_surface() */
     
@@ -67,43 +176,54 @@ int compositor_register_surface(struct wl_surface *surface) {
 }
 
 void compositor_unregister_surface(struct wl_surface *surface) {
-    if (!surface) {
+    if (!find_surface_entry(surface)) {
         return;
     }
     
-    /* Find and remove surface entry */
-    struct surface_entry **entry_ptr = &g_surfaces;
-    while (*entry_ptr) {
-        if ((*entry_ptr)->surface == surface) {
-            struct surface_entry *to_free = *entry_ptr;
-            *entry_ptr = (*entry_ptr)->next;
-            
-            free(to_free->frame_timestamps);
-            free(to_free);
-            return;
+    size_t mask = g_surface_capacity - 1;
+    size_t hole = surface_probe(g_surface_table, g_surface_capacity, surface);
+    metrics_surface_release((uint64_t)(uintptr_t)surface);
+    free(g_surface_table[hole].entry);
+    
+    /* Backward-shift deletion: pull later entries of the run into the hole */
+    for (size_t i = (hole + 1) & mask; g_surface_table[i].surface; i = (i + 1) & mask) {
+        size_t home = surface_hash(g_surface_table[i].surface) & mask;
+        /* Move unless the entry's home lies cyclically in (hole, i] */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            g_surface_table[hole] = g_surface_table[i];
+            hole = i;
         }
-        entry_ptr = &(*entry_ptr)->next;
     }
+    g_surface_table[hole] = (struct surface_slot){NULL, NULL};
     
+    if (--g_surface_count == 0) {
+        free(g_surface_table);
+        g_surface_table = NULL;
+        g_surface_capacity = 0;
+        g_paced_frame_us = 0;
+        g_ticked_frame_us = 0;
+        g_pacing_refresh_ns = 0;
+    }
+    
+    /* Commits still in flight go away with the surface */
     /* wlroots frame callbacks are cleaned up by compositor_wlroots_cleanup() */
 }
 
-/* Find surface entry */
-static struct surface_entry *find_surface_entry(struct wl_surface *surface) {
-    struct surface_entry *entry = g_surfaces;
-    while (entry) {
-        if (entry->surface == surface) {
-            return entry;
-        }
-        entry = entry->next;
-    }
-    return NULL;
+static inline uint64_t surface_in_flight(const struct surface_entry *entry) {
+    return entry->frame_id_counter + 1 - entry->first_pending;
 }
 
-int compositor_notify_frame_presented(struct wl_surface *surface,
+/* Count a commit that never reached the screen */
+static void surface_frame_dropped(struct surface_entry *entry, uint64_t timestamp_us) {
+    entry->stats.dropped++;
+    metrics_record_frame_presented(timestamp_us, 0, true);
+    metrics_record_surface_frame((uint64_t)(uintptr_t)entry->surface, 0, true);
+}
+
+int compositor_notify_frame_feedback(struct wl_surface *surface,
                                      uint64_t frame_id,
-                                     uint64_t timestamp_us) {
-    if (!surface) {
+                                     const struct compositor_presentation_feedback *feedback) {
+    if (!surface || !feedback) {
         return -1;
     }
     
@@ -112,36 +232,100 @@ int compositor_notify_frame_presented(struct wl_surface *surface,
         return -1;  /* Surface not registered */
     }
     
-    /* Calculate latency */
-    uint32_t latency_ms = 0;
-    bool dropped = false;
+    /* Feedback for a commit that is no longer in flight (repeated or overflowed) */
+    if (frame_id < entry->first_pending || frame_id > entry->frame_id_counter) {
+        return -1;
+    }
     
-    /* Look up frame creation timestamp */
-    if (frame_id < entry->frame_capacity && entry->frame_timestamps[frame_id] > 0) {
-        uint64_t frame_created_us = entry->frame_timestamps[frame_id];
-        uint64_t latency_us = timestamp_us - frame_created_us;
-        latency_ms = latency_us / 1000;
-        
-        /* Clear timestamp (frame processed) */
-        entry->frame_timestamps[frame_id] = 0;
+    /* Older commits were superseded by this one before reaching the screen */
+    entry->stats.merged += frame_id - entry->first_pending;
+    entry->first_pending = frame_id + 1;
+    entry->stats.presented++;
+    if (feedback->flags & COMPOSITOR_PRESENTATION_ZERO_COPY) {
+        entry->stats.zero_copy++;
+    }
+    
+    /* Commit-to-present latency */
+    uint64_t present_us = feedback->present_us;
+    uint64_t commit_us = entry->commit_us[frame_id & SURFACE_FRAME_MASK];
+    uint64_t latency_us = present_us > commit_us ? present_us - commit_us : 0;
+    entry->stats.last_latency_us = latency_us;
+    entry->stats.last_present_us = present_us;
+    entry->stats.last_refresh_ns = feedback->refresh_ns;
+    entry->stats.last_flags = feedback->flags;
+    
+    /* Forward to metrics collector: latency per surface, pacing per output frame */
+    if (output_frame_begin(&g_paced_frame_us, present_us)) {
+        if (feedback->refresh_ns != 0 && feedback->refresh_ns != g_pacing_refresh_ns) {
+            /* Jank is measured against the refresh the display really runs at */
+            metrics_set_target_frame_rate((uint32_t)((1000000000ULL + feedback->refresh_ns / 2) /
+                                                     feedback->refresh_ns));
+            g_pacing_refresh_ns = feedback->refresh_ns;
+        }
+        metrics_record_frame_presented(present_us, latency_us, false);
     } else {
-        /* Frame not found in tracking - might be dropped or old */
-        dropped = true;
+        metrics_record_frame_us(latency_us, false);
     }
+    metrics_record_surface_frame((uint64_t)(uintptr_t)surface, latency_us, false);
+    
+    /* Trigger input reconciliation for this frame (on the input thread) */
+    (void)compositor_reconcile_input(frame_id);
     
-    /* Forward to metrics collector */
-    extern void metrics_record_frame(uint32_t latency_ms, bool dropped);
-    metrics_record_frame(latency_ms, dropped);
+    /* Only vsync'd presentation marks a vblank the predictor can aim at */
+    uint64_t refresh_us = feedback->flags & COMPOSITOR_PRESENTATION_VSYNC ?
+                          (feedback->refresh_ns + 500) / 1000 : 0;
+    output_frame_tick(present_us, refresh_us);
     
-    /* Trigger input reconciliation for this frame */
-    struct input_proxy *proxy = compositor_get_global_input_proxy();
-    if (proxy) {
-        input_proxy_reconcile(proxy, frame_id, NULL);
+    return 0;
+}
+
+int compositor_notify_frame_presented(struct wl_surface *surface,
+                                     uint64_t frame_id,
+                                     uint64_t timestamp_us) {
+    struct compositor_presentation_feedback feedback = {
+        .present_us = timestamp_us,
+    };
+    return compositor_notify_frame_feedback(surface, frame_id, &feedback);
+}
+
+int compositor_notify_frame_discarded(struct wl_surface *surface, uint64_t frame_id) {
+    struct surface_entry *entry = find_surface_entry(surface);
+    if (!entry) {
+        return -1;
+    }
+    
+    if (frame_id < entry->first_pending || frame_id > entry->frame_id_counter) {
+        return -1;
+    }
+    
+    /* Superseded commits are merged; the newest commit has nothing to merge into */
+    entry->stats.merged += frame_id - entry->first_pending;
+    entry->first_pending = frame_id + 1;
+    if (frame_id == entry->frame_id_counter) {
+        surface_frame_dropped(entry, compositor_now_us());
+    } else {
+        entry->stats.merged++;
     }
     
     return 0;
 }
 
+int compositor_notify_frame_done(struct wl_surface *surface, uint64_t timestamp_us) {
+    struct surface_entry *entry = find_surface_entry(surface);
+    if (!entry) {
+        return -1;
+    }
+    
+    /* Nothing committed since the last frame: still a frame tick for input */
+    if (surface_in_flight(entry) == 0) {
+        output_frame_tick(timestamp_us, 0);
+        return 0;
+    }
+    
+    /* The frame shows the surface's current state, i.e. its newest commit */
+    return compositor_notify_frame_presented(surface, entry->frame_id_counter, timestamp_us);
+}
+
 /* Generate and track new frame ID */
 uint64_t compositor_generate_frame_id(struct wl_surface *surface) {
     struct surface_entry *entry = find_surface_entry(surface);
@@ -149,33 +333,29 @@ uint64_t compositor_generate_frame_id(struct wl_surface *surface) {
         return 0;
     }
     
-    uint64_t frame_id = ++entry->frame_id_counter;
+    uint64_t now_us = compositor_now_us();
     
-    /* Get current timestamp */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t timestamp_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
-    /* Expand frame_timestamps array if needed */
-    if (frame_id >= entry->frame_capacity) {
-        size_t new_capacity = entry->frame_capacity * 2;
-        uint64_t *new_timestamps = realloc(entry->frame_timestamps,
-                                          new_capacity * sizeof(uint64_t));
-        if (new_timestamps) {
-            /* Zero out new entries */
-            memset(new_timestamps + entry->frame_capacity, 0,
-                   (new_capacity - entry->frame_capacity) * sizeof(uint64_t));
-            entry->frame_timestamps = new_timestamps;
-            entry->frame_capacity = new_capacity;
-        }
+    /* A full queue gives up its oldest commit: it will never get feedback here */
+    if (surface_in_flight(entry) == SURFACE_FRAME_RING) {
+        entry->first_pending++;
+        surface_frame_dropped(entry, now_us);
     }
     
-    /* Store frame creation timestamp */
-    if (frame_id < entry->frame_capacity) {
-        entry->frame_timestamps[frame_id] = timestamp_us;
-        entry->frame_count++;
-    }
+    uint64_t frame_id = ++entry->frame_id_counter;
+    entry->commit_us[frame_id & SURFACE_FRAME_MASK] = now_us;
+    entry->stats.committed++;
     
     return frame_id;
 }
 
+int compositor_get_surface_stats(struct wl_surface *surface,
+                                 struct compositor_surface_stats *stats_out) {
+    struct surface_entry *entry = find_surface_entry(surface);
+    if (!entry || !stats_out) {
+        return -1;
+    }
+    
+    *stats_out = entry->stats;
+    stats_out->in_flight = surface_in_flight(entry);
+    return 0;
+}
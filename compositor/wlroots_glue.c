@@ -16,11 +16,15 @@
  */
 
 #ifdef WLR_USE_UNSTABLE
+#include <wlr/backend/libinput.h>
 #include <wlr/types/wlr_input_device.h>
+#include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_pointer.h>
 #include <wlr/types/wlr_keyboard.h>
 #include <wlr/types/wlr_seat.h>
+#include <wlr/types/wlr_touch.h>
 #include <wlr/types/wlr_surface.h>
+#include <wlr/util/addon.h>
 #include <wayland-server.h>
 
 /* wlroots-specific state */
@@ -28,22 +32,158 @@ struct wlroots_state {
     struct wlr_backend *backend;
     struct wlr_seat *seat;
     struct wl_listener new_input_listener;
-    struct wl_listener pointer_motion_listener;
-    struct wl_listener pointer_button_listener;
-    struct wl_listener pointer_axis_listener;
-    struct wl_listener surface_commit_listener;
-    struct wl_listener surface_frame_listener;
+    struct wl_list devices;         /* struct wlroots_device::link */
+    struct wl_list free_devices;    /* Unused pool blocks (struct wlroots_device::link) */
+    struct wl_list device_chunks;   /* struct wlroots_device_chunk::link */
+    struct wl_list surfaces;    /* struct wlroots_surface::link */
+    struct wl_list outputs;     /* struct wlroots_output::link */
+};
+
+/*
+ * Per-device listeners. A wl_listener can be on one signal only, so
+ * every device gets its own block; which union member is live depends
+ * on the device type.
+ */
+struct wlroots_device {
+    struct wlr_input_device *device;
+    enum wlr_input_device_type type;
+    struct wl_listener destroy_listener;
+    union {
+        struct {
+            struct wl_listener motion;
+            struct wl_listener motion_absolute;
+            struct wl_listener button;
+            struct wl_listener axis;
+        } pointer;
+        struct {
+            struct wl_listener key;
+        } keyboard;
+        struct {
+            struct wl_listener down;
+            struct wl_listener up;
+            struct wl_listener motion;
+            struct wl_listener cancel;
+        } touch;
+    };
+    struct wl_list link;
+};
+
+/* Device blocks are allocated in chunks and recycled through a free list */
+#define WLROOTS_DEVICE_CHUNK 16
+
+struct wlroots_device_chunk {
+    struct wl_list link;
+    struct wlroots_device devices[WLROOTS_DEVICE_CHUNK];
+};
+
+/* Per-output presentation listeners */
+struct wlroots_output {
+    struct wlr_output *output;
+    struct wl_listener present_listener;
+    struct wl_listener destroy_listener;
+    struct wl_list sampled;     /* struct wlroots_surface::sampled_link */
+    struct wl_list link;
+};
+
+/*
+ * Per-surface state, attached to the wlr_surface as an addon so it is
+ * found in O(1) and torn down with the surface. Commits must reach the
+ * surface's own in-flight queue.
+ */
+struct wlroots_surface {
+    struct wlr_surface *surface;
+    struct wlr_addon addon;
+    struct wl_listener commit_listener;
+    struct wl_list link;
+    uint64_t last_frame_id;                 /* Newest commit */
+    struct wlroots_output *sampled_output;  /* Rendered there, awaiting present (NULL = none) */
+    uint64_t sampled_frame_id;
+    struct wl_list sampled_link;
 };
 
 static struct wlroots_state *g_wlroots_state = NULL;
 
 /* Forward declarations */
 static void handle_new_input(struct wl_listener *listener, void *data);
+static void handle_device_destroy(struct wl_listener *listener, void *data);
 static void handle_pointer_motion(struct wl_listener *listener, void *data);
+static void handle_pointer_motion_absolute(struct wl_listener *listener, void *data);
 static void handle_pointer_button(struct wl_listener *listener, void *data);
 static void handle_pointer_axis(struct wl_listener *listener, void *data);
+static void handle_keyboard_key(struct wl_listener *listener, void *data);
+static void handle_touch_down(struct wl_listener *listener, void *data);
+static void handle_touch_up(struct wl_listener *listener, void *data);
+static void handle_touch_motion(struct wl_listener *listener, void *data);
+static void handle_touch_cancel(struct wl_listener *listener, void *data);
 static void handle_surface_commit(struct wl_listener *listener, void *data);
+static void handle_surface_addon_destroy(struct wlr_addon *addon);
 static void handle_surface_frame_done(void *data);
+static void handle_output_present(struct wl_listener *listener, void *data);
+static void handle_output_destroy(struct wl_listener *listener, void *data);
+
+static const struct wlr_addon_interface wlroots_surface_addon_impl = {
+    .name = "lunar_telescope_surface",
+    .destroy = handle_surface_addon_destroy,
+};
+
+/* Stop tracking a surface and free its state */
+static void wlroots_surface_destroy(struct wlroots_surface *ws) {
+    compositor_unregister_surface((struct wl_surface *)ws->surface);
+    if (ws->sampled_output) {
+        wl_list_remove(&ws->sampled_link);
+    }
+    wl_list_remove(&ws->commit_listener.link);
+    wl_list_remove(&ws->link);
+    wlr_addon_finish(&ws->addon);
+    free(ws);
+}
+
+/* Take a device block from the pool, growing it by a chunk when empty */
+static struct wlroots_device *wlroots_device_alloc(void) {
+    if (wl_list_empty(&g_wlroots_state->free_devices)) {
+        struct wlroots_device_chunk *chunk = calloc(1, sizeof(struct wlroots_device_chunk));
+        if (!chunk) {
+            return NULL;
+        }
+        wl_list_insert(&g_wlroots_state->device_chunks, &chunk->link);
+        for (size_t i = 0; i < WLROOTS_DEVICE_CHUNK; i++) {
+            wl_list_insert(&g_wlroots_state->free_devices, &chunk->devices[i].link);
+        }
+    }
+    
+    struct wlroots_device *wd = wl_container_of(g_wlroots_state->free_devices.next, wd, link);
+    wl_list_remove(&wd->link);
+    memset(wd, 0, sizeof(*wd));
+    return wd;
+}
+
+/* Stop listening to a device, unregister it and return its block to the pool */
+static void wlroots_device_destroy(struct wlroots_device *wd) {
+    switch (wd->type) {
+        case WLR_INPUT_DEVICE_POINTER:
+            wl_list_remove(&wd->pointer.motion.link);
+            wl_list_remove(&wd->pointer.motion_absolute.link);
+            wl_list_remove(&wd->pointer.button.link);
+            wl_list_remove(&wd->pointer.axis.link);
+            break;
+        case WLR_INPUT_DEVICE_KEYBOARD:
+            wl_list_remove(&wd->keyboard.key.link);
+            break;
+        case WLR_INPUT_DEVICE_TOUCH:
+            wl_list_remove(&wd->touch.down.link);
+            wl_list_remove(&wd->touch.up.link);
+            wl_list_remove(&wd->touch.motion.link);
+            wl_list_remove(&wd->touch.cancel.link);
+            break;
+        default:
+            break;
+    }
+    wl_list_remove(&wd->destroy_listener.link);
+    compositor_unregister_input_device((struct wl_input_device *)wd->device);
+    
+    wl_list_remove(&wd->link);
+    wl_list_insert(&g_wlroots_state->free_devices, &wd->link);
+}
 
 /**
  * Initialize wlroots integration
@@ -64,6 +204,11 @@ int compositor_wlroots_init(void *backend, void *seat) {
     
     g_wlroots_state->backend = (struct wlr_backend *)backend;
     g_wlroots_state->seat = (struct wlr_seat *)seat;
+    wl_list_init(&g_wlroots_state->devices);
+    wl_list_init(&g_wlroots_state->free_devices);
+    wl_list_init(&g_wlroots_state->device_chunks);
+    wl_list_init(&g_wlroots_state->surfaces);
+    wl_list_init(&g_wlroots_state->outputs);
     
     if (g_wlroots_state->backend) {
         /* Register for new input devices */
@@ -88,6 +233,28 @@ void compositor_wlroots_cleanup(void) {
         wl_list_remove(&g_wlroots_state->new_input_listener.link);
     }
     
+    struct wlroots_device *wd, *wd_tmp;
+    wl_list_for_each_safe(wd, wd_tmp, &g_wlroots_state->devices, link) {
+        wlroots_device_destroy(wd);
+    }
+    struct wlroots_device_chunk *chunk, *chunk_tmp;
+    wl_list_for_each_safe(chunk, chunk_tmp, &g_wlroots_state->device_chunks, link) {
+        free(chunk);
+    }
+    
+    struct wlroots_surface *ws, *tmp;
+    wl_list_for_each_safe(ws, tmp, &g_wlroots_state->surfaces, link) {
+        wlroots_surface_destroy(ws);
+    }
+    
+    struct wlroots_output *wo, *wo_tmp;
+    wl_list_for_each_safe(wo, wo_tmp, &g_wlroots_state->outputs, link) {
+        wl_list_remove(&wo->present_listener.link);
+        wl_list_remove(&wo->destroy_listener.link);
+        wl_list_remove(&wo->link);
+        free(wo);
+    }
+    
     free(g_wlroots_state);
     g_wlroots_state = NULL;
 }
@@ -102,7 +269,13 @@ static void handle_new_input(struct wl_listener *listener, void *data) {
     /* Map wlroots device type to compositor type */
     switch (device->type) {
         case WLR_INPUT_DEVICE_POINTER:
+            /* Touchpads report as pointers; libinput knows which have taps */
             type = COMPOSITOR_INPUT_POINTER;
+            if (wlr_input_device_is_libinput(device) &&
+                libinput_device_config_tap_get_finger_count(
+                    wlr_libinput_get_device_handle(device)) > 0) {
+                type = COMPOSITOR_INPUT_TOUCHPAD;
+            }
             break;
         case WLR_INPUT_DEVICE_KEYBOARD:
             type = COMPOSITOR_INPUT_KEYBOARD;
@@ -111,47 +284,123 @@ static void handle_new_input(struct wl_listener *listener, void *data) {
             type = COMPOSITOR_INPUT_TOUCHSCREEN;
             break;
         case WLR_INPUT_DEVICE_TABLET_TOOL:
-            type = COMPOSITOR_INPUT_TOUCHPAD;
+            type = COMPOSITOR_INPUT_TABLET;
             break;
         default:
             return;  /* Unknown device type */
     }
     
-    /* Register device with compositor framework */
-    compositor_register_input_device((struct wl_input_device *)device, type);
+    struct wlroots_device *wd = wlroots_device_alloc();
+    if (!wd) {
+        return;  /* Out of memory: the device's input is not intercepted */
+    }
+    wd->device = device;
+    wd->type = device->type;
+    
+    /* Register device with compositor framework (own proxy per device) */
+    if (compositor_register_seat_input_device((struct wl_seat *)g_wlroots_state->seat,
+                                              (struct wl_input_device *)device, type) < 0) {
+        wl_list_insert(&g_wlroots_state->free_devices, &wd->link);
+        return;
+    }
     
-    /* Set up device-specific listeners */
+    /* Each device has its own listeners, so every device's events arrive */
     if (device->type == WLR_INPUT_DEVICE_POINTER) {
         struct wlr_pointer *pointer = wlr_pointer_from_input_device(device);
         
         /* Motion events */
-        g_wlroots_state->pointer_motion_listener.notify = handle_pointer_motion;
-        wl_signal_add(&pointer->events.motion, &g_wlroots_state->pointer_motion_listener);
+        wd->pointer.motion.notify = handle_pointer_motion;
+        wl_signal_add(&pointer->events.motion, &wd->pointer.motion);
+        wd->pointer.motion_absolute.notify = handle_pointer_motion_absolute;
+        wl_signal_add(&pointer->events.motion_absolute, &wd->pointer.motion_absolute);
         
         /* Button events */
-        g_wlroots_state->pointer_button_listener.notify = handle_pointer_button;
-        wl_signal_add(&pointer->events.button, &g_wlroots_state->pointer_button_listener);
+        wd->pointer.button.notify = handle_pointer_button;
+        wl_signal_add(&pointer->events.button, &wd->pointer.button);
         
         /* Scroll events */
-        g_wlroots_state->pointer_axis_listener.notify = handle_pointer_axis;
-        wl_signal_add(&pointer->events.axis, &g_wlroots_state->pointer_axis_listener);
+        wd->pointer.axis.notify = handle_pointer_axis;
+        wl_signal_add(&pointer->events.axis, &wd->pointer.axis);
+    } else if (device->type == WLR_INPUT_DEVICE_KEYBOARD) {
+        struct wlr_keyboard *keyboard = wlr_keyboard_from_input_device(device);
+        
+        wd->keyboard.key.notify = handle_keyboard_key;
+        wl_signal_add(&keyboard->events.key, &wd->keyboard.key);
+    } else if (device->type == WLR_INPUT_DEVICE_TOUCH) {
+        struct wlr_touch *touch = wlr_touch_from_input_device(device);
+        
+        wd->touch.down.notify = handle_touch_down;
+        wl_signal_add(&touch->events.down, &wd->touch.down);
+        wd->touch.up.notify = handle_touch_up;
+        wl_signal_add(&touch->events.up, &wd->touch.up);
+        wd->touch.motion.notify = handle_touch_motion;
+        wl_signal_add(&touch->events.motion, &wd->touch.motion);
+        wd->touch.cancel.notify = handle_touch_cancel;
+        wl_signal_add(&touch->events.cancel, &wd->touch.cancel);
+    }
+    /* Tablet tool events are not intercepted yet; the block only tracks the device's lifetime */
+    
+    /* Unplugged devices release their listeners and pipeline */
+    wd->destroy_listener.notify = handle_device_destroy;
+    wl_signal_add(&device->events.destroy, &wd->destroy_listener);
+    wl_list_insert(&g_wlroots_state->devices, &wd->link);
+}
+
+/**
+ * Handle input device destroy (device unplugged)
+ */
+static void handle_device_destroy(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, destroy_listener);
+    (void)data;
+    
+    wlroots_device_destroy(wd);
+}
+
+/*
+ * wlroots stamps input with 32-bit CLOCK_MONOTONIC milliseconds; widen
+ * them against the compositor clock (a monotonic clock outside replays,
+ * read once per iteration) so the pipeline predicts from device time.
+ */
+static uint64_t glue_event_time_us(uint32_t time_msec) {
+    uint64_t now_ms = compositor_now_us() / 1000;
+    uint64_t time_ms = (now_ms & ~(uint64_t)UINT32_MAX) | time_msec;
+    if (time_ms > now_ms && time_ms > UINT32_MAX) {
+        time_ms -= (uint64_t)UINT32_MAX + 1;  /* Stamped before the low word wrapped */
     }
+    return time_ms * 1000;
 }
 
 /**
  * Handle pointer motion from wlroots
  */
 static void handle_pointer_motion(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, pointer.motion);
     struct wlr_pointer_motion_event *event = (struct wlr_pointer_motion_event *)data;
-    struct wlr_input_device *device = event->pointer->base;
     
     /* Convert to compositor format and intercept */
     compositor_intercept_pointer_motion(
-        (struct wl_input_device *)device,
+        (struct wl_input_device *)wd->device,
         event->delta_x,
         event->delta_y,
         false,  /* Relative motion */
-        0.0, 0.0
+        0.0, 0.0,
+        glue_event_time_us(event->time_msec)
+    );
+}
+
+/**
+ * Handle absolute pointer motion from wlroots (tablets in mouse mode, VMs)
+ */
+static void handle_pointer_motion_absolute(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, pointer.motion_absolute);
+    struct wlr_pointer_motion_absolute_event *event = (struct wlr_pointer_motion_absolute_event *)data;
+    
+    compositor_intercept_pointer_motion(
+        (struct wl_input_device *)wd->device,
+        0.0, 0.0,
+        true,   /* Absolute, normalized to the output layout */
+        event->x, event->y,
+        glue_event_time_us(event->time_msec)
     );
 }
 
@@ -159,13 +408,14 @@ static void handle_pointer_motion(struct wl_listener *listener, void *data) {
  * Handle pointer button from wlroots
  */
 static void handle_pointer_button(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, pointer.button);
     struct wlr_pointer_button_event *event = (struct wlr_pointer_button_event *)data;
-    struct wlr_input_device *device = event->pointer->base;
     
     compositor_intercept_button(
-        (struct wl_input_device *)device,
+        (struct wl_input_device *)wd->device,
         event->button,
-        event->state == WLR_BUTTON_PRESSED
+        event->state == WLR_BUTTON_PRESSED,
+        glue_event_time_us(event->time_msec)
     );
 }
 
@@ -173,8 +423,8 @@ static void handle_pointer_button(struct wl_listener *listener, void *data) {
  * Handle pointer axis (scroll) from wlroots
  */
 static void handle_pointer_axis(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, pointer.axis);
     struct wlr_pointer_axis_event *event = (struct wlr_pointer_axis_event *)data;
-    struct wlr_input_device *device = event->pointer->base;
     
     double dx = 0.0, dy = 0.0;
     bool discrete = false;
@@ -192,50 +442,134 @@ static void handle_pointer_axis(struct wl_listener *listener, void *data) {
     }
     
     compositor_intercept_scroll(
-        (struct wl_input_device *)device,
+        (struct wl_input_device *)wd->device,
         dx, dy,
-        discrete
+        discrete,
+        glue_event_time_us(event->time_msec)
     );
 }
 
+/**
+ * Handle keyboard key from wlroots
+ */
+static void handle_keyboard_key(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, keyboard.key);
+    struct wlr_keyboard_key_event *event = (struct wlr_keyboard_key_event *)data;
+    
+    compositor_intercept_key(
+        (struct wl_input_device *)wd->device,
+        event->keycode,
+        event->state == WL_KEYBOARD_KEY_STATE_PRESSED,
+        glue_event_time_us(event->time_msec)
+    );
+}
+
+/**
+ * Handle touch down from wlroots
+ */
+static void handle_touch_down(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, touch.down);
+    struct wlr_touch_down_event *event = (struct wlr_touch_down_event *)data;
+    
+    compositor_intercept_touch((struct wl_input_device *)wd->device,
+                               (uint32_t)event->touch_id, event->x, event->y, true,
+                               glue_event_time_us(event->time_msec));
+}
+
+/**
+ * Handle touch up from wlroots
+ */
+static void handle_touch_up(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, touch.up);
+    struct wlr_touch_up_event *event = (struct wlr_touch_up_event *)data;
+    
+    compositor_intercept_touch((struct wl_input_device *)wd->device,
+                               (uint32_t)event->touch_id, 0.0, 0.0, false,
+                               glue_event_time_us(event->time_msec));
+}
+
+/**
+ * Handle touch motion from wlroots
+ */
+static void handle_touch_motion(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, touch.motion);
+    struct wlr_touch_motion_event *event = (struct wlr_touch_motion_event *)data;
+    
+    compositor_intercept_touch((struct wl_input_device *)wd->device,
+                               (uint32_t)event->touch_id, event->x, event->y, true,
+                               glue_event_time_us(event->time_msec));
+}
+
+/**
+ * Handle touch cancel from wlroots (the point is gone, like touch up)
+ */
+static void handle_touch_cancel(struct wl_listener *listener, void *data) {
+    struct wlroots_device *wd = wl_container_of(listener, wd, touch.cancel);
+    struct wlr_touch_cancel_event *event = (struct wlr_touch_cancel_event *)data;
+    
+    compositor_intercept_touch((struct wl_input_device *)wd->device,
+                               (uint32_t)event->touch_id, 0.0, 0.0, false,
+                               glue_event_time_us(event->time_msec));
+}
+
 /**
  * Register wlroots surface for frame tracking
  */
 int compositor_wlroots_register_surface(void *wlr_surface) {
     struct wlr_surface *surface = (struct wlr_surface *)wlr_surface;
     
+    /* Already tracked: a second addon with the same owner would trip wlroots */
+    if (g_wlroots_state &&
+        wlr_addon_find(&surface->addons, g_wlroots_state, &wlroots_surface_addon_impl)) {
+        return 0;
+    }
+    
     /* Register with compositor framework */
     int ret = compositor_register_surface((struct wl_surface *)surface);
     if (ret < 0) {
         return ret;
     }
     
-    /* Set up frame callback */
-    struct wlr_surface_state *state = &surface->current;
-    
     /* Frame done callback */
     wlr_surface_set_frame_done_callback(surface, handle_surface_frame_done, surface);
     
-    /* Commit listener for frame ID generation */
+    /* Commit listener for frame ID generation, one per surface */
     if (g_wlroots_state) {
-        g_wlroots_state->surface_commit_listener.notify = handle_surface_commit;
-        wl_signal_add(&surface->events.commit, &g_wlroots_state->surface_commit_listener);
+        struct wlroots_surface *ws = calloc(1, sizeof(struct wlroots_surface));
+        if (!ws) {
+            compositor_unregister_surface((struct wl_surface *)surface);
+            return -ENOMEM;
+        }
+        ws->surface = surface;
+        wlr_addon_init(&ws->addon, &surface->addons, g_wlroots_state, &wlroots_surface_addon_impl);
+        ws->commit_listener.notify = handle_surface_commit;
+        wl_signal_add(&surface->events.commit, &ws->commit_listener);
+        wl_list_insert(&g_wlroots_state->surfaces, &ws->link);
     }
     
     return 0;
 }
 
 /**
- * Handle surface commit (generate frame ID)
+ * Handle surface commit (queue a frame ID)
  */
 static void handle_surface_commit(struct wl_listener *listener, void *data) {
-    struct wlr_surface *surface = (struct wlr_surface *)data;
-    
-    /* Generate frame ID on commit */
-    uint64_t frame_id = compositor_generate_frame_id((struct wl_surface *)surface);
+    struct wlroots_surface *ws = wl_container_of(listener, ws, commit_listener);
+    (void)data;
     
-    /* Frame ID is now tracked for this surface */
-    (void)frame_id;  /* Used by reconciliation system */
+    /* The ID and commit time wait in the surface's in-flight queue */
+    uint64_t frame_id = compositor_generate_frame_id((struct wl_surface *)ws->surface);
+    if (frame_id != 0) {
+        ws->last_frame_id = frame_id;
+    }
+}
+
+/**
+ * Handle surface destroy (addons are destroyed with the surface)
+ */
+static void handle_surface_addon_destroy(struct wlr_addon *addon) {
+    struct wlroots_surface *ws = wl_container_of(addon, ws, addon);
+    wlroots_surface_destroy(ws);
 }
 
 /**
@@ -244,28 +578,133 @@ static void handle_surface_commit(struct wl_listener *listener, void *data) {
 static void handle_surface_frame_done(void *data) {
     struct wlr_surface *surface = (struct wlr_surface *)data;
     
-    /* Get current time */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t timestamp_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
-    /* Get frame ID from surface tracking */
-    /* compositor_generate_frame_id() was called on commit */
-    /* We need to track the last frame ID per surface - for now use simple approach */
-    /* In production, would maintain frame_id -> surface mapping */
-    extern uint64_t compositor_generate_frame_id(struct wl_surface *);
-    uint64_t frame_id = compositor_generate_frame_id((struct wl_surface *)surface);
-    if (frame_id == 0) {
-        /* Fallback: use simple counter if frame ID generation failed */
-        static uint64_t frame_counter = 1;
-        frame_id = frame_counter++;
-    }
-    
-    compositor_notify_frame_presented(
-        (struct wl_surface *)surface,
-        frame_id,
-        timestamp_us
-    );
+    /* With presentation feedback, frame done only means the client may draw again */
+    if (g_wlroots_state && !wl_list_empty(&g_wlroots_state->outputs)) {
+        return;
+    }
+    
+    /* Presents the newest commit and merges older ones still in flight */
+    (void)compositor_notify_frame_done((struct wl_surface *)surface, compositor_now_us());
+}
+
+/**
+ * Register a wlroots output for presentation feedback
+ *
+ * Once an output is registered, frames are accounted when the output
+ * reports them presented (wp_presentation semantics) instead of at
+ * frame done; the compositor reports what it rendered with
+ * compositor_wlroots_surface_sampled(). Presentation timestamps must
+ * be on the compositor clock (CLOCK_MONOTONIC unless a clock was set).
+ */
+int compositor_wlroots_register_output(void *wlr_output) {
+    struct wlr_output *output = (struct wlr_output *)wlr_output;
+    if (!g_wlroots_state || !output) {
+        return -EINVAL;
+    }
+    
+    struct wlroots_output *wo = calloc(1, sizeof(struct wlroots_output));
+    if (!wo) {
+        return -ENOMEM;
+    }
+    
+    wo->output = output;
+    wl_list_init(&wo->sampled);
+    wo->present_listener.notify = handle_output_present;
+    wl_signal_add(&output->events.present, &wo->present_listener);
+    wo->destroy_listener.notify = handle_output_destroy;
+    wl_signal_add(&output->events.destroy, &wo->destroy_listener);
+    wl_list_insert(&g_wlroots_state->outputs, &wo->link);
+    return 0;
+}
+
+/**
+ * Record that a surface's current state was rendered on an output
+ *
+ * Call where wlr_presentation_surface_sampled_on_output() would be
+ * called: the newest commit is presented with the output's next
+ * present event.
+ */
+void compositor_wlroots_surface_sampled(void *wlr_surface, void *wlr_output) {
+    struct wlr_surface *surface = (struct wlr_surface *)wlr_surface;
+    if (!g_wlroots_state || !surface) {
+        return;
+    }
+    
+    struct wlr_addon *addon = wlr_addon_find(&surface->addons, g_wlroots_state,
+                                             &wlroots_surface_addon_impl);
+    if (!addon) {
+        return;
+    }
+    struct wlroots_surface *ws = wl_container_of(addon, ws, addon);
+    
+    struct wlroots_output *wo, *found = NULL;
+    wl_list_for_each(wo, &g_wlroots_state->outputs, link) {
+        if (wo->output == (struct wlr_output *)wlr_output) {
+            found = wo;
+            break;
+        }
+    }
+    if (!found || ws->last_frame_id == 0) {
+        return;
+    }
+    
+    /* Rendered again before the present: the newer commit supersedes the older one */
+    if (ws->sampled_output) {
+        wl_list_remove(&ws->sampled_link);
+    }
+    ws->sampled_output = found;
+    ws->sampled_frame_id = ws->last_frame_id;
+    wl_list_insert(&found->sampled, &ws->sampled_link);
+}
+
+/**
+ * Handle output present (presentation feedback for every sampled surface)
+ */
+static void handle_output_present(struct wl_listener *listener, void *data) {
+    struct wlroots_output *wo = wl_container_of(listener, wo, present_listener);
+    struct wlr_output_event_present *event = (struct wlr_output_event_present *)data;
+    
+    struct compositor_presentation_feedback feedback = {
+        .present_us = event->when ? (uint64_t)event->when->tv_sec * 1000000ULL +
+                                    (uint64_t)event->when->tv_nsec / 1000 : compositor_now_us(),
+        .refresh_ns = event->refresh > 0 ? (uint64_t)event->refresh : 0,
+        .msc = event->seq,
+        .flags = event->flags,  /* wlr_output_present_flag uses the protocol's kind bits */
+    };
+    
+    struct wlroots_surface *ws, *tmp;
+    wl_list_for_each_safe(ws, tmp, &wo->sampled, sampled_link) {
+        struct wl_surface *surface = (struct wl_surface *)ws->surface;
+        if (event->presented) {
+            (void)compositor_notify_frame_feedback(surface, ws->sampled_frame_id, &feedback);
+        } else {
+            (void)compositor_notify_frame_discarded(surface, ws->sampled_frame_id);
+        }
+        wl_list_remove(&ws->sampled_link);
+        ws->sampled_output = NULL;
+        ws->sampled_frame_id = 0;
+    }
+}
+
+/**
+ * Handle output destroy (stop listening)
+ */
+static void handle_output_destroy(struct wl_listener *listener, void *data) {
+    struct wlroots_output *wo = wl_container_of(listener, wo, destroy_listener);
+    (void)data;
+    
+    /* Surfaces sampled there never get feedback; their commits stay in flight */
+    struct wlroots_surface *ws, *tmp;
+    wl_list_for_each_safe(ws, tmp, &wo->sampled, sampled_link) {
+        wl_list_remove(&ws->sampled_link);
+        ws->sampled_output = NULL;
+        ws->sampled_frame_id = 0;
+    }
+    
+    wl_list_remove(&wo->present_listener.link);
+    wl_list_remove(&wo->destroy_listener.link);
+    wl_list_remove(&wo->link);
+    free(wo);
 }
 
 #else /* WLR_USE_UNSTABLE not defined */
@@ -287,5 +726,15 @@ int compositor_wlroots_register_surface(void *wlr_surface) {
     return -ENOTSUP;  /* wlroots not available */
 }
 
+int compositor_wlroots_register_output(void *wlr_output) {
+    (void)wlr_output;
+    return -ENOTSUP;  /* wlroots not available */
+}
+
+void compositor_wlroots_surface_sampled(void *wlr_surface, void *wlr_output) {
+    (void)wlr_surface;
+    (void)wlr_output;
+}
+
 #endif /* WLR_USE_UNSTABLE */
 
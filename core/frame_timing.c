@@ -0,0 +1,117 @@
+#include "frame_timing.h"
+#include <string.h>
+#include <errno.h>
+
+/**
+ * Frame timing implementation
+ *
+ * Recording is O(1): the window sum is maintained incrementally so the
+ * adaptive jank threshold needs no scan. Variance and the longest stall
+ * are computed by a pass over the window when statistics are requested.
+ */
+
+static uint64_t frame_timing_threshold_us(const struct frame_timing *ft) {
+    uint64_t reference = ft->target_interval_us;
+    if (reference == 0 && ft->count > 0) {
+        reference = ft->window_sum_us / ft->count;
+    }
+    return (uint64_t)((double)reference * FRAME_TIMING_JANK_FACTOR);
+}
+
+void frame_timing_init(struct frame_timing *ft, uint32_t target_fps) {
+    if (!ft) {
+        return;
+    }
+
+    memset(ft, 0, sizeof(*ft));
+    frame_timing_set_target(ft, target_fps);
+}
+
+void frame_timing_set_target(struct frame_timing *ft, uint32_t target_fps) {
+    if (!ft) {
+        return;
+    }
+
+    ft->target_interval_us = target_fps > 0 ? 1000000ULL / target_fps : 0;
+}
+
+void frame_timing_reset(struct frame_timing *ft) {
+    if (!ft) {
+        return;
+    }
+
+    uint64_t target = ft->target_interval_us;
+    memset(ft, 0, sizeof(*ft));
+    ft->target_interval_us = target;
+}
+
+int frame_timing_record(struct frame_timing *ft, uint64_t present_us) {
+    if (!ft) {
+        return -EINVAL;
+    }
+
+    if (ft->last_present_us == 0) {
+        ft->last_present_us = present_us;
+        return 0;
+    }
+
+    if (present_us <= ft->last_present_us) {
+        return -EINVAL;
+    }
+
+    uint64_t interval_us = present_us - ft->last_present_us;
+    ft->last_present_us = present_us;
+
+    /* Judge against the window before this interval joins it */
+    uint64_t threshold = frame_timing_threshold_us(ft);
+    if (threshold > 0 && interval_us > threshold) {
+        ft->jank_total++;
+    }
+
+    if (ft->count == FRAME_TIMING_WINDOW) {
+        ft->window_sum_us -= ft->intervals_us[ft->head];
+    } else {
+        ft->count++;
+    }
+    ft->intervals_us[ft->head] = interval_us;
+    ft->window_sum_us += interval_us;
+    ft->head = (ft->head + 1) % FRAME_TIMING_WINDOW;
+
+    return 0;
+}
+
+void frame_timing_stats(const struct frame_timing *ft, struct frame_timing_stats *stats_out) {
+    if (!stats_out) {
+        return;
+    }
+
+    memset(stats_out, 0, sizeof(*stats_out));
+    if (!ft || ft->count == 0) {
+        return;
+    }
+
+    double mean = (double)ft->window_sum_us / (double)ft->count;
+    uint64_t threshold = frame_timing_threshold_us(ft);
+    double sq_sum = 0.0;
+
+    for (size_t i = 0; i < ft->count; i++) {
+        uint64_t interval_us = ft->intervals_us[i];
+        double d = (double)interval_us - mean;
+        sq_sum += d * d;
+
+        if (interval_us > stats_out->longest_stall_us) {
+            stats_out->longest_stall_us = interval_us;
+        }
+        if (threshold > 0 && interval_us > threshold) {
+            stats_out->jank_count++;
+        }
+    }
+
+    stats_out->frames = ft->count;
+    stats_out->mean_frame_time_us = mean;
+    stats_out->mean_fps = mean > 0.0 ? 1e6 / mean : 0.0;
+    stats_out->frame_time_variance_us2 = sq_sum / (double)ft->count;
+    stats_out->jank_total = ft->jank_total;
+    stats_out->target_interval_us = ft->target_interval_us > 0 ?
+                                    ft->target_interval_us : (uint64_t)mean;
+}
@@ -0,0 +1,89 @@
+#ifndef FRAME_TIMING_H
+#define FRAME_TIMING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Windowed frame pacing statistics
+ *
+ * Keeps the last FRAME_TIMING_WINDOW inter-frame intervals derived from
+ * caller-supplied presentation timestamps; the clock is never read here.
+ * A frame is counted as jank when its interval exceeds
+ * FRAME_TIMING_JANK_FACTOR times the target interval (or the window mean
+ * when no target frame rate is configured).
+ *
+ * Not thread-safe: one thread records, or callers serialize access.
+ */
+
+#define FRAME_TIMING_WINDOW 128
+#define FRAME_TIMING_JANK_FACTOR 1.5
+
+struct frame_timing {
+    uint64_t intervals_us[FRAME_TIMING_WINDOW];
+    size_t head;              /* Next slot to write */
+    size_t count;             /* Valid intervals in the window */
+    uint64_t window_sum_us;   /* Sum of the valid intervals */
+    uint64_t last_present_us;
+    uint64_t target_interval_us;  /* 0 = adaptive */
+    uint64_t jank_total;      /* Since init/reset */
+};
+
+struct frame_timing_stats {
+    size_t frames;                  /* Intervals in the window */
+    double mean_fps;
+    double mean_frame_time_us;
+    double frame_time_variance_us2;
+    uint32_t jank_count;            /* Janky intervals in the window */
+    uint64_t jank_total;            /* Janky intervals since init/reset */
+    uint64_t longest_stall_us;      /* Longest interval in the window */
+    uint64_t target_interval_us;    /* Interval jank is measured against */
+};
+
+/**
+ * Initialize frame timing
+ *
+ * @param ft Frame timing state
+ * @param target_fps Target frame rate (0 = adaptive)
+ */
+void frame_timing_init(struct frame_timing *ft, uint32_t target_fps);
+
+/**
+ * Change the target frame rate without discarding the window
+ *
+ * @param ft Frame timing state
+ * @param target_fps Target frame rate (0 = adaptive)
+ */
+void frame_timing_set_target(struct frame_timing *ft, uint32_t target_fps);
+
+/**
+ * Discard all recorded frames (the target is kept)
+ */
+void frame_timing_reset(struct frame_timing *ft);
+
+/**
+ * Record a frame presentation
+ *
+ * @param ft Frame timing state
+ * @param present_us Presentation timestamp in microseconds (monotonic)
+ * @return 0 on success, -EINVAL if the timestamp does not advance
+ */
+int frame_timing_record(struct frame_timing *ft, uint64_t present_us);
+
+/**
+ * Compute statistics over the current window
+ *
+ * @param ft Frame timing state
+ * @param stats_out Output statistics (all zero when fewer than two frames were recorded)
+ */
+void frame_timing_stats(const struct frame_timing *ft, struct frame_timing_stats *stats_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_TIMING_H */
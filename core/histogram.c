@@ -0,0 +1,119 @@
+#include "histogram.h"
+#include <string.h>
+
+/**
+ * Log-linear latency histogram implementation
+ */
+
+uint32_t histogram_bucket_index(uint64_t value_us) {
+    if (value_us > HISTOGRAM_MAX_US) {
+        value_us = HISTOGRAM_MAX_US;
+    }
+
+    if (value_us < HISTOGRAM_SUB_BUCKETS) {
+        return (uint32_t)value_us;  /* Exact region */
+    }
+
+    /* msb >= SUB_BUCKET_BITS; keep the top SUB_BUCKET_BITS+1 bits */
+    uint32_t msb = 63 - (uint32_t)__builtin_clzll(value_us);
+    uint32_t shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+    uint32_t sub = (uint32_t)(value_us >> shift) - HISTOGRAM_SUB_BUCKETS;
+
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+uint64_t histogram_bucket_upper_us(uint32_t index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+
+    uint32_t shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    uint64_t sub = index % HISTOGRAM_SUB_BUCKETS;
+    uint64_t lower = (HISTOGRAM_SUB_BUCKETS + sub) << shift;
+
+    return lower + (1ULL << shift) - 1;
+}
+
+void histogram_reset(struct histogram *hist) {
+    if (!hist) {
+        return;
+    }
+    memset(hist, 0, sizeof(*hist));
+}
+
+void histogram_record(struct histogram *hist, uint64_t value_us) {
+    if (!hist) {
+        return;
+    }
+    hist->counts[histogram_bucket_index(value_us)]++;
+    hist->total_count++;
+}
+
+void histogram_merge(struct histogram *dst, const struct histogram *src) {
+    if (!dst || !src) {
+        return;
+    }
+    for (uint32_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total_count += src->total_count;
+}
+
+/* Rank (1-based) of the sample at a quantile */
+static uint64_t quantile_rank(uint64_t total, double quantile) {
+    if (quantile <= 0.0) {
+        return 1;
+    }
+    if (quantile >= 1.0) {
+        return total;
+    }
+    uint64_t rank = (uint64_t)(quantile * (double)total + 0.5);
+    return rank > 0 ? rank : 1;
+}
+
+uint64_t histogram_percentile(const struct histogram *hist, double quantile) {
+    if (!hist || hist->total_count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = quantile_rank(hist->total_count, quantile);
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            return histogram_bucket_upper_us(i);
+        }
+    }
+
+    return HISTOGRAM_MAX_US;
+}
+
+void histogram_percentiles(const struct histogram *hist,
+                           telescope_latency_percentiles_t *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+
+    if (!hist || hist->total_count == 0) {
+        return;
+    }
+
+    static const double quantiles[4] = {0.50, 0.95, 0.99, 0.999};
+    uint32_t *fields[4] = {&out->p50_us, &out->p95_us, &out->p99_us, &out->p999_us};
+    uint64_t ranks[4];
+    for (int q = 0; q < 4; q++) {
+        ranks[q] = quantile_rank(hist->total_count, quantiles[q]);
+    }
+
+    uint64_t seen = 0;
+    int q = 0;
+    for (uint32_t i = 0; i < HISTOGRAM_BUCKETS && q < 4; i++) {
+        seen += hist->counts[i];
+        while (q < 4 && seen >= ranks[q]) {
+            *fields[q] = (uint32_t)histogram_bucket_upper_us(i);
+            q++;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telescope.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Log-linear latency histogram (HDR-style)
+ *
+ * Values are microseconds. The first 2^SUB_BUCKET_BITS values are
+ * recorded exactly; above that each power of two is split into
+ * 2^SUB_BUCKET_BITS linear sub-buckets, bounding the relative error to
+ * 1/2^SUB_BUCKET_BITS (~3%). Values at or above 2^MAX_BITS us (~67 s)
+ * are clamped into the last bucket.
+ *
+ * Recording is constant-time and allocation-free. Histograms are plain
+ * data so callers can keep, merge and reset their own windows.
+ */
+
+#define HISTOGRAM_SUB_BUCKET_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1u << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAX_BITS 26
+#define HISTOGRAM_BUCKETS \
+    ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+#define HISTOGRAM_MAX_US ((1ULL << HISTOGRAM_MAX_BITS) - 1)
+
+struct histogram {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total_count;
+};
+
+/**
+ * Map a value to its bucket index
+ *
+ * @param value_us Value in microseconds (clamped to HISTOGRAM_MAX_US)
+ * @return Bucket index in [0, HISTOGRAM_BUCKETS)
+ */
+uint32_t histogram_bucket_index(uint64_t value_us);
+
+/**
+ * Highest value that maps to a bucket
+ *
+ * @param index Bucket index
+ * @return Upper bound of the bucket in microseconds
+ */
+uint64_t histogram_bucket_upper_us(uint32_t index);
+
+/**
+ * Clear all counts
+ */
+void histogram_reset(struct histogram *hist);
+
+/**
+ * Record a single value
+ */
+void histogram_record(struct histogram *hist, uint64_t value_us);
+
+/**
+ * Add all counts from src into dst
+ */
+void histogram_merge(struct histogram *dst, const struct histogram *src);
+
+/**
+ * Value at a quantile
+ *
+ * @param hist Histogram
+ * @param quantile Quantile in [0.0, 1.0] (e.g. 0.99 for p99)
+ * @return Upper bound of the bucket containing the quantile, 0 if empty
+ */
+uint64_t histogram_percentile(const struct histogram *hist, double quantile);
+
+/**
+ * Compute p50/p95/p99/p999 in a single pass
+ *
+ * @param hist Histogram
+ * @param out Output percentiles (all zero if the histogram is empty)
+ */
+void histogram_percentiles(const struct histogram *hist,
+                           telescope_latency_percentiles_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTOGRAM_H */
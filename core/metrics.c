@@ -1,265 +1,1279 @@
 #include "telescope.h"
+#include "metrics.h"
+#include "histogram.h"
+#include "frame_timing.h"
+#include "metrics_writer.h"
+#include "metrics_shm.h"
+#include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 /**
  * Metrics collection and observability
+ *
+ * Counters are split into cache-line sized shards. Each recording thread
+ * is assigned a shard on first use and updates it with relaxed atomics,
+ * so the frame/input hot path never takes a lock. Readers aggregate the
+ * shards and publish the result under a seqlock.
+ *
+ * Bandwidth is averaged over a preallocated ring of fixed-width time
+ * buckets with running window sums, so recording is O(1) and never
+ * allocates.
+ *
+ * Latencies are additionally recorded into log-linear histograms
+ * (relaxed atomic bucket counts) so tail percentiles survive.
+ *
+ * Per-surface counters live in an open-addressing hash table keyed by
+ * surface ID: recording a known surface is a lock-free probe, and only
+ * the first frame of a surface or its release takes the table lock.
+ *
+ * Frame pacing (fps, variance, jank) comes from a sliding window of
+ * caller-supplied presentation timestamps (frame_timing.c); the frame
+ * path never reads the clock.
+ *
+ * File output is handed off to an asynchronous writer thread
+ * (metrics_writer.c); flushing never formats or blocks on disk I/O.
+ * Flushing can also publish into a shared-memory region (metrics_shm.c)
+ * for external readers.
+ *
+ * Each telescope session owns a collector registered under its session
+ * handle; recording threads bind to a collector (metrics_bind()) and fall
+ * back to the process-wide default collector from
+ * metrics_collector_init(), or record nothing. An unbound thread is never
+ * attributed to a session it did not choose. The registry also provides
+ * an aggregate view across all collectors.
+ *
+ * Session collectors are reference counted: the owner holds one
+ * reference and every bound thread another. Destroying a collector
+ * disables it and drops the owner's reference; a thread still bound to
+ * it notices on its next record and lets go, and the last reference
+ * frees it. A stale binding therefore never points at freed memory.
+ *
+ * Per-lens counters are derived from the shard totals at lens switches
+ * rather than recorded separately, so attribution costs nothing on the
+ * hot path.
  */
 
-/* Bandwidth sample for time-based averaging */
-struct bandwidth_sample {
-    uint64_t timestamp_us;
-    uint64_t rx_bytes;
-    uint64_t tx_bytes;
-    struct bandwidth_sample *next;
+#define METRICS_CACHELINE 64
+#define METRICS_SHARD_COUNT 16
+
+#define BANDWIDTH_BUCKET_US 10000ULL     /* 10 ms per bucket */
+#define BANDWIDTH_BUCKET_COUNT 100       /* 1 second window */
+
+/* Per-thread counter shard (one cache line) */
+struct metrics_shard {
+    _Alignas(METRICS_CACHELINE) atomic_uint_least64_t frames_total;
+    atomic_uint_least64_t frames_dropped;
+    atomic_uint_least64_t input_events_total;
+    atomic_uint_least64_t input_events_predicted;
+    atomic_uint_least64_t input_events_reconciled;
+    atomic_uint_least64_t rx_bytes;
+    atomic_uint_least64_t tx_bytes;
+};
+
+/* Last-value gauges (last writer wins) */
+struct metrics_gauges {
+    _Alignas(METRICS_CACHELINE) atomic_uint_least32_t end_to_end_latency_ms;
+    atomic_uint_least32_t input_lag_ms;
+    atomic_uint_least32_t frame_delay_ms;
+    atomic_uint_least32_t frames_per_second;  /* Sampler interval rate */
+};
+
+/* Bytes transferred during one bandwidth bucket */
+struct bandwidth_bucket {
+    atomic_uint_least64_t rx_bytes;
+    atomic_uint_least64_t tx_bytes;
+};
+
+/*
+ * Time-bucketed bandwidth ring
+ *
+ * `head` is the absolute index (now / BANDWIDTH_BUCKET_US) of the newest
+ * bucket. The thread that advances `head` expires the buckets it skips
+ * over, subtracting their contents from the running window sums, so the
+ * sums always equal the total of the live buckets.
+ */
+struct bandwidth_ring {
+    _Alignas(METRICS_CACHELINE) atomic_uint_least64_t head;
+    atomic_uint_least64_t window_rx_bytes;
+    atomic_uint_least64_t window_tx_bytes;
+    struct bandwidth_bucket buckets[BANDWIDTH_BUCKET_COUNT];
+};
+
+/* Surface hash table: at most half full, so probe runs stay short */
+#define METRICS_SURFACE_TABLE_SIZE (2 * METRICS_MAX_SURFACES)   /* Power of two */
+#define METRICS_SURFACE_TOMBSTONE UINT64_MAX                    /* Released slot */
+
+/* Per-surface counters; id 0 marks a free slot */
+struct metrics_surface_slot {
+    atomic_uint_least64_t surface_id;
+    atomic_uint_least64_t frames_total;
+    atomic_uint_least64_t frames_dropped;
+    atomic_uint_least64_t last_latency_us;
+};
+
+/* Concurrently recorded histogram; converted to struct histogram on read */
+struct metrics_histogram {
+    _Alignas(METRICS_CACHELINE) atomic_uint_least64_t counts[HISTOGRAM_BUCKETS];
 };
 
 struct metrics_collector {
-    struct telescope_metrics metrics;
-    bool enabled;
+    struct metrics_shard shards[METRICS_SHARD_COUNT];
+    struct metrics_gauges gauges;
+    struct metrics_histogram latency[METRICS_LATENCY_KIND_COUNT];
+
+    /* Seqlock-protected aggregated snapshot */
+    _Alignas(METRICS_CACHELINE) atomic_uint snapshot_seq;
+    atomic_flag publish_lock;
+    struct telescope_metrics published;
+
+    atomic_bool enabled;        /* Cleared when the owner destroys the collector */
+    atomic_uint refs;           /* Owner plus one per bound thread */
     uint32_t interval_ms;
     char *metrics_file;
-    FILE *metrics_fp;
-    uint64_t last_collection_us;
-    uint64_t frame_counter;
-    uint64_t input_event_counter;
-    
+    struct metrics_writer *writer;
+    struct utils_clock *clock;  /* NULL = system monotonic */
+
     /* Time-based bandwidth averaging */
-    struct bandwidth_sample *bandwidth_samples;
-    size_t bandwidth_sample_count;
-    uint64_t bandwidth_window_us;  /* Averaging window (default 1 second) */
-    uint64_t total_rx_bytes;
-    uint64_t total_tx_bytes;
-    uint64_t bandwidth_last_update_us;
+    struct bandwidth_ring bandwidth;
+
+    /*
+     * Presentation-timestamp window. Recorders serialize on frame_lock for
+     * an O(1) update and bump frame_seq around it; readers copy the window
+     * under the seqlock and compute statistics on the copy, so they never
+     * hold a lock a recorder spins on.
+     */
+    _Alignas(METRICS_CACHELINE) atomic_flag frame_lock;
+    atomic_uint frame_seq;
+    struct frame_timing frame_timing;
+
+    /* Lens attribution: totals of finished activations plus the running one */
+    _Alignas(METRICS_CACHELINE) atomic_flag lens_lock;
+    int active_lens;  /* -1 = none */
+    struct metrics_counters lens_base[METRICS_SHM_LENS_SLOTS];
+    struct metrics_counters lens_mark;
+
+    /* Surface table: lock-free lookup, claims and releases under surface_lock */
+    _Alignas(METRICS_CACHELINE) atomic_flag surface_lock;
+    size_t surface_count;
+    atomic_uint_least64_t surface_frames_untracked;
+    struct metrics_surface_slot surfaces[METRICS_SURFACE_TABLE_SIZE];
+
+    /* Shared-memory export (single publisher at a time) */
+    _Alignas(METRICS_CACHELINE) atomic_flag shm_lock;
+    struct metrics_shm *shm;
 };
 
-static struct metrics_collector *g_collector = NULL;
+_Static_assert(METRICS_SHM_LENS_SLOTS == TELESCOPE_LENS_AUTO, "one lens slot per concrete lens");
+_Static_assert((METRICS_SURFACE_TABLE_SIZE & (METRICS_SURFACE_TABLE_SIZE - 1)) == 0,
+               "surface table size is a power of two");
 
-int metrics_collector_init(const telescope_observability_t *obs_config) {
-    if (!obs_config || !obs_config->enable_metrics) {
-        return 0;  /* Metrics disabled */
+/* Process-wide default collector (metrics_collector_init) */
+static struct metrics_collector *_Atomic g_collector = NULL;
+
+/* Per-session collectors, one cache line per slot; mutated under the lock */
+struct metrics_registry_slot {
+    _Alignas(METRICS_CACHELINE) const void *key;
+    struct metrics_collector *collector;
+};
+
+static struct metrics_registry_slot g_registry[METRICS_MAX_SESSIONS];
+static pthread_mutex_t g_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Collector this thread records into, holding a reference (NULL = default collector) */
+static _Thread_local struct metrics_collector *t_bound = NULL;
+
+/* Mirrors t_bound so a thread's reference is dropped when it exits */
+static pthread_key_t g_bound_key;
+static pthread_once_t g_bound_key_once = PTHREAD_ONCE_INIT;
+
+/* Shard assignment: round-robin per thread, shared once threads exceed shards */
+static atomic_uint g_next_shard = 0;
+static _Thread_local int t_shard = -1;
+
+static inline struct metrics_collector *metrics_active(void) {
+    struct metrics_collector *c = t_bound;
+    if (c && !atomic_load_explicit(&c->enabled, memory_order_acquire)) {
+        metrics_bind(NULL);  /* Destroyed by its owner: let go (may free it) */
+        c = NULL;
     }
-    
-    if (g_collector) {
-        return -EBUSY;  /* Already initialized */
+    if (!c) {
+        c = atomic_load_explicit(&g_collector, memory_order_acquire);
+    }
+    if (!c || !atomic_load_explicit(&c->enabled, memory_order_acquire)) {
+        return NULL;
+    }
+    return c;
+}
+
+static inline struct metrics_shard *metrics_local_shard(struct metrics_collector *c) {
+    if (t_shard < 0) {
+        t_shard = (int)(atomic_fetch_add_explicit(&g_next_shard, 1, memory_order_relaxed) %
+                        METRICS_SHARD_COUNT);
     }
-    
-    g_collector = calloc(1, sizeof(struct metrics_collector));
-    if (!g_collector) {
+    return &c->shards[t_shard];
+}
+
+static inline void counter_add(atomic_uint_least64_t *counter, uint64_t value) {
+    atomic_fetch_add_explicit(counter, value, memory_order_relaxed);
+}
+
+static inline uint64_t counter_load(atomic_uint_least64_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+static inline uint64_t metrics_now_us(const struct metrics_collector *c) {
+    return utils_clock_now_us(c ? c->clock : NULL);
+}
+
+static int metrics_collector_alloc(const telescope_observability_t *obs_config,
+                                   const char *shm_name,
+                                   struct metrics_collector **collector_out) {
+    /* Shards are cache-line aligned; calloc() does not guarantee that */
+    struct metrics_collector *c = NULL;
+    if (posix_memalign((void **)&c, METRICS_CACHELINE, sizeof(*c)) != 0) {
         return -ENOMEM;
     }
-    
-    g_collector->enabled = true;
-    g_collector->interval_ms = obs_config->metrics_interval_ms;
-    g_collector->last_collection_us = 0;
-    g_collector->frame_counter = 0;
-    g_collector->input_event_counter = 0;
-    
-    g_collector->bandwidth_samples = NULL;
-    g_collector->bandwidth_sample_count = 0;
-    g_collector->bandwidth_window_us = 1000000ULL;  /* 1 second window */
-    g_collector->total_rx_bytes = 0;
-    g_collector->total_tx_bytes = 0;
-    g_collector->bandwidth_last_update_us = 0;
-    
-    memset(&g_collector->metrics, 0, sizeof(g_collector->metrics));
-    
+    memset(c, 0, sizeof(*c));
+
+    for (size_t i = 0; i < METRICS_SHARD_COUNT; i++) {
+        atomic_init(&c->shards[i].frames_total, 0);
+        atomic_init(&c->shards[i].frames_dropped, 0);
+        atomic_init(&c->shards[i].input_events_total, 0);
+        atomic_init(&c->shards[i].input_events_predicted, 0);
+        atomic_init(&c->shards[i].input_events_reconciled, 0);
+        atomic_init(&c->shards[i].rx_bytes, 0);
+        atomic_init(&c->shards[i].tx_bytes, 0);
+    }
+    for (size_t k = 0; k < METRICS_LATENCY_KIND_COUNT; k++) {
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            atomic_init(&c->latency[k].counts[i], 0);
+        }
+    }
+    atomic_init(&c->snapshot_seq, 0);
+    atomic_flag_clear(&c->publish_lock);
+    atomic_flag_clear(&c->frame_lock);
+    atomic_init(&c->frame_seq, 0);
+    atomic_flag_clear(&c->lens_lock);
+    atomic_flag_clear(&c->shm_lock);
+    c->active_lens = -1;
+    atomic_flag_clear(&c->surface_lock);
+    c->surface_count = 0;
+    atomic_init(&c->surface_frames_untracked, 0);
+    for (size_t i = 0; i < METRICS_SURFACE_TABLE_SIZE; i++) {
+        atomic_init(&c->surfaces[i].surface_id, 0);
+        atomic_init(&c->surfaces[i].frames_total, 0);
+        atomic_init(&c->surfaces[i].frames_dropped, 0);
+        atomic_init(&c->surfaces[i].last_latency_us, 0);
+    }
+    frame_timing_init(&c->frame_timing, 0);
+
+    atomic_init(&c->enabled, true);
+    atomic_init(&c->refs, 1);
+    c->interval_ms = obs_config->metrics_interval_ms;
+
+    atomic_init(&c->bandwidth.head, 0);
+    atomic_init(&c->bandwidth.window_rx_bytes, 0);
+    atomic_init(&c->bandwidth.window_tx_bytes, 0);
+    for (size_t i = 0; i < BANDWIDTH_BUCKET_COUNT; i++) {
+        atomic_init(&c->bandwidth.buckets[i].rx_bytes, 0);
+        atomic_init(&c->bandwidth.buckets[i].tx_bytes, 0);
+    }
+
     if (obs_config->metrics_file) {
-        g_collector->metrics_file = strdup(obs_config->metrics_file);
-        g_collector->metrics_fp = fopen(obs_config->metrics_file, "a");
-        if (!g_collector->metrics_fp) {
+        c->metrics_file = strdup(obs_config->metrics_file);
+        if (metrics_writer_create(obs_config->metrics_file, obs_config->metrics_format,
+                                  &c->writer) < 0) {
             /* Non-fatal: metrics collection continues without file output */
+            c->writer = NULL;
         }
     } else {
-        g_collector->metrics_file = NULL;
-        g_collector->metrics_fp = NULL;
+        c->metrics_file = NULL;
+        c->writer = NULL;
+    }
+
+    if (obs_config->metrics_shm && metrics_shm_create(shm_name, &c->shm) < 0) {
+        /* Non-fatal: in-process snapshots and file output still work */
+        c->shm = NULL;
+    }
+
+    *collector_out = c;
+    return 0;
+}
+
+static void metrics_collector_free(struct metrics_collector *c) {
+    /* Drains any queued records before closing the file */
+    metrics_writer_destroy(c->writer);
+    metrics_shm_destroy(c->shm);
+
+    free(c->metrics_file);
+    free(c);
+}
+
+int metrics_collector_init(const telescope_observability_t *obs_config) {
+    if (!obs_config || !obs_config->enable_metrics) {
+        return 0;  /* Metrics disabled */
+    }
+
+    if (atomic_load(&g_collector)) {
+        return -EBUSY;  /* Already initialized */
+    }
+
+    struct metrics_collector *c = NULL;
+    int ret = metrics_collector_alloc(obs_config, NULL, &c);
+    if (ret < 0) {
+        return ret;
     }
-    
+
+    atomic_store_explicit(&g_collector, c, memory_order_release);
     return 0;
 }
 
 void metrics_collector_cleanup(void) {
-    if (!g_collector) {
+    struct metrics_collector *c = atomic_exchange(&g_collector, NULL);
+    if (!c) {
         return;
     }
-    
-    if (g_collector->metrics_fp) {
-        fclose(g_collector->metrics_fp);
+
+    atomic_store_explicit(&c->enabled, false, memory_order_release);
+    if (t_bound == c) {
+        metrics_bind(NULL);
+    }
+    metrics_collector_unref(c);
+}
+
+int metrics_collector_create(const void *key, const telescope_observability_t *obs_config,
+                             struct metrics_collector **collector_out) {
+    if (!key || !collector_out) {
+        return -EINVAL;
+    }
+
+    *collector_out = NULL;
+    if (!obs_config || !obs_config->enable_metrics) {
+        return 0;  /* Metrics disabled */
+    }
+
+    pthread_mutex_lock(&g_registry_lock);
+
+    size_t free_slot = METRICS_MAX_SESSIONS;
+    for (size_t i = 0; i < METRICS_MAX_SESSIONS; i++) {
+        if (g_registry[i].key == key) {
+            pthread_mutex_unlock(&g_registry_lock);
+            return -EEXIST;
+        }
+        if (!g_registry[i].key && free_slot == METRICS_MAX_SESSIONS) {
+            free_slot = i;
+        }
+    }
+    if (free_slot == METRICS_MAX_SESSIONS) {
+        pthread_mutex_unlock(&g_registry_lock);
+        return -ENOSPC;
     }
-    
-    /* Free bandwidth samples */
-    struct bandwidth_sample *sample = g_collector->bandwidth_samples;
-    while (sample) {
-        struct bandwidth_sample *next = sample->next;
-        free(sample);
-        sample = next;
+
+    char shm_name[METRICS_SHM_NAME_MAX];
+    int ret = metrics_shm_session_name(getpid(), (unsigned)free_slot, shm_name, sizeof(shm_name));
+    struct metrics_collector *c = NULL;
+    if (ret == 0) {
+        ret = metrics_collector_alloc(obs_config, shm_name, &c);
+    }
+    if (ret < 0) {
+        pthread_mutex_unlock(&g_registry_lock);
+        return ret;
     }
-    
-    free(g_collector->metrics_file);
-    free(g_collector);
-    g_collector = NULL;
+
+    g_registry[free_slot].key = key;
+    g_registry[free_slot].collector = c;
+    pthread_mutex_unlock(&g_registry_lock);
+
+    *collector_out = c;
+    return 0;
+}
+
+void metrics_collector_destroy(struct metrics_collector *collector) {
+    if (!collector) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_registry_lock);
+    for (size_t i = 0; i < METRICS_MAX_SESSIONS; i++) {
+        if (g_registry[i].collector == collector) {
+            g_registry[i].key = NULL;
+            g_registry[i].collector = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+
+    /* Threads still bound elsewhere keep it alive until they let go */
+    atomic_store_explicit(&collector->enabled, false, memory_order_release);
+    if (t_bound == collector) {
+        metrics_bind(NULL);
+    }
+    metrics_collector_unref(collector);
+}
+
+struct metrics_collector *metrics_collector_ref(struct metrics_collector *collector) {
+    if (collector) {
+        atomic_fetch_add_explicit(&collector->refs, 1, memory_order_relaxed);
+    }
+    return collector;
+}
+
+void metrics_collector_unref(struct metrics_collector *collector) {
+    if (collector && atomic_fetch_sub_explicit(&collector->refs, 1, memory_order_acq_rel) == 1) {
+        metrics_collector_free(collector);
+    }
+}
+
+struct metrics_collector *metrics_registry_lookup(const void *key) {
+    struct metrics_collector *c = NULL;
+
+    pthread_mutex_lock(&g_registry_lock);
+    for (size_t i = 0; key && i < METRICS_MAX_SESSIONS; i++) {
+        if (g_registry[i].key == key) {
+            c = g_registry[i].collector;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+
+    return c;
+}
+
+size_t metrics_registry_count(void) {
+    size_t n = 0;
+
+    pthread_mutex_lock(&g_registry_lock);
+    for (size_t i = 0; i < METRICS_MAX_SESSIONS; i++) {
+        if (g_registry[i].collector) {
+            n++;
+        }
+    }
+    pthread_mutex_unlock(&g_registry_lock);
+
+    return n;
+}
+
+void metrics_collector_set_clock(struct metrics_collector *collector, struct utils_clock *clock) {
+    if (collector) {
+        collector->clock = clock;
+    }
+}
+
+static void metrics_bound_key_destroy(void *value) {
+    metrics_collector_unref(value);
+}
+
+static void metrics_bound_key_create(void) {
+    (void)pthread_key_create(&g_bound_key, metrics_bound_key_destroy);
+}
+
+void metrics_bind(struct metrics_collector *collector) {
+    struct metrics_collector *prev = t_bound;
+    if (collector == prev) {
+        return;
+    }
+
+    pthread_once(&g_bound_key_once, metrics_bound_key_create);
+    t_bound = metrics_collector_ref(collector);
+    (void)pthread_setspecific(g_bound_key, t_bound);
+    metrics_collector_unref(prev);
+}
+
+struct metrics_collector *metrics_bound(void) {
+    return t_bound;
+}
+
+static inline void latency_record(struct metrics_collector *c,
+                                  metrics_latency_kind_t kind, uint64_t value_us) {
+    counter_add(&c->latency[kind].counts[histogram_bucket_index(value_us)], 1);
+}
+
+static inline uint32_t us_to_ms(uint64_t value_us) {
+    uint64_t ms = value_us / 1000;
+    return ms > UINT32_MAX ? UINT32_MAX : (uint32_t)ms;
 }
 
 void metrics_record_frame(uint32_t latency_ms, bool dropped) {
-    if (!g_collector || !g_collector->enabled) {
+    metrics_record_frame_us((uint64_t)latency_ms * 1000, dropped);
+}
+
+void metrics_record_frame_us(uint64_t latency_us, bool dropped) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
         return;
     }
-    
-    g_collector->frame_counter++;
-    g_collector->metrics.frames_total++;
-    
+
+    struct metrics_shard *shard = metrics_local_shard(c);
+    counter_add(&shard->frames_total, 1);
+
     if (dropped) {
-        g_collector->metrics.frames_dropped++;
+        counter_add(&shard->frames_dropped, 1);
+    } else {
+        latency_record(c, METRICS_LATENCY_FRAME_DELAY, latency_us);
     }
-    
+
     /* Update latency metrics */
-    g_collector->metrics.frame_delay_ms = latency_ms;
-    
-    /* Calculate FPS (simplified) */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t now_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
-    if (g_collector->last_collection_us > 0) {
-        uint64_t dt_us = now_us - g_collector->last_collection_us;
-        if (dt_us > 0) {
-            g_collector->metrics.frames_per_second = 1000000ULL / dt_us;
+    atomic_store_explicit(&c->gauges.frame_delay_ms, us_to_ms(latency_us), memory_order_relaxed);
+}
+
+/* Start an O(1) update of the frame window (recorders only) */
+static void frame_timing_write_begin(struct metrics_collector *c) {
+    while (atomic_flag_test_and_set_explicit(&c->frame_lock, memory_order_acquire)) {
+        /* Spin: other recorders only touch a few words */
+    }
+
+    unsigned seq = atomic_load_explicit(&c->frame_seq, memory_order_relaxed);
+    atomic_store_explicit(&c->frame_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void frame_timing_write_end(struct metrics_collector *c) {
+    unsigned seq = atomic_load_explicit(&c->frame_seq, memory_order_relaxed);
+    atomic_store_explicit(&c->frame_seq, seq + 1, memory_order_release);
+    atomic_flag_clear_explicit(&c->frame_lock, memory_order_release);
+}
+
+/* Statistics from a consistent copy of the window; never blocks recorders */
+static void frame_timing_read_stats(struct metrics_collector *c, struct frame_timing_stats *stats_out) {
+    struct frame_timing copy;
+    unsigned seq_begin, seq_end;
+
+    do {
+        seq_begin = atomic_load_explicit(&c->frame_seq, memory_order_acquire);
+        if (seq_begin & 1) {
+            continue;  /* Recorder in progress */
         }
+        copy = c->frame_timing;
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&c->frame_seq, memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+
+    frame_timing_stats(&copy, stats_out);
+}
+
+void metrics_record_frame_presented(uint64_t present_us, uint64_t latency_us, bool dropped) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return;
     }
-    
-    g_collector->last_collection_us = now_us;
-    g_collector->metrics.timestamp_us = now_us;
+
+    metrics_record_frame_us(latency_us, dropped);
+    if (dropped) {
+        return;
+    }
+
+    frame_timing_write_begin(c);
+    (void)frame_timing_record(&c->frame_timing, present_us);
+    frame_timing_write_end(c);
+}
+
+void metrics_set_target_frame_rate(uint32_t target_fps) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return;
+    }
+
+    frame_timing_write_begin(c);
+    frame_timing_set_target(&c->frame_timing, target_fps);
+    frame_timing_write_end(c);
+}
+
+int metrics_frame_pacing(struct frame_timing_stats *stats_out) {
+    if (!stats_out) {
+        return -EINVAL;
+    }
+
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return -ENOENT;
+    }
+
+    frame_timing_read_stats(c, stats_out);
+    return 0;
 }
 
 void metrics_record_input_event(bool predicted, bool reconciled) {
-    if (!g_collector || !g_collector->enabled) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
         return;
     }
-    
-    g_collector->input_event_counter++;
-    g_collector->metrics.input_events_total++;
-    
+
+    struct metrics_shard *shard = metrics_local_shard(c);
+    counter_add(&shard->input_events_total, 1);
+
     if (predicted) {
-        g_collector->metrics.input_events_predicted++;
+        counter_add(&shard->input_events_predicted, 1);
     }
-    
+
     if (reconciled) {
-        g_collector->metrics.input_events_reconciled++;
+        counter_add(&shard->input_events_reconciled, 1);
+    }
+}
+
+/*
+ * Move the ring head forward to `bucket`, expiring skipped buckets.
+ *
+ * Only the thread whose CAS advances the head expires buckets. A writer
+ * racing with expiry may have its bytes counted as expired immediately,
+ * or land in the slot's next bucket and expire with it. Writers add to
+ * the window sums before the slot, so a sum never drops below what its
+ * slots hold and cannot wrap.
+ */
+static void bandwidth_advance(struct bandwidth_ring *ring, uint64_t bucket) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while (bucket > head) {
+        if (!atomic_compare_exchange_weak_explicit(&ring->head, &head, bucket,
+                                                   memory_order_acq_rel,
+                                                   memory_order_acquire)) {
+            continue;  /* head reloaded; retry if still behind */
+        }
+
+        /* We own buckets (head, bucket]; at most one full lap */
+        uint64_t first = head + 1;
+        if (bucket - head > BANDWIDTH_BUCKET_COUNT) {
+            first = bucket - BANDWIDTH_BUCKET_COUNT + 1;
+        }
+
+        for (uint64_t b = first; b <= bucket; b++) {
+            struct bandwidth_bucket *slot = &ring->buckets[b % BANDWIDTH_BUCKET_COUNT];
+            uint64_t rx = atomic_exchange_explicit(&slot->rx_bytes, 0, memory_order_relaxed);
+            uint64_t tx = atomic_exchange_explicit(&slot->tx_bytes, 0, memory_order_relaxed);
+            atomic_fetch_sub_explicit(&ring->window_rx_bytes, rx, memory_order_relaxed);
+            atomic_fetch_sub_explicit(&ring->window_tx_bytes, tx, memory_order_relaxed);
+        }
+        return;
     }
 }
 
 void metrics_record_bandwidth(uint64_t rx_bytes, uint64_t tx_bytes) {
-    if (!g_collector || !g_collector->enabled) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
         return;
     }
-    
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t now_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    
-    /* Create new bandwidth sample */
-    struct bandwidth_sample *sample = malloc(sizeof(struct bandwidth_sample));
-    if (sample) {
-        sample->timestamp_us = now_us;
-        sample->rx_bytes = rx_bytes;
-        sample->tx_bytes = tx_bytes;
-        sample->next = g_collector->bandwidth_samples;
-        g_collector->bandwidth_samples = sample;
-        g_collector->bandwidth_sample_count++;
-        
-        g_collector->total_rx_bytes += rx_bytes;
-        g_collector->total_tx_bytes += tx_bytes;
-    }
-    
-    /* Remove samples outside the averaging window */
-    uint64_t window_start_us = now_us - g_collector->bandwidth_window_us;
-    struct bandwidth_sample **sample_ptr = &g_collector->bandwidth_samples;
-    
-    while (*sample_ptr) {
-        if ((*sample_ptr)->timestamp_us < window_start_us) {
-            struct bandwidth_sample *old = *sample_ptr;
-            *sample_ptr = (*sample_ptr)->next;
-            
-            g_collector->total_rx_bytes -= old->rx_bytes;
-            g_collector->total_tx_bytes -= old->tx_bytes;
-            g_collector->bandwidth_sample_count--;
-            free(old);
-        } else {
-            sample_ptr = &(*sample_ptr)->next;
+
+    struct metrics_shard *shard = metrics_local_shard(c);
+    counter_add(&shard->rx_bytes, rx_bytes);
+    counter_add(&shard->tx_bytes, tx_bytes);
+
+    struct bandwidth_ring *ring = &c->bandwidth;
+    uint64_t bucket = metrics_now_us(c) / BANDWIDTH_BUCKET_US;
+
+    bandwidth_advance(ring, bucket);
+
+    /* Late writers (clock read before another thread advanced) still land in-window */
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head - bucket >= BANDWIDTH_BUCKET_COUNT) {
+        return;  /* Sample already outside the averaging window */
+    }
+
+    /*
+     * Window sums first: expiry subtracts only what it took out of a slot,
+     * so adding to the slot last keeps the unsigned sums from wrapping.
+     */
+    struct bandwidth_bucket *slot = &ring->buckets[bucket % BANDWIDTH_BUCKET_COUNT];
+    counter_add(&ring->window_rx_bytes, rx_bytes);
+    counter_add(&ring->window_tx_bytes, tx_bytes);
+    counter_add(&slot->rx_bytes, rx_bytes);
+    counter_add(&slot->tx_bytes, tx_bytes);
+}
+
+void metrics_record_latency(uint32_t end_to_end_ms, uint32_t input_lag_ms) {
+    metrics_record_latency_us((uint64_t)end_to_end_ms * 1000, (uint64_t)input_lag_ms * 1000);
+}
+
+void metrics_record_latency_us(uint64_t end_to_end_us, uint64_t input_lag_us) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return;
+    }
+
+    latency_record(c, METRICS_LATENCY_END_TO_END, end_to_end_us);
+    latency_record(c, METRICS_LATENCY_INPUT_LAG, input_lag_us);
+
+    atomic_store_explicit(&c->gauges.end_to_end_latency_ms, us_to_ms(end_to_end_us), memory_order_relaxed);
+    atomic_store_explicit(&c->gauges.input_lag_ms, us_to_ms(input_lag_us), memory_order_relaxed);
+}
+
+/* Copy (and optionally drain) a concurrently recorded histogram */
+static void latency_copy(struct metrics_histogram *src, struct histogram *dst, bool drain) {
+    dst->total_count = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        uint64_t n = drain
+            ? atomic_exchange_explicit(&src->counts[i], 0, memory_order_relaxed)
+            : counter_load(&src->counts[i]);
+        dst->counts[i] = n;
+        dst->total_count += n;
+    }
+}
+
+int metrics_latency_histogram(metrics_latency_kind_t kind, struct histogram *hist_out) {
+    if (!hist_out || kind >= METRICS_LATENCY_KIND_COUNT) {
+        return -EINVAL;
+    }
+
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return -ENOENT;
+    }
+
+    latency_copy(&c->latency[kind], hist_out, false);
+    return 0;
+}
+
+int metrics_latency_take(metrics_latency_kind_t kind, struct histogram *hist_out) {
+    if (kind >= METRICS_LATENCY_KIND_COUNT) {
+        return -EINVAL;
+    }
+
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return -ENOENT;
+    }
+
+    struct histogram discard;
+    latency_copy(&c->latency[kind], hist_out ? hist_out : &discard, true);
+    return 0;
+}
+
+int metrics_latency_percentiles(metrics_latency_kind_t kind,
+                                telescope_latency_percentiles_t *percentiles_out) {
+    if (!percentiles_out) {
+        return -EINVAL;
+    }
+
+    struct histogram hist;
+    int ret = metrics_latency_histogram(kind, &hist);
+    if (ret < 0) {
+        return ret;
+    }
+
+    histogram_percentiles(&hist, percentiles_out);
+    return 0;
+}
+
+/* Sum all shards and gauges into a plain metrics structure */
+static void metrics_aggregate(struct metrics_collector *c, struct telescope_metrics *out) {
+    uint64_t frames_total = 0;
+    uint64_t frames_dropped = 0;
+    uint64_t input_total = 0;
+    uint64_t input_predicted = 0;
+    uint64_t input_reconciled = 0;
+
+    for (size_t i = 0; i < METRICS_SHARD_COUNT; i++) {
+        struct metrics_shard *shard = &c->shards[i];
+        frames_total += counter_load(&shard->frames_total);
+        frames_dropped += counter_load(&shard->frames_dropped);
+        input_total += counter_load(&shard->input_events_total);
+        input_predicted += counter_load(&shard->input_events_predicted);
+        input_reconciled += counter_load(&shard->input_events_reconciled);
+    }
+
+    /* Expire idle buckets so the average decays once traffic stops */
+    bandwidth_advance(&c->bandwidth, metrics_now_us(c) / BANDWIDTH_BUCKET_US);
+    uint64_t window_rx = counter_load(&c->bandwidth.window_rx_bytes);
+    uint64_t window_tx = counter_load(&c->bandwidth.window_tx_bytes);
+    uint64_t window_us = BANDWIDTH_BUCKET_COUNT * BANDWIDTH_BUCKET_US;
+
+    memset(out, 0, sizeof(*out));
+    out->end_to_end_latency_ms = atomic_load_explicit(&c->gauges.end_to_end_latency_ms, memory_order_relaxed);
+    out->input_lag_ms = atomic_load_explicit(&c->gauges.input_lag_ms, memory_order_relaxed);
+    out->frame_delay_ms = atomic_load_explicit(&c->gauges.frame_delay_ms, memory_order_relaxed);
+    out->frames_per_second = atomic_load_explicit(&c->gauges.frames_per_second, memory_order_relaxed);
+
+    /* Prefer the presentation-timestamp window over the sampler's interval rate */
+    struct frame_timing_stats pacing;
+    frame_timing_read_stats(c, &pacing);
+    if (pacing.frames > 0) {
+        out->frames_per_second = (uint32_t)(pacing.mean_fps + 0.5);
+    }
+
+    out->frames_dropped = (uint32_t)frames_dropped;
+    out->frames_total = (uint32_t)frames_total;
+    /* Convert bytes to bits per second */
+    out->bandwidth_rx_bps = (window_rx * 8 * 1000000ULL) / window_us;
+    out->bandwidth_tx_bps = (window_tx * 8 * 1000000ULL) / window_us;
+    out->input_events_predicted = (uint32_t)input_predicted;
+    out->input_events_reconciled = (uint32_t)input_reconciled;
+    out->input_events_total = (uint32_t)input_total;
+    out->timestamp_us = metrics_now_us(c);
+
+    struct histogram hist;
+    telescope_latency_percentiles_t *pct[METRICS_LATENCY_KIND_COUNT] = {
+        [METRICS_LATENCY_END_TO_END] = &out->end_to_end_latency,
+        [METRICS_LATENCY_INPUT_LAG] = &out->input_lag,
+        [METRICS_LATENCY_FRAME_DELAY] = &out->frame_delay,
+    };
+    for (size_t k = 0; k < METRICS_LATENCY_KIND_COUNT; k++) {
+        latency_copy(&c->latency[k], &hist, false);
+        histogram_percentiles(&hist, pct[k]);
+    }
+}
+
+/* Aggregate and publish under the seqlock; concurrent publishers back off */
+static void metrics_publish(struct metrics_collector *c) {
+    if (atomic_flag_test_and_set_explicit(&c->publish_lock, memory_order_acquire)) {
+        return;  /* Another thread is publishing a fresh snapshot */
+    }
+
+    struct telescope_metrics m;
+    metrics_aggregate(c, &m);
+
+    unsigned seq = atomic_load_explicit(&c->snapshot_seq, memory_order_relaxed);
+    atomic_store_explicit(&c->snapshot_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    c->published = m;
+
+    atomic_store_explicit(&c->snapshot_seq, seq + 2, memory_order_release);
+    atomic_flag_clear_explicit(&c->publish_lock, memory_order_release);
+}
+
+static void metrics_read_published(struct metrics_collector *c, struct telescope_metrics *out) {
+    unsigned seq_begin, seq_end;
+
+    do {
+        seq_begin = atomic_load_explicit(&c->snapshot_seq, memory_order_acquire);
+        if (seq_begin & 1) {
+            continue;  /* Writer in progress */
         }
+        *out = c->published;
+        atomic_thread_fence(memory_order_acquire);
+        seq_end = atomic_load_explicit(&c->snapshot_seq, memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+}
+
+int metrics_collector_snapshot(struct telescope_metrics *metrics_out) {
+    return metrics_session_snapshot(metrics_active(), metrics_out);
+}
+
+int metrics_session_snapshot(struct metrics_collector *collector,
+                             struct telescope_metrics *metrics_out) {
+    if (!metrics_out) {
+        return -EINVAL;
     }
-    
-    /* Calculate average bandwidth over the window */
-    if (g_collector->bandwidth_sample_count > 0) {
-        uint64_t window_duration_us = g_collector->bandwidth_window_us;
-        if (window_duration_us > 0) {
-            /* Convert bytes to bits per second */
-            g_collector->metrics.bandwidth_rx_bps = 
-                (g_collector->total_rx_bytes * 8 * 1000000ULL) / window_duration_us;
-            g_collector->metrics.bandwidth_tx_bps = 
-                (g_collector->total_tx_bytes * 8 * 1000000ULL) / window_duration_us;
+
+    if (!collector || !collector->enabled) {
+        return -ENOENT;
+    }
+
+    metrics_publish(collector);
+    metrics_read_published(collector, metrics_out);
+    return 0;
+}
+
+/* Fold one collector into a cross-session aggregate */
+static void metrics_registry_accumulate(struct metrics_collector *c,
+                                        struct telescope_metrics *agg,
+                                        struct histogram *hists) {
+    struct telescope_metrics m;
+    metrics_aggregate(c, &m);
+
+    agg->frames_total += m.frames_total;
+    agg->frames_dropped += m.frames_dropped;
+    agg->frames_per_second += m.frames_per_second;
+    agg->bandwidth_rx_bps += m.bandwidth_rx_bps;
+    agg->bandwidth_tx_bps += m.bandwidth_tx_bps;
+    agg->input_events_total += m.input_events_total;
+    agg->input_events_predicted += m.input_events_predicted;
+    agg->input_events_reconciled += m.input_events_reconciled;
+
+    /* Worst session wins for last-value gauges */
+    if (m.end_to_end_latency_ms > agg->end_to_end_latency_ms) {
+        agg->end_to_end_latency_ms = m.end_to_end_latency_ms;
+    }
+    if (m.input_lag_ms > agg->input_lag_ms) {
+        agg->input_lag_ms = m.input_lag_ms;
+    }
+    if (m.frame_delay_ms > agg->frame_delay_ms) {
+        agg->frame_delay_ms = m.frame_delay_ms;
+    }
+
+    struct histogram hist;
+    for (size_t k = 0; k < METRICS_LATENCY_KIND_COUNT; k++) {
+        latency_copy(&c->latency[k], &hist, false);
+        histogram_merge(&hists[k], &hist);
+    }
+}
+
+int metrics_registry_snapshot(struct telescope_metrics *metrics_out) {
+    if (!metrics_out) {
+        return -EINVAL;
+    }
+
+    struct histogram hists[METRICS_LATENCY_KIND_COUNT];
+    for (size_t k = 0; k < METRICS_LATENCY_KIND_COUNT; k++) {
+        histogram_reset(&hists[k]);
+    }
+    memset(metrics_out, 0, sizeof(*metrics_out));
+
+    size_t collectors = 0;
+    pthread_mutex_lock(&g_registry_lock);
+
+    struct metrics_collector *def = atomic_load_explicit(&g_collector, memory_order_acquire);
+    if (def && def->enabled) {
+        metrics_registry_accumulate(def, metrics_out, hists);
+        collectors++;
+    }
+    for (size_t i = 0; i < METRICS_MAX_SESSIONS; i++) {
+        struct metrics_collector *c = g_registry[i].collector;
+        if (c && c->enabled) {
+            metrics_registry_accumulate(c, metrics_out, hists);
+            collectors++;
         }
     }
-    
-    g_collector->bandwidth_last_update_us = now_us;
+
+    pthread_mutex_unlock(&g_registry_lock);
+
+    if (collectors == 0) {
+        return -ENOENT;
+    }
+
+    /* Percentiles over the merged distributions, not averages of percentiles */
+    histogram_percentiles(&hists[METRICS_LATENCY_END_TO_END], &metrics_out->end_to_end_latency);
+    histogram_percentiles(&hists[METRICS_LATENCY_INPUT_LAG], &metrics_out->input_lag);
+    histogram_percentiles(&hists[METRICS_LATENCY_FRAME_DELAY], &metrics_out->frame_delay);
+    metrics_out->timestamp_us = metrics_now_us(NULL);
+    return 0;
 }
 
-void metrics_record_latency(uint32_t end_to_end_ms, uint32_t input_lag_ms) {
-    if (!g_collector || !g_collector->enabled) {
+static void metrics_sum_counters(struct metrics_collector *c,
+                                 struct metrics_counters *counters_out) {
+    memset(counters_out, 0, sizeof(*counters_out));
+    for (size_t i = 0; i < METRICS_SHARD_COUNT; i++) {
+        struct metrics_shard *shard = &c->shards[i];
+        counters_out->frames_total += counter_load(&shard->frames_total);
+        counters_out->frames_dropped += counter_load(&shard->frames_dropped);
+        counters_out->input_events_total += counter_load(&shard->input_events_total);
+        counters_out->input_events_predicted += counter_load(&shard->input_events_predicted);
+        counters_out->input_events_reconciled += counter_load(&shard->input_events_reconciled);
+        counters_out->rx_bytes += counter_load(&shard->rx_bytes);
+        counters_out->tx_bytes += counter_load(&shard->tx_bytes);
+    }
+    counters_out->timestamp_us = metrics_now_us(c);
+}
+
+int metrics_collector_counters(struct metrics_counters *counters_out) {
+    if (!counters_out) {
+        return -EINVAL;
+    }
+
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return -ENOENT;
+    }
+
+    metrics_sum_counters(c, counters_out);
+    return 0;
+}
+
+static void lens_lock(struct metrics_collector *c) {
+    while (atomic_flag_test_and_set_explicit(&c->lens_lock, memory_order_acquire)) {
+        /* Spin: lens switches and reads are rare and short */
+    }
+}
+
+static void lens_unlock(struct metrics_collector *c) {
+    atomic_flag_clear_explicit(&c->lens_lock, memory_order_release);
+}
+
+/* dst += cur - mark */
+static void counters_accumulate(struct metrics_counters *dst,
+                                const struct metrics_counters *cur,
+                                const struct metrics_counters *mark) {
+    dst->frames_total += cur->frames_total - mark->frames_total;
+    dst->frames_dropped += cur->frames_dropped - mark->frames_dropped;
+    dst->input_events_total += cur->input_events_total - mark->input_events_total;
+    dst->input_events_predicted += cur->input_events_predicted - mark->input_events_predicted;
+    dst->input_events_reconciled += cur->input_events_reconciled - mark->input_events_reconciled;
+    dst->rx_bytes += cur->rx_bytes - mark->rx_bytes;
+    dst->tx_bytes += cur->tx_bytes - mark->tx_bytes;
+}
+
+void metrics_set_active_lens(telescope_lens_t lens) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
         return;
     }
-    
-    g_collector->metrics.end_to_end_latency_ms = end_to_end_ms;
-    g_collector->metrics.input_lag_ms = input_lag_ms;
+
+    struct metrics_counters cur;
+    metrics_sum_counters(c, &cur);
+
+    lens_lock(c);
+    if (c->active_lens >= 0) {
+        counters_accumulate(&c->lens_base[c->active_lens], &cur, &c->lens_mark);
+    }
+    c->lens_mark = cur;
+    c->active_lens = ((int)lens >= 0 && (int)lens < METRICS_SHM_LENS_SLOTS) ? (int)lens : -1;
+    lens_unlock(c);
 }
 
-int metrics_collector_flush(void) {
-    if (!g_collector || !g_collector->enabled || !g_collector->metrics_fp) {
+int metrics_lens_counters(telescope_lens_t lens, struct metrics_counters *counters_out,
+                          bool *active_out) {
+    if (!counters_out || (int)lens < 0 || (int)lens >= METRICS_SHM_LENS_SLOTS) {
+        return -EINVAL;
+    }
+
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return -ENOENT;
+    }
+
+    struct metrics_counters cur;
+    metrics_sum_counters(c, &cur);
+
+    lens_lock(c);
+    *counters_out = c->lens_base[lens];
+    bool active = c->active_lens == (int)lens;
+    if (active) {
+        counters_accumulate(counters_out, &cur, &c->lens_mark);
+    }
+    lens_unlock(c);
+
+    counters_out->timestamp_us = cur.timestamp_us;
+    if (active_out) {
+        *active_out = active;
+    }
+    return 0;
+}
+
+static inline size_t surface_hash(uint64_t surface_id) {
+    return (size_t)((surface_id * 0x9E3779B97F4A7C15ULL) >> 32) & (METRICS_SURFACE_TABLE_SIZE - 1);
+}
+
+static void surface_lock(struct metrics_collector *c) {
+    while (atomic_flag_test_and_set_explicit(&c->surface_lock, memory_order_acquire)) {
+        /* Spin: only a surface's first frame and its release get here */
+    }
+}
+
+static void surface_unlock(struct metrics_collector *c) {
+    atomic_flag_clear_explicit(&c->surface_lock, memory_order_release);
+}
+
+/* Slot tracking surface_id; probes past released slots up to a free one */
+static struct metrics_surface_slot *surface_find(struct metrics_collector *c, uint64_t surface_id) {
+    size_t i = surface_hash(surface_id);
+    for (size_t n = 0; n < METRICS_SURFACE_TABLE_SIZE; n++) {
+        uint64_t id = atomic_load_explicit(&c->surfaces[i].surface_id, memory_order_acquire);
+        if (id == surface_id) {
+            return &c->surfaces[i];
+        }
+        if (id == 0) {
+            return NULL;
+        }
+        i = (i + 1) & (METRICS_SURFACE_TABLE_SIZE - 1);
+    }
+    return NULL;
+}
+
+/* Find or claim a surface's slot; NULL once METRICS_MAX_SURFACES are tracked */
+static struct metrics_surface_slot *surface_claim(struct metrics_collector *c, uint64_t surface_id) {
+    surface_lock(c);
+    struct metrics_surface_slot *slot = surface_find(c, surface_id);
+    if (!slot && c->surface_count < METRICS_MAX_SURFACES) {
+        /* Claims are serialized, so the first free or released slot of the run is ours */
+        size_t i = surface_hash(surface_id);
+        for (;;) {
+            uint64_t id = atomic_load_explicit(&c->surfaces[i].surface_id, memory_order_relaxed);
+            if (id == 0 || id == METRICS_SURFACE_TOMBSTONE) {
+                break;
+            }
+            i = (i + 1) & (METRICS_SURFACE_TABLE_SIZE - 1);
+        }
+        slot = &c->surfaces[i];
+        atomic_store_explicit(&slot->surface_id, surface_id, memory_order_release);
+        c->surface_count++;
+    }
+    surface_unlock(c);
+    return slot;
+}
+
+void metrics_record_surface_frame(uint64_t surface_id, uint64_t latency_us, bool dropped) {
+    struct metrics_collector *c = metrics_active();
+    if (!c || surface_id == 0 || surface_id == METRICS_SURFACE_TOMBSTONE) {
+        return;
+    }
+
+    struct metrics_surface_slot *slot = surface_find(c, surface_id);
+    if (!slot) {
+        slot = surface_claim(c, surface_id);
+    }
+    if (!slot) {
+        counter_add(&c->surface_frames_untracked, 1);
+        return;
+    }
+
+    counter_add(&slot->frames_total, 1);
+    if (dropped) {
+        counter_add(&slot->frames_dropped, 1);
+    } else {
+        atomic_store_explicit(&slot->last_latency_us, latency_us, memory_order_relaxed);
+    }
+}
+
+void metrics_surface_release(uint64_t surface_id) {
+    struct metrics_collector *c = metrics_active();
+    if (!c || surface_id == 0 || surface_id == METRICS_SURFACE_TOMBSTONE) {
+        return;
+    }
+
+    surface_lock(c);
+    struct metrics_surface_slot *slot = surface_find(c, surface_id);
+    if (!slot) {
+        surface_unlock(c);
+        return;
+    }
+
+    atomic_store_explicit(&slot->frames_total, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->frames_dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->last_latency_us, 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->surface_id, METRICS_SURFACE_TOMBSTONE, memory_order_release);
+    c->surface_count--;
+
+    /*
+     * A released slot right before a free one ends no probe run: free it,
+     * and the released slots before it, so tombstones do not pile up.
+     */
+    size_t i = (size_t)(slot - c->surfaces);
+    size_t next = (i + 1) & (METRICS_SURFACE_TABLE_SIZE - 1);
+    while (atomic_load_explicit(&c->surfaces[next].surface_id, memory_order_relaxed) == 0 &&
+           atomic_load_explicit(&c->surfaces[i].surface_id, memory_order_relaxed) ==
+               METRICS_SURFACE_TOMBSTONE) {
+        atomic_store_explicit(&c->surfaces[i].surface_id, 0, memory_order_release);
+        next = i;
+        i = (i - 1) & (METRICS_SURFACE_TABLE_SIZE - 1);
+    }
+    surface_unlock(c);
+}
+
+/* Copy out up to max surfaces; returns how many are tracked */
+static size_t metrics_collect_surfaces(struct metrics_collector *c,
+                                       struct metrics_surface_counters *out, size_t max) {
+    size_t tracked = 0;
+    for (size_t i = 0; i < METRICS_SURFACE_TABLE_SIZE; i++) {
+        struct metrics_surface_slot *slot = &c->surfaces[i];
+        uint64_t id = atomic_load_explicit(&slot->surface_id, memory_order_acquire);
+        if (id == 0 || id == METRICS_SURFACE_TOMBSTONE) {
+            continue;
+        }
+        if (tracked < max) {
+            out[tracked].surface_id = id;
+            out[tracked].frames_total = counter_load(&slot->frames_total);
+            out[tracked].frames_dropped = counter_load(&slot->frames_dropped);
+            out[tracked].last_latency_us = counter_load(&slot->last_latency_us);
+        }
+        tracked++;
+    }
+    return tracked;
+}
+
+size_t metrics_surface_counters(struct metrics_surface_counters *counters_out, size_t max) {
+    struct metrics_collector *c = metrics_active();
+    if (!c || !counters_out) {
         return 0;
     }
-    
-    /* Write metrics to file as JSON */
-    fprintf(g_collector->metrics_fp,
-            "{\"timestamp\":%llu,"
-            "\"end_to_end_latency_ms\":%u,"
-            "\"input_lag_ms\":%u,"
-            "\"frame_delay_ms\":%u,"
-            "\"frames_per_second\":%u,"
-            "\"frames_dropped\":%u,"
-            "\"frames_total\":%u,"
-            "\"bandwidth_rx_bps\":%llu,"
-            "\"bandwidth_tx_bps\":%llu,"
-            "\"input_events_predicted\":%u,"
-            "\"input_events_reconciled\":%u,"
-            "\"input_events_total\":%u}\n",
-            (unsigned long long)g_collector->metrics.timestamp_us,
-            g_collector->metrics.end_to_end_latency_ms,
-            g_collector->metrics.input_lag_ms,
-            g_collector->metrics.frame_delay_ms,
-            g_collector->metrics.frames_per_second,
-            g_collector->metrics.frames_dropped,
-            g_collector->metrics.frames_total,
-            (unsigned long long)g_collector->metrics.bandwidth_rx_bps,
-            (unsigned long long)g_collector->metrics.bandwidth_tx_bps,
-            g_collector->metrics.input_events_predicted,
-            g_collector->metrics.input_events_reconciled,
-            g_collector->metrics.input_events_total);
-    
-    fflush(g_collector->metrics_fp);
+    size_t tracked = metrics_collect_surfaces(c, counters_out, max);
+    return tracked < max ? tracked : max;
+}
+
+uint64_t metrics_surface_frames_untracked(void) {
+    struct metrics_collector *c = metrics_active();
+    return c ? counter_load(&c->surface_frames_untracked) : 0;
+}
+
+/* Build a payload and copy it into the shared-memory region */
+static void metrics_shm_export(struct metrics_collector *c, const struct telescope_metrics *m) {
+    if (atomic_flag_test_and_set_explicit(&c->shm_lock, memory_order_acquire)) {
+        return;  /* Another flush is exporting */
+    }
+
+    struct metrics_shm_payload payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.metrics = *m;
+
+    payload.lens_count = METRICS_SHM_LENS_SLOTS;
+    for (uint32_t lens = 0; lens < METRICS_SHM_LENS_SLOTS; lens++) {
+        struct metrics_counters lc;
+        bool active = false;
+        (void)metrics_lens_counters((telescope_lens_t)lens, &lc, &active);
+        payload.lenses[lens] = (struct metrics_shm_lens){
+            .lens = lens,
+            .active = active,
+            .frames_total = lc.frames_total,
+            .frames_dropped = lc.frames_dropped,
+            .rx_bytes = lc.rx_bytes,
+            .tx_bytes = lc.tx_bytes,
+        };
+    }
+
+    struct metrics_surface_counters surfaces[METRICS_SHM_SURFACE_SLOTS];
+    size_t tracked = metrics_collect_surfaces(c, surfaces, METRICS_SHM_SURFACE_SLOTS);
+    size_t n = tracked < METRICS_SHM_SURFACE_SLOTS ? tracked : METRICS_SHM_SURFACE_SLOTS;
+    payload.surface_count = (uint32_t)n;
+    payload.surfaces_tracked = (uint32_t)tracked;
+    payload.surface_frames_untracked = counter_load(&c->surface_frames_untracked);
+    for (size_t i = 0; i < n; i++) {
+        payload.surfaces[i] = (struct metrics_shm_surface){
+            .surface_id = surfaces[i].surface_id,
+            .frames_total = surfaces[i].frames_total,
+            .frames_dropped = surfaces[i].frames_dropped,
+            .last_latency_us = surfaces[i].last_latency_us,
+        };
+    }
+
+    metrics_shm_publish(c->shm, &payload);
+    atomic_flag_clear_explicit(&c->shm_lock, memory_order_release);
+}
+
+int metrics_collector_apply_interval(const struct metrics_interval *interval) {
+    if (!interval) {
+        return -EINVAL;
+    }
+
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
+        return -ENOENT;
+    }
+
+    atomic_store_explicit(&c->gauges.frames_per_second,
+                          (uint32_t)(interval->frames_per_second + 0.5),
+                          memory_order_relaxed);
     return 0;
 }
 
+int metrics_collector_flush(void) {
+    struct metrics_collector *c = metrics_active();
+    if (!c || (!c->writer && !c->shm)) {
+        return 0;
+    }
+
+    struct telescope_metrics m;
+    metrics_publish(c);
+    metrics_read_published(c, &m);
+
+    if (c->shm) {
+        metrics_shm_export(c, &m);
+    }
+
+    /* Formatting and file I/O happen on the writer thread */
+    return c->writer ? metrics_writer_submit(c->writer, &m) : 0;
+}
+
 const struct telescope_metrics *metrics_collector_get(void) {
-    if (!g_collector || !g_collector->enabled) {
+    struct metrics_collector *c = metrics_active();
+    if (!c) {
         return NULL;
     }
-    
-    return &g_collector->metrics;
-}
 
+    metrics_publish(c);
+    return &c->published;
+}
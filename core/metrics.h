@@ -0,0 +1,440 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "telescope.h"
+#include "histogram.h"
+#include "frame_timing.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Metrics collection and observability
+ *
+ * Recording functions are safe to call concurrently from any thread
+ * (compositor, lens I/O, input). Hot-path counters live in per-thread
+ * shards updated with relaxed atomics; readers obtain a consistent
+ * aggregated view through metrics_collector_snapshot().
+ *
+ * Each session can own a collector created with
+ * metrics_collector_create() and registered under its session handle.
+ * Recording functions write to the collector bound to the calling thread
+ * (metrics_bind()). A thread that is not bound records into the
+ * process-wide default collector from metrics_collector_init(), or
+ * nowhere if there is none: with several sessions in one process an
+ * unbound thread cannot be attributed to any of them. Every thread that
+ * records for a session (compositor, lens I/O, input) must therefore
+ * bind to its collector.
+ *
+ * Session collectors may be destroyed while other threads are bound to
+ * them: those threads stop recording into it and the memory is freed
+ * when the last of them lets go. metrics_collector_init() and
+ * metrics_collector_cleanup() must still not race with unbound recorders.
+ */
+
+#define METRICS_MAX_SESSIONS 64
+
+struct metrics_collector;
+struct utils_clock;
+
+/**
+ * Latency series tracked with histograms
+ */
+typedef enum {
+    METRICS_LATENCY_END_TO_END,
+    METRICS_LATENCY_INPUT_LAG,
+    METRICS_LATENCY_FRAME_DELAY,
+    METRICS_LATENCY_KIND_COUNT
+} metrics_latency_kind_t;
+
+/**
+ * Cumulative raw counters (monotonic, 64-bit)
+ */
+struct metrics_counters {
+    uint64_t frames_total;
+    uint64_t frames_dropped;
+    uint64_t input_events_total;
+    uint64_t input_events_predicted;
+    uint64_t input_events_reconciled;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint64_t timestamp_us;  /* When the counters were read (monotonic) */
+};
+
+#define METRICS_MAX_SURFACES 1024  /* Power of two */
+
+/**
+ * Per-surface frame counters
+ */
+struct metrics_surface_counters {
+    uint64_t surface_id;
+    uint64_t frames_total;
+    uint64_t frames_dropped;
+    uint64_t last_latency_us;
+};
+
+/**
+ * Rates derived from two counter readings one sampling interval apart
+ */
+struct metrics_interval {
+    uint64_t start_us;
+    uint64_t end_us;
+    uint64_t frames;
+    uint64_t frames_dropped;
+    double frames_per_second;
+    double drop_rate;               /* Dropped / total frames in the interval */
+    uint64_t bandwidth_rx_bps;
+    uint64_t bandwidth_tx_bps;
+    uint64_t input_events;
+    double predictions_per_second;
+    double prediction_rate;         /* Predicted / total input events in the interval */
+};
+
+/**
+ * Initialize the metrics collector
+ *
+ * @param obs_config Observability configuration (metrics disabled if NULL or !enable_metrics)
+ * @return 0 on success, -EBUSY if already initialized, negative error code on failure
+ */
+int metrics_collector_init(const telescope_observability_t *obs_config);
+
+/**
+ * Cleanup the metrics collector
+ */
+void metrics_collector_cleanup(void);
+
+/**
+ * Create a per-session collector and register it
+ *
+ * With metrics_shm enabled the collector exports to
+ * /dev/shm/lunar-telescope.<pid>.<slot>.
+ *
+ * @param key Session handle the collector is registered under
+ * @param obs_config Observability configuration
+ * @param collector_out Output collector (NULL if metrics are disabled)
+ * @return 0 on success, -EEXIST if key is already registered,
+ *         -ENOSPC if METRICS_MAX_SESSIONS are registered, negative error code on failure
+ */
+int metrics_collector_create(const void *key, const telescope_observability_t *obs_config,
+                             struct metrics_collector **collector_out);
+
+/**
+ * Unregister and release a per-session collector
+ *
+ * Recording into the collector stops at once and the calling thread is
+ * unbound. Threads bound elsewhere hold references; the collector (and
+ * its file and shared-memory export) is freed when the last of them
+ * records again, rebinds or exits.
+ */
+void metrics_collector_destroy(struct metrics_collector *collector);
+
+/**
+ * Take a reference on a collector
+ *
+ * The caller must already hold a reference (own it, or be bound to it).
+ *
+ * @param collector Collector (NULL is passed through)
+ * @return collector
+ */
+struct metrics_collector *metrics_collector_ref(struct metrics_collector *collector);
+
+/**
+ * Drop a reference taken with metrics_collector_ref()
+ */
+void metrics_collector_unref(struct metrics_collector *collector);
+
+/**
+ * Find the collector registered for a session
+ *
+ * @param key Session handle
+ * @return Collector, or NULL if none is registered
+ */
+struct metrics_collector *metrics_registry_lookup(const void *key);
+
+/**
+ * Number of registered per-session collectors
+ */
+size_t metrics_registry_count(void);
+
+/**
+ * Set the clock a collector stamps snapshots and bandwidth buckets with
+ *
+ * Set it before recording starts; recording threads read the pointer
+ * without synchronization. Latency and presentation times are always
+ * taken from the caller, never from the clock.
+ *
+ * @param collector Collector (NULL is ignored)
+ * @param clock Clock provider (must outlive the collector), or NULL for
+ *              the system monotonic clock
+ */
+void metrics_collector_set_clock(struct metrics_collector *collector, struct utils_clock *clock);
+
+/**
+ * Direct this thread's recording to a collector
+ *
+ * The binding holds a reference until the thread rebinds or exits. The
+ * caller must hold a reference to bind (see metrics_collector_ref()).
+ *
+ * @param collector Collector to record into (NULL = default collector)
+ */
+void metrics_bind(struct metrics_collector *collector);
+
+/**
+ * Collector the calling thread is bound to (NULL = default collector)
+ */
+struct metrics_collector *metrics_bound(void);
+
+/**
+ * Record a presented (or dropped) frame
+ *
+ * @param latency_ms Frame delay in milliseconds
+ * @param dropped Whether the frame was dropped
+ */
+void metrics_record_frame(uint32_t latency_ms, bool dropped);
+
+/**
+ * Record a presented (or dropped) frame with microsecond latency
+ *
+ * Non-dropped frames are added to the frame-delay histogram.
+ *
+ * @param latency_us Frame delay in microseconds
+ * @param dropped Whether the frame was dropped
+ */
+void metrics_record_frame_us(uint64_t latency_us, bool dropped);
+
+/**
+ * Record a frame together with its presentation timestamp
+ *
+ * Counts the frame like metrics_record_frame_us() and, unless dropped,
+ * feeds the timestamp into the frame pacing window. Snapshot
+ * frames_per_second is then the window mean.
+ *
+ * @param present_us Presentation timestamp in microseconds (CLOCK_MONOTONIC)
+ * @param latency_us Frame delay in microseconds
+ * @param dropped Whether the frame was dropped
+ */
+void metrics_record_frame_presented(uint64_t present_us, uint64_t latency_us, bool dropped);
+
+/**
+ * Set the frame rate that jank is measured against
+ *
+ * @param target_fps Target frame rate (0 = adaptive, relative to the window mean)
+ */
+void metrics_set_target_frame_rate(uint32_t target_fps);
+
+/**
+ * Get frame pacing statistics over the presentation-timestamp window
+ *
+ * @param stats_out Output statistics
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_frame_pacing(struct frame_timing_stats *stats_out);
+
+/**
+ * Record an input event
+ *
+ * @param predicted Whether prediction was applied
+ * @param reconciled Whether the event was reconciled
+ */
+void metrics_record_input_event(bool predicted, bool reconciled);
+
+/**
+ * Record transferred bytes for windowed bandwidth averaging
+ *
+ * @param rx_bytes Bytes received
+ * @param tx_bytes Bytes transmitted
+ */
+void metrics_record_bandwidth(uint64_t rx_bytes, uint64_t tx_bytes);
+
+/**
+ * Record end-to-end and input latency
+ *
+ * @param end_to_end_ms End-to-end latency in milliseconds
+ * @param input_lag_ms Input lag in milliseconds
+ */
+void metrics_record_latency(uint32_t end_to_end_ms, uint32_t input_lag_ms);
+
+/**
+ * Record end-to-end and input latency with microsecond resolution
+ *
+ * @param end_to_end_us End-to-end latency in microseconds
+ * @param input_lag_us Input lag in microseconds
+ */
+void metrics_record_latency_us(uint64_t end_to_end_us, uint64_t input_lag_us);
+
+/**
+ * Get p50/p95/p99/p999 for a latency series since the last take
+ *
+ * @param kind Latency series
+ * @param percentiles_out Output percentiles
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_latency_percentiles(metrics_latency_kind_t kind,
+                                telescope_latency_percentiles_t *percentiles_out);
+
+/**
+ * Copy a latency histogram without resetting it
+ *
+ * The copy can be merged into caller-held windows with histogram_merge().
+ *
+ * @param kind Latency series
+ * @param hist_out Output histogram
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_latency_histogram(metrics_latency_kind_t kind, struct histogram *hist_out);
+
+/**
+ * Move a latency histogram out and start a new window
+ *
+ * Each bucket is atomically exchanged with zero, so no concurrently
+ * recorded sample is lost between the copy and the reset.
+ *
+ * @param kind Latency series
+ * @param hist_out Output histogram (NULL to just reset the window)
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_latency_take(metrics_latency_kind_t kind, struct histogram *hist_out);
+
+/**
+ * Copy out a consistent snapshot of the current collector
+ *
+ * Aggregates all per-thread shards and publishes the result under a
+ * seqlock; the copy never observes a partially written snapshot.
+ *
+ * @param metrics_out Output metrics structure
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_collector_snapshot(struct telescope_metrics *metrics_out);
+
+/**
+ * Copy out a consistent snapshot of one session's collector
+ *
+ * @param collector Session collector
+ * @param metrics_out Output metrics structure
+ * @return 0 on success, -ENOENT if collector is NULL, -EINVAL on bad args
+ */
+int metrics_session_snapshot(struct metrics_collector *collector,
+                             struct telescope_metrics *metrics_out);
+
+/**
+ * Aggregate all collectors (default and per-session) into one view
+ *
+ * Counters, frame rates and bandwidth are summed, last-value latency
+ * gauges report the worst session, and percentiles are computed over the
+ * merged latency histograms.
+ *
+ * @param metrics_out Output metrics structure
+ * @return 0 on success, -ENOENT if no collector exists, -EINVAL on bad args
+ */
+int metrics_registry_snapshot(struct telescope_metrics *metrics_out);
+
+/**
+ * Read the cumulative counters (summed over all shards)
+ *
+ * @param counters_out Output counters
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_collector_counters(struct metrics_counters *counters_out);
+
+/**
+ * Attribute subsequently recorded counters to a lens
+ *
+ * Called when a session starts or switches transport.
+ *
+ * @param lens Active lens (TELESCOPE_LENS_AUTO clears attribution)
+ */
+void metrics_set_active_lens(telescope_lens_t lens);
+
+/**
+ * Read the counters accumulated while a lens was active
+ *
+ * @param lens Lens type
+ * @param counters_out Output counters
+ * @param active_out Whether the lens is currently active (optional)
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_lens_counters(telescope_lens_t lens, struct metrics_counters *counters_out,
+                          bool *active_out);
+
+/**
+ * Count a frame for one surface
+ *
+ * Up to METRICS_MAX_SURFACES surfaces are tracked; frames of further
+ * surfaces are still counted in the totals, and in
+ * metrics_surface_frames_untracked(), but not individually.
+ *
+ * @param surface_id Surface identifier (not 0 or UINT64_MAX)
+ * @param latency_us Frame delay in microseconds
+ * @param dropped Whether the frame was dropped
+ */
+void metrics_record_surface_frame(uint64_t surface_id, uint64_t latency_us, bool dropped);
+
+/**
+ * Stop tracking a surface and free its slot
+ *
+ * @param surface_id Surface identifier
+ */
+void metrics_surface_release(uint64_t surface_id);
+
+/**
+ * Copy out the tracked surfaces' counters
+ *
+ * @param counters_out Output array (METRICS_MAX_SURFACES entries hold every surface)
+ * @param max Capacity of counters_out
+ * @return Number of entries written
+ */
+size_t metrics_surface_counters(struct metrics_surface_counters *counters_out, size_t max);
+
+/**
+ * Frames recorded for surfaces that were not tracked
+ *
+ * Non-zero once a surface found METRICS_MAX_SURFACES others tracked:
+ * the per-surface counters then leave surfaces out.
+ *
+ * @return Frame count (0 if no collector is active)
+ */
+uint64_t metrics_surface_frames_untracked(void);
+
+/**
+ * Publish per-interval rates computed by a sampler
+ *
+ * frames_per_second in snapshots reports the interval rate unless
+ * presentation timestamps are recorded, whose window mean takes precedence.
+ *
+ * @param interval Completed interval
+ * @return 0 on success, -ENOENT if no collector is active, -EINVAL on bad args
+ */
+int metrics_collector_apply_interval(const struct metrics_interval *interval);
+
+/**
+ * Queue the current snapshot for the metrics file (if configured)
+ *
+ * With metrics_shm enabled the snapshot, per-lens and per-surface
+ * counters are also published to the shared-memory region.
+ *
+ * Non-blocking: the record is formatted and written in a batch by the
+ * background writer thread, in the configured metrics_format.
+ *
+ * @return 0 on success, -EAGAIN if the writer queue is full (record dropped)
+ */
+int metrics_collector_flush(void);
+
+/**
+ * Get a pointer to the most recently published snapshot
+ *
+ * Legacy accessor: the pointed-to structure is rewritten by later
+ * publishes. Concurrent readers should use metrics_collector_snapshot().
+ *
+ * @return Pointer to the published snapshot, or NULL if metrics are disabled
+ */
+const struct telescope_metrics *metrics_collector_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
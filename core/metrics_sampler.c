@@ -0,0 +1,281 @@
+#include "metrics_sampler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+/**
+ * Metrics sampler implementation
+ *
+ * Counters are cumulative, so an interval is just the difference of two
+ * readings; samples lost to a late wakeup widen the next interval rather
+ * than dropping events.
+ */
+
+struct metrics_sampler {
+    struct metrics_collector *collector;  /* NULL = default collector */
+    int timer_fd;
+    int stop_fd;
+    uint32_t interval_ms;
+
+    struct metrics_counters prev;
+    bool have_prev;
+
+    pthread_mutex_t last_lock;
+    struct metrics_interval last;
+    bool have_last;
+
+    pthread_t thread;
+    bool thread_running;
+};
+
+static uint64_t delta_u64(uint64_t cur, uint64_t prev) {
+    return cur >= prev ? cur - prev : 0;
+}
+
+int metrics_interval_compute(const struct metrics_counters *prev,
+                             const struct metrics_counters *cur,
+                             struct metrics_interval *interval_out) {
+    if (!prev || !cur || !interval_out || cur->timestamp_us <= prev->timestamp_us) {
+        return -EINVAL;
+    }
+
+    memset(interval_out, 0, sizeof(*interval_out));
+
+    uint64_t dt_us = cur->timestamp_us - prev->timestamp_us;
+    double seconds = (double)dt_us / 1e6;
+
+    interval_out->start_us = prev->timestamp_us;
+    interval_out->end_us = cur->timestamp_us;
+    interval_out->frames = delta_u64(cur->frames_total, prev->frames_total);
+    interval_out->frames_dropped = delta_u64(cur->frames_dropped, prev->frames_dropped);
+    interval_out->frames_per_second = (double)interval_out->frames / seconds;
+    if (interval_out->frames > 0) {
+        interval_out->drop_rate = (double)interval_out->frames_dropped /
+                                  (double)interval_out->frames;
+    }
+
+    /* Bits per second, matching telescope_metrics */
+    interval_out->bandwidth_rx_bps =
+        (uint64_t)((double)delta_u64(cur->rx_bytes, prev->rx_bytes) * 8.0 / seconds);
+    interval_out->bandwidth_tx_bps =
+        (uint64_t)((double)delta_u64(cur->tx_bytes, prev->tx_bytes) * 8.0 / seconds);
+
+    uint64_t predicted = delta_u64(cur->input_events_predicted, prev->input_events_predicted);
+    interval_out->input_events = delta_u64(cur->input_events_total, prev->input_events_total);
+    interval_out->predictions_per_second = (double)predicted / seconds;
+    if (interval_out->input_events > 0) {
+        interval_out->prediction_rate = (double)predicted / (double)interval_out->input_events;
+    }
+
+    return 0;
+}
+
+int metrics_sampler_create(struct metrics_collector *collector, uint32_t interval_ms,
+                           struct metrics_sampler **sampler_out) {
+    if (interval_ms == 0 || !sampler_out) {
+        return -EINVAL;
+    }
+
+    struct metrics_sampler *sampler = calloc(1, sizeof(struct metrics_sampler));
+    if (!sampler) {
+        return -ENOMEM;
+    }
+
+    sampler->collector = collector;
+    sampler->interval_ms = interval_ms;
+    sampler->stop_fd = -1;
+    sampler->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (sampler->timer_fd < 0) {
+        int ret = -errno;
+        free(sampler);
+        return ret;
+    }
+
+    struct itimerspec spec = {
+        .it_interval = {
+            .tv_sec = interval_ms / 1000,
+            .tv_nsec = (long)(interval_ms % 1000) * 1000000L,
+        },
+    };
+    spec.it_value = spec.it_interval;
+
+    if (timerfd_settime(sampler->timer_fd, 0, &spec, NULL) < 0) {
+        int ret = -errno;
+        close(sampler->timer_fd);
+        free(sampler);
+        return ret;
+    }
+
+    pthread_mutex_init(&sampler->last_lock, NULL);
+
+    /* Baseline so the first tick already yields a full interval */
+    (void)metrics_sampler_sample(sampler);
+
+    *sampler_out = sampler;
+    return 0;
+}
+
+static void metrics_sampler_stop_thread(struct metrics_sampler *sampler) {
+    if (!sampler->thread_running) {
+        return;
+    }
+
+    uint64_t one = 1;
+    ssize_t n = write(sampler->stop_fd, &one, sizeof(one));
+    (void)n;
+    pthread_join(sampler->thread, NULL);
+    sampler->thread_running = false;
+
+    close(sampler->stop_fd);
+    sampler->stop_fd = -1;
+}
+
+void metrics_sampler_destroy(struct metrics_sampler *sampler) {
+    if (!sampler) {
+        return;
+    }
+
+    metrics_sampler_stop_thread(sampler);
+    close(sampler->timer_fd);
+    pthread_mutex_destroy(&sampler->last_lock);
+    free(sampler);
+}
+
+int metrics_sampler_get_fd(const struct metrics_sampler *sampler) {
+    return sampler ? sampler->timer_fd : -1;
+}
+
+/* Sample the collector bound to the calling thread */
+static int metrics_sampler_sample_bound(struct metrics_sampler *sampler) {
+    struct metrics_counters cur;
+    int ret = metrics_collector_counters(&cur);
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (!sampler->have_prev) {
+        sampler->prev = cur;
+        sampler->have_prev = true;
+        return 0;
+    }
+
+    struct metrics_interval interval;
+    ret = metrics_interval_compute(&sampler->prev, &cur, &interval);
+    if (ret < 0) {
+        return ret;
+    }
+    sampler->prev = cur;
+
+    pthread_mutex_lock(&sampler->last_lock);
+    sampler->last = interval;
+    sampler->have_last = true;
+    pthread_mutex_unlock(&sampler->last_lock);
+
+    (void)metrics_collector_apply_interval(&interval);
+    (void)metrics_collector_flush();
+    return 1;
+}
+
+int metrics_sampler_sample(struct metrics_sampler *sampler) {
+    if (!sampler) {
+        return -EINVAL;
+    }
+
+    /* Work on the sampler's collector whichever thread dispatches */
+    struct metrics_collector *prev_bound = metrics_collector_ref(metrics_bound());
+    metrics_bind(sampler->collector);
+    int ret = metrics_sampler_sample_bound(sampler);
+    metrics_bind(prev_bound);
+    metrics_collector_unref(prev_bound);
+
+    return ret;
+}
+
+int metrics_sampler_dispatch(struct metrics_sampler *sampler) {
+    if (!sampler) {
+        return -EINVAL;
+    }
+
+    uint64_t expirations = 0;
+    ssize_t n = read(sampler->timer_fd, &expirations, sizeof(expirations));
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -errno;
+    }
+    if (n != sizeof(expirations) || expirations == 0) {
+        return 0;
+    }
+
+    /* Missed ticks collapse into one wider interval */
+    return metrics_sampler_sample(sampler);
+}
+
+static void *metrics_sampler_thread(void *arg) {
+    struct metrics_sampler *sampler = arg;
+    struct pollfd fds[2] = {
+        { .fd = sampler->timer_fd, .events = POLLIN },
+        { .fd = sampler->stop_fd, .events = POLLIN },
+    };
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            (void)metrics_sampler_dispatch(sampler);
+        }
+    }
+
+    return NULL;
+}
+
+int metrics_sampler_start_thread(struct metrics_sampler *sampler) {
+    if (!sampler) {
+        return -EINVAL;
+    }
+
+    if (sampler->thread_running) {
+        return -EALREADY;
+    }
+
+    sampler->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (sampler->stop_fd < 0) {
+        return -errno;
+    }
+
+    int ret = pthread_create(&sampler->thread, NULL, metrics_sampler_thread, sampler);
+    if (ret != 0) {
+        close(sampler->stop_fd);
+        sampler->stop_fd = -1;
+        return -ret;
+    }
+
+    sampler->thread_running = true;
+    return 0;
+}
+
+int metrics_sampler_last_interval(struct metrics_sampler *sampler,
+                                  struct metrics_interval *interval_out) {
+    if (!sampler || !interval_out) {
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&sampler->last_lock);
+    bool have = sampler->have_last;
+    if (have) {
+        *interval_out = sampler->last;
+    }
+    pthread_mutex_unlock(&sampler->last_lock);
+
+    return have ? 0 : -ENOENT;
+}
@@ -0,0 +1,105 @@
+#ifndef METRICS_SAMPLER_H
+#define METRICS_SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "metrics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Timer-driven metrics sampling
+ *
+ * A sampler owns a timerfd armed at metrics_interval_ms. On every
+ * expiration it reads the collector's cumulative counters, derives
+ * per-interval rates from the previous reading, publishes them to the
+ * collector and queues a snapshot for the metrics file. Recording
+ * threads are never touched.
+ *
+ * The sampler can be driven by an existing event loop (poll
+ * metrics_sampler_get_fd() for readability and call
+ * metrics_sampler_dispatch()), or by its own thread.
+ */
+
+struct metrics_sampler;
+
+/**
+ * Create a sampler and arm its timer
+ *
+ * @param collector Collector to sample (NULL = default collector)
+ * @param interval_ms Sampling interval in milliseconds (must be > 0)
+ * @param sampler_out Output sampler handle
+ * @return 0 on success, negative error code on failure
+ */
+int metrics_sampler_create(struct metrics_collector *collector, uint32_t interval_ms,
+                           struct metrics_sampler **sampler_out);
+
+/**
+ * Stop the sampler thread (if running), disarm the timer and free the sampler
+ */
+void metrics_sampler_destroy(struct metrics_sampler *sampler);
+
+/**
+ * Get the timer file descriptor for integration in an external event loop
+ *
+ * @return Readable fd that becomes ready once per interval
+ */
+int metrics_sampler_get_fd(const struct metrics_sampler *sampler);
+
+/**
+ * Consume pending timer expirations and take a sample
+ *
+ * Must not be called while the sampler thread is running.
+ *
+ * @param sampler Sampler handle
+ * @return 1 if an interval was completed, 0 if the timer had not expired, negative on error
+ */
+int metrics_sampler_dispatch(struct metrics_sampler *sampler);
+
+/**
+ * Take a sample immediately, independent of the timer
+ *
+ * The first sample only establishes a baseline.
+ *
+ * @param sampler Sampler handle
+ * @return 1 if an interval was completed, 0 for the baseline sample, negative on error
+ */
+int metrics_sampler_sample(struct metrics_sampler *sampler);
+
+/**
+ * Run the sampler on a dedicated thread
+ *
+ * @param sampler Sampler handle
+ * @return 0 on success, -EALREADY if already running, negative error code on failure
+ */
+int metrics_sampler_start_thread(struct metrics_sampler *sampler);
+
+/**
+ * Get the most recently completed interval
+ *
+ * @param sampler Sampler handle
+ * @param interval_out Output interval
+ * @return 0 on success, -ENOENT if no interval has completed yet, -EINVAL on bad args
+ */
+int metrics_sampler_last_interval(struct metrics_sampler *sampler,
+                                  struct metrics_interval *interval_out);
+
+/**
+ * Derive per-interval rates from two counter readings
+ *
+ * @param prev Earlier reading
+ * @param cur Later reading
+ * @param interval_out Output interval
+ * @return 0 on success, -EINVAL if the readings are out of order
+ */
+int metrics_interval_compute(const struct metrics_counters *prev,
+                             const struct metrics_counters *cur,
+                             struct metrics_interval *interval_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_SAMPLER_H */
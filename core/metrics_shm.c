@@ -0,0 +1,244 @@
+#include "metrics_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * Shared-memory metrics export implementation
+ *
+ * The seqlock protocol matches the in-process snapshot in metrics.c:
+ * the writer makes `seq` odd, copies the payload and makes it even
+ * again; readers retry if `seq` was odd or changed across their copy.
+ */
+
+#define METRICS_SHM_READ_RETRIES 1000
+
+struct metrics_shm {
+    struct metrics_shm_region *region;
+    size_t map_size;
+    char name[METRICS_SHM_NAME_MAX];
+};
+
+struct metrics_shm_reader {
+    const struct metrics_shm_region *region;
+    size_t map_size;
+};
+
+static size_t metrics_shm_map_size(void) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t page_size = page > 0 ? (size_t)page : 4096;
+    return (sizeof(struct metrics_shm_region) + page_size - 1) / page_size * page_size;
+}
+
+int metrics_shm_default_name(pid_t pid, char *buf, size_t len) {
+    if (!buf) {
+        return -EINVAL;
+    }
+
+    int n = snprintf(buf, len, "/lunar-telescope.%d", (int)pid);
+    if (n < 0 || (size_t)n >= len) {
+        return -ENAMETOOLONG;
+    }
+    return 0;
+}
+
+int metrics_shm_session_name(pid_t pid, unsigned session, char *buf, size_t len) {
+    if (!buf) {
+        return -EINVAL;
+    }
+
+    int n = snprintf(buf, len, "/lunar-telescope.%d.%u", (int)pid, session);
+    if (n < 0 || (size_t)n >= len) {
+        return -ENAMETOOLONG;
+    }
+    return 0;
+}
+
+int metrics_shm_create(const char *name, struct metrics_shm **shm_out) {
+    if (!shm_out) {
+        return -EINVAL;
+    }
+
+    struct metrics_shm *shm = calloc(1, sizeof(struct metrics_shm));
+    if (!shm) {
+        return -ENOMEM;
+    }
+
+    int ret;
+    if (name) {
+        if (name[0] != '/' || strlen(name) >= sizeof(shm->name)) {
+            free(shm);
+            return -EINVAL;
+        }
+        strcpy(shm->name, name);
+    } else if ((ret = metrics_shm_default_name(getpid(), shm->name, sizeof(shm->name))) < 0) {
+        free(shm);
+        return ret;
+    }
+
+    int fd = shm_open(shm->name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ret = -errno;
+        free(shm);
+        return ret;
+    }
+
+    shm->map_size = metrics_shm_map_size();
+    if (ftruncate(fd, (off_t)shm->map_size) < 0) {
+        ret = -errno;
+        close(fd);
+        shm_unlink(shm->name);
+        free(shm);
+        return ret;
+    }
+
+    void *map = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        ret = -errno;
+        shm_unlink(shm->name);
+        free(shm);
+        return ret;
+    }
+
+    /* Fresh pages are zeroed: seq starts even with an empty payload */
+    shm->region = map;
+    shm->region->version = METRICS_SHM_VERSION;
+    shm->region->payload_size = sizeof(struct metrics_shm_payload);
+    shm->region->pid = (uint32_t)getpid();
+    atomic_init(&shm->region->seq, 0);
+
+    /* Magic last: readers that see it also see a valid header */
+    atomic_thread_fence(memory_order_release);
+    memcpy(shm->region->magic, METRICS_SHM_MAGIC, sizeof(shm->region->magic));
+
+    *shm_out = shm;
+    return 0;
+}
+
+void metrics_shm_destroy(struct metrics_shm *shm) {
+    if (!shm) {
+        return;
+    }
+
+    munmap(shm->region, shm->map_size);
+    shm_unlink(shm->name);
+    free(shm);
+}
+
+const char *metrics_shm_name(const struct metrics_shm *shm) {
+    return shm ? shm->name : NULL;
+}
+
+void metrics_shm_publish(struct metrics_shm *shm, const struct metrics_shm_payload *payload) {
+    if (!shm || !payload) {
+        return;
+    }
+
+    struct metrics_shm_region *region = shm->region;
+    unsigned seq = atomic_load_explicit(&region->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&region->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    region->payload = *payload;
+    region->publish_count++;
+
+    atomic_store_explicit(&region->seq, seq + 2, memory_order_release);
+}
+
+int metrics_shm_attach(const char *name, struct metrics_shm_reader **reader_out) {
+    if (!name || !reader_out) {
+        return -EINVAL;
+    }
+
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int ret = -errno;
+        close(fd);
+        return ret;
+    }
+    if ((size_t)st.st_size < sizeof(struct metrics_shm_region)) {
+        close(fd);
+        return -EPROTO;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -errno;
+    }
+
+    const struct metrics_shm_region *region = map;
+    if (memcmp(region->magic, METRICS_SHM_MAGIC, sizeof(region->magic)) != 0 ||
+        region->version != METRICS_SHM_VERSION ||
+        region->payload_size != sizeof(struct metrics_shm_payload)) {
+        munmap(map, (size_t)st.st_size);
+        return -EPROTO;
+    }
+
+    struct metrics_shm_reader *reader = calloc(1, sizeof(struct metrics_shm_reader));
+    if (!reader) {
+        munmap(map, (size_t)st.st_size);
+        return -ENOMEM;
+    }
+
+    reader->region = region;
+    reader->map_size = (size_t)st.st_size;
+    *reader_out = reader;
+    return 0;
+}
+
+void metrics_shm_detach(struct metrics_shm_reader *reader) {
+    if (!reader) {
+        return;
+    }
+
+    munmap((void *)reader->region, reader->map_size);
+    free(reader);
+}
+
+int metrics_shm_read(const struct metrics_shm_reader *reader,
+                     struct metrics_shm_payload *payload_out,
+                     uint64_t *publish_count_out) {
+    if (!reader || !payload_out) {
+        return -EINVAL;
+    }
+
+    /* The mapping is read-only; atomic loads on it never write */
+    atomic_uint *seq_ptr = (atomic_uint *)&reader->region->seq;
+
+    for (int attempt = 0; attempt < METRICS_SHM_READ_RETRIES; attempt++) {
+        unsigned seq_begin = atomic_load_explicit(seq_ptr, memory_order_acquire);
+        if (seq_begin & 1) {
+            continue;  /* Writer in progress */
+        }
+
+        *payload_out = reader->region->payload;
+        uint64_t count = reader->region->publish_count;
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(seq_ptr, memory_order_relaxed) == seq_begin) {
+            if (publish_count_out) {
+                *publish_count_out = count;
+            }
+            return 0;
+        }
+    }
+
+    return -EAGAIN;
+}
+
+pid_t metrics_shm_reader_pid(const struct metrics_shm_reader *reader) {
+    return reader ? (pid_t)reader->region->pid : 0;
+}
@@ -0,0 +1,167 @@
+#ifndef METRICS_SHM_H
+#define METRICS_SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "telescope.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Shared-memory metrics export
+ *
+ * The producer maps a POSIX shared-memory object and copies each
+ * published payload into it under a seqlock, so publishing is a plain
+ * memory copy with no syscalls. Readers (lt-top, exporters) map the same
+ * object read-only and may poll at any rate without coordinating with
+ * the producer.
+ *
+ * Region layout (native endianness, same-host readers only):
+ *
+ *   header:  magic "LTSHMMET" | version u32 | payload_size u32 | pid u32 | reserved u32
+ *   seqlock: seq (odd while a write is in progress) | publish_count u64
+ *   payload: struct metrics_shm_payload
+ *
+ * Readers must reject regions whose magic, version or payload_size do
+ * not match what they were built against.
+ */
+
+#define METRICS_SHM_MAGIC "LTSHMMET"
+#define METRICS_SHM_VERSION 2
+#define METRICS_SHM_NAME_MAX 64
+
+/* Concrete lens types (telescope_lens_t without AUTO) */
+#define METRICS_SHM_LENS_SLOTS 3
+#define METRICS_SHM_SURFACE_SLOTS 32  /* Surfaces exported; the collector may track more */
+
+struct metrics_shm_lens {
+    uint32_t lens;          /* telescope_lens_t */
+    uint32_t active;        /* Non-zero for the session's current lens */
+    uint64_t frames_total;
+    uint64_t frames_dropped;
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+};
+
+struct metrics_shm_surface {
+    uint64_t surface_id;
+    uint64_t frames_total;
+    uint64_t frames_dropped;
+    uint64_t last_latency_us;
+};
+
+struct metrics_shm_payload {
+    struct telescope_metrics metrics;
+    uint32_t lens_count;
+    uint32_t surface_count;             /* Entries in surfaces[] */
+    uint32_t surfaces_tracked;          /* Surfaces with counters (more than surface_count if they do not fit) */
+    uint32_t reserved;
+    uint64_t surface_frames_untracked;  /* Frames of surfaces the collector had no room for */
+    struct metrics_shm_lens lenses[METRICS_SHM_LENS_SLOTS];
+    struct metrics_shm_surface surfaces[METRICS_SHM_SURFACE_SLOTS];
+};
+
+struct metrics_shm_region {
+    char magic[8];
+    uint32_t version;
+    uint32_t payload_size;
+    uint32_t pid;
+    uint32_t reserved;
+
+    _Alignas(64) atomic_uint seq;
+    uint64_t publish_count;
+
+    _Alignas(64) struct metrics_shm_payload payload;
+};
+
+struct metrics_shm;
+struct metrics_shm_reader;
+
+/**
+ * Default object name for a process ("/lunar-telescope.<pid>")
+ *
+ * @param pid Producer process id
+ * @param buf Output buffer (METRICS_SHM_NAME_MAX is sufficient)
+ * @param len Buffer size
+ * @return 0 on success, -ENAMETOOLONG if the buffer is too small
+ */
+int metrics_shm_default_name(pid_t pid, char *buf, size_t len);
+
+/**
+ * Object name for a per-session collector ("/lunar-telescope.<pid>.<session>")
+ *
+ * @param pid Producer process id
+ * @param session Session slot within the process
+ * @param buf Output buffer (METRICS_SHM_NAME_MAX is sufficient)
+ * @param len Buffer size
+ * @return 0 on success, -ENAMETOOLONG if the buffer is too small
+ */
+int metrics_shm_session_name(pid_t pid, unsigned session, char *buf, size_t len);
+
+/**
+ * Create (or replace) and map a shared-memory region
+ *
+ * @param name Object name starting with '/' (NULL for the default name)
+ * @param shm_out Output handle
+ * @return 0 on success, negative error code on failure
+ */
+int metrics_shm_create(const char *name, struct metrics_shm **shm_out);
+
+/**
+ * Unmap and unlink the region
+ */
+void metrics_shm_destroy(struct metrics_shm *shm);
+
+/**
+ * Get the object name of a region
+ */
+const char *metrics_shm_name(const struct metrics_shm *shm);
+
+/**
+ * Copy a payload into the region (single producer, no syscalls)
+ *
+ * @param shm Region handle
+ * @param payload Payload to publish
+ */
+void metrics_shm_publish(struct metrics_shm *shm, const struct metrics_shm_payload *payload);
+
+/**
+ * Map an existing region read-only
+ *
+ * @param name Object name
+ * @param reader_out Output reader handle
+ * @return 0 on success, -ENOENT if it does not exist, -EPROTO on layout mismatch
+ */
+int metrics_shm_attach(const char *name, struct metrics_shm_reader **reader_out);
+
+/**
+ * Unmap a region mapped with metrics_shm_attach()
+ */
+void metrics_shm_detach(struct metrics_shm_reader *reader);
+
+/**
+ * Copy out a consistent payload
+ *
+ * @param reader Reader handle
+ * @param payload_out Output payload
+ * @param publish_count_out Number of publishes so far (optional)
+ * @return 0 on success, -EAGAIN if the producer kept the region busy
+ */
+int metrics_shm_read(const struct metrics_shm_reader *reader,
+                     struct metrics_shm_payload *payload_out,
+                     uint64_t *publish_count_out);
+
+/**
+ * Producer pid recorded in the region
+ */
+pid_t metrics_shm_reader_pid(const struct metrics_shm_reader *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_SHM_H */
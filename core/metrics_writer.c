@@ -0,0 +1,345 @@
+#include "metrics_writer.h"
+#include "spsc_ring.h"
+#include "le_bytes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/**
+ * Asynchronous, batched metrics writer
+ *
+ * The writer thread sleeps for up to METRICS_WRITER_BATCH_MS between
+ * batches. Producers only signal it when the queue is half full, so a
+ * normal submit is a memcpy and a release store.
+ */
+
+#define METRICS_WRITER_QUEUE_CAPACITY 512
+#define METRICS_WRITER_BATCH_MS 100
+#define METRICS_WRITER_BUFFER_SIZE (64 * 1024)
+
+struct metrics_writer {
+    struct spsc_ring queue;
+    atomic_flag producer_lock;
+    atomic_uint_least64_t dropped;
+
+    FILE *fp;
+    telescope_metrics_format_t format;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stop;  /* Protected by lock */
+
+    char buffer[METRICS_WRITER_BUFFER_SIZE];
+};
+
+void metrics_binary_header_encode(uint8_t *out) {
+    memcpy(out, METRICS_BINARY_MAGIC, 8);
+    le_put_u16(out + 8, METRICS_BINARY_VERSION);
+    le_put_u16(out + 10, METRICS_BINARY_RECORD_SIZE);
+    le_put_u32(out + 12, 0);
+}
+
+int metrics_binary_header_decode(const uint8_t *in, uint16_t *record_size_out) {
+    if (memcmp(in, METRICS_BINARY_MAGIC, 8) != 0) {
+        return -EINVAL;
+    }
+    if (le_get_u16(in + 8) != METRICS_BINARY_VERSION) {
+        return -ENOTSUP;
+    }
+    if (record_size_out) {
+        *record_size_out = le_get_u16(in + 10);
+    }
+    return 0;
+}
+
+/*
+ * Record layout (offsets in bytes, all little-endian):
+ *   0 timestamp_us u64 | 8 end_to_end_latency_ms | 12 input_lag_ms | 16 frame_delay_ms
+ *  20 frames_per_second | 24 frames_dropped | 28 frames_total (u32)
+ *  32 bandwidth_rx_bps u64 | 40 bandwidth_tx_bps u64
+ *  48 input_events_predicted | 52 input_events_reconciled | 56 input_events_total (u32)
+ *  60 end_to_end p50/p95/p99/p999 | 76 input_lag p50..p999 | 92 frame_delay p50..p999 (u32)
+ * 108 reserved u32
+ */
+static void put_percentiles(uint8_t *p, const telescope_latency_percentiles_t *pct) {
+    le_put_u32(p, pct->p50_us);
+    le_put_u32(p + 4, pct->p95_us);
+    le_put_u32(p + 8, pct->p99_us);
+    le_put_u32(p + 12, pct->p999_us);
+}
+
+static void get_percentiles(const uint8_t *p, telescope_latency_percentiles_t *pct) {
+    pct->p50_us = le_get_u32(p);
+    pct->p95_us = le_get_u32(p + 4);
+    pct->p99_us = le_get_u32(p + 8);
+    pct->p999_us = le_get_u32(p + 12);
+}
+
+void metrics_record_encode(const struct telescope_metrics *m, uint8_t *out) {
+    le_put_u64(out + 0, m->timestamp_us);
+    le_put_u32(out + 8, m->end_to_end_latency_ms);
+    le_put_u32(out + 12, m->input_lag_ms);
+    le_put_u32(out + 16, m->frame_delay_ms);
+    le_put_u32(out + 20, m->frames_per_second);
+    le_put_u32(out + 24, m->frames_dropped);
+    le_put_u32(out + 28, m->frames_total);
+    le_put_u64(out + 32, m->bandwidth_rx_bps);
+    le_put_u64(out + 40, m->bandwidth_tx_bps);
+    le_put_u32(out + 48, m->input_events_predicted);
+    le_put_u32(out + 52, m->input_events_reconciled);
+    le_put_u32(out + 56, m->input_events_total);
+    put_percentiles(out + 60, &m->end_to_end_latency);
+    put_percentiles(out + 76, &m->input_lag);
+    put_percentiles(out + 92, &m->frame_delay);
+    le_put_u32(out + 108, 0);
+}
+
+void metrics_record_decode(const uint8_t *in, struct telescope_metrics *m) {
+    memset(m, 0, sizeof(*m));
+    m->timestamp_us = le_get_u64(in + 0);
+    m->end_to_end_latency_ms = le_get_u32(in + 8);
+    m->input_lag_ms = le_get_u32(in + 12);
+    m->frame_delay_ms = le_get_u32(in + 16);
+    m->frames_per_second = le_get_u32(in + 20);
+    m->frames_dropped = le_get_u32(in + 24);
+    m->frames_total = le_get_u32(in + 28);
+    m->bandwidth_rx_bps = le_get_u64(in + 32);
+    m->bandwidth_tx_bps = le_get_u64(in + 40);
+    m->input_events_predicted = le_get_u32(in + 48);
+    m->input_events_reconciled = le_get_u32(in + 52);
+    m->input_events_total = le_get_u32(in + 56);
+    get_percentiles(in + 60, &m->end_to_end_latency);
+    get_percentiles(in + 76, &m->input_lag);
+    get_percentiles(in + 92, &m->frame_delay);
+}
+
+int metrics_format_json(const struct telescope_metrics *m, char *buf, size_t len) {
+    if (!m || !buf) {
+        return -EINVAL;
+    }
+
+    return snprintf(buf, len,
+            "{\"timestamp\":%llu,"
+            "\"end_to_end_latency_ms\":%u,"
+            "\"input_lag_ms\":%u,"
+            "\"frame_delay_ms\":%u,"
+            "\"frames_per_second\":%u,"
+            "\"frames_dropped\":%u,"
+            "\"frames_total\":%u,"
+            "\"bandwidth_rx_bps\":%llu,"
+            "\"bandwidth_tx_bps\":%llu,"
+            "\"input_events_predicted\":%u,"
+            "\"input_events_reconciled\":%u,"
+            "\"input_events_total\":%u,"
+            "\"end_to_end_latency_us\":{\"p50\":%u,\"p95\":%u,\"p99\":%u,\"p999\":%u},"
+            "\"input_lag_us\":{\"p50\":%u,\"p95\":%u,\"p99\":%u,\"p999\":%u},"
+            "\"frame_delay_us\":{\"p50\":%u,\"p95\":%u,\"p99\":%u,\"p999\":%u}}\n",
+            (unsigned long long)m->timestamp_us,
+            m->end_to_end_latency_ms,
+            m->input_lag_ms,
+            m->frame_delay_ms,
+            m->frames_per_second,
+            m->frames_dropped,
+            m->frames_total,
+            (unsigned long long)m->bandwidth_rx_bps,
+            (unsigned long long)m->bandwidth_tx_bps,
+            m->input_events_predicted,
+            m->input_events_reconciled,
+            m->input_events_total,
+            m->end_to_end_latency.p50_us, m->end_to_end_latency.p95_us,
+            m->end_to_end_latency.p99_us, m->end_to_end_latency.p999_us,
+            m->input_lag.p50_us, m->input_lag.p95_us,
+            m->input_lag.p99_us, m->input_lag.p999_us,
+            m->frame_delay.p50_us, m->frame_delay.p95_us,
+            m->frame_delay.p99_us, m->frame_delay.p999_us);
+}
+
+/* Pop everything currently queued and write it as one batch */
+static void writer_drain(struct metrics_writer *w) {
+    struct telescope_metrics m;
+    size_t used = 0;
+    bool wrote = false;
+
+    while (spsc_ring_pop(&w->queue, &m)) {
+        size_t need = (w->format == TELESCOPE_METRICS_FORMAT_BINARY)
+            ? METRICS_BINARY_RECORD_SIZE
+            : METRICS_JSON_LINE_MAX;
+
+        if (used + need > sizeof(w->buffer)) {
+            fwrite(w->buffer, 1, used, w->fp);
+            used = 0;
+        }
+
+        if (w->format == TELESCOPE_METRICS_FORMAT_BINARY) {
+            metrics_record_encode(&m, (uint8_t *)w->buffer + used);
+            used += METRICS_BINARY_RECORD_SIZE;
+        } else {
+            int n = metrics_format_json(&m, w->buffer + used, sizeof(w->buffer) - used);
+            if (n > 0) {
+                used += (size_t)n;
+            }
+        }
+        wrote = true;
+    }
+
+    if (used > 0) {
+        fwrite(w->buffer, 1, used, w->fp);
+    }
+    if (wrote) {
+        fflush(w->fp);
+    }
+}
+
+static void *writer_thread_main(void *arg) {
+    struct metrics_writer *w = arg;
+
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        if (!w->stop && spsc_ring_size(&w->queue) < w->queue.capacity / 2) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_nsec += METRICS_WRITER_BATCH_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&w->wake, &w->lock, &deadline);
+        }
+        bool stopping = w->stop;
+        pthread_mutex_unlock(&w->lock);
+
+        writer_drain(w);
+
+        if (stopping) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+int metrics_writer_create(const char *path,
+                          telescope_metrics_format_t format,
+                          struct metrics_writer **writer_out) {
+    if (!path || !writer_out) {
+        return -EINVAL;
+    }
+
+    struct metrics_writer *w = NULL;
+    if (posix_memalign((void **)&w, SPSC_RING_CACHELINE, sizeof(*w)) != 0) {
+        return -ENOMEM;
+    }
+    memset(w, 0, sizeof(*w));
+
+    int ret = spsc_ring_init(&w->queue, METRICS_WRITER_QUEUE_CAPACITY,
+                             sizeof(struct telescope_metrics));
+    if (ret < 0) {
+        free(w);
+        return ret;
+    }
+
+    w->format = format;
+    w->fp = fopen(path, format == TELESCOPE_METRICS_FORMAT_BINARY ? "ab" : "a");
+    if (!w->fp) {
+        ret = -errno;
+        spsc_ring_destroy(&w->queue);
+        free(w);
+        return ret;
+    }
+
+    /* New binary files get a header; appends continue the existing stream */
+    if (format == TELESCOPE_METRICS_FORMAT_BINARY) {
+        fseek(w->fp, 0, SEEK_END);
+        if (ftell(w->fp) == 0) {
+            uint8_t header[METRICS_BINARY_HEADER_SIZE];
+            metrics_binary_header_encode(header);
+            fwrite(header, 1, sizeof(header), w->fp);
+            fflush(w->fp);
+        }
+    }
+
+    atomic_flag_clear(&w->producer_lock);
+    atomic_init(&w->dropped, 0);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&w->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&w->lock, NULL);
+    w->stop = false;
+
+    ret = pthread_create(&w->thread, NULL, writer_thread_main, w);
+    if (ret != 0) {
+        pthread_cond_destroy(&w->wake);
+        pthread_mutex_destroy(&w->lock);
+        fclose(w->fp);
+        spsc_ring_destroy(&w->queue);
+        free(w);
+        return -ret;
+    }
+
+    *writer_out = w;
+    return 0;
+}
+
+void metrics_writer_destroy(struct metrics_writer *writer) {
+    if (!writer) {
+        return;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+
+    pthread_join(writer->thread, NULL);
+
+    pthread_cond_destroy(&writer->wake);
+    pthread_mutex_destroy(&writer->lock);
+    fclose(writer->fp);
+    spsc_ring_destroy(&writer->queue);
+    free(writer);
+}
+
+int metrics_writer_submit(struct metrics_writer *writer,
+                          const struct telescope_metrics *metrics) {
+    if (!writer || !metrics) {
+        return -EINVAL;
+    }
+
+    /* The queue is single-producer; a second concurrent submitter drops */
+    if (atomic_flag_test_and_set_explicit(&writer->producer_lock, memory_order_acquire)) {
+        atomic_fetch_add_explicit(&writer->dropped, 1, memory_order_relaxed);
+        return -EAGAIN;
+    }
+
+    bool queued = spsc_ring_push(&writer->queue, metrics);
+    bool wake = queued && spsc_ring_size(&writer->queue) == writer->queue.capacity / 2;
+
+    atomic_flag_clear_explicit(&writer->producer_lock, memory_order_release);
+
+    if (!queued) {
+        atomic_fetch_add_explicit(&writer->dropped, 1, memory_order_relaxed);
+        return -EAGAIN;
+    }
+
+    if (wake) {
+        pthread_mutex_lock(&writer->lock);
+        pthread_cond_signal(&writer->wake);
+        pthread_mutex_unlock(&writer->lock);
+    }
+
+    return 0;
+}
+
+uint64_t metrics_writer_dropped(const struct metrics_writer *writer) {
+    if (!writer) {
+        return 0;
+    }
+    return atomic_load_explicit(&writer->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,119 @@
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "telescope.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Asynchronous metrics file writer
+ *
+ * Snapshots are handed to a background thread through a lock-free SPSC
+ * queue; the thread formats them in batches and issues one write and one
+ * fflush per batch. Submitting never blocks and never touches the disk.
+ *
+ * Binary files start with a 16-byte header followed by fixed-width
+ * little-endian records:
+ *
+ *   header: magic "LTMETRIC" (8) | version u16 | record_size u16 | reserved u32
+ *   record: see metrics_record_encode() for the field layout
+ */
+
+struct metrics_writer;
+
+#define METRICS_BINARY_MAGIC "LTMETRIC"
+#define METRICS_BINARY_VERSION 1
+#define METRICS_BINARY_HEADER_SIZE 16
+#define METRICS_BINARY_RECORD_SIZE 112
+
+/* Longest JSON line produced by metrics_format_json() (including newline) */
+#define METRICS_JSON_LINE_MAX 1024
+
+/**
+ * Open a metrics file and start the writer thread
+ *
+ * @param path Output file (opened for append)
+ * @param format Output format
+ * @param writer_out Output writer handle
+ * @return 0 on success, negative error code on failure
+ */
+int metrics_writer_create(const char *path,
+                          telescope_metrics_format_t format,
+                          struct metrics_writer **writer_out);
+
+/**
+ * Drain queued records, stop the thread and close the file
+ */
+void metrics_writer_destroy(struct metrics_writer *writer);
+
+/**
+ * Queue a snapshot for writing (non-blocking)
+ *
+ * Safe to call from any thread; concurrent submitters back off rather
+ * than wait.
+ *
+ * @param writer Writer handle
+ * @param metrics Snapshot to write
+ * @return 0 on success, -EAGAIN if the queue is full or contended (record dropped)
+ */
+int metrics_writer_submit(struct metrics_writer *writer,
+                          const struct telescope_metrics *metrics);
+
+/**
+ * Number of records dropped because the queue was full or contended
+ */
+uint64_t metrics_writer_dropped(const struct metrics_writer *writer);
+
+/**
+ * Format a snapshot as a single JSON line (newline-terminated)
+ *
+ * @param metrics Snapshot
+ * @param buf Output buffer
+ * @param len Buffer size (METRICS_JSON_LINE_MAX is always sufficient)
+ * @return Number of characters written (excluding NUL), or negative on error
+ */
+int metrics_format_json(const struct telescope_metrics *metrics, char *buf, size_t len);
+
+/**
+ * Write the binary file header
+ *
+ * @param out Output buffer of METRICS_BINARY_HEADER_SIZE bytes
+ */
+void metrics_binary_header_encode(uint8_t *out);
+
+/**
+ * Validate a binary file header
+ *
+ * @param in Header bytes (METRICS_BINARY_HEADER_SIZE)
+ * @param record_size_out Record size declared by the file
+ * @return 0 on success, -EINVAL if the magic is wrong, -ENOTSUP for unknown versions
+ */
+int metrics_binary_header_decode(const uint8_t *in, uint16_t *record_size_out);
+
+/**
+ * Encode a snapshot into a fixed-width binary record
+ *
+ * @param metrics Snapshot
+ * @param out Output buffer of METRICS_BINARY_RECORD_SIZE bytes
+ */
+void metrics_record_encode(const struct telescope_metrics *metrics, uint8_t *out);
+
+/**
+ * Decode a fixed-width binary record
+ *
+ * @param in Record bytes (METRICS_BINARY_RECORD_SIZE)
+ * @param metrics_out Output snapshot
+ */
+void metrics_record_decode(const uint8_t *in, struct telescope_metrics *metrics_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_WRITER_H */
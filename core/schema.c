@@ -192,6 +192,23 @@ static int parse_observability(json_object *obj, telescope_observability_t *obs)
         obs->metrics_file = NULL;
     }
     
+    if (json_object_object_get_ex(obj, "metrics_format", &tmp)) {
+        const char *format = json_object_get_string(tmp);
+        if (strcmp(format, "binary") == 0) {
+            obs->metrics_format = TELESCOPE_METRICS_FORMAT_BINARY;
+        } else {
+            obs->metrics_format = TELESCOPE_METRICS_FORMAT_JSON;
+        }
+    } else {
+        obs->metrics_format = TELESCOPE_METRICS_FORMAT_JSON;
+    }
+
+    if (json_object_object_get_ex(obj, "metrics_shm", &tmp)) {
+        obs->metrics_shm = json_object_get_boolean(tmp);
+    } else {
+        obs->metrics_shm = false;
+    }
+    
     if (json_object_object_get_ex(obj, "log_level", &tmp)) {
         const char *level = json_object_get_string(tmp);
         if (strcmp(level, "error") == 0) {
@@ -322,6 +339,8 @@ int telescope_config_load(const char *config_path, struct telescope_config **con
         config->observability.enable_metrics = true;
         config->observability.metrics_interval_ms = 1000;
         config->observability.metrics_file = NULL;
+        config->observability.metrics_format = TELESCOPE_METRICS_FORMAT_JSON;
+        config->observability.metrics_shm = false;
         config->observability.log_level = 2;
     }
     
@@ -0,0 +1,99 @@
+#include "spsc_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+ * Lock-free SPSC ring implementation
+ *
+ * `tail` is written only by the producer and `head` only by the consumer.
+ * Indices grow monotonically and are masked on access, so full/empty are
+ * distinguished without a spare slot.
+ */
+
+int spsc_ring_init(struct spsc_ring *ring, size_t capacity, size_t elem_size) {
+    if (!ring || capacity == 0 || elem_size == 0) {
+        return -EINVAL;
+    }
+
+    size_t cap = 1;
+    while (cap < capacity) {
+        cap <<= 1;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+
+    void *slots = NULL;
+    if (posix_memalign(&slots, SPSC_RING_CACHELINE, cap * elem_size) != 0) {
+        return -ENOMEM;
+    }
+
+    ring->slots = slots;
+    ring->capacity = cap;
+    ring->mask = cap - 1;
+    ring->elem_size = elem_size;
+    ring->cached_head = 0;
+    ring->cached_tail = 0;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    return 0;
+}
+
+void spsc_ring_destroy(struct spsc_ring *ring) {
+    if (!ring) {
+        return;
+    }
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+bool spsc_ring_push(struct spsc_ring *ring, const void *elem) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (tail - ring->cached_head >= ring->capacity) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head >= ring->capacity) {
+            return false;  /* Full */
+        }
+    }
+
+    memcpy(ring->slots + (tail & ring->mask) * ring->elem_size, elem, ring->elem_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+const void *spsc_ring_peek(struct spsc_ring *ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head == ring->cached_tail) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail) {
+            return NULL;  /* Empty */
+        }
+    }
+
+    return ring->slots + (head & ring->mask) * ring->elem_size;
+}
+
+bool spsc_ring_pop(struct spsc_ring *ring, void *elem_out) {
+    const void *slot = spsc_ring_peek(ring);
+    if (!slot) {
+        return false;
+    }
+
+    if (elem_out) {
+        memcpy(elem_out, slot, ring->elem_size);
+    }
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+size_t spsc_ring_size(const struct spsc_ring *ring) {
+    /* Read head first: tail never falls behind it, so the difference cannot underflow */
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return tail - head;
+}
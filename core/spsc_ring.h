@@ -0,0 +1,87 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Bounded lock-free single-producer/single-consumer ring
+ *
+ * Fixed-size elements are copied in and out of a preallocated,
+ * power-of-two slot array. Producer and consumer indices live on
+ * separate cache lines, and each side caches the other's index so the
+ * common case touches only its own line.
+ *
+ * Exactly one thread may push and exactly one thread may pop at a time.
+ */
+
+#define SPSC_RING_CACHELINE 64
+
+struct spsc_ring {
+    /* Consumer side */
+    _Alignas(SPSC_RING_CACHELINE) atomic_size_t head;
+    size_t cached_tail;
+
+    /* Producer side */
+    _Alignas(SPSC_RING_CACHELINE) atomic_size_t tail;
+    size_t cached_head;
+
+    /* Immutable after init */
+    _Alignas(SPSC_RING_CACHELINE) size_t capacity;
+    size_t mask;
+    size_t elem_size;
+    uint8_t *slots;
+};
+
+/**
+ * Initialize a ring
+ *
+ * @param ring Ring to initialize
+ * @param capacity Number of slots (rounded up to a power of two)
+ * @param elem_size Size of one element in bytes
+ * @return 0 on success, negative error code on failure
+ */
+int spsc_ring_init(struct spsc_ring *ring, size_t capacity, size_t elem_size);
+
+/**
+ * Release ring storage
+ */
+void spsc_ring_destroy(struct spsc_ring *ring);
+
+/**
+ * Copy an element into the ring (producer only)
+ *
+ * @return true on success, false if the ring is full
+ */
+bool spsc_ring_push(struct spsc_ring *ring, const void *elem);
+
+/**
+ * Copy the oldest element out of the ring (consumer only)
+ *
+ * @return true on success, false if the ring is empty
+ */
+bool spsc_ring_pop(struct spsc_ring *ring, void *elem_out);
+
+/**
+ * Borrow the oldest element without removing it (consumer only)
+ *
+ * @return Pointer to the element, valid until the next pop, or NULL if empty
+ */
+const void *spsc_ring_peek(struct spsc_ring *ring);
+
+/**
+ * Number of queued elements (approximate when called concurrently)
+ */
+size_t spsc_ring_size(const struct spsc_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPSC_RING_H */
@@ -1,5 +1,8 @@
 #include "telescope.h"
+#include "metrics.h"
+#include "metrics_sampler.h"
 #include "lens.h"
+#include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,15 +10,9 @@
 #include <sys/wait.h>
 #include <signal.h>
 #include <errno.h>
-#include <time.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 
-/* Forward declaration for metrics */
-extern int metrics_collector_init(const telescope_observability_t *obs_config);
-extern void metrics_collector_cleanup(void);
-extern const struct telescope_metrics *metrics_collector_get(void);
-
 /**
  * Telescope session management
  */
@@ -26,6 +23,9 @@ struct telescope_session {
     struct lens_session *lens_session;
     bool running;
     struct telescope_metrics metrics;
+    struct metrics_collector *collector;  /* Registered under the session handle */
+    struct metrics_sampler *sampler;
+    struct utils_clock *clock;  /* NULL = system monotonic */
     uint64_t start_time_us;
 };
 
@@ -52,6 +52,16 @@ int telescope_session_create(const struct telescope_config *config,
     return 0;
 }
 
+int telescope_session_set_clock(struct telescope_session *session, struct utils_clock *clock) {
+    if (!session) {
+        return -EINVAL;
+    }
+    
+    session->clock = clock;
+    metrics_collector_set_clock(session->collector, clock);
+    return 0;
+}
+
 /* Transport process launching is handled by the lens layer (`lenses/`). */
 
 int telescope_session_start(struct telescope_session *session) {
@@ -125,13 +135,28 @@ int telescope_session_start(struct telescope_session *session) {
         return ret;
     }
     
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    session->start_time_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    session->start_time_us = utils_clock_now_us(session->clock);
     session->running = true;
     
-    /* Initialize metrics collection */
-    metrics_collector_init(&session->config->observability);
+    /* Per-session metrics; the starting thread is bound, others bind themselves */
+    if (metrics_collector_create(session, &session->config->observability,
+                                 &session->collector) < 0) {
+        session->collector = NULL;
+    }
+    metrics_collector_set_clock(session->collector, session->clock);
+    metrics_bind(session->collector);
+    metrics_set_target_frame_rate(session->config->performance.frame_rate);
+    metrics_set_active_lens(session->lens_type);
+
+    /* Sample at the configured interval; metrics still work without it */
+    const telescope_observability_t *obs = &session->config->observability;
+    if (session->collector && obs->metrics_interval_ms > 0 &&
+        metrics_sampler_create(session->collector, obs->metrics_interval_ms,
+                               &session->sampler) == 0 &&
+        metrics_sampler_start_thread(session->sampler) < 0) {
+        metrics_sampler_destroy(session->sampler);
+        session->sampler = NULL;
+    }
     
     /* Initialize logging if available */
     #ifdef LOGGING_H
@@ -160,7 +185,10 @@ int telescope_session_stop(struct telescope_session *session) {
     session->running = false;
     
     /* Cleanup metrics */
-    metrics_collector_cleanup();
+    metrics_sampler_destroy(session->sampler);
+    session->sampler = NULL;
+    metrics_collector_destroy(session->collector);
+    session->collector = NULL;
     
     return 0;
 }
@@ -180,18 +208,13 @@ int telescope_session_get_metrics(const struct telescope_session *session,
         return -EINVAL;
     }
     
-    /* Try to get metrics from collector first */
-    const struct telescope_metrics *collected = metrics_collector_get();
-    if (collected) {
-        *metrics_out = *collected;
-    } else {
+    /* Try to get a consistent snapshot from the collector first */
+    if (metrics_session_snapshot(session->collector, metrics_out) < 0) {
         /* Fallback to session metrics */
         *metrics_out = session->metrics;
         
         /* Update timestamp */
-        struct timespec ts;
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        metrics_out->timestamp_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+        metrics_out->timestamp_us = utils_clock_now_us(session->clock);
     }
     
     return 0;
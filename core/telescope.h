@@ -32,6 +32,7 @@ extern "C" {
 struct telescope_config;
 struct telescope_session;
 struct telescope_metrics;
+struct utils_clock;
 
 /**
  * Performance profile types
@@ -90,6 +91,14 @@ typedef struct {
     bool enable_scroll_smoothing;
 } telescope_performance_t;
 
+/**
+ * Metrics file formats
+ */
+typedef enum {
+    TELESCOPE_METRICS_FORMAT_JSON,      /* One JSON object per line */
+    TELESCOPE_METRICS_FORMAT_BINARY     /* Fixed-width little-endian records */
+} telescope_metrics_format_t;
+
 /**
  * Observability configuration
  */
@@ -97,6 +106,8 @@ typedef struct {
     bool enable_metrics;
     uint32_t metrics_interval_ms;
     char *metrics_file;
+    telescope_metrics_format_t metrics_format;
+    bool metrics_shm;   /* Publish live snapshots to a shared-memory region */
     int log_level;  /* 0=error, 1=warn, 2=info, 3=debug, 4=trace */
 } telescope_observability_t;
 
@@ -120,6 +131,16 @@ struct telescope_config {
     telescope_lens_config_t lens;
 };
 
+/**
+ * Latency distribution summary (microseconds)
+ */
+typedef struct {
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t p999_us;
+} telescope_latency_percentiles_t;
+
 /**
  * Session metrics
  */
@@ -143,6 +164,11 @@ struct telescope_metrics {
     uint32_t input_events_reconciled;
     uint32_t input_events_total;
     
+    /* Latency distributions (from histograms, microsecond resolution) */
+    telescope_latency_percentiles_t end_to_end_latency;
+    telescope_latency_percentiles_t input_lag;
+    telescope_latency_percentiles_t frame_delay;
+    
     /* Timestamp of last update */
     uint64_t timestamp_us;
 };
@@ -171,6 +197,20 @@ void telescope_config_free(struct telescope_config *config);
 int telescope_session_create(const struct telescope_config *config,
                             struct telescope_session **session_out);
 
+/**
+ * Set the session clock
+ *
+ * The clock stamps the session start and the session's metrics. Set it
+ * before telescope_session_start(); replays and tests pass a virtual
+ * clock to make timestamps deterministic.
+ *
+ * @param session Session handle
+ * @param clock Clock provider (must outlive the session), or NULL for
+ *              the system monotonic clock
+ * @return 0 on success, negative error code on failure
+ */
+int telescope_session_set_clock(struct telescope_session *session, struct utils_clock *clock);
+
 /**
  * Start the telescope session (launch remote application)
  *
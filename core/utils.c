@@ -17,6 +17,59 @@ double utils_timestamp_sec(void) {
     return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
+void utils_clock_init(struct utils_clock *clock, utils_clock_kind_t kind, uint64_t start_us) {
+    if (!clock) {
+        return;
+    }
+    clock->kind = kind;
+    atomic_init(&clock->virtual_us, kind == UTILS_CLOCK_VIRTUAL ? start_us : 0);
+}
+
+/* The iteration bracketed on this thread: its clock (NULL = system) and reading */
+static _Thread_local bool t_iteration_active = false;
+static _Thread_local const struct utils_clock *t_iteration_clock = NULL;
+static _Thread_local uint64_t t_iteration_us = 0;
+
+static uint64_t utils_clock_read(struct utils_clock *clock) {
+    if (clock && clock->kind == UTILS_CLOCK_VIRTUAL) {
+        return atomic_load_explicit(&clock->virtual_us, memory_order_relaxed);
+    }
+    return utils_timestamp_us();
+}
+
+uint64_t utils_clock_now_us(struct utils_clock *clock) {
+    if (t_iteration_active && t_iteration_clock == clock) {
+        return t_iteration_us;
+    }
+    return utils_clock_read(clock);
+}
+
+void utils_clock_set(struct utils_clock *clock, uint64_t now_us) {
+    if (clock && clock->kind == UTILS_CLOCK_VIRTUAL) {
+        atomic_store_explicit(&clock->virtual_us, now_us, memory_order_relaxed);
+    }
+}
+
+void utils_clock_advance(struct utils_clock *clock, uint64_t delta_us) {
+    if (clock && clock->kind == UTILS_CLOCK_VIRTUAL) {
+        atomic_fetch_add_explicit(&clock->virtual_us, delta_us, memory_order_relaxed);
+    }
+}
+
+uint64_t utils_clock_begin_iteration(struct utils_clock *clock) {
+    t_iteration_us = utils_clock_read(clock);
+    t_iteration_clock = clock;
+    t_iteration_active = true;
+    return t_iteration_us;
+}
+
+void utils_clock_end_iteration(struct utils_clock *clock) {
+    if (t_iteration_active && t_iteration_clock == clock) {
+        t_iteration_active = false;
+        t_iteration_clock = NULL;
+    }
+}
+
 uint32_t utils_time_diff_ms(uint64_t start_us, uint64_t end_us) {
     if (end_us < start_us) {
         return 0;  /* Invalid or wrapped */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <time.h>
 
 #ifdef __cplusplus
@@ -29,6 +30,74 @@ uint64_t utils_timestamp_us(void);
  */
 double utils_timestamp_sec(void);
 
+/**
+ * Clock provider
+ *
+ * Time source for code that needs "now" rather than an event timestamp.
+ * Pass a clock per session (or per pipeline); a NULL clock is the system
+ * monotonic clock. A virtual clock only moves when set or advanced, which
+ * makes the input and metrics pipelines replayable.
+ *
+ * Either kind, and the NULL system clock, can cache one reading per
+ * event-loop iteration: between utils_clock_begin_iteration() and
+ * utils_clock_end_iteration() every read on the bracketing thread
+ * returns the same value without touching the system clock. The cached reading is per thread: other threads
+ * reading the same clock (input threads, samplers) see live time.
+ */
+typedef enum {
+    UTILS_CLOCK_MONOTONIC,
+    UTILS_CLOCK_VIRTUAL
+} utils_clock_kind_t;
+
+struct utils_clock {
+    utils_clock_kind_t kind;
+    atomic_uint_least64_t virtual_us;   /* Current time of a virtual clock */
+};
+
+/**
+ * Initialize a clock
+ *
+ * @param clock Clock to initialize
+ * @param kind Monotonic or virtual
+ * @param start_us Initial time of a virtual clock (ignored for monotonic)
+ */
+void utils_clock_init(struct utils_clock *clock, utils_clock_kind_t kind, uint64_t start_us);
+
+/**
+ * Read a clock in microseconds
+ *
+ * @param clock Clock, or NULL for the system monotonic clock
+ * @return This thread's cached iteration time for the clock if set,
+ *         otherwise the current time
+ */
+uint64_t utils_clock_now_us(struct utils_clock *clock);
+
+/**
+ * Set a virtual clock (no effect on a monotonic clock)
+ */
+void utils_clock_set(struct utils_clock *clock, uint64_t now_us);
+
+/**
+ * Advance a virtual clock (no effect on a monotonic clock)
+ */
+void utils_clock_advance(struct utils_clock *clock, uint64_t delta_us);
+
+/**
+ * Read the clock once and serve that reading to this thread until the
+ * iteration ends (one clock per thread at a time)
+ *
+ * @param clock Clock, or NULL for the system monotonic clock
+ * @return The cached time
+ */
+uint64_t utils_clock_begin_iteration(struct utils_clock *clock);
+
+/**
+ * Drop this thread's cached reading
+ *
+ * @param clock Clock the iteration began with (NULL = system monotonic)
+ */
+void utils_clock_end_iteration(struct utils_clock *clock);
+
 /**
  * Convert microseconds to seconds
  */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +21,9 @@ extern "C" {
 struct input_proxy;
 struct input_event;
 struct scroll_state;
+struct scroll_kinetic_config;
+struct motion_predictor;
+struct utils_clock;
 
 /**
  * Input event types
@@ -70,6 +74,19 @@ struct input_event {
     };
 };
 
+/**
+ * Pointer prediction backends
+ */
+typedef enum {
+    INPUT_PREDICTOR_AUTO,       /* Rust if linked, otherwise the C velocity tracker */
+    INPUT_PREDICTOR_RUST,       /* Rust VelocityTracker (WITH_RUST=1 builds) */
+    INPUT_PREDICTOR_VELOCITY,   /* C port of the Rust VelocityTracker */
+    INPUT_PREDICTOR_ADAPTIVE    /* Alpha-beta filter tuned by reconciliation error */
+} input_predictor_backend_t;
+
+/* Unacknowledged predictions tracked per proxy (power of two) */
+#define INPUT_PROXY_PENDING_CAPACITY 1024
+
 /**
  * Prediction state
  */
@@ -77,8 +94,30 @@ typedef struct {
     bool enabled;
     uint32_t window_ms;
     uint64_t last_prediction_us;
+    uint64_t horizon_us;          /* Lead time of the last prediction (window or next vblank) */
     uint32_t events_predicted;
     uint32_t events_reconciled;
+    uint32_t pending_overflows;   /* Unacked predictions overwritten by newer frames */
+    uint32_t late_acks;           /* Acks for predictions already overwritten or expired */
+    
+    /* Scroll prediction (touchpad scroll, see input_proxy_set_scroll_prediction()) */
+    bool scroll_enabled;
+    uint32_t scroll_predicted;    /* Scroll events extrapolated over the window */
+    uint32_t scroll_rollbacks;    /* Outstanding scroll leads withdrawn on mismatch */
+    
+    /*
+     * Prediction error, every backend: each prediction is scored against
+     * the first real sample at its target time (or the actual event
+     * passed to input_proxy_reconcile()); adaptive models learn from the
+     * same errors.
+     */
+    uint32_t mispredictions;      /* Lead made the event worse than no lead would have */
+    uint32_t corrections;         /* Predictions scored */
+    double error_mean;            /* EWMA of |predicted - actual| */
+    double error_rms;             /* EWMA root-mean-square error */
+    double filter_alpha;          /* Current alpha-beta gains (adaptive backend) */
+    double filter_beta;
+    double effective_window_ms;   /* Prediction window after learned horizon scaling */
 } prediction_state_t;
 
 /**
@@ -100,6 +139,129 @@ int input_proxy_create(bool enable_prediction,
  */
 void input_proxy_destroy(struct input_proxy *proxy);
 
+/**
+ * Select the pointer prediction backend
+ *
+ * Resets prediction history. Must be called from the thread that
+ * processes events for this proxy.
+ *
+ * @param proxy Input proxy handle
+ * @param backend Backend to use (INPUT_PREDICTOR_AUTO resolves at call time)
+ * @return 0 on success, -1 if the backend is unavailable (current backend kept)
+ */
+int input_proxy_set_predictor(struct input_proxy *proxy, input_predictor_backend_t backend);
+
+/**
+ * Get the active pointer prediction backend
+ *
+ * @return Resolved backend, or INPUT_PREDICTOR_AUTO if prediction is disabled
+ */
+input_predictor_backend_t input_proxy_get_predictor(const struct input_proxy *proxy);
+
+/**
+ * Enable or disable touchpad scroll prediction
+ *
+ * Continuous (non-discrete) scroll is extrapolated over the prediction
+ * window with the active predictor backend and tracked for
+ * reconciliation like pointer motion. The lead is applied once: each
+ * predicted scroll event replaces the previous event's lead rather than
+ * adding to it, and the outstanding lead is withdrawn when the scroll
+ * stops (a zero-delta or discrete scroll event) or a reconciled
+ * prediction turns out wrong. Requires prediction to be enabled.
+ *
+ * @param proxy Input proxy handle
+ * @param enable Whether to predict scroll
+ * @return 0 on success, -1 on failure (e.g. prediction disabled)
+ */
+int input_proxy_set_scroll_prediction(struct input_proxy *proxy, bool enable);
+
+/**
+ * Set the clock used when no event time is available
+ *
+ * Events are processed at their own timestamp_us; the clock is read only
+ * for untimed events, frame acknowledgments and rollbacks. Event
+ * timestamps must use the same time base. A virtual clock makes the
+ * proxy fully replayable.
+ *
+ * @param proxy Input proxy handle
+ * @param clock Clock provider (must outlive the proxy), or NULL for the
+ *              system monotonic clock
+ */
+void input_proxy_set_clock(struct input_proxy *proxy, struct utils_clock *clock);
+
+/**
+ * Aim predictions at the display's vblanks
+ *
+ * With display timing known, each prediction targets the first vblank
+ * at or after event time + prediction window, extrapolated from the last
+ * presented vblank, and its lead is rescaled from the window to that
+ * horizon. Timing older than a second is ignored, and older vblanks than
+ * the one already known are skipped.
+ *
+ * @param proxy Input proxy handle
+ * @param vblank_us Time of a presented vblank in microseconds (same clock as events)
+ * @param refresh_us Refresh period in microseconds, or 0 to forget the timing
+ * @return 0 on success, -1 on failure
+ */
+int input_proxy_set_display_timing(struct input_proxy *proxy,
+                                   uint64_t vblank_us,
+                                   uint64_t refresh_us);
+
+/**
+ * Enable or disable kinetic scroll continuation
+ *
+ * When the fingers lift off a touchpad mid-scroll, the fling carries on
+ * locally and is emitted by input_proxy_frame(). Key, button and touch
+ * events or new scroll input cancel it. Requires scroll smoothing.
+ *
+ * @param proxy Input proxy handle
+ * @param config Friction curve, or NULL to disable
+ * @return 0 on success, -1 on failure
+ */
+int input_proxy_set_kinetic_scroll(struct input_proxy *proxy,
+                                   const struct scroll_kinetic_config *config);
+
+/**
+ * Stop a kinetic scroll in progress
+ *
+ * For deliberate input this proxy does not see, e.g. a click on another
+ * device of the same seat.
+ *
+ * @param proxy Input proxy handle
+ * @return 0 on success, -1 on failure
+ */
+int input_proxy_cancel_kinetic_scroll(struct input_proxy *proxy);
+
+/**
+ * Advance kinetic scrolling to a display frame
+ *
+ * Also scores predictions whose target time passed with no input since
+ * as if the pointer had stopped (see prediction_state_t).
+ *
+ * @param proxy Input proxy handle
+ * @param frame_time_us Frame time in microseconds (monotonic)
+ * @param out Output scroll event
+ * @return 1 if a scroll event was written to out, 0 if none, -1 on failure
+ */
+int input_proxy_frame(struct input_proxy *proxy, uint64_t frame_time_us, struct input_event *out);
+
+/**
+ * Take a pending lead rollback, if any
+ *
+ * When the scroll or motion that follows a displacement lead (scroll
+ * prediction, or pointer prediction by a velocity backend) stalls,
+ * reverses or falls well short of it (or an explicit actual event
+ * disagrees), the lead already shown locally must be withdrawn; the
+ * result is a scroll or relative pointer motion event carrying the
+ * negated lead, to be forwarded like any processed event. Call until it
+ * returns 0 after every process, frame and reconcile call.
+ *
+ * @param proxy Input proxy handle
+ * @param out Output rollback event
+ * @return 1 if a rollback was written to out, 0 if none, -1 on failure
+ */
+int input_proxy_take_correction(struct input_proxy *proxy, struct input_event *out);
+
 /**
  * Process input event (with prediction if enabled)
  *
@@ -107,19 +269,56 @@ void input_proxy_destroy(struct input_proxy *proxy);
  * @param event Input event
  * @param predicted_out Output predicted event (if prediction applied).
  *                      If non-NULL and prediction/smoothing produces an event, the caller owns the returned
- *                      `struct input_event *` and must `free()` it.
+ *                      `struct input_event *` and must `free()` it. Hot paths should
+ *                      prefer input_proxy_process_into().
  * @return 0 on success, negative error code on failure
  */
 int input_proxy_process(struct input_proxy *proxy,
                        const struct input_event *event,
                        struct input_event **predicted_out);
 
+/**
+ * Process input event into caller-provided storage (allocation-free)
+ *
+ * Same processing as input_proxy_process(), without heap traffic: the
+ * predicted/smoothed event is written to `out` and prediction tracking
+ * uses a fixed slab inside the proxy.
+ *
+ * @param proxy Input proxy handle
+ * @param event Input event
+ * @param out Output event storage (may be NULL if the result is not needed)
+ * @return 1 if an event was produced (and written to out), 0 if none, -1 on failure
+ */
+int input_proxy_process_into(struct input_proxy *proxy,
+                            const struct input_event *event,
+                            struct input_event *out);
+
+/**
+ * Process a burst of pointer motion events as one coalesced event
+ *
+ * Every sample is fed to the predictor (one batched call per chunk for
+ * the velocity backends), and the result is a single predicted event
+ * covering the whole burst. A burst of one behaves like
+ * input_proxy_process_into().
+ *
+ * @param proxy Input proxy handle
+ * @param events Consecutive pointer motion events, all relative or all absolute
+ * @param count Number of events (> 0)
+ * @param out Output event storage (may be NULL if the result is not needed)
+ * @return 1 if an event was produced (and written to out), 0 if none, -1 on failure
+ */
+int input_proxy_process_burst(struct input_proxy *proxy,
+                              const struct input_event *events,
+                              size_t count,
+                              struct input_event *out);
+
 /**
  * Reconcile predicted input with server acknowledgment
  *
  * @param proxy Input proxy handle
  * @param frame_id Frame ID that was acknowledged
- * @param actual_event Actual event that was processed (NULL if prediction was correct)
+ * @param actual_event Actual event that was processed, or NULL to score the
+ *        prediction against the input that follows it (the usual case)
  * @return 0 on success, negative error code on failure
  */
 int input_proxy_reconcile(struct input_proxy *proxy,
@@ -169,6 +368,152 @@ int scroll_smoother_process(struct scroll_state *smoother,
                            bool discrete,
                            double *smoothed_dx, double *smoothed_dy);
 
+/**
+ * Smooth scroll event at an explicit time
+ *
+ * Same as scroll_smoother_process() with the event timestamp supplied by
+ * the caller, so results are deterministic. Any fling in progress is
+ * cancelled; continuous deltas are recorded for the next release.
+ *
+ * @param smoother Scroll smoother handle
+ * @param timestamp_us Event timestamp in microseconds (monotonic)
+ * @return 0 on success, negative error code on failure
+ */
+int scroll_smoother_process_at(struct scroll_state *smoother,
+                               uint64_t timestamp_us,
+                               double dx, double dy,
+                               bool discrete,
+                               double *smoothed_dx, double *smoothed_dy);
+
+/**
+ * Kinetic scroll friction curve
+ *
+ * Fling speed v decays as dv/dt = -friction * v - deceleration until it
+ * reaches stop_velocity. At least one of friction or deceleration must
+ * be positive, and a pure exponential curve needs a stop velocity.
+ */
+struct scroll_kinetic_config {
+    double friction;            /* Proportional decay, 1/s */
+    double deceleration;        /* Constant decay, units/s^2 */
+    double stop_velocity;       /* Fling ends below this speed, units/s */
+    double min_fling_velocity;  /* Slower releases do not fling, units/s */
+};
+
+/**
+ * Fill in the default kinetic scroll curve
+ */
+void scroll_smoother_kinetic_defaults(struct scroll_kinetic_config *config);
+
+/**
+ * Enable or disable kinetic scrolling
+ *
+ * @param smoother Scroll smoother handle
+ * @param config Friction curve (copied), or NULL to disable
+ * @return 0 on success, -1 if the curve would never stop
+ */
+int scroll_smoother_set_kinetic(struct scroll_state *smoother,
+                                const struct scroll_kinetic_config *config);
+
+/**
+ * Fingers lifted: start a fling from the recent scroll velocity
+ *
+ * @param smoother Scroll smoother handle
+ * @param timestamp_us Release time in microseconds (monotonic)
+ * @return 1 if a fling started, 0 if not (too slow, paused, or disabled), -1 on failure
+ */
+int scroll_smoother_release(struct scroll_state *smoother, uint64_t timestamp_us);
+
+/**
+ * Advance a fling to a frame time
+ *
+ * Emits the distance covered since the previous frame; call once per
+ * display frame (e.g. from the frame callback).
+ *
+ * @param smoother Scroll smoother handle
+ * @param frame_time_us Frame time in microseconds (monotonic)
+ * @param dx Output scroll delta X
+ * @param dy Output scroll delta Y
+ * @return 1 if a delta was produced, 0 if idle, -1 on failure
+ */
+int scroll_smoother_frame(struct scroll_state *smoother,
+                          uint64_t frame_time_us,
+                          double *dx, double *dy);
+
+/**
+ * Stop any fling in progress (new touch, key or button input)
+ */
+void scroll_smoother_cancel(struct scroll_state *smoother);
+
+/**
+ * Whether a fling is in progress
+ */
+bool scroll_smoother_is_flinging(const struct scroll_state *smoother);
+
+/**
+ * Adaptive motion prediction functions
+ */
+
+/**
+ * Motion predictor statistics
+ */
+struct motion_predictor_stats {
+    uint32_t corrections;
+    double error_mean;
+    double error_rms;
+    double alpha;
+    double beta;
+    double effective_window_ms;
+};
+
+/**
+ * Create adaptive motion predictor (alpha-beta filter with error feedback)
+ *
+ * @param window_ms Nominal prediction window in milliseconds
+ * @param predictor_out Output predictor handle
+ * @return 0 on success, negative error code on failure
+ */
+int motion_predictor_create(uint32_t window_ms, struct motion_predictor **predictor_out);
+
+/**
+ * Destroy motion predictor
+ */
+void motion_predictor_destroy(struct motion_predictor *predictor);
+
+/**
+ * Predict pointer motion one window ahead
+ *
+ * @param predictor Motion predictor handle
+ * @param timestamp_us Event timestamp in microseconds (monotonic)
+ * @param dx Measured delta X
+ * @param dy Measured delta Y
+ * @param predicted_dx Output predicted delta X
+ * @param predicted_dy Output predicted delta Y
+ * @return 0 on success, negative error code on failure
+ */
+int motion_predictor_predict(struct motion_predictor *predictor,
+                             uint64_t timestamp_us,
+                             double dx, double dy,
+                             double *predicted_dx, double *predicted_dy);
+
+/**
+ * Feed a reconciliation error back into the model
+ *
+ * @param predictor Motion predictor handle
+ * @param lead_dx Predicted minus measured delta X at prediction time
+ * @param lead_dy Predicted minus measured delta Y at prediction time
+ * @param error_dx Predicted minus actual delta X
+ * @param error_dy Predicted minus actual delta Y
+ */
+void motion_predictor_correct(struct motion_predictor *predictor,
+                              double lead_dx, double lead_dy,
+                              double error_dx, double error_dy);
+
+/**
+ * Get motion predictor statistics
+ */
+void motion_predictor_get_stats(const struct motion_predictor *predictor,
+                                struct motion_predictor_stats *stats_out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,20 +1,53 @@
 #include "input.h"
 #include "rust_predictor.h"
+#include "../core/utils.h"
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <math.h>
 
 /**
  * Input proxy implementation with predictive input
  */
 
+/*
+ * Pending predictions live in a power-of-two ring indexed by
+ * frame_id & mask. Frame IDs are issued in order, so the slot for a new
+ * prediction is always the oldest one; each slot keeps its full frame_id
+ * as a generation tag, so an overwritten or expired entry can never be
+ * mistaken for the frame being acknowledged. Nothing is ever walked or
+ * explicitly evicted.
+ */
+#define INPUT_PROXY_PENDING_MASK (INPUT_PROXY_PENDING_CAPACITY - 1)
+#define INPUT_PROXY_STALE_US 1000000ULL  /* 1 second */
+#define INPUT_PROXY_BURST_CHUNK 64          /* Samples per predictor batch call */
+#define INPUT_PROXY_SCROLL_GAP_S 0.1        /* Longer pauses end the scroll rate estimate */
+#define INPUT_PROXY_SCROLL_MIN_DT_S 0.0005  /* Coalesced scroll can share a timestamp */
+#define INPUT_PROXY_ERROR_DECAY 0.05        /* EWMA weight of the newest scored error */
+#define INPUT_PROXY_MISPREDICT_SLACK 0.5    /* Units a lead may miss by before it counts */
+#define INPUT_PROXY_OBSERVE_GRACE_US 8000   /* No sample this long past a target = input stopped */
+
+_Static_assert((INPUT_PROXY_PENDING_CAPACITY & INPUT_PROXY_PENDING_MASK) == 0,
+               "pending prediction ring must be a power of two");
+
 /* Pending predicted event with frame ID */
 struct pending_prediction {
-    uint64_t frame_id;
-    struct input_event *predicted_event;
+    uint64_t frame_id;          /* Generation tag (0 = never used) */
+    bool live;                  /* Not yet acknowledged */
+    bool adaptive;              /* Predicted by an adaptive model */
+    bool observing;             /* Not yet scored against the input that followed */
+    bool displaced;             /* Lead is a displacement, shown until revised */
     uint64_t timestamp_us;
-    struct pending_prediction *next;
+    double lead_dx, lead_dy;    /* Displacement, or predicted minus measured delta */
+    double base_x, base_y;      /* Accumulated input when predicted */
+    struct input_event predicted_event;
+};
+
+/* Displacement lead shown locally on top of the real deltas */
+struct shown_lead {
+    double dx, dy;
+    uint64_t frame_id;          /* Prediction whose lead is shown */
+    bool correction_pending;
+    double correction_dx, correction_dy;
 };
 
 struct input_proxy {
@@ -22,19 +55,172 @@ struct input_proxy {
     uint32_t prediction_window_ms;
     bool enable_scroll_smoothing;
     struct scroll_state *scroll_smoother;
+    struct motion_predictor *motion_predictor;
+    struct motion_predictor *scroll_predictor;  /* Adaptive backend's scroll track */
     prediction_state_t prediction_state;
     uint64_t frame_counter;
+    struct utils_clock *clock;  /* NULL = system monotonic */
+    
+    /* Display timing from presentation feedback (0 = unknown) */
+    uint64_t vblank_us;
+    uint64_t refresh_us;
     
     /* Reconciliation tracking */
-    struct pending_prediction *pending_predictions;
-    size_t pending_count;
     uint64_t next_frame_id;
     
-    /* Rust predictor (if available) */
-    rust_input_predictor_t *rust_predictor;
-    bool use_rust_predictor;
+    /* Scoring against the real input that followed each prediction */
+    uint64_t observe_motion;    /* Oldest motion prediction not yet scored */
+    uint64_t observe_scroll;    /* Oldest scroll prediction not yet scored */
+    double error_sq;            /* EWMA of the squared error */
+    
+    /* Velocity predictor (Rust or C, same ABI) */
+    input_predictor_backend_t predictor_backend;
+    const struct velocity_backend *velocity;
+    rust_input_predictor_t *velocity_predictor;
+    
+    /* Motion prediction: the velocity trackers' lead over the real motion */
+    double motion_offset_x, motion_offset_y;    /* Accumulated real motion */
+    struct shown_lead motion_lead;
+    
+    /* Scroll prediction: lead shown locally on top of the real deltas */
+    bool enable_scroll_prediction;
+    double scroll_offset_x, scroll_offset_y;    /* Accumulated real scroll */
+    uint64_t scroll_last_us;                    /* Previous scroll event (0 = stopped) */
+    struct shown_lead scroll_lead;
+    
+    struct pending_prediction pending[INPUT_PROXY_PENDING_CAPACITY];
+};
+
+/* Velocity predictor backends sharing the rust_predictor.h ABI */
+struct velocity_backend {
+    rust_input_predictor_t *(*create)(uint32_t window_ms, double smoothing_factor, double velocity_decay);
+    void (*destroy)(rust_input_predictor_t *predictor);
+    int (*predict_pointer_batch)(rust_input_predictor_t *predictor, const uint64_t *timestamps_us,
+                                 const double *dx, const double *dy, size_t count,
+                                 double *predicted_dx, double *predicted_dy);
+    int (*predict_scroll)(rust_input_predictor_t *predictor, double timestamp,
+                          double dx, double dy, double *predicted_dx, double *predicted_dy);
+};
+
+static const struct velocity_backend rust_backend = {
+    rust_input_predictor_create,
+    rust_input_predictor_destroy,
+    rust_input_predictor_predict_pointer_batch,
+    rust_input_predictor_predict_scroll,
+};
+
+static const struct velocity_backend c_velocity_backend = {
+    velocity_predictor_create,
+    velocity_predictor_destroy,
+    velocity_predictor_predict_pointer_batch,
+    velocity_predictor_predict_scroll,
 };
 
+static void input_proxy_release_predictor(struct input_proxy *proxy) {
+    if (proxy->velocity_predictor) {
+        proxy->velocity->destroy(proxy->velocity_predictor);
+        proxy->velocity_predictor = NULL;
+    }
+    proxy->velocity = NULL;
+    motion_predictor_destroy(proxy->motion_predictor);
+    proxy->motion_predictor = NULL;
+    motion_predictor_destroy(proxy->scroll_predictor);
+    proxy->scroll_predictor = NULL;
+}
+
+int input_proxy_set_predictor(struct input_proxy *proxy, input_predictor_backend_t backend) {
+    if (!proxy) {
+        return -1;
+    }
+    
+    if (backend == INPUT_PREDICTOR_AUTO) {
+        if (input_proxy_set_predictor(proxy, INPUT_PREDICTOR_RUST) == 0) {
+            return 0;
+        }
+        return input_proxy_set_predictor(proxy, INPUT_PREDICTOR_VELOCITY);
+    }
+    
+    /* Build the new backend before dropping the current one */
+    const struct velocity_backend *velocity = NULL;
+    rust_input_predictor_t *velocity_predictor = NULL;
+    struct motion_predictor *motion = NULL;
+    struct motion_predictor *scroll = NULL;
+    
+    switch (backend) {
+        case INPUT_PREDICTOR_RUST:
+            velocity = &rust_backend;
+            break;
+        case INPUT_PREDICTOR_VELOCITY:
+            velocity = &c_velocity_backend;
+            break;
+        case INPUT_PREDICTOR_ADAPTIVE:
+            if (motion_predictor_create(proxy->prediction_window_ms, &motion) < 0) {
+                return -1;
+            }
+            if (motion_predictor_create(proxy->prediction_window_ms, &scroll) < 0) {
+                motion_predictor_destroy(motion);
+                return -1;
+            }
+            break;
+        default:
+            return -1;
+    }
+    
+    if (velocity) {
+        /* Smoothing/decay defaults shared by both velocity backends */
+        velocity_predictor = velocity->create(proxy->prediction_window_ms, 0.7, 0.9);
+        if (!velocity_predictor) {
+            return -1;  /* e.g. Rust not linked */
+        }
+    }
+    
+    input_proxy_release_predictor(proxy);
+    proxy->velocity = velocity;
+    proxy->velocity_predictor = velocity_predictor;
+    proxy->motion_predictor = motion;
+    proxy->scroll_predictor = scroll;
+    proxy->predictor_backend = backend;
+    return 0;
+}
+
+input_predictor_backend_t input_proxy_get_predictor(const struct input_proxy *proxy) {
+    return proxy ? proxy->predictor_backend : INPUT_PREDICTOR_AUTO;
+}
+
+int input_proxy_set_scroll_prediction(struct input_proxy *proxy, bool enable) {
+    if (!proxy || (enable && !proxy->enable_prediction)) {
+        return -1;
+    }
+    
+    proxy->enable_scroll_prediction = enable;
+    proxy->prediction_state.scroll_enabled = enable;
+    return 0;
+}
+
+void input_proxy_set_clock(struct input_proxy *proxy, struct utils_clock *clock) {
+    if (proxy) {
+        proxy->clock = clock;
+    }
+}
+
+int input_proxy_set_display_timing(struct input_proxy *proxy,
+                                   uint64_t vblank_us,
+                                   uint64_t refresh_us) {
+    if (!proxy) {
+        return -1;
+    }
+    
+    /* Only ever move forward: feedback from several surfaces arrives out of order */
+    if (refresh_us == 0 || vblank_us == 0) {
+        proxy->vblank_us = 0;
+        proxy->refresh_us = 0;
+    } else if (vblank_us >= proxy->vblank_us) {
+        proxy->vblank_us = vblank_us;
+        proxy->refresh_us = refresh_us;
+    }
+    return 0;
+}
+
 int input_proxy_create(bool enable_prediction,
                       uint32_t prediction_window_ms,
                       bool enable_scroll_smoothing,
@@ -58,31 +244,24 @@ int input_proxy_create(bool enable_prediction,
     proxy->prediction_state.last_prediction_us = 0;
     proxy->prediction_state.events_predicted = 0;
     proxy->prediction_state.events_reconciled = 0;
+    proxy->prediction_state.pending_overflows = 0;
+    proxy->prediction_state.late_acks = 0;
+    proxy->prediction_state.mispredictions = 0;
+    proxy->prediction_state.effective_window_ms = prediction_window_ms;
     
-    proxy->pending_predictions = NULL;
-    proxy->pending_count = 0;
     proxy->next_frame_id = 1;
+    proxy->observe_motion = 1;
+    proxy->observe_scroll = 1;
     
-    /* Try to initialize Rust predictor */
-    proxy->rust_predictor = NULL;
-    proxy->use_rust_predictor = false;
-    
-    if (enable_prediction) {
-        /* Try to create Rust predictor with default parameters */
-        proxy->rust_predictor = rust_input_predictor_create(
-            prediction_window_ms,
-            0.7,  /* smoothing_factor */
-            0.9   /* velocity_decay */
-        );
-        
-        if (proxy->rust_predictor) {
-            proxy->use_rust_predictor = true;
-        }
+    /* Rust predictor if linked, otherwise its C port */
+    if (enable_prediction && input_proxy_set_predictor(proxy, INPUT_PREDICTOR_AUTO) < 0) {
+        input_proxy_destroy(proxy);
+        return -1;
     }
     
     if (enable_scroll_smoothing) {
         if (scroll_smoother_create(&proxy->scroll_smoother) < 0) {
-            free(proxy);
+            input_proxy_destroy(proxy);
             return -1;
         }
     } else {
@@ -102,148 +281,574 @@ void input_proxy_destroy(struct input_proxy *proxy) {
         scroll_smoother_destroy(proxy->scroll_smoother);
     }
     
-    /* Free pending predictions */
-    struct pending_prediction *pred = proxy->pending_predictions;
-    while (pred) {
-        struct pending_prediction *next = pred->next;
-        if (pred->predicted_event) {
-            free(pred->predicted_event);
+    input_proxy_release_predictor(proxy);
+    
+    free(proxy);
+}
+
+/* A prediction made at timestamp_us can still be acknowledged at now_us */
+static inline bool input_proxy_is_fresh(uint64_t timestamp_us, uint64_t now_us) {
+    return timestamp_us + INPUT_PROXY_STALE_US >= now_us;
+}
+
+/*
+ * Lead time of a prediction made at now_us. The window is how long input
+ * takes to reach the screen; with display timing known, the prediction
+ * aims at the first vblank at or after now + window instead, which is when
+ * the frame showing it is actually scanned out.
+ */
+static uint64_t input_proxy_horizon_us(const struct input_proxy *proxy, uint64_t now_us) {
+    uint64_t window_us = proxy->prediction_window_ms * 1000ULL;
+    if (proxy->refresh_us == 0 || !input_proxy_is_fresh(proxy->vblank_us, now_us)) {
+        return window_us;
+    }
+    
+    uint64_t target_us = now_us + window_us;
+    if (target_us <= proxy->vblank_us) {
+        return proxy->vblank_us - now_us;
+    }
+    uint64_t periods = (target_us - proxy->vblank_us + proxy->refresh_us - 1) / proxy->refresh_us;
+    return proxy->vblank_us + periods * proxy->refresh_us - now_us;
+}
+
+/* Leads are predicted over the window; rescale them to the horizon */
+static inline double input_proxy_horizon_scale(const struct input_proxy *proxy, uint64_t horizon_us) {
+    uint64_t window_us = proxy->prediction_window_ms * 1000ULL;
+    return window_us > 0 ? (double)horizon_us / (double)window_us : 1.0;
+}
+
+/* Event time for the predictors (events without one use processing time) */
+static inline uint64_t event_time_us(const struct input_event *event, uint64_t now_us) {
+    return event->timestamp_us ? event->timestamp_us : now_us;
+}
+
+/* Feed a prediction's error to the statistics and, if it was adaptive, to its model */
+static void input_proxy_score(struct input_proxy *proxy,
+                              const struct pending_prediction *pending,
+                              double error_dx, double error_dy) {
+    prediction_state_t *state = &proxy->prediction_state;
+    double error_sq = error_dx * error_dx + error_dy * error_dy;
+    double error = sqrt(error_sq);
+    if (state->corrections == 0) {
+        state->error_mean = error;
+        proxy->error_sq = error_sq;
+    } else {
+        state->error_mean += INPUT_PROXY_ERROR_DECAY * (error - state->error_mean);
+        proxy->error_sq += INPUT_PROXY_ERROR_DECAY * (error_sq - proxy->error_sq);
+    }
+    state->error_rms = sqrt(proxy->error_sq);
+    state->corrections++;
+    
+    /* Every observed error (small ones included) tunes the model's gain and horizon */
+    struct motion_predictor *model = pending->predicted_event.type == INPUT_EVENT_SCROLL ?
+                                     proxy->scroll_predictor : proxy->motion_predictor;
+    if (pending->adaptive && model) {
+        motion_predictor_correct(model, pending->lead_dx, pending->lead_dy, error_dx, error_dy);
+    }
+}
+
+/* actual_dx/dy: the real displacement the prediction was measured against */
+static void input_proxy_mispredicted(struct input_proxy *proxy,
+                                     const struct pending_prediction *pending,
+                                     double actual_dx, double actual_dy) {
+    proxy->prediction_state.mispredictions++;
+    
+    /*
+     * Displacement leads: withdraw the lead shown locally if it is the
+     * mispredicted one (no newer event has revised it) or it runs against
+     * the real input; prediction restarts with the next event.
+     */
+    bool scroll = pending->predicted_event.type == INPUT_EVENT_SCROLL;
+    struct shown_lead *shown = scroll ? &proxy->scroll_lead : &proxy->motion_lead;
+    bool stale = pending->frame_id == shown->frame_id ||
+                 shown->dx * actual_dx + shown->dy * actual_dy < 0.0;
+    if (pending->displaced && stale && (shown->dx != 0.0 || shown->dy != 0.0)) {
+        shown->correction_dx -= shown->dx;
+        shown->correction_dy -= shown->dy;
+        shown->correction_pending = true;
+        shown->dx = 0.0;
+        shown->dy = 0.0;
+        if (scroll) {
+            proxy->prediction_state.scroll_rollbacks++;
+        }
+    }
+}
+
+/*
+ * Score predictions of one type against the input that really followed
+ * them. A displacement lead (scroll, or motion from a velocity tracker)
+ * stands for the input expected by the target time (timestamp +
+ * horizon), so it is compared with the real input accumulated up to
+ * that time. Any other motion prediction stands for the event expected
+ * at its target time, so it is compared with the first real sample at or
+ * after that time. sample is the real event at now_us (motion is
+ * accumulated before it is scored, scroll after), or NULL once the input
+ * has gone quiet: a delta target passed with no sample is an actual
+ * delta of zero. A prediction counts as mispredicted when its lead moved
+ * the event further from what really arrived than showing no lead would
+ * have; for a displacement that is a lead in the wrong direction or
+ * less than half realized.
+ */
+static void input_proxy_observe(struct input_proxy *proxy,
+                                input_event_type_t type,
+                                uint64_t now_us,
+                                const struct input_event *sample) {
+    uint64_t *next = type == INPUT_EVENT_SCROLL ? &proxy->observe_scroll : &proxy->observe_motion;
+    if (proxy->next_frame_id - *next > INPUT_PROXY_PENDING_CAPACITY) {
+        *next = proxy->next_frame_id - INPUT_PROXY_PENDING_CAPACITY;  /* Older slots are reused */
+    }
+    while (*next < proxy->next_frame_id) {
+        struct pending_prediction *pending = &proxy->pending[*next & INPUT_PROXY_PENDING_MASK];
+        const struct input_event *predicted = &pending->predicted_event;
+        if (pending->frame_id == *next && pending->observing && predicted->type == type) {
+            uint64_t target_us = predicted->timestamp_us;
+            bool due = !sample ? target_us + INPUT_PROXY_OBSERVE_GRACE_US <= now_us :
+                       type == INPUT_EVENT_SCROLL ? target_us < now_us : target_us <= now_us;
+            if (!due) {
+                return;  /* Target still ahead; later predictions aim later */
+            }
+            
+            double actual_dx, actual_dy, error_dx, error_dy;
+            if (type == INPUT_EVENT_SCROLL) {
+                actual_dx = proxy->scroll_offset_x - pending->base_x;
+                actual_dy = proxy->scroll_offset_y - pending->base_y;
+                error_dx = pending->lead_dx - actual_dx;
+                error_dy = pending->lead_dy - actual_dy;
+            } else if (pending->displaced) {
+                actual_dx = proxy->motion_offset_x - pending->base_x;
+                actual_dy = proxy->motion_offset_y - pending->base_y;
+                error_dx = pending->lead_dx - actual_dx;
+                error_dy = pending->lead_dy - actual_dy;
+            } else {
+                actual_dx = sample ? sample->pointer_motion.dx : 0.0;
+                actual_dy = sample ? sample->pointer_motion.dy : 0.0;
+                error_dx = predicted->pointer_motion.dx - actual_dx;
+                error_dy = predicted->pointer_motion.dy - actual_dy;
+            }
+            input_proxy_score(proxy, pending, error_dx, error_dy);
+            if (hypot(error_dx, error_dy) >
+                hypot(error_dx - pending->lead_dx, error_dy - pending->lead_dy) + INPUT_PROXY_MISPREDICT_SLACK) {
+                input_proxy_mispredicted(proxy, pending, actual_dx, actual_dy);
+            }
+            pending->observing = false;
+        }
+        (*next)++;  /* Scored, another type, overwritten, or scored by an explicit actual event */
+    }
+}
+
+/*
+ * A scroll gesture ended with event: leads due by its time are scored
+ * (nothing else arrives up to and including it), the rest aimed past the
+ * stop and were withdrawn with it.
+ */
+static void input_proxy_scroll_stopped(struct input_proxy *proxy,
+                                       const struct input_event *event,
+                                       uint64_t timestamp_us) {
+    input_proxy_observe(proxy, INPUT_EVENT_SCROLL, timestamp_us + 1, event);
+    for (uint64_t id = proxy->observe_scroll; id < proxy->next_frame_id; id++) {
+        struct pending_prediction *pending = &proxy->pending[id & INPUT_PROXY_PENDING_MASK];
+        if (pending->frame_id == id && pending->predicted_event.type == INPUT_EVENT_SCROLL) {
+            pending->observing = false;
+        }
+    }
+}
+
+/* Score whatever the input going quiet until now_us settles */
+static void input_proxy_observe_idle(struct input_proxy *proxy, uint64_t now_us) {
+    input_proxy_observe(proxy, INPUT_EVENT_POINTER_MOTION, now_us, NULL);
+    input_proxy_observe(proxy, INPUT_EVENT_SCROLL, now_us, NULL);
+}
+
+/*
+ * Feed every sample of a motion burst to the active predictor (one batch
+ * call per chunk for velocity backends) and return the lead predicted
+ * after the last sample, over the prediction window. The velocity
+ * trackers differentiate their input, so they are fed the accumulated
+ * motion (origin_x/y is where it stood before the burst) and return the
+ * displacement expected over the window, to be shown until revised
+ * (*displaced); the adaptive model and the fallback predict the next
+ * delta, and the lead is how far it differs from the last one. Returns
+ * true if the adaptive model produced it.
+ */
+static bool input_proxy_predict_motion(struct input_proxy *proxy,
+                                       const struct input_event *events,
+                                       size_t count,
+                                       double origin_x, double origin_y,
+                                       uint64_t now_us,
+                                       double *lead_dx,
+                                       double *lead_dy,
+                                       bool *displaced) {
+    const struct input_event *last = &events[count - 1];
+    
+    *displaced = false;
+    if (proxy->velocity_predictor) {
+        uint64_t timestamps_us[INPUT_PROXY_BURST_CHUNK];
+        double x[INPUT_PROXY_BURST_CHUNK], y[INPUT_PROXY_BURST_CHUNK];
+        double out_dx[INPUT_PROXY_BURST_CHUNK], out_dy[INPUT_PROXY_BURST_CHUNK];
+        double position_x = origin_x, position_y = origin_y;
+        
+        bool predicted = true;
+        for (size_t base = 0; base < count && predicted; base += INPUT_PROXY_BURST_CHUNK) {
+            size_t n = count - base < INPUT_PROXY_BURST_CHUNK ? count - base : INPUT_PROXY_BURST_CHUNK;
+            for (size_t i = 0; i < n; i++) {
+                position_x += events[base + i].pointer_motion.dx;
+                position_y += events[base + i].pointer_motion.dy;
+                timestamps_us[i] = event_time_us(&events[base + i], now_us);
+                x[i] = position_x;
+                y[i] = position_y;
+            }
+            predicted = proxy->velocity->predict_pointer_batch(proxy->velocity_predictor,
+                                                               timestamps_us, x, y, n,
+                                                               out_dx, out_dy) == 0;
+            *lead_dx = out_dx[n - 1];
+            *lead_dy = out_dy[n - 1];
+        }
+        if (predicted) {
+            *displaced = true;
+            return false;
+        }
+    }
+    
+    double predicted_dx = 0.0, predicted_dy = 0.0;
+    bool adaptive = false;
+    if (proxy->motion_predictor) {
+        for (size_t i = 0; i < count; i++) {
+            adaptive = motion_predictor_predict(proxy->motion_predictor,
+                                                event_time_us(&events[i], now_us),
+                                                events[i].pointer_motion.dx,
+                                                events[i].pointer_motion.dy,
+                                                &predicted_dx, &predicted_dy) == 0;
         }
-        free(pred);
-        pred = next;
     }
     
-    /* Destroy Rust predictor */
-    if (proxy->rust_predictor) {
-        rust_input_predictor_destroy(proxy->rust_predictor);
+    if (!adaptive) {
+        /* Simple extrapolation: assume constant velocity */
+        predicted_dx = last->pointer_motion.dx * 1.1;
+        predicted_dy = last->pointer_motion.dy * 1.1;
     }
     
-    free(proxy);
+    *lead_dx = predicted_dx - last->pointer_motion.dx;
+    *lead_dy = predicted_dy - last->pointer_motion.dy;
+    return adaptive;
 }
 
-int input_proxy_process(struct input_proxy *proxy,
-                       const struct input_event *event,
-                       struct input_event **predicted_out) {
-    if (!proxy || !event) {
-        return -1;
+/* Track a prediction for reconciliation, replacing the oldest slot */
+static void input_proxy_track(struct input_proxy *proxy,
+                              const struct input_event *predicted,
+                              bool adaptive,
+                              bool displaced,
+                              double lead_dx, double lead_dy,
+                              uint64_t now_us) {
+    /* Assign frame ID for tracking */
+    uint64_t frame_id = proxy->next_frame_id++;
+    
+    struct pending_prediction *pending = &proxy->pending[frame_id & INPUT_PROXY_PENDING_MASK];
+    if (pending->live && input_proxy_is_fresh(pending->timestamp_us, now_us)) {
+        proxy->prediction_state.pending_overflows++;
     }
+    pending->frame_id = frame_id;
+    pending->live = true;
+    pending->adaptive = adaptive;
+    pending->observing = true;
+    pending->displaced = displaced;
+    pending->timestamp_us = now_us;
+    pending->lead_dx = lead_dx;
+    pending->lead_dy = lead_dy;
+    if (predicted->type == INPUT_EVENT_SCROLL) {
+        pending->base_x = proxy->scroll_offset_x;
+        pending->base_y = proxy->scroll_offset_y;
+    } else {
+        pending->base_x = proxy->motion_offset_x;
+        pending->base_y = proxy->motion_offset_y;
+    }
+    pending->predicted_event = *predicted;
     
-    if (predicted_out) {
-        *predicted_out = NULL;
+    proxy->prediction_state.events_predicted++;
+    proxy->prediction_state.last_prediction_us = now_us;
+}
+
+/*
+ * Predict a motion burst and track the result for reconciliation. The
+ * lead predicted for the last sample is applied to the coalesced event,
+ * so a burst of one is an ordinary single-event prediction. As with
+ * scroll, a displacement lead is applied once: each event carries only
+ * the change from the lead shown before it.
+ */
+static int input_proxy_predict_burst(struct input_proxy *proxy,
+                                     const struct input_event *events,
+                                     size_t count,
+                                     const struct input_event *coalesced,
+                                     uint64_t now_us,
+                                     struct input_event *out) {
+    double origin_x = proxy->motion_offset_x;
+    double origin_y = proxy->motion_offset_y;
+    
+    /* Earlier predictions aimed at these samples are scored before predicting again */
+    for (size_t i = 0; i < count; i++) {
+        proxy->motion_offset_x += events[i].pointer_motion.dx;
+        proxy->motion_offset_y += events[i].pointer_motion.dy;
+        input_proxy_observe(proxy, INPUT_EVENT_POINTER_MOTION, event_time_us(&events[i], now_us), &events[i]);
+    }
+    
+    uint64_t horizon_us = input_proxy_horizon_us(proxy, now_us);
+    double scale = input_proxy_horizon_scale(proxy, horizon_us);
+    
+    double lead_dx, lead_dy;
+    bool displaced;
+    bool adaptive = input_proxy_predict_motion(proxy, events, count, origin_x, origin_y, now_us,
+                                               &lead_dx, &lead_dy, &displaced);
+    lead_dx *= scale;
+    lead_dy *= scale;
+    proxy->prediction_state.horizon_us = horizon_us;
+    
+    /* Create predicted event (a lead left shown by another backend is withdrawn) */
+    struct input_event predicted = *coalesced;
+    predicted.timestamp_us = now_us + horizon_us;
+    predicted.pointer_motion.dx = coalesced->pointer_motion.dx + lead_dx - proxy->motion_lead.dx;
+    predicted.pointer_motion.dy = coalesced->pointer_motion.dy + lead_dy - proxy->motion_lead.dy;
+    proxy->motion_lead.dx = displaced ? lead_dx : 0.0;
+    proxy->motion_lead.dy = displaced ? lead_dy : 0.0;
+    
+    input_proxy_track(proxy, &predicted, adaptive, displaced, lead_dx, lead_dy, now_us);
+    proxy->motion_lead.frame_id = proxy->next_frame_id - 1;
+    
+    if (out) {
+        *out = predicted;
+    }
+    return 1;
+}
+
+/*
+ * Scroll expected over the next prediction window. The velocity
+ * trackers differentiate their input, so they are fed the accumulated
+ * scroll offset and return the lead directly; the adaptive model and the
+ * fallback predict the next delta, which is scaled from the event
+ * interval to the window. Returns true if the adaptive model was used.
+ */
+static bool input_proxy_predict_scroll_lead(struct input_proxy *proxy,
+                                            const struct input_event *event,
+                                            uint64_t now_us,
+                                            double *lead_dx,
+                                            double *lead_dy) {
+    uint64_t timestamp_us = event_time_us(event, now_us);
+    double window_s = proxy->prediction_window_ms / 1000.0;
+    double dt = 0.0;
+    if (proxy->scroll_last_us != 0 && timestamp_us > proxy->scroll_last_us) {
+        dt = (double)(timestamp_us - proxy->scroll_last_us) / 1000000.0;
+    }
+    proxy->scroll_last_us = timestamp_us;
+    input_proxy_observe(proxy, INPUT_EVENT_SCROLL, timestamp_us, event);
+    proxy->scroll_offset_x += event->scroll.dx;
+    proxy->scroll_offset_y += event->scroll.dy;
+    
+    if (proxy->velocity_predictor &&
+        proxy->velocity->predict_scroll(proxy->velocity_predictor,
+                                        (double)timestamp_us / 1000000.0,
+                                        proxy->scroll_offset_x, proxy->scroll_offset_y,
+                                        lead_dx, lead_dy) == 0) {
+        return false;
     }
     
-    /* Get current timestamp */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t now_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    double predicted_dx = event->scroll.dx;
+    double predicted_dy = event->scroll.dy;
+    bool adaptive = proxy->scroll_predictor &&
+                    motion_predictor_predict(proxy->scroll_predictor, timestamp_us,
+                                             event->scroll.dx, event->scroll.dy,
+                                             &predicted_dx, &predicted_dy) == 0;
     
-    /* Handle scroll smoothing */
-    if (event->type == INPUT_EVENT_SCROLL && proxy->enable_scroll_smoothing && proxy->scroll_smoother) {
+    /* Without an interval there is no rate to extrapolate */
+    if (dt <= 0.0 || dt > INPUT_PROXY_SCROLL_GAP_S) {
+        *lead_dx = 0.0;
+        *lead_dy = 0.0;
+        return adaptive;
+    }
+    if (dt < INPUT_PROXY_SCROLL_MIN_DT_S) {
+        dt = INPUT_PROXY_SCROLL_MIN_DT_S;
+    }
+    *lead_dx = predicted_dx / dt * window_s;
+    *lead_dy = predicted_dy / dt * window_s;
+    return adaptive;
+}
+
+/*
+ * Smooth and (for touchpad scroll) predict a scroll event. Only the
+ * change in lead is added to each event, so the total shown locally is
+ * always the real scroll plus one window of lead; a stop withdraws it.
+ */
+static int input_proxy_process_scroll(struct input_proxy *proxy,
+                                      const struct input_event *event,
+                                      uint64_t now_us,
+                                      struct input_event *out) {
+    struct input_event result = *event;
+    bool produced = false;
+    
+    if (proxy->enable_scroll_smoothing && proxy->scroll_smoother) {
         double smoothed_dx, smoothed_dy;
-        if (scroll_smoother_process(proxy->scroll_smoother,
-                                    event->scroll.dx, event->scroll.dy,
-                                    event->scroll.discrete,
-                                    &smoothed_dx, &smoothed_dy) == 0) {
-            /* Create smoothed event */
-            struct input_event *smoothed = malloc(sizeof(struct input_event));
-            if (smoothed) {
-                *smoothed = *event;
-                smoothed->scroll.dx = smoothed_dx;
-                smoothed->scroll.dy = smoothed_dy;
-                if (predicted_out) {
-                    *predicted_out = smoothed;
-                }
-            }
+        if (scroll_smoother_process_at(proxy->scroll_smoother,
+                                       event_time_us(event, now_us),
+                                       event->scroll.dx, event->scroll.dy,
+                                       event->scroll.discrete,
+                                       &smoothed_dx, &smoothed_dy) == 0) {
+            result.scroll.dx = smoothed_dx;
+            result.scroll.dy = smoothed_dy;
+            produced = true;
+        }
+        
+        /* Fingers lifted: hand over to the kinetic engine */
+        if (!event->scroll.discrete && event->scroll.dx == 0.0 && event->scroll.dy == 0.0) {
+            scroll_smoother_release(proxy->scroll_smoother, event_time_us(event, now_us));
         }
     }
     
-    /* Handle prediction for pointer motion */
-    if (event->type == INPUT_EVENT_POINTER_MOTION && proxy->enable_prediction) {
-        uint64_t prediction_window_us = proxy->prediction_window_ms * 1000ULL;
-        
-        /* Create predicted event */
-        struct input_event *predicted = malloc(sizeof(struct input_event));
-        if (predicted) {
-            *predicted = *event;
-            predicted->timestamp_us = now_us + prediction_window_us;
-            
-            double predicted_dx = event->pointer_motion.dx;
-            double predicted_dy = event->pointer_motion.dy;
-            
-            /* Use Rust predictor if available, otherwise fallback to simple prediction */
-            if (proxy->use_rust_predictor && proxy->rust_predictor) {
-                /* Convert timestamp to seconds for Rust */
-                double timestamp_sec = now_us / 1000000.0;
-                
-                int ret = rust_input_predictor_predict_pointer(
-                    proxy->rust_predictor,
-                    timestamp_sec,
-                    event->pointer_motion.dx,
-                    event->pointer_motion.dy,
-                    &predicted_dx,
-                    &predicted_dy
-                );
-                
-                if (ret < 0) {
-                    /* Fallback to simple prediction if Rust predictor fails */
-                    predicted_dx = event->pointer_motion.dx * 1.1;
-                    predicted_dy = event->pointer_motion.dy * 1.1;
-                }
-            } else {
-                /* Simple extrapolation: assume constant velocity */
-                predicted_dx = event->pointer_motion.dx * 1.1;
-                predicted_dy = event->pointer_motion.dy * 1.1;
+    if (proxy->enable_scroll_prediction) {
+        if (event->scroll.discrete || (event->scroll.dx == 0.0 && event->scroll.dy == 0.0)) {
+            /* Wheel click or end of a touchpad scroll: nothing left to extrapolate */
+            if (proxy->scroll_last_us != 0) {
+                input_proxy_scroll_stopped(proxy, event, event_time_us(event, now_us));
             }
-            
-            predicted->pointer_motion.dx = predicted_dx;
-            predicted->pointer_motion.dy = predicted_dy;
-            
-            /* Assign frame ID for tracking */
-            uint64_t frame_id = proxy->next_frame_id++;
-            
-            /* Track prediction for reconciliation */
-            struct pending_prediction *pending = malloc(sizeof(struct pending_prediction));
-            if (pending) {
-                pending->frame_id = frame_id;
-                /*
-                 * Ownership rule:
-                 * - If caller requested predicted_out, the caller owns that returned event and may free it.
-                 *   We therefore store an internal copy for reconciliation.
-                 * - If caller did not request predicted_out, the proxy owns the predicted event and stores it directly.
-                 */
-                if (predicted_out) {
-                    pending->predicted_event = malloc(sizeof(struct input_event));
-                    if (pending->predicted_event) {
-                        *pending->predicted_event = *predicted;
-                    }
-                } else {
-                    pending->predicted_event = predicted;
-                    predicted = NULL; /* transferred to pending list */
-                }
-                pending->timestamp_us = now_us;
-                pending->next = proxy->pending_predictions;
-                proxy->pending_predictions = pending;
-                proxy->pending_count++;
-            } else {
-                /* If nobody will receive this predicted event, avoid leaking it. */
-                if (!predicted_out) {
-                    free(predicted);
-                    predicted = NULL;
-                }
+            if (proxy->scroll_lead.dx != 0.0 || proxy->scroll_lead.dy != 0.0) {
+                result.scroll.dx -= proxy->scroll_lead.dx;
+                result.scroll.dy -= proxy->scroll_lead.dy;
+                proxy->scroll_lead.dx = 0.0;
+                proxy->scroll_lead.dy = 0.0;
+                produced = true;
             }
+            proxy->scroll_last_us = 0;
+        } else {
+            double lead_dx, lead_dy;
+            bool adaptive = input_proxy_predict_scroll_lead(proxy, event, now_us,
+                                                            &lead_dx, &lead_dy);
+            uint64_t horizon_us = input_proxy_horizon_us(proxy, now_us);
+            double scale = input_proxy_horizon_scale(proxy, horizon_us);
+            lead_dx *= scale;
+            lead_dy *= scale;
+            proxy->prediction_state.horizon_us = horizon_us;
             
-            if (predicted_out) {
-                *predicted_out = predicted;
-            }
+            result.timestamp_us = now_us + horizon_us;
+            result.scroll.dx += lead_dx - proxy->scroll_lead.dx;
+            result.scroll.dy += lead_dy - proxy->scroll_lead.dy;
+            proxy->scroll_lead.dx = lead_dx;
+            proxy->scroll_lead.dy = lead_dy;
             
-            proxy->prediction_state.events_predicted++;
-            proxy->prediction_state.last_prediction_us = now_us;
+            input_proxy_track(proxy, &result, adaptive, true, lead_dx, lead_dy, now_us);
+            proxy->scroll_lead.frame_id = proxy->next_frame_id - 1;
+            proxy->prediction_state.scroll_predicted++;
+            produced = true;
+        }
+    }
+    
+    if (produced && out) {
+        *out = result;
+    }
+    return produced ? 1 : 0;
+}
+
+int input_proxy_process_into(struct input_proxy *proxy,
+                            const struct input_event *event,
+                            struct input_event *out) {
+    if (!proxy || !event) {
+        return -1;
+    }
+    
+    /* The event carries its own time; only untimed events read the clock */
+    uint64_t now_us = event->timestamp_us ? event->timestamp_us : utils_clock_now_us(proxy->clock);
+    
+    /* Handle scroll smoothing and prediction */
+    if (event->type == INPUT_EVENT_SCROLL) {
+        return input_proxy_process_scroll(proxy, event, now_us, out);
+    }
+    
+    /* Any other deliberate input stops a fling */
+    if (event->type != INPUT_EVENT_POINTER_MOTION) {
+        scroll_smoother_cancel(proxy->scroll_smoother);
+    }
+    
+    /* Handle prediction for pointer motion */
+    if (event->type == INPUT_EVENT_POINTER_MOTION && proxy->enable_prediction) {
+        return input_proxy_predict_burst(proxy, event, 1, event, now_us, out);
+    }
+    
+    return 0;
+}
+
+int input_proxy_process_burst(struct input_proxy *proxy,
+                              const struct input_event *events,
+                              size_t count,
+                              struct input_event *out) {
+    if (!proxy || !events || count == 0) {
+        return -1;
+    }
+    
+    /* One burst = consecutive pointer motion in a single mode, merged */
+    struct input_event coalesced = events[0];
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].type != INPUT_EVENT_POINTER_MOTION ||
+            events[i].pointer_motion.absolute != events[0].pointer_motion.absolute) {
+            return -1;
+        }
+        if (i > 0) {
+            coalesced.timestamp_us = events[i].timestamp_us;
+            coalesced.pointer_motion.dx += events[i].pointer_motion.dx;
+            coalesced.pointer_motion.dy += events[i].pointer_motion.dy;
+            coalesced.pointer_motion.x = events[i].pointer_motion.x;
+            coalesced.pointer_motion.y = events[i].pointer_motion.y;
+        }
+    }
+    
+    if (!proxy->enable_prediction) {
+        return 0;
+    }
+    
+    uint64_t now_us = coalesced.timestamp_us ? coalesced.timestamp_us : utils_clock_now_us(proxy->clock);
+    
+    return input_proxy_predict_burst(proxy, events, count, &coalesced, now_us, out);
+}
+
+int input_proxy_process(struct input_proxy *proxy,
+                       const struct input_event *event,
+                       struct input_event **predicted_out) {
+    if (predicted_out) {
+        *predicted_out = NULL;
+    }
+    
+    struct input_event processed;
+    int ret = input_proxy_process_into(proxy, event, &processed);
+    if (ret < 0) {
+        return ret;
+    }
+    
+    if (ret > 0 && predicted_out) {
+        *predicted_out = malloc(sizeof(struct input_event));
+        if (*predicted_out) {
+            **predicted_out = processed;
         }
     }
     
     return 0;
 }
 
+/* Predicted minus actual delta, for event types that carry one */
+static bool prediction_error(const struct input_event *predicted,
+                             const struct input_event *actual,
+                             double *dx_error, double *dy_error) {
+    if (predicted->type != actual->type) {
+        return false;
+    }
+    
+    switch (predicted->type) {
+        case INPUT_EVENT_POINTER_MOTION:
+            *dx_error = predicted->pointer_motion.dx - actual->pointer_motion.dx;
+            *dy_error = predicted->pointer_motion.dy - actual->pointer_motion.dy;
+            return true;
+        case INPUT_EVENT_SCROLL:
+            *dx_error = predicted->scroll.dx - actual->scroll.dx;
+            *dy_error = predicted->scroll.dy - actual->scroll.dy;
+            return true;
+        default:
+            return false;
+    }
+}
+
 int input_proxy_reconcile(struct input_proxy *proxy,
                          uint64_t frame_id,
                          const struct input_event *actual_event) {
@@ -251,101 +856,134 @@ int input_proxy_reconcile(struct input_proxy *proxy,
         return -1;
     }
     
+    uint64_t now_us = utils_clock_now_us(proxy->clock);
+    
     /* Find pending prediction for this frame */
-    struct pending_prediction **pred_ptr = &proxy->pending_predictions;
     struct pending_prediction *found = NULL;
-    
-    while (*pred_ptr) {
-        if ((*pred_ptr)->frame_id == frame_id) {
-            found = *pred_ptr;
-            *pred_ptr = (*pred_ptr)->next;  /* Remove from list */
-            break;
+    if (frame_id != 0 && frame_id < proxy->next_frame_id) {
+        struct pending_prediction *slot = &proxy->pending[frame_id & INPUT_PROXY_PENDING_MASK];
+        if (slot->frame_id == frame_id && slot->live &&
+            input_proxy_is_fresh(slot->timestamp_us, now_us)) {
+            found = slot;
+        } else if (slot->frame_id != frame_id || slot->live) {
+            /* Slot reused for a newer frame, or the prediction expired */
+            proxy->prediction_state.late_acks++;
+            if (slot->frame_id == frame_id) {
+                slot->live = false;
+            }
         }
-        pred_ptr = &(*pred_ptr)->next;
     }
     
     if (found) {
         /* Compare predicted vs actual */
         bool prediction_correct = false;
+        const struct input_event *predicted = &found->predicted_event;
+        double dx_error, dy_error;
         
         if (actual_event == NULL) {
-            /* No actual event provided - assume prediction was correct */
+            /* Scored against the input that follows instead (input_proxy_observe()) */
             prediction_correct = true;
-        } else if (found->predicted_event) {
-            /* Compare predicted and actual events */
-            if (found->predicted_event->type == actual_event->type) {
-                if (found->predicted_event->type == INPUT_EVENT_POINTER_MOTION) {
-                    /* Check if deltas are close (within tolerance) */
-                    double dx_diff = found->predicted_event->pointer_motion.dx - 
-                                   actual_event->pointer_motion.dx;
-                    double dy_diff = found->predicted_event->pointer_motion.dy - 
-                                   actual_event->pointer_motion.dy;
-                    double tolerance = 0.1;  /* 10% tolerance */
-                    
-                    if (fabs(dx_diff) < tolerance && fabs(dy_diff) < tolerance) {
-                        prediction_correct = true;
-                    }
-                } else {
-                    /* For other event types, exact match */
-                    prediction_correct = true;
-                }
-            }
+        } else if (prediction_error(predicted, actual_event, &dx_error, &dy_error)) {
+            /* Check if deltas are close (within tolerance) */
+            double tolerance = 0.1;  /* 10% tolerance */
+            prediction_correct = fabs(dx_error) < tolerance && fabs(dy_error) < tolerance;
+            input_proxy_score(proxy, found, dx_error, dy_error);
+            found->observing = false;
+        } else {
+            /* For other event types, exact match */
+            prediction_correct = predicted->type == actual_event->type;
         }
         
-        if (!prediction_correct && actual_event && found->predicted_event) {
-            /* Apply correction: calculate delta and update metrics */
-            if (found->predicted_event->type == INPUT_EVENT_POINTER_MOTION &&
-                actual_event->type == INPUT_EVENT_POINTER_MOTION) {
-                double dx_error = found->predicted_event->pointer_motion.dx -
-                                actual_event->pointer_motion.dx;
-                double dy_error = found->predicted_event->pointer_motion.dy -
-                                actual_event->pointer_motion.dy;
-                
-                /* Correction delta would be applied to local cursor position */
-                /* In production, this would trigger a correction event to the compositor */
-                /* For now, we just track the error for prediction model updates */
-                
-                /* Update prediction accuracy metrics */
-                /* Larger errors indicate prediction model needs adjustment */
-                (void)dx_error;  /* Used for future model updates */
-                (void)dy_error;  /* Used for future model updates */
-            }
+        if (!prediction_correct) {
+            bool scroll = actual_event && actual_event->type == INPUT_EVENT_SCROLL;
+            input_proxy_mispredicted(proxy, found,
+                                     scroll ? actual_event->scroll.dx : 0.0,
+                                     scroll ? actual_event->scroll.dy : 0.0);
         }
         
-        /* Free prediction entry */
-        if (found->predicted_event) {
-            free(found->predicted_event);
-        }
-        free(found);
-        proxy->pending_count--;
+        found->live = false;
     }
     
+    /* After an explicit actual event, so that frame is not scored twice */
+    input_proxy_observe_idle(proxy, now_us);
+    
     proxy->prediction_state.events_reconciled++;
     
-    /* Clean up stale predictions (older than 1 second) */
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t now_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
-    uint64_t stale_threshold_us = 1000000ULL;  /* 1 second */
-    
-    pred_ptr = &proxy->pending_predictions;
-    while (*pred_ptr) {
-        if (now_us - (*pred_ptr)->timestamp_us > stale_threshold_us) {
-            struct pending_prediction *stale = *pred_ptr;
-            *pred_ptr = (*pred_ptr)->next;
-            if (stale->predicted_event) {
-                free(stale->predicted_event);
-            }
-            free(stale);
-            proxy->pending_count--;
-        } else {
-            pred_ptr = &(*pred_ptr)->next;
-        }
+    return 0;
+}
+
+int input_proxy_set_kinetic_scroll(struct input_proxy *proxy,
+                                   const struct scroll_kinetic_config *config) {
+    if (!proxy || !proxy->scroll_smoother) {
+        return -1;
+    }
+    
+    return scroll_smoother_set_kinetic(proxy->scroll_smoother, config);
+}
+
+int input_proxy_cancel_kinetic_scroll(struct input_proxy *proxy) {
+    if (!proxy) {
+        return -1;
     }
     
+    scroll_smoother_cancel(proxy->scroll_smoother);
     return 0;
 }
 
+int input_proxy_frame(struct input_proxy *proxy, uint64_t frame_time_us, struct input_event *out) {
+    if (!proxy || !out) {
+        return -1;
+    }
+    
+    /* Predictions aimed well before this frame with no input since are scored as stopped */
+    input_proxy_observe_idle(proxy, frame_time_us);
+    
+    double dx, dy;
+    if (!proxy->scroll_smoother ||
+        scroll_smoother_frame(proxy->scroll_smoother, frame_time_us, &dx, &dy) <= 0) {
+        return 0;
+    }
+    
+    *out = (struct input_event){
+        .type = INPUT_EVENT_SCROLL,
+        .timestamp_us = frame_time_us,
+        .scroll = {
+            .dx = dx,
+            .dy = dy,
+        },
+    };
+    return 1;
+}
+
+int input_proxy_take_correction(struct input_proxy *proxy, struct input_event *out) {
+    if (!proxy || !out) {
+        return -1;
+    }
+    
+    struct shown_lead *shown = proxy->scroll_lead.correction_pending ? &proxy->scroll_lead :
+                               proxy->motion_lead.correction_pending ? &proxy->motion_lead : NULL;
+    if (!shown) {
+        return 0;
+    }
+    
+    *out = (struct input_event){
+        .timestamp_us = utils_clock_now_us(proxy->clock),
+    };
+    if (shown == &proxy->scroll_lead) {
+        out->type = INPUT_EVENT_SCROLL;
+        out->scroll.dx = shown->correction_dx;
+        out->scroll.dy = shown->correction_dy;
+    } else {
+        out->type = INPUT_EVENT_POINTER_MOTION;
+        out->pointer_motion.dx = shown->correction_dx;
+        out->pointer_motion.dy = shown->correction_dy;
+    }
+    shown->correction_pending = false;
+    shown->correction_dx = 0.0;
+    shown->correction_dy = 0.0;
+    return 1;
+}
+
 int input_proxy_get_prediction_state(const struct input_proxy *proxy,
                                     prediction_state_t *state_out) {
     if (!proxy || !state_out) {
@@ -353,6 +991,15 @@ int input_proxy_get_prediction_state(const struct input_proxy *proxy,
     }
     
     *state_out = proxy->prediction_state;
+    
+    /* Error statistics are the proxy's own; the filter state is the adaptive model's */
+    if (proxy->motion_predictor) {
+        struct motion_predictor_stats stats;
+        motion_predictor_get_stats(proxy->motion_predictor, &stats);
+        state_out->filter_alpha = stats.alpha;
+        state_out->filter_beta = stats.beta;
+        state_out->effective_window_ms = stats.effective_window_ms;
+    }
     return 0;
 }
 
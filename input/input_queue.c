@@ -0,0 +1,519 @@
+#include "input_queue.h"
+#include "input_resampler.h"
+#include "../core/spsc_ring.h"
+#include "../core/metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * Input event queue implementation
+ *
+ * Ring entries carry an input event, a frame acknowledgment, a frame
+ * tick or a fling cancel, so reconciliation and kinetic scrolling stay
+ * ordered with the events they refer to.
+ *
+ * Runs of relative or absolute pointer motion are drained as one burst:
+ * the predictor sees every sample (one batched call), while the sink gets
+ * a single coalesced event.
+ *
+ * With a resampler attached, relative motion and continuous scroll are
+ * buffered instead and reach the proxy once per frame tick; any other
+ * event flushes the resampler first so ordering is preserved.
+ *
+ * The consumer thread sleeps on a condition variable only after
+ * announcing it through `sleeping`; producers check the flag after each
+ * push (with a full fence on both sides), so the common case costs the
+ * producer no syscall.
+ */
+
+#define INPUT_QUEUE_BURST_MAX 64
+
+typedef enum {
+    INPUT_QUEUE_ENTRY_EVENT,
+    INPUT_QUEUE_ENTRY_RECONCILE,
+    INPUT_QUEUE_ENTRY_FRAME,
+    INPUT_QUEUE_ENTRY_CANCEL    /* Stop kinetic scrolling */
+} input_queue_entry_kind_t;
+
+struct input_queue_entry {
+    input_queue_entry_kind_t kind;
+    uint64_t frame;     /* Frame ID (RECONCILE) or frame time in us (FRAME) */
+    uint64_t refresh_us;    /* FRAME: refresh period if frame is a presented vblank */
+    struct input_event event;
+};
+
+struct input_queue {
+    struct spsc_ring ring;
+    struct input_proxy *proxy;
+    input_queue_sink_fn sink;
+    void *sink_data;
+    struct input_resampler *resampler;
+
+    /* Producer side */
+    _Alignas(SPSC_RING_CACHELINE) struct input_event carry;
+    bool has_carry;
+    atomic_uint_least64_t enqueued;
+    atomic_uint_least64_t dropped;
+    atomic_uint_least64_t carried;
+
+    /* Consumer side */
+    _Alignas(SPSC_RING_CACHELINE) atomic_uint_least64_t coalesced;
+    atomic_uint_least64_t processed;
+
+    /* Consumer thread */
+    _Alignas(SPSC_RING_CACHELINE) atomic_bool sleeping;
+    atomic_bool running;
+    bool wakeup;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+    struct metrics_collector *collector;    /* Starting thread's binding (referenced) */
+};
+
+static inline void stat_add(atomic_uint_least64_t *stat, uint64_t n) {
+    atomic_fetch_add_explicit(stat, n, memory_order_relaxed);
+}
+
+static inline uint64_t stat_load(const atomic_uint_least64_t *stat) {
+    return atomic_load_explicit((atomic_uint_least64_t *)stat, memory_order_relaxed);
+}
+
+static bool input_event_is_scroll_stop(const struct input_event *event) {
+    return !event->scroll.discrete && event->scroll.dx == 0.0 && event->scroll.dy == 0.0;
+}
+
+bool input_event_coalesce(struct input_event *dst, const struct input_event *src) {
+    if (!dst || !src || dst->type != src->type) {
+        return false;
+    }
+
+    switch (dst->type) {
+        case INPUT_EVENT_POINTER_MOTION:
+            if (dst->pointer_motion.absolute != src->pointer_motion.absolute) {
+                return false;
+            }
+            dst->pointer_motion.dx += src->pointer_motion.dx;
+            dst->pointer_motion.dy += src->pointer_motion.dy;
+            dst->pointer_motion.x = src->pointer_motion.x;
+            dst->pointer_motion.y = src->pointer_motion.y;
+            break;
+
+        case INPUT_EVENT_SCROLL:
+            /* A zero-delta scroll marks the end of a gesture and must survive */
+            if (dst->scroll.discrete != src->scroll.discrete ||
+                input_event_is_scroll_stop(dst) || input_event_is_scroll_stop(src)) {
+                return false;
+            }
+            dst->scroll.dx += src->scroll.dx;
+            dst->scroll.dy += src->scroll.dy;
+            dst->scroll.discrete_dx += src->scroll.discrete_dx;
+            dst->scroll.discrete_dy += src->scroll.discrete_dy;
+            break;
+
+        default:
+            return false;
+    }
+
+    dst->timestamp_us = src->timestamp_us;
+    return true;
+}
+
+static bool input_event_carriable(const struct input_event *event) {
+    return event->type == INPUT_EVENT_POINTER_MOTION || event->type == INPUT_EVENT_SCROLL;
+}
+
+int input_queue_create(struct input_proxy *proxy,
+                       size_t capacity,
+                       input_queue_sink_fn sink,
+                       void *user_data,
+                       struct input_queue **queue_out) {
+    if (!proxy || !queue_out) {
+        return -1;
+    }
+
+    /* Producer and consumer fields are cache-line aligned */
+    struct input_queue *queue = NULL;
+    if (posix_memalign((void **)&queue, SPSC_RING_CACHELINE, sizeof(*queue)) != 0) {
+        return -1;
+    }
+    memset(queue, 0, sizeof(*queue));
+
+    if (spsc_ring_init(&queue->ring,
+                       capacity ? capacity : INPUT_QUEUE_DEFAULT_CAPACITY,
+                       sizeof(struct input_queue_entry)) < 0) {
+        free(queue);
+        return -1;
+    }
+
+    queue->proxy = proxy;
+    queue->sink = sink;
+    queue->sink_data = user_data;
+    queue->has_carry = false;
+    atomic_init(&queue->enqueued, 0);
+    atomic_init(&queue->dropped, 0);
+    atomic_init(&queue->carried, 0);
+    atomic_init(&queue->coalesced, 0);
+    atomic_init(&queue->processed, 0);
+    atomic_init(&queue->sleeping, false);
+    atomic_init(&queue->running, false);
+    queue->wakeup = false;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+
+    *queue_out = queue;
+    return 0;
+}
+
+static void input_queue_wake(struct input_queue *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->wakeup = true;
+    pthread_cond_signal(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/* Push one entry and wake the consumer if it announced it was sleeping */
+static bool input_queue_push_entry(struct input_queue *queue,
+                                   const struct input_queue_entry *entry) {
+    if (!spsc_ring_push(&queue->ring, entry)) {
+        return false;
+    }
+
+    stat_add(&queue->enqueued, 1);
+
+    /* Pairs with the fence in the consumer before it re-checks the ring */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&queue->sleeping, memory_order_relaxed)) {
+        input_queue_wake(queue);
+    }
+    return true;
+}
+
+static bool input_queue_push_event(struct input_queue *queue, const struct input_event *event) {
+    struct input_queue_entry entry = {
+        .kind = INPUT_QUEUE_ENTRY_EVENT,
+        .frame = 0,
+        .event = *event,
+    };
+    return input_queue_push_entry(queue, &entry);
+}
+
+/* Try to flush the producer-side carry; false if the ring is still full */
+static bool input_queue_flush_carry(struct input_queue *queue) {
+    if (!queue->has_carry) {
+        return true;
+    }
+    if (!input_queue_push_event(queue, &queue->carry)) {
+        return false;
+    }
+    queue->has_carry = false;
+    return true;
+}
+
+int input_queue_push(struct input_queue *queue, const struct input_event *event) {
+    if (!queue || !event) {
+        return -1;
+    }
+
+    /* Fold into a pending carry of the same kind, then try to flush it */
+    if (queue->has_carry && input_event_coalesce(&queue->carry, event)) {
+        stat_add(&queue->carried, 1);
+        input_queue_flush_carry(queue);
+        return 0;
+    }
+
+    /* Preserve ordering: the carry must go out before anything newer */
+    if (input_queue_flush_carry(queue) && input_queue_push_event(queue, event)) {
+        return 0;
+    }
+
+    if (!queue->has_carry && input_event_carriable(event)) {
+        queue->carry = *event;
+        queue->has_carry = true;
+        stat_add(&queue->carried, 1);
+        return 0;
+    }
+
+    stat_add(&queue->dropped, 1);
+    return -1;
+}
+
+/* Queue a non-event entry behind any carried input */
+static int input_queue_push_frame_entry(struct input_queue *queue,
+                                        input_queue_entry_kind_t kind,
+                                        uint64_t frame,
+                                        uint64_t refresh_us) {
+    if (!queue) {
+        return -1;
+    }
+
+    struct input_queue_entry entry = {
+        .kind = kind,
+        .frame = frame,
+        .refresh_us = refresh_us,
+    };
+
+    if (!input_queue_flush_carry(queue) || !input_queue_push_entry(queue, &entry)) {
+        stat_add(&queue->dropped, 1);
+        return -1;
+    }
+    return 0;
+}
+
+int input_queue_push_reconcile(struct input_queue *queue, uint64_t frame_id) {
+    return input_queue_push_frame_entry(queue, INPUT_QUEUE_ENTRY_RECONCILE, frame_id, 0);
+}
+
+int input_queue_push_frame(struct input_queue *queue, uint64_t frame_time_us) {
+    return input_queue_push_frame_entry(queue, INPUT_QUEUE_ENTRY_FRAME, frame_time_us, 0);
+}
+
+int input_queue_push_vblank(struct input_queue *queue, uint64_t vblank_us, uint64_t refresh_us) {
+    return input_queue_push_frame_entry(queue, INPUT_QUEUE_ENTRY_FRAME, vblank_us, refresh_us);
+}
+
+int input_queue_push_cancel(struct input_queue *queue) {
+    return input_queue_push_frame_entry(queue, INPUT_QUEUE_ENTRY_CANCEL, 0, 0);
+}
+
+int input_queue_set_resampler(struct input_queue *queue, struct input_resampler *resampler) {
+    if (!queue || queue->thread_started) {
+        return -1;
+    }
+
+    queue->resampler = resampler;
+    return 0;
+}
+
+/* A mispredicted lead leaves a rollback to forward (scroll and motion each) */
+static void input_queue_forward_correction(struct input_queue *queue) {
+    struct input_event correction;
+    while (input_proxy_take_correction(queue->proxy, &correction) > 0) {
+        if (queue->sink) {
+            queue->sink(queue->sink_data, &correction, &correction);
+        }
+    }
+}
+
+/* Run an event through the proxy and hand the result to the sink */
+static void input_queue_forward(struct input_queue *queue, const struct input_event *event) {
+    struct input_event processed;
+    int ret = input_proxy_process_into(queue->proxy, event, &processed);
+    if (ret >= 0 && queue->sink) {
+        queue->sink(queue->sink_data, event, ret > 0 ? &processed : NULL);
+    }
+    input_queue_forward_correction(queue);
+}
+
+static void input_queue_flush_resampler(struct input_queue *queue) {
+    struct input_event samples[INPUT_RESAMPLER_MAX_OUTPUT];
+    int n = input_resampler_flush(queue->resampler, samples);
+    for (int i = 0; i < n; i++) {
+        input_queue_forward(queue, &samples[i]);
+    }
+}
+
+static void input_queue_handle(struct input_queue *queue, const struct input_queue_entry *entry) {
+    if (entry->kind == INPUT_QUEUE_ENTRY_RECONCILE) {
+        input_proxy_reconcile(queue->proxy, entry->frame, NULL);
+        input_queue_forward_correction(queue);
+        return;
+    }
+    
+    if (entry->kind == INPUT_QUEUE_ENTRY_CANCEL) {
+        input_proxy_cancel_kinetic_scroll(queue->proxy);
+        return;
+    }
+    
+    if (entry->kind == INPUT_QUEUE_ENTRY_FRAME) {
+        if (entry->refresh_us) {
+            input_proxy_set_display_timing(queue->proxy, entry->frame, entry->refresh_us);
+        }
+        
+        /* Resampled input, then kinetic scroll, advance once per display frame */
+        if (queue->resampler) {
+            struct input_event samples[INPUT_RESAMPLER_MAX_OUTPUT];
+            int n = input_resampler_frame(queue->resampler, entry->frame, samples);
+            for (int i = 0; i < n; i++) {
+                input_queue_forward(queue, &samples[i]);
+            }
+        }
+        
+        struct input_event fling;
+        if (input_proxy_frame(queue->proxy, entry->frame, &fling) > 0 && queue->sink) {
+            queue->sink(queue->sink_data, &fling, &fling);
+        }
+        input_queue_forward_correction(queue);
+        return;
+    }
+
+    input_queue_forward(queue, &entry->event);
+}
+
+static bool input_queue_motion_continues(const struct input_event *first,
+                                         const struct input_queue_entry *next) {
+    return next->kind == INPUT_QUEUE_ENTRY_EVENT &&
+           next->event.type == INPUT_EVENT_POINTER_MOTION &&
+           next->event.pointer_motion.absolute == first->pointer_motion.absolute;
+}
+
+/* Drain a run of motion events starting with first as one predictor burst */
+static void input_queue_handle_motion(struct input_queue *queue, const struct input_event *first) {
+    struct input_event burst[INPUT_QUEUE_BURST_MAX];
+    struct input_event coalesced = *first;
+    size_t count = 1;
+    burst[0] = *first;
+
+    const struct input_queue_entry *next;
+    while (count < INPUT_QUEUE_BURST_MAX &&
+           (next = spsc_ring_peek(&queue->ring)) != NULL &&
+           input_queue_motion_continues(first, next)) {
+        burst[count++] = next->event;
+        input_event_coalesce(&coalesced, &next->event);
+        spsc_ring_pop(&queue->ring, NULL);
+        stat_add(&queue->coalesced, 1);
+    }
+
+    struct input_event processed;
+    int ret = input_proxy_process_burst(queue->proxy, burst, count, &processed);
+    if (ret >= 0 && queue->sink) {
+        queue->sink(queue->sink_data, &coalesced, ret > 0 ? &processed : NULL);
+    }
+}
+
+size_t input_queue_drain(struct input_queue *queue, size_t max) {
+    if (!queue) {
+        return 0;
+    }
+
+    size_t n = 0;
+    struct input_queue_entry entry;
+
+    while ((max == 0 || n < max) && spsc_ring_pop(&queue->ring, &entry)) {
+        if (queue->resampler && entry.kind == INPUT_QUEUE_ENTRY_EVENT) {
+            /* Buffered until the next frame tick, or forwarded after what is buffered */
+            if (input_resampler_push(queue->resampler, &entry.event) == 1) {
+                stat_add(&queue->processed, 1);
+                n++;
+                continue;
+            }
+            input_queue_flush_resampler(queue);
+        }
+
+        if (entry.kind == INPUT_QUEUE_ENTRY_EVENT &&
+            entry.event.type == INPUT_EVENT_POINTER_MOTION) {
+            input_queue_handle_motion(queue, &entry.event);
+        } else {
+            /* Behind: merge the backlog of consecutive scroll events */
+            if (entry.kind == INPUT_QUEUE_ENTRY_EVENT) {
+                const struct input_queue_entry *next;
+                while ((next = spsc_ring_peek(&queue->ring)) != NULL &&
+                       next->kind == INPUT_QUEUE_ENTRY_EVENT &&
+                       input_event_coalesce(&entry.event, &next->event)) {
+                    spsc_ring_pop(&queue->ring, NULL);
+                    stat_add(&queue->coalesced, 1);
+                }
+            }
+            input_queue_handle(queue, &entry);
+        }
+
+        stat_add(&queue->processed, 1);
+        n++;
+    }
+
+    return n;
+}
+
+static void *input_queue_thread(void *arg) {
+    struct input_queue *queue = arg;
+
+    /* Record metrics where the thread that started the queue does */
+    metrics_bind(queue->collector);
+
+    while (atomic_load_explicit(&queue->running, memory_order_acquire)) {
+        if (input_queue_drain(queue, 0) > 0) {
+            continue;
+        }
+
+        /* Announce, then re-check so a concurrent push cannot be missed */
+        atomic_store_explicit(&queue->sleeping, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (spsc_ring_size(&queue->ring) == 0) {
+            pthread_mutex_lock(&queue->lock);
+            while (!queue->wakeup && atomic_load_explicit(&queue->running, memory_order_acquire)) {
+                pthread_cond_wait(&queue->cond, &queue->lock);
+            }
+            queue->wakeup = false;
+            pthread_mutex_unlock(&queue->lock);
+        }
+
+        atomic_store_explicit(&queue->sleeping, false, memory_order_relaxed);
+    }
+
+    metrics_bind(NULL);
+    return NULL;
+}
+
+int input_queue_start(struct input_queue *queue) {
+    if (!queue || queue->thread_started) {
+        return -1;
+    }
+
+    queue->collector = metrics_collector_ref(metrics_bound());
+    atomic_store_explicit(&queue->running, true, memory_order_release);
+    if (pthread_create(&queue->thread, NULL, input_queue_thread, queue) != 0) {
+        atomic_store_explicit(&queue->running, false, memory_order_release);
+        metrics_collector_unref(queue->collector);
+        queue->collector = NULL;
+        return -1;
+    }
+
+    queue->thread_started = true;
+    return 0;
+}
+
+void input_queue_destroy(struct input_queue *queue) {
+    if (!queue) {
+        return;
+    }
+
+    if (queue->thread_started) {
+        atomic_store_explicit(&queue->running, false, memory_order_release);
+        input_queue_wake(queue);
+        pthread_join(queue->thread, NULL);
+        queue->thread_started = false;
+        metrics_collector_unref(queue->collector);
+        queue->collector = NULL;
+    }
+
+    /* Nothing produces any more: deliver what is left, including the carry */
+    input_queue_drain(queue, 0);
+    if (input_queue_flush_carry(queue)) {
+        input_queue_drain(queue, 0);
+    }
+    if (queue->resampler) {
+        input_queue_flush_resampler(queue);
+    }
+
+    spsc_ring_destroy(&queue->ring);
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue);
+}
+
+void input_queue_get_stats(const struct input_queue *queue, struct input_queue_stats *stats_out) {
+    if (!queue || !stats_out) {
+        return;
+    }
+
+    stats_out->enqueued = stat_load(&queue->enqueued);
+    stats_out->dropped = stat_load(&queue->dropped);
+    stats_out->carried = stat_load(&queue->carried);
+    stats_out->coalesced = stat_load(&queue->coalesced);
+    stats_out->processed = stat_load(&queue->processed);
+    stats_out->depth = spsc_ring_size(&queue->ring);
+    stats_out->capacity = queue->ring.capacity;
+}
@@ -0,0 +1,196 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Input event queue
+ *
+ * Decouples compositor input hooks from prediction: the compositor thread
+ * only copies events into a bounded lock-free SPSC ring, and a consumer
+ * (normally the queue's own input thread) runs them through the input
+ * proxy and hands the results to a sink for transport forwarding.
+ *
+ * Backpressure is handled without blocking the producer:
+ * - when the consumer falls behind, consecutive motion (or scroll)
+ *   events already in the ring are coalesced on pop;
+ * - when the ring is full, motion/scroll deltas are carried on the
+ *   producer side and merged into the next event that fits, so no
+ *   movement is lost; other events are dropped and counted.
+ *
+ * Exactly one thread may produce (push/push_reconcile/push_frame) and
+ * one consume.
+ */
+
+struct input_queue;
+struct input_resampler;
+
+#define INPUT_QUEUE_DEFAULT_CAPACITY 1024
+
+/**
+ * Receives each processed event on the consumer thread
+ *
+ * Scroll the proxy synthesizes itself (rollbacks after reconciliation,
+ * kinetic scroll on frame ticks) is delivered with event == processed.
+ *
+ * @param user_data Sink context
+ * @param event Event as queued (after coalescing)
+ * @param processed Predicted/smoothed event, or NULL if none was produced
+ */
+typedef void (*input_queue_sink_fn)(void *user_data,
+                                    const struct input_event *event,
+                                    const struct input_event *processed);
+
+/**
+ * Queue statistics (approximate while the queue is running)
+ */
+struct input_queue_stats {
+    uint64_t enqueued;      /* Entries accepted by the ring */
+    uint64_t dropped;       /* Events lost because the ring was full */
+    uint64_t carried;       /* Events merged into a producer-side carry */
+    uint64_t coalesced;     /* Events merged on the consumer side */
+    uint64_t processed;     /* Entries handled by the consumer */
+    size_t depth;           /* Entries currently queued */
+    size_t capacity;
+};
+
+/**
+ * Create an input queue
+ *
+ * @param proxy Input proxy used by the consumer (not owned)
+ * @param capacity Ring capacity in events (0 = INPUT_QUEUE_DEFAULT_CAPACITY)
+ * @param sink Optional sink for processed events
+ * @param user_data Sink context
+ * @param queue_out Output queue handle
+ * @return 0 on success, -1 on failure
+ */
+int input_queue_create(struct input_proxy *proxy,
+                       size_t capacity,
+                       input_queue_sink_fn sink,
+                       void *user_data,
+                       struct input_queue **queue_out);
+
+/**
+ * Stop the input thread (if running), process what is still queued and free the queue
+ */
+void input_queue_destroy(struct input_queue *queue);
+
+/**
+ * Start the dedicated input thread
+ *
+ * The thread records metrics into the collector the calling thread is
+ * bound to (metrics_bind()), or like any unbound thread into the process
+ * default collector, if any.
+ *
+ * @return 0 on success, -1 on failure or if already running
+ */
+int input_queue_start(struct input_queue *queue);
+
+/**
+ * Attach a frame-aligned resampler (see input_resampler.h)
+ *
+ * Relative motion and continuous scroll are then forwarded once per
+ * input_queue_push_frame() tick instead of once per device event. Must
+ * be called before input_queue_start().
+ *
+ * @param queue Queue handle
+ * @param resampler Resampler (not owned), or NULL to detach
+ * @return 0 on success, -1 on failure or if the thread is running
+ */
+int input_queue_set_resampler(struct input_queue *queue, struct input_resampler *resampler);
+
+/**
+ * Enqueue an input event (producer only, never blocks or allocates)
+ *
+ * @param queue Queue handle
+ * @param event Event to enqueue
+ * @return 0 if queued or carried, -1 if the event was dropped
+ */
+int input_queue_push(struct input_queue *queue, const struct input_event *event);
+
+/**
+ * Enqueue a frame acknowledgment for input_proxy_reconcile() (producer only)
+ *
+ * Keeps reconciliation ordered with the events and on the consumer thread.
+ *
+ * @param queue Queue handle
+ * @param frame_id Acknowledged frame ID
+ * @return 0 if queued, -1 if dropped
+ */
+int input_queue_push_reconcile(struct input_queue *queue, uint64_t frame_id);
+
+/**
+ * Enqueue a display frame tick for input_proxy_frame() (producer only)
+ *
+ * Drives kinetic scrolling from frame callbacks on the input thread.
+ *
+ * @param queue Queue handle
+ * @param frame_time_us Frame time in microseconds (monotonic)
+ * @return 0 if queued, -1 if dropped
+ */
+int input_queue_push_frame(struct input_queue *queue, uint64_t frame_time_us);
+
+/**
+ * Enqueue a presented vblank (producer only)
+ *
+ * A frame tick that also updates the proxy's display timing
+ * (input_proxy_set_display_timing()) on the input thread.
+ *
+ * @param queue Queue handle
+ * @param vblank_us Presentation time in microseconds (monotonic)
+ * @param refresh_us Refresh period in microseconds (0 = unknown, plain frame tick)
+ * @return 0 if queued, -1 if dropped
+ */
+int input_queue_push_vblank(struct input_queue *queue, uint64_t vblank_us, uint64_t refresh_us);
+
+/**
+ * Enqueue a kinetic scroll cancel for input_proxy_cancel_kinetic_scroll() (producer only)
+ *
+ * Stops a fling on the input thread, in order with the queued events.
+ *
+ * @param queue Queue handle
+ * @return 0 if queued, -1 if dropped
+ */
+int input_queue_push_cancel(struct input_queue *queue);
+
+/**
+ * Process queued entries on the calling thread (consumer only)
+ *
+ * For callers that drive the consumer from their own loop instead of
+ * input_queue_start().
+ *
+ * @param queue Queue handle
+ * @param max Maximum entries to process (0 = until empty)
+ * @return Number of entries processed
+ */
+size_t input_queue_drain(struct input_queue *queue, size_t max);
+
+/**
+ * Get queue statistics
+ */
+void input_queue_get_stats(const struct input_queue *queue, struct input_queue_stats *stats_out);
+
+/**
+ * Merge src into dst if both are coalescible events of the same kind
+ *
+ * Pointer motion (same absolute mode) and scroll (same discrete mode)
+ * deltas are summed; absolute positions and the timestamp take src's
+ * values. A zero-delta continuous scroll (end of a touchpad gesture) is
+ * never merged.
+ *
+ * @return true if src was merged into dst
+ */
+bool input_event_coalesce(struct input_event *dst, const struct input_event *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUT_QUEUE_H */
@@ -0,0 +1,316 @@
+#include "input_resampler.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Frame-aligned input resampler implementation
+ *
+ * Each stream (motion, scroll) keeps a short history of accumulated
+ * position against event time. A frame at time T samples the streams at
+ * T - RESAMPLER_LATENCY_US, which usually falls between two device
+ * events and is interpolated; when the device is slower than the display
+ * the position is extrapolated from the last two events, by at most
+ * half a frame. Output is the difference from what was already emitted,
+ * so extrapolation overshoot is taken back on the next frame and the
+ * emitted total always converges on the input total.
+ *
+ * Events closer than RESAMPLER_MIN_SPACING_US replace the newest point
+ * instead of adding one, which bounds the history at kHz rates.
+ */
+
+#define RESAMPLER_HISTORY 64
+#define RESAMPLER_LATENCY_US 5000           /* Sample this far behind the frame */
+#define RESAMPLER_MAX_PREDICTION_US 8000    /* Longest extrapolation */
+#define RESAMPLER_MIN_SPACING_US 1000
+#define RESAMPLER_MIN_DELTA_US 2000         /* Extrapolate only from well-spaced events */
+#define RESAMPLER_MAX_DELTA_US 20000
+#define RESAMPLER_MIN_FRAME_US 2000         /* Closer ticks belong to the same vsync */
+#define RESAMPLER_MAX_FRAME_US 100000       /* Longer gaps are idle time, not an interval */
+#define RESAMPLER_DEFAULT_FRAME_US (1000000.0 / 60.0)
+#define RESAMPLER_INTERVAL_DECAY 0.1        /* EWMA weight of a measured interval */
+
+struct resample_point {
+    uint64_t timestamp_us;
+    double x;
+    double y;
+};
+
+struct resample_stream {
+    struct resample_point points[RESAMPLER_HISTORY];
+    size_t head;
+    size_t count;
+    bool overflowed;            /* Oldest points were dropped */
+    double total_x, total_y;    /* Accumulated input */
+    double emitted_x, emitted_y;
+};
+
+struct input_resampler {
+    bool measure;
+    bool measured;
+    uint64_t last_frame_us;
+    struct resample_stream motion;
+    struct resample_stream scroll;
+    struct input_resampler_stats stats;
+};
+
+static inline struct resample_point *stream_point(struct resample_stream *stream, size_t i) {
+    return &stream->points[(stream->head + i) % RESAMPLER_HISTORY];
+}
+
+static void stream_reset(struct resample_stream *stream) {
+    memset(stream, 0, sizeof(*stream));
+}
+
+static void stream_push(struct resample_stream *stream, uint64_t timestamp_us, double dx, double dy) {
+    stream->total_x += dx;
+    stream->total_y += dy;
+
+    if (stream->count > 0) {
+        struct resample_point *last = stream_point(stream, stream->count - 1);
+        if (timestamp_us < last->timestamp_us) {
+            timestamp_us = last->timestamp_us;  /* Out-of-order timestamp */
+        }
+
+        /* Keep points apart: a close event moves the newest point forward */
+        uint64_t previous_us = stream->count > 1 ?
+                               stream_point(stream, stream->count - 2)->timestamp_us : 0;
+        if (timestamp_us == last->timestamp_us ||
+            (stream->count > 1 && timestamp_us - previous_us <= RESAMPLER_MIN_SPACING_US)) {
+            *last = (struct resample_point){timestamp_us, stream->total_x, stream->total_y};
+            return;
+        }
+    }
+
+    if (stream->count == RESAMPLER_HISTORY) {
+        stream->head = (stream->head + 1) % RESAMPLER_HISTORY;
+        stream->count--;
+        stream->overflowed = true;
+    }
+    *stream_point(stream, stream->count++) =
+        (struct resample_point){timestamp_us, stream->total_x, stream->total_y};
+}
+
+/*
+ * Position of a stream at sample_us. Returns true when the stream has
+ * gone quiet and the position is its exact total.
+ */
+static bool stream_position(struct resample_stream *stream, uint64_t sample_us,
+                            double max_prediction_us, double *x, double *y) {
+    const struct resample_point *last = stream_point(stream, stream->count - 1);
+
+    if (sample_us >= last->timestamp_us) {
+        double ahead_us = (double)(sample_us - last->timestamp_us);
+        *x = last->x;
+        *y = last->y;
+        if (ahead_us > max_prediction_us) {
+            return true;
+        }
+        if (stream->count > 1) {
+            const struct resample_point *prev = stream_point(stream, stream->count - 2);
+            uint64_t delta_us = last->timestamp_us - prev->timestamp_us;
+            if (delta_us >= RESAMPLER_MIN_DELTA_US && delta_us <= RESAMPLER_MAX_DELTA_US) {
+                double alpha = ahead_us / (double)delta_us;
+                *x += (last->x - prev->x) * alpha;
+                *y += (last->y - prev->y) * alpha;
+            }
+        }
+        return false;
+    }
+
+    const struct resample_point *first = stream_point(stream, 0);
+    if (sample_us < first->timestamp_us) {
+        /* Nothing known before the first point (unless history was dropped) */
+        *x = stream->overflowed ? first->x : stream->emitted_x;
+        *y = stream->overflowed ? first->y : stream->emitted_y;
+        return false;
+    }
+
+    /* Interpolate between the points around the sample time */
+    size_t i = stream->count - 1;
+    while (i > 0 && stream_point(stream, i - 1)->timestamp_us > sample_us) {
+        i--;
+    }
+    const struct resample_point *a = stream_point(stream, i - 1);
+    const struct resample_point *b = stream_point(stream, i);
+    double alpha = (double)(sample_us - a->timestamp_us) /
+                   (double)(b->timestamp_us - a->timestamp_us);
+    *x = a->x + (b->x - a->x) * alpha;
+    *y = a->y + (b->y - a->y) * alpha;
+
+    /* Points before a are no longer needed */
+    stream->head = (stream->head + i - 1) % RESAMPLER_HISTORY;
+    stream->count -= i - 1;
+    stream->overflowed = stream->overflowed && i == 1;
+    return false;
+}
+
+/* Emit a stream's movement up to (x, y); returns the number of events written */
+static int stream_emit(struct resample_stream *stream, input_event_type_t type,
+                       uint64_t timestamp_us, double x, double y, bool settled,
+                       struct input_event *out) {
+    double dx = x - stream->emitted_x;
+    double dy = y - stream->emitted_y;
+    stream->emitted_x = x;
+    stream->emitted_y = y;
+    if (settled) {
+        stream_reset(stream);
+    }
+
+    if (dx == 0.0 && dy == 0.0) {
+        return 0;
+    }
+
+    *out = (struct input_event){.type = type, .timestamp_us = timestamp_us};
+    if (type == INPUT_EVENT_POINTER_MOTION) {
+        out->pointer_motion.dx = dx;
+        out->pointer_motion.dy = dy;
+    } else {
+        out->scroll.dx = dx;
+        out->scroll.dy = dy;
+    }
+    return 1;
+}
+
+int input_resampler_create(uint32_t frame_rate, struct input_resampler **resampler_out) {
+    if (!resampler_out) {
+        return -1;
+    }
+
+    struct input_resampler *resampler = calloc(1, sizeof(struct input_resampler));
+    if (!resampler) {
+        return -1;
+    }
+
+    resampler->measure = frame_rate == 0;
+    resampler->stats.frame_interval_us = frame_rate ? 1000000.0 / frame_rate
+                                                    : RESAMPLER_DEFAULT_FRAME_US;
+
+    *resampler_out = resampler;
+    return 0;
+}
+
+void input_resampler_destroy(struct input_resampler *resampler) {
+    free(resampler);
+}
+
+int input_resampler_push(struct input_resampler *resampler, const struct input_event *event) {
+    if (!resampler || !event) {
+        return -1;
+    }
+
+    if (event->timestamp_us == 0) {
+        return 0;
+    }
+
+    switch (event->type) {
+        case INPUT_EVENT_POINTER_MOTION:
+            if (event->pointer_motion.absolute) {
+                return 0;
+            }
+            stream_push(&resampler->motion, event->timestamp_us,
+                        event->pointer_motion.dx, event->pointer_motion.dy);
+            break;
+
+        case INPUT_EVENT_SCROLL:
+            if (event->scroll.discrete || (event->scroll.dx == 0.0 && event->scroll.dy == 0.0)) {
+                return 0;
+            }
+            stream_push(&resampler->scroll, event->timestamp_us,
+                        event->scroll.dx, event->scroll.dy);
+            break;
+
+        default:
+            return 0;
+    }
+
+    resampler->stats.events_in++;
+    return 1;
+}
+
+int input_resampler_frame(struct input_resampler *resampler,
+                          uint64_t frame_time_us,
+                          struct input_event *out) {
+    if (!resampler || !out) {
+        return -1;
+    }
+
+    /* One sample per frame: drop repeated or early ticks */
+    double interval_us = resampler->stats.frame_interval_us;
+    if (resampler->last_frame_us != 0) {
+        if (frame_time_us <= resampler->last_frame_us) {
+            return 0;
+        }
+        uint64_t delta_us = frame_time_us - resampler->last_frame_us;
+        if (resampler->measure) {
+            if (delta_us < RESAMPLER_MIN_FRAME_US) {
+                return 0;
+            }
+            if (delta_us <= RESAMPLER_MAX_FRAME_US) {
+                interval_us = resampler->measured ?
+                              interval_us + RESAMPLER_INTERVAL_DECAY * ((double)delta_us - interval_us) :
+                              (double)delta_us;
+                resampler->measured = true;
+            }
+        } else if ((double)delta_us < interval_us * 0.75) {
+            return 0;
+        }
+    }
+    resampler->last_frame_us = frame_time_us;
+    resampler->stats.frame_interval_us = interval_us;
+    resampler->stats.frames++;
+
+    uint64_t sample_us = frame_time_us > RESAMPLER_LATENCY_US ?
+                         frame_time_us - RESAMPLER_LATENCY_US : 0;
+    double max_prediction_us = interval_us / 2.0 < RESAMPLER_MAX_PREDICTION_US ?
+                               interval_us / 2.0 : RESAMPLER_MAX_PREDICTION_US;
+
+    int n = 0;
+    struct {
+        struct resample_stream *stream;
+        input_event_type_t type;
+    } streams[] = {
+        {&resampler->motion, INPUT_EVENT_POINTER_MOTION},
+        {&resampler->scroll, INPUT_EVENT_SCROLL},
+    };
+    for (size_t i = 0; i < sizeof(streams) / sizeof(streams[0]); i++) {
+        if (streams[i].stream->count == 0) {
+            continue;
+        }
+        double x, y;
+        bool settled = stream_position(streams[i].stream, sample_us, max_prediction_us, &x, &y);
+        n += stream_emit(streams[i].stream, streams[i].type, sample_us, x, y, settled, &out[n]);
+    }
+
+    resampler->stats.samples_out += (uint64_t)n;
+    return n;
+}
+
+int input_resampler_flush(struct input_resampler *resampler, struct input_event *out) {
+    if (!resampler || !out) {
+        return -1;
+    }
+
+    int n = 0;
+    if (resampler->motion.count > 0) {
+        struct resample_stream *s = &resampler->motion;
+        uint64_t last_us = stream_point(s, s->count - 1)->timestamp_us;
+        n += stream_emit(s, INPUT_EVENT_POINTER_MOTION, last_us, s->total_x, s->total_y, true, &out[n]);
+    }
+    if (resampler->scroll.count > 0) {
+        struct resample_stream *s = &resampler->scroll;
+        uint64_t last_us = stream_point(s, s->count - 1)->timestamp_us;
+        n += stream_emit(s, INPUT_EVENT_SCROLL, last_us, s->total_x, s->total_y, true, &out[n]);
+    }
+
+    resampler->stats.samples_out += (uint64_t)n;
+    return n;
+}
+
+void input_resampler_get_stats(const struct input_resampler *resampler,
+                               struct input_resampler_stats *stats_out) {
+    if (!resampler || !stats_out) {
+        return;
+    }
+
+    *stats_out = resampler->stats;
+}
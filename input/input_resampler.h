@@ -0,0 +1,107 @@
+#ifndef INPUT_RESAMPLER_H
+#define INPUT_RESAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Frame-aligned input resampler
+ *
+ * Decouples the device rate (125 Hz to 8 kHz) from the display rate:
+ * relative pointer motion and continuous scroll are buffered with their
+ * event timestamps, and each display frame produces at most one motion
+ * and one scroll sample, interpolated at the frame time minus a small
+ * resampling latency (or briefly extrapolated when the device is slower
+ * than the display). Movement is never lost: once a stream goes quiet,
+ * the next frame settles it on the exact accumulated delta.
+ *
+ * Absolute motion, discrete scroll, the zero-delta scroll that ends a
+ * touchpad gesture, and events without a timestamp are not resampled;
+ * callers flush the resampler before forwarding such events so ordering
+ * is preserved.
+ *
+ * Not thread-safe: use from the thread that processes input.
+ */
+
+struct input_resampler;
+
+/* Largest number of events a frame or flush can produce (motion + scroll) */
+#define INPUT_RESAMPLER_MAX_OUTPUT 2
+
+/**
+ * Resampler statistics
+ */
+struct input_resampler_stats {
+    uint64_t events_in;         /* Events buffered for resampling */
+    uint64_t samples_out;       /* Events produced by frames and flushes */
+    uint64_t frames;            /* Frame ticks accepted */
+    double frame_interval_us;   /* Target or measured frame interval */
+};
+
+/**
+ * Create a resampler
+ *
+ * @param frame_rate Target frame rate in Hz, or 0 to measure the
+ *                   interval from input_resampler_frame() calls (vsync)
+ * @param resampler_out Output resampler handle
+ * @return 0 on success, -1 on failure
+ */
+int input_resampler_create(uint32_t frame_rate, struct input_resampler **resampler_out);
+
+/**
+ * Destroy a resampler
+ */
+void input_resampler_destroy(struct input_resampler *resampler);
+
+/**
+ * Buffer an input event
+ *
+ * @param resampler Resampler handle
+ * @param event Input event
+ * @return 1 if the event was buffered, 0 if it is not resampled (flush,
+ *         then forward it as is), -1 on failure
+ */
+int input_resampler_push(struct input_resampler *resampler, const struct input_event *event);
+
+/**
+ * Produce the samples for a display frame
+ *
+ * With a fixed frame rate, ticks closer together than the target
+ * interval allows are ignored, so several surfaces presenting on the
+ * same vsync still yield one sample per frame.
+ *
+ * @param resampler Resampler handle
+ * @param frame_time_us Frame time in microseconds (same clock as event timestamps)
+ * @param out Output events (room for INPUT_RESAMPLER_MAX_OUTPUT)
+ * @return Number of events written, or -1 on failure
+ */
+int input_resampler_frame(struct input_resampler *resampler,
+                          uint64_t frame_time_us,
+                          struct input_event *out);
+
+/**
+ * Emit all buffered movement immediately
+ *
+ * @param resampler Resampler handle
+ * @param out Output events (room for INPUT_RESAMPLER_MAX_OUTPUT)
+ * @return Number of events written, or -1 on failure
+ */
+int input_resampler_flush(struct input_resampler *resampler, struct input_event *out);
+
+/**
+ * Get resampler statistics
+ */
+void input_resampler_get_stats(const struct input_resampler *resampler,
+                               struct input_resampler_stats *stats_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUT_RESAMPLER_H */
@@ -0,0 +1,337 @@
+#include "input_trace.h"
+#include "../core/le_bytes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Input trace recording and reading
+ *
+ * The writer encodes each record into a stdio buffer of
+ * INPUT_TRACE_BUFFER_SIZE bytes, so recording costs an encode and a
+ * memcpy; the file is written about once per thousand records.
+ */
+
+#define INPUT_TRACE_BUFFER_SIZE (64 * 1024)
+
+#define INPUT_TRACE_FLAG 0x01u  /* absolute / pressed / discrete */
+
+struct input_trace_writer {
+    FILE *fp;
+    uint64_t records;
+    bool failed;
+    char buffer[INPUT_TRACE_BUFFER_SIZE];
+};
+
+struct input_trace_reader {
+    FILE *fp;
+    uint16_t record_size;
+    uint8_t *record;
+};
+
+void input_trace_header_encode(uint8_t *out) {
+    memcpy(out, INPUT_TRACE_MAGIC, 8);
+    le_put_u16(out + 8, INPUT_TRACE_VERSION);
+    le_put_u16(out + 10, INPUT_TRACE_RECORD_SIZE);
+    le_put_u32(out + 12, 0);
+}
+
+int input_trace_header_decode(const uint8_t *in, uint16_t *record_size_out) {
+    if (!in || memcmp(in, INPUT_TRACE_MAGIC, 8) != 0 ||
+        le_get_u16(in + 8) != INPUT_TRACE_VERSION ||
+        le_get_u16(in + 10) < INPUT_TRACE_RECORD_MIN_SIZE) {
+        return -1;
+    }
+    if (record_size_out) {
+        *record_size_out = le_get_u16(in + 10);
+    }
+    return 0;
+}
+
+/*
+ * Record layout (offsets in bytes, all little-endian):
+ *   0 timestamp_us u64 | 8 frame_id (ACK) or refresh_us (FRAME) u64
+ *  16 kind u8 | 17 event type u8 | 18 flags u8 | 19 device type u8 | 20 code u32
+ *  24 payload 4 x f64 (a, b, c, d)
+ *  56 device u32 | 60 reserved u32
+ */
+void input_trace_record_encode(const struct input_trace_record *record, uint8_t *out) {
+    memset(out, 0, INPUT_TRACE_RECORD_SIZE);
+    le_put_u64(out + 0, record->timestamp_us);
+    le_put_u64(out + 8, record->kind == INPUT_TRACE_ACK ? record->frame_id :
+                     record->kind == INPUT_TRACE_FRAME ? record->refresh_us : 0);
+    out[16] = (uint8_t)record->kind;
+    if (record->kind != INPUT_TRACE_EVENT) {
+        return;
+    }
+
+    const struct input_event *e = &record->event;
+    uint8_t flags = 0;
+    uint32_t code = 0;
+    double a = 0.0, b = 0.0, c = 0.0, d = 0.0;
+    switch (e->type) {
+        case INPUT_EVENT_POINTER_MOTION:
+            flags = e->pointer_motion.absolute ? INPUT_TRACE_FLAG : 0;
+            a = e->pointer_motion.dx;
+            b = e->pointer_motion.dy;
+            c = e->pointer_motion.x;
+            d = e->pointer_motion.y;
+            break;
+        case INPUT_EVENT_POINTER_BUTTON:
+            flags = e->pointer_button.pressed ? INPUT_TRACE_FLAG : 0;
+            code = e->pointer_button.button;
+            break;
+        case INPUT_EVENT_SCROLL:
+            flags = e->scroll.discrete ? INPUT_TRACE_FLAG : 0;
+            a = e->scroll.dx;
+            b = e->scroll.dy;
+            c = e->scroll.discrete_dx;
+            d = e->scroll.discrete_dy;
+            break;
+        case INPUT_EVENT_KEY:
+            flags = e->key.pressed ? INPUT_TRACE_FLAG : 0;
+            code = e->key.key;
+            break;
+        case INPUT_EVENT_TOUCH:
+            flags = e->touch.pressed ? INPUT_TRACE_FLAG : 0;
+            code = e->touch.touch_id;
+            a = e->touch.x;
+            b = e->touch.y;
+            break;
+    }
+    out[17] = (uint8_t)e->type;
+    out[18] = flags;
+    out[19] = record->device_type;
+    le_put_u32(out + 20, code);
+    le_put_f64(out + 24, a);
+    le_put_f64(out + 32, b);
+    le_put_f64(out + 40, c);
+    le_put_f64(out + 48, d);
+    le_put_u32(out + 56, record->device);
+}
+
+int input_trace_record_decode(const uint8_t *in, struct input_trace_record *record_out) {
+    if (!in || !record_out) {
+        return -1;
+    }
+
+    memset(record_out, 0, sizeof(*record_out));
+    record_out->timestamp_us = le_get_u64(in + 0);
+    switch (in[16]) {
+        case INPUT_TRACE_EVENT:
+            record_out->kind = INPUT_TRACE_EVENT;
+            break;
+        case INPUT_TRACE_ACK:
+            record_out->kind = INPUT_TRACE_ACK;
+            record_out->frame_id = le_get_u64(in + 8);
+            break;
+        case INPUT_TRACE_FRAME:
+            record_out->kind = INPUT_TRACE_FRAME;
+            record_out->refresh_us = le_get_u64(in + 8);
+            break;
+        default:
+            return -1;
+    }
+    if (record_out->kind != INPUT_TRACE_EVENT) {
+        return 0;
+    }
+
+    struct input_event *e = &record_out->event;
+    bool flag = (in[18] & INPUT_TRACE_FLAG) != 0;
+    uint32_t code = le_get_u32(in + 20);
+    double a = le_get_f64(in + 24), b = le_get_f64(in + 32);
+    double c = le_get_f64(in + 40), d = le_get_f64(in + 48);
+    e->timestamp_us = record_out->timestamp_us;
+    record_out->device_type = in[19];
+    record_out->device = le_get_u32(in + 56);
+    switch (in[17]) {
+        case INPUT_EVENT_POINTER_MOTION:
+            e->type = INPUT_EVENT_POINTER_MOTION;
+            e->pointer_motion.dx = a;
+            e->pointer_motion.dy = b;
+            e->pointer_motion.absolute = flag;
+            e->pointer_motion.x = c;
+            e->pointer_motion.y = d;
+            break;
+        case INPUT_EVENT_POINTER_BUTTON:
+            e->type = INPUT_EVENT_POINTER_BUTTON;
+            e->pointer_button.button = code;
+            e->pointer_button.pressed = flag;
+            break;
+        case INPUT_EVENT_SCROLL:
+            e->type = INPUT_EVENT_SCROLL;
+            e->scroll.dx = a;
+            e->scroll.dy = b;
+            e->scroll.discrete = flag;
+            e->scroll.discrete_dx = (int32_t)c;
+            e->scroll.discrete_dy = (int32_t)d;
+            break;
+        case INPUT_EVENT_KEY:
+            e->type = INPUT_EVENT_KEY;
+            e->key.key = code;
+            e->key.pressed = flag;
+            break;
+        case INPUT_EVENT_TOUCH:
+            e->type = INPUT_EVENT_TOUCH;
+            e->touch.touch_id = code;
+            e->touch.x = a;
+            e->touch.y = b;
+            e->touch.pressed = flag;
+            break;
+        default:
+            return -1;
+    }
+    return 0;
+}
+
+int input_trace_writer_open(const char *path, struct input_trace_writer **writer_out) {
+    if (!path || !writer_out) {
+        return -1;
+    }
+
+    struct input_trace_writer *writer = calloc(1, sizeof(struct input_trace_writer));
+    if (!writer) {
+        return -1;
+    }
+
+    writer->fp = fopen(path, "wb");
+    if (!writer->fp) {
+        free(writer);
+        return -1;
+    }
+    setvbuf(writer->fp, writer->buffer, _IOFBF, sizeof(writer->buffer));
+
+    uint8_t header[INPUT_TRACE_HEADER_SIZE];
+    input_trace_header_encode(header);
+    if (fwrite(header, 1, sizeof(header), writer->fp) != sizeof(header)) {
+        fclose(writer->fp);
+        free(writer);
+        return -1;
+    }
+
+    *writer_out = writer;
+    return 0;
+}
+
+int input_trace_write(struct input_trace_writer *writer, const struct input_trace_record *record) {
+    if (!writer || !record || writer->failed) {
+        return -1;
+    }
+
+    uint8_t out[INPUT_TRACE_RECORD_SIZE];
+    input_trace_record_encode(record, out);
+    if (fwrite(out, 1, sizeof(out), writer->fp) != sizeof(out)) {
+        writer->failed = true;  /* Keep the file a valid prefix of the session */
+        return -1;
+    }
+    writer->records++;
+    return 0;
+}
+
+int input_trace_write_event(struct input_trace_writer *writer, const struct input_event *event) {
+    if (!event) {
+        return -1;
+    }
+
+    struct input_trace_record record = {
+        .kind = INPUT_TRACE_EVENT,
+        .timestamp_us = event->timestamp_us,
+        .event = *event,
+    };
+    return input_trace_write(writer, &record);
+}
+
+int input_trace_write_ack(struct input_trace_writer *writer, uint64_t frame_id, uint64_t timestamp_us) {
+    struct input_trace_record record = {
+        .kind = INPUT_TRACE_ACK,
+        .timestamp_us = timestamp_us,
+        .frame_id = frame_id,
+    };
+    return input_trace_write(writer, &record);
+}
+
+int input_trace_write_frame(struct input_trace_writer *writer, uint64_t frame_time_us) {
+    return input_trace_write_vblank(writer, frame_time_us, 0);
+}
+
+int input_trace_write_vblank(struct input_trace_writer *writer, uint64_t vblank_us, uint64_t refresh_us) {
+    struct input_trace_record record = {
+        .kind = INPUT_TRACE_FRAME,
+        .timestamp_us = vblank_us,
+        .refresh_us = refresh_us,
+    };
+    return input_trace_write(writer, &record);
+}
+
+uint64_t input_trace_writer_count(const struct input_trace_writer *writer) {
+    return writer ? writer->records : 0;
+}
+
+int input_trace_writer_close(struct input_trace_writer *writer) {
+    if (!writer) {
+        return -1;
+    }
+
+    /* The stdio buffer lives in the writer: close before freeing it */
+    int ret = fclose(writer->fp) == 0 && !writer->failed ? 0 : -1;
+    free(writer);
+    return ret;
+}
+
+int input_trace_reader_open(const char *path, struct input_trace_reader **reader_out) {
+    if (!path || !reader_out) {
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return -1;
+    }
+
+    uint8_t header[INPUT_TRACE_HEADER_SIZE];
+    uint16_t record_size = 0;
+    if (fread(header, 1, sizeof(header), fp) != sizeof(header) ||
+        input_trace_header_decode(header, &record_size) < 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    /* Older, shorter records are decoded with the missing fields zeroed */
+    struct input_trace_reader *reader = calloc(1, sizeof(struct input_trace_reader));
+    uint8_t *record = calloc(1, record_size > INPUT_TRACE_RECORD_SIZE ? record_size
+                                                                      : INPUT_TRACE_RECORD_SIZE);
+    if (!reader || !record) {
+        free(reader);
+        free(record);
+        fclose(fp);
+        return -1;
+    }
+
+    reader->fp = fp;
+    reader->record_size = record_size;
+    reader->record = record;
+    *reader_out = reader;
+    return 0;
+}
+
+int input_trace_read(struct input_trace_reader *reader, struct input_trace_record *record_out) {
+    if (!reader || !record_out) {
+        return -1;
+    }
+
+    /* Newer writers may append fields; only the known prefix is decoded */
+    if (fread(reader->record, 1, reader->record_size, reader->fp) != reader->record_size) {
+        return 0;
+    }
+    return input_trace_record_decode(reader->record, record_out) < 0 ? -1 : 1;
+}
+
+void input_trace_reader_close(struct input_trace_reader *reader) {
+    if (!reader) {
+        return;
+    }
+
+    fclose(reader->fp);
+    free(reader->record);
+    free(reader);
+}
@@ -0,0 +1,192 @@
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Input trace files
+ *
+ * A trace captures what the compositor handed to the input pipeline:
+ * every intercepted input event, every frame-presented acknowledgment
+ * and every frame tick, in order. Replaying a trace through an input
+ * proxy on a virtual clock reproduces the session exactly, so predictor
+ * and smoother changes can be compared on real user input
+ * (tools/lt_input_replay.c).
+ *
+ * Files start with a 16-byte header followed by fixed-width
+ * little-endian records:
+ *
+ *   header: magic "LTINPTRC" (8) | version u16 | record_size u16 | reserved u32
+ *   record: timestamp_us u64 | frame_id or refresh_us u64 | kind u8 | event type u8 |
+ *           flags u8 | device type u8 | code u32 | 4 x f64 payload |
+ *           device u32 | reserved u32
+ *
+ * See input_trace_record_encode() for the per-event payload layout.
+ * The device fields were appended to the original 56-byte record; they
+ * read as 0 (unknown device) from traces that predate them.
+ */
+
+#define INPUT_TRACE_MAGIC "LTINPTRC"
+#define INPUT_TRACE_VERSION 1
+#define INPUT_TRACE_HEADER_SIZE 16
+#define INPUT_TRACE_RECORD_SIZE 64
+#define INPUT_TRACE_RECORD_MIN_SIZE 56  /* Records written before the device fields */
+
+/**
+ * Trace record kinds
+ */
+typedef enum {
+    INPUT_TRACE_EVENT,  /* Input event (timestamp_us = event time) */
+    INPUT_TRACE_ACK,    /* Frame presented (input_proxy_reconcile()) */
+    INPUT_TRACE_FRAME   /* Frame tick (input_proxy_frame()) */
+} input_trace_kind_t;
+
+/**
+ * Decoded trace record
+ */
+struct input_trace_record {
+    input_trace_kind_t kind;
+    uint64_t timestamp_us;      /* Event, acknowledgment or frame time */
+    uint64_t frame_id;          /* INPUT_TRACE_ACK only */
+    uint64_t refresh_us;        /* INPUT_TRACE_FRAME: refresh period of a presented vblank (0 = tick) */
+    struct input_event event;   /* INPUT_TRACE_EVENT only */
+    uint32_t device;            /* INPUT_TRACE_EVENT: recording device, unique per trace (0 = unknown) */
+    uint8_t device_type;        /* INPUT_TRACE_EVENT: device class defined by the recorder (0 = unknown) */
+};
+
+struct input_trace_writer;
+struct input_trace_reader;
+
+/**
+ * Write the file header
+ *
+ * @param out Output buffer of INPUT_TRACE_HEADER_SIZE bytes
+ */
+void input_trace_header_encode(uint8_t *out);
+
+/**
+ * Validate a file header
+ *
+ * @param in Header bytes (INPUT_TRACE_HEADER_SIZE)
+ * @param record_size_out Record size declared by the file
+ * @return 0 on success, -1 if this is not a trace this version can read
+ */
+int input_trace_header_decode(const uint8_t *in, uint16_t *record_size_out);
+
+/**
+ * Encode a record
+ *
+ * Payload by event type: motion dx, dy, x, y (flags: absolute); button
+ * and key code (flags: pressed); scroll dx, dy, discrete_dx, discrete_dy
+ * (flags: discrete); touch id as code, x, y (flags: pressed).
+ *
+ * @param record Record
+ * @param out Output buffer of INPUT_TRACE_RECORD_SIZE bytes
+ */
+void input_trace_record_encode(const struct input_trace_record *record, uint8_t *out);
+
+/**
+ * Decode a record
+ *
+ * @param in Record bytes (INPUT_TRACE_RECORD_SIZE)
+ * @param record_out Output record
+ * @return 0 on success, -1 for an unknown kind or event type
+ */
+int input_trace_record_decode(const uint8_t *in, struct input_trace_record *record_out);
+
+/**
+ * Create a trace file (truncated if it exists)
+ *
+ * Records are buffered and written by the calling thread. Not
+ * thread-safe: record from the thread that owns the input pipeline.
+ *
+ * @param path Output file
+ * @param writer_out Output writer handle
+ * @return 0 on success, -1 on failure
+ */
+int input_trace_writer_open(const char *path, struct input_trace_writer **writer_out);
+
+/**
+ * Append a record
+ *
+ * @return 0 on success, -1 on failure (write error)
+ */
+int input_trace_write(struct input_trace_writer *writer, const struct input_trace_record *record);
+
+/**
+ * Append an input event from an unknown device
+ */
+int input_trace_write_event(struct input_trace_writer *writer, const struct input_event *event);
+
+/**
+ * Append a frame-presented acknowledgment
+ *
+ * @param writer Writer handle
+ * @param frame_id Acknowledged frame ID
+ * @param timestamp_us Acknowledgment time (same clock as the events)
+ */
+int input_trace_write_ack(struct input_trace_writer *writer, uint64_t frame_id, uint64_t timestamp_us);
+
+/**
+ * Append a frame tick
+ */
+int input_trace_write_frame(struct input_trace_writer *writer, uint64_t frame_time_us);
+
+/**
+ * Append a frame tick from presentation feedback
+ *
+ * @param writer Writer handle
+ * @param vblank_us Presentation time
+ * @param refresh_us Refresh period in microseconds (input_proxy_set_display_timing())
+ */
+int input_trace_write_vblank(struct input_trace_writer *writer, uint64_t vblank_us, uint64_t refresh_us);
+
+/**
+ * Number of records written so far
+ */
+uint64_t input_trace_writer_count(const struct input_trace_writer *writer);
+
+/**
+ * Flush and close a trace file
+ *
+ * @return 0 on success, -1 if buffered records could not be written
+ */
+int input_trace_writer_close(struct input_trace_writer *writer);
+
+/**
+ * Open a trace file for reading
+ *
+ * @param path Trace file
+ * @param reader_out Output reader handle
+ * @return 0 on success, -1 if the file cannot be opened or is not a trace
+ */
+int input_trace_reader_open(const char *path, struct input_trace_reader **reader_out);
+
+/**
+ * Read the next record
+ *
+ * Fields appended by newer writers are skipped, fields missing from
+ * older traces read as 0, and a truncated trailing record ends the trace.
+ *
+ * @return 1 if a record was read, 0 at the end of the trace, -1 on a
+ *         corrupt record
+ */
+int input_trace_read(struct input_trace_reader *reader, struct input_trace_record *record_out);
+
+/**
+ * Close a trace file
+ */
+void input_trace_reader_close(struct input_trace_reader *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUT_TRACE_H */
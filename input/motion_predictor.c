@@ -0,0 +1,200 @@
+#include "input.h"
+#include <stdlib.h>
+#include <math.h>
+
+/**
+ * Adaptive pointer motion predictor
+ *
+ * A per-axis alpha-beta filter tracks pointer velocity and acceleration
+ * from event deltas; the prediction is the delta expected one prediction
+ * window ahead. Reconciliation errors close the loop in two ways:
+ *
+ * - the effective horizon is a learned multiple of the nominal window,
+ *   fitted by normalized LMS against the error along the predicted lead
+ *   (overshoot on direction changes shrinks it, undershoot during fast
+ *   flicks grows it);
+ * - the filter gains follow from a tracking index (Kalata), which rises
+ *   when errors are large relative to the lead (respond faster) and
+ *   decays when they are small (reject noise).
+ */
+
+#define MOTION_MIN_DT_S 0.0005          /* Coalesced events can share a timestamp */
+#define MOTION_MAX_DT_S 0.1             /* Longer gaps restart the track */
+#define MOTION_LAMBDA_INITIAL 0.5
+#define MOTION_LAMBDA_MIN 0.05
+#define MOTION_LAMBDA_MAX 5.0
+#define MOTION_LAMBDA_RATE 0.2
+#define MOTION_ERROR_TARGET 0.25        /* Normalized error the tracking index aims for */
+#define MOTION_HORIZON_RATE 0.2
+#define MOTION_HORIZON_MAX 3.0
+#define MOTION_STATS_DECAY 0.05         /* EWMA weight of the newest error */
+
+struct motion_axis {
+    double velocity;        /* units/s */
+    double acceleration;    /* units/s^2 */
+};
+
+struct motion_predictor {
+    double window_s;
+    double horizon_scale;
+    double lambda;
+    double alpha;
+    double beta;
+
+    struct motion_axis x;
+    struct motion_axis y;
+    uint64_t last_us;
+    uint32_t samples;
+
+    struct motion_predictor_stats stats;
+    double error_sq;
+};
+
+/* Alpha-beta gains for a tracking index (Kalata, 1984) */
+static void motion_predictor_update_gains(struct motion_predictor *mp) {
+    double l = mp->lambda;
+    double r = sqrt(l * l + 8.0 * l);
+    mp->alpha = -(l * l + 8.0 * l - (l + 4.0) * r) / 8.0;
+    mp->beta = (l * l + 4.0 * l - l * r) / 4.0;
+    mp->stats.alpha = mp->alpha;
+    mp->stats.beta = mp->beta;
+}
+
+static void motion_axis_update(struct motion_axis *axis, double alpha, double beta,
+                               double measured, double dt) {
+    double predicted = axis->velocity + axis->acceleration * dt;
+    double residual = measured - predicted;
+    axis->velocity = predicted + alpha * residual;
+    axis->acceleration += beta * residual / dt;
+}
+
+/* Velocity one horizon ahead; the acceleration term may at most double or cancel it */
+static double motion_axis_extrapolate(const struct motion_axis *axis, double horizon_s) {
+    double lead = axis->acceleration * horizon_s;
+    double limit = fabs(axis->velocity);
+    if (lead > limit) {
+        lead = limit;
+    } else if (lead < -limit) {
+        lead = -limit;
+    }
+    return axis->velocity + lead;
+}
+
+int motion_predictor_create(uint32_t window_ms, struct motion_predictor **predictor_out) {
+    if (!predictor_out) {
+        return -1;
+    }
+
+    struct motion_predictor *mp = calloc(1, sizeof(struct motion_predictor));
+    if (!mp) {
+        return -1;
+    }
+
+    mp->window_s = window_ms / 1000.0;
+    mp->horizon_scale = 1.0;
+    mp->lambda = MOTION_LAMBDA_INITIAL;
+    motion_predictor_update_gains(mp);
+    mp->stats.effective_window_ms = window_ms;
+
+    *predictor_out = mp;
+    return 0;
+}
+
+void motion_predictor_destroy(struct motion_predictor *predictor) {
+    free(predictor);
+}
+
+int motion_predictor_predict(struct motion_predictor *predictor,
+                             uint64_t timestamp_us,
+                             double dx, double dy,
+                             double *predicted_dx, double *predicted_dy) {
+    if (!predictor || !predicted_dx || !predicted_dy) {
+        return -1;
+    }
+
+    *predicted_dx = dx;
+    *predicted_dy = dy;
+
+    double dt = (double)(timestamp_us - predictor->last_us) / 1000000.0;
+    if (predictor->samples == 0 || timestamp_us < predictor->last_us || dt > MOTION_MAX_DT_S) {
+        /* No usable interval yet: pass through and restart the track */
+        predictor->x = (struct motion_axis){0};
+        predictor->y = (struct motion_axis){0};
+        predictor->last_us = timestamp_us;
+        predictor->samples = 1;
+        return 0;
+    }
+    if (dt < MOTION_MIN_DT_S) {
+        dt = MOTION_MIN_DT_S;
+    }
+
+    if (predictor->samples == 1) {
+        predictor->x.velocity = dx / dt;
+        predictor->y.velocity = dy / dt;
+    } else {
+        motion_axis_update(&predictor->x, predictor->alpha, predictor->beta, dx / dt, dt);
+        motion_axis_update(&predictor->y, predictor->alpha, predictor->beta, dy / dt, dt);
+    }
+    predictor->samples++;
+    predictor->last_us = timestamp_us;
+
+    double horizon_s = predictor->window_s * predictor->horizon_scale;
+    *predicted_dx = motion_axis_extrapolate(&predictor->x, horizon_s) * dt;
+    *predicted_dy = motion_axis_extrapolate(&predictor->y, horizon_s) * dt;
+    return 0;
+}
+
+void motion_predictor_correct(struct motion_predictor *predictor,
+                              double lead_dx, double lead_dy,
+                              double error_dx, double error_dy) {
+    if (!predictor) {
+        return;
+    }
+
+    double lead_sq = lead_dx * lead_dx + lead_dy * lead_dy;
+    double error_sq = error_dx * error_dx + error_dy * error_dy;
+
+    /* Horizon: NLMS step on the error component along the lead */
+    if (lead_sq > 1e-9) {
+        double step = (error_dx * lead_dx + error_dy * lead_dy) / lead_sq;
+        predictor->horizon_scale -= MOTION_HORIZON_RATE * step;
+        if (predictor->horizon_scale < 0.0) {
+            predictor->horizon_scale = 0.0;
+        } else if (predictor->horizon_scale > MOTION_HORIZON_MAX) {
+            predictor->horizon_scale = MOTION_HORIZON_MAX;
+        }
+    }
+
+    /* Tracking index: multiplicative step toward the target normalized error */
+    double normalized = error_sq / (error_sq + lead_sq + 1e-9);
+    predictor->lambda *= exp(MOTION_LAMBDA_RATE * (normalized - MOTION_ERROR_TARGET));
+    if (predictor->lambda < MOTION_LAMBDA_MIN) {
+        predictor->lambda = MOTION_LAMBDA_MIN;
+    } else if (predictor->lambda > MOTION_LAMBDA_MAX) {
+        predictor->lambda = MOTION_LAMBDA_MAX;
+    }
+    motion_predictor_update_gains(predictor);
+
+    /* Live error statistics */
+    double error = sqrt(error_sq);
+    struct motion_predictor_stats *stats = &predictor->stats;
+    if (stats->corrections == 0) {
+        stats->error_mean = error;
+        predictor->error_sq = error_sq;
+    } else {
+        stats->error_mean += MOTION_STATS_DECAY * (error - stats->error_mean);
+        predictor->error_sq += MOTION_STATS_DECAY * (error_sq - predictor->error_sq);
+    }
+    stats->error_rms = sqrt(predictor->error_sq);
+    stats->corrections++;
+    stats->effective_window_ms = predictor->window_s * predictor->horizon_scale * 1000.0;
+}
+
+void motion_predictor_get_stats(const struct motion_predictor *predictor,
+                                struct motion_predictor_stats *stats_out) {
+    if (!predictor || !stats_out) {
+        return;
+    }
+
+    *stats_out = predictor->stats;
+}
@@ -2,6 +2,7 @@
 #define RUST_PREDICTOR_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,6 +54,29 @@ int rust_input_predictor_predict_pointer(rust_input_predictor_t *predictor,
                                         double *predicted_dx,
                                         double *predicted_dy);
 
+/**
+ * Predict a burst of pointer motion samples in one call
+ *
+ * Equivalent to calling rust_input_predictor_predict_pointer() for each
+ * sample in order, with one FFI crossing for the whole burst. Inputs and
+ * outputs are parallel arrays (SoA) of `count` elements.
+ *
+ * @param predictor Predictor handle
+ * @param timestamps_us Monotonic timestamps in microseconds
+ * @param dx Deltas X
+ * @param dy Deltas Y
+ * @param count Number of samples
+ * @param predicted_dx Output predicted deltas X (one per sample)
+ * @param predicted_dy Output predicted deltas Y (one per sample)
+ * @return 0 on success, negative on error
+ */
+int rust_input_predictor_predict_pointer_batch(rust_input_predictor_t *predictor,
+                                              const uint64_t *timestamps_us,
+                                              const double *dx, const double *dy,
+                                              size_t count,
+                                              double *predicted_dx,
+                                              double *predicted_dy);
+
 /**
  * Predict scroll motion
  *
@@ -78,6 +102,36 @@ int rust_input_predictor_predict_scroll(rust_input_predictor_t *predictor,
  */
 int rust_input_predictor_reset(rust_input_predictor_t *predictor);
 
+/**
+ * C velocity predictor
+ *
+ * Native port of the Rust VelocityTracker with the same ABI and
+ * numerically identical results. Always built, so C-only builds get the
+ * same prediction as Rust builds; see input_proxy_set_predictor().
+ * Parameters and return values match the rust_input_predictor_* calls.
+ */
+rust_input_predictor_t *velocity_predictor_create(uint32_t window_ms,
+                                                  double smoothing_factor,
+                                                  double velocity_decay);
+void velocity_predictor_destroy(rust_input_predictor_t *predictor);
+int velocity_predictor_predict_pointer(rust_input_predictor_t *predictor,
+                                       double timestamp,
+                                       double dx, double dy,
+                                       double *predicted_dx,
+                                       double *predicted_dy);
+int velocity_predictor_predict_pointer_batch(rust_input_predictor_t *predictor,
+                                             const uint64_t *timestamps_us,
+                                             const double *dx, const double *dy,
+                                             size_t count,
+                                             double *predicted_dx,
+                                             double *predicted_dy);
+int velocity_predictor_predict_scroll(rust_input_predictor_t *predictor,
+                                      double timestamp,
+                                      double dx, double dy,
+                                      double *predicted_dx,
+                                      double *predicted_dy);
+int velocity_predictor_reset(rust_input_predictor_t *predictor);
+
 #ifdef __cplusplus
 }
 #endif
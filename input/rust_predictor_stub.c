@@ -5,8 +5,8 @@
  * Rust predictor stub implementation
  *
  * This provides fallback stubs when the Rust library is not linked.
- * In production, these would be replaced by actual Rust function calls
- * via dynamic linking or static linking of the Rust library.
+ * rust_input_predictor_create() returns NULL, which makes the input proxy
+ * select the C port of the same predictor (velocity_predictor.c).
  */
 
 rust_input_predictor_t *rust_input_predictor_create(uint32_t window_ms,
@@ -43,6 +43,22 @@ int rust_input_predictor_predict_pointer(rust_input_predictor_t *predictor,
     return -1;  /* Indicate stub/failure */
 }
 
+int rust_input_predictor_predict_pointer_batch(rust_input_predictor_t *predictor,
+                                              const uint64_t *timestamps_us,
+                                              const double *dx, const double *dy,
+                                              size_t count,
+                                              double *predicted_dx,
+                                              double *predicted_dy) {
+    (void)predictor;
+    (void)timestamps_us;
+    (void)dx;
+    (void)dy;
+    (void)count;
+    (void)predicted_dx;
+    (void)predicted_dy;
+    return -1;  /* Indicate stub/failure */
+}
+
 int rust_input_predictor_predict_scroll(rust_input_predictor_t *predictor,
                                        double timestamp,
                                        double dx, double dy,
@@ -1,16 +1,33 @@
 #include "input.h"
+#include "../core/utils.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include <time.h>
 
 /**
  * Scroll smoothing implementation
  *
  * Applies smoothing to scroll events to reduce jitter and improve
  * perceived smoothness, especially for touchpad scrolling.
+ *
+ * Kinetic scrolling continues a touchpad fling after the fingers lift.
+ * The release velocity is estimated from the last raw deltas, then
+ * decays under dv/dt = -friction * v - deceleration until it falls to
+ * the stop velocity. Distance is evaluated in closed form at each frame
+ * time and only the increment since the previous frame is emitted, so
+ * the curve is independent of frame rate and fully determined by the
+ * timestamps passed in.
  */
 
+#define SCROLL_KINETIC_SAMPLES 8
+#define SCROLL_KINETIC_SAMPLE_WINDOW_US 50000   /* Deltas used for the release velocity */
+
+struct scroll_sample {
+    uint64_t timestamp_us;
+    double dx;
+    double dy;
+};
+
 struct scroll_state {
     /* Smoothing parameters */
     double smoothing_factor;
@@ -26,8 +43,71 @@ struct scroll_state {
     /* Discrete scroll accumulator */
     int32_t discrete_accum_x;
     int32_t discrete_accum_y;
+    
+    /* Kinetic scrolling */
+    bool kinetic_enabled;
+    struct scroll_kinetic_config kinetic;
+    struct scroll_sample samples[SCROLL_KINETIC_SAMPLES];
+    size_t sample_head;
+    size_t sample_count;
+    
+    bool flinging;
+    uint64_t fling_start_us;
+    double fling_speed;         /* Release speed, units/s */
+    double fling_dir_x;         /* Unit direction of the fling */
+    double fling_dir_y;
+    double fling_duration_s;    /* Time until the stop velocity is reached */
+    double fling_emitted;       /* Distance already emitted */
 };
 
+void scroll_smoother_kinetic_defaults(struct scroll_kinetic_config *config) {
+    if (!config) {
+        return;
+    }
+    
+    config->friction = 4.0;
+    config->deceleration = 200.0;
+    config->stop_velocity = 10.0;
+    config->min_fling_velocity = 100.0;
+}
+
+/*
+ * Distance travelled t seconds into a fling. With friction k and
+ * deceleration c the speed is (v0 + c/k) e^(-kt) - c/k; without
+ * friction it falls linearly.
+ */
+static double kinetic_distance(const struct scroll_kinetic_config *k, double v0, double t) {
+    if (k->friction > 0.0) {
+        double c = k->deceleration / k->friction;
+        return (v0 + c) * -expm1(-k->friction * t) / k->friction - c * t;
+    }
+    return v0 * t - 0.5 * k->deceleration * t * t;
+}
+
+/* Time at which the fling slows to the stop velocity */
+static double kinetic_duration(const struct scroll_kinetic_config *k, double v0) {
+    double v_end = k->stop_velocity;
+    if (v0 <= v_end) {
+        return 0.0;
+    }
+    if (k->friction > 0.0) {
+        double c = k->deceleration / k->friction;
+        return log((v0 + c) / (v_end + c)) / k->friction;
+    }
+    return (v0 - v_end) / k->deceleration;
+}
+
+static void scroll_smoother_record(struct scroll_state *smoother, uint64_t timestamp_us,
+                                   double dx, double dy) {
+    size_t index = (smoother->sample_head + smoother->sample_count) % SCROLL_KINETIC_SAMPLES;
+    if (smoother->sample_count == SCROLL_KINETIC_SAMPLES) {
+        smoother->sample_head = (smoother->sample_head + 1) % SCROLL_KINETIC_SAMPLES;
+    } else {
+        smoother->sample_count++;
+    }
+    smoother->samples[index] = (struct scroll_sample){timestamp_us, dx, dy};
+}
+
 int scroll_smoother_create(struct scroll_state **smoother_out) {
     if (!smoother_out) {
         return -1;
@@ -47,9 +127,8 @@ int scroll_smoother_create(struct scroll_state **smoother_out) {
     smoother->position_x = 0.0;
     smoother->position_y = 0.0;
     
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    smoother->last_update_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    /* No previous event: the first one is measured from time zero, i.e. from rest */
+    smoother->last_update_us = 0;
     
     smoother->discrete_accum_x = 0;
     smoother->discrete_accum_y = 0;
@@ -68,17 +147,32 @@ int scroll_smoother_process(struct scroll_state *smoother,
                            double dx, double dy,
                            bool discrete,
                            double *smoothed_dx, double *smoothed_dy) {
+    return scroll_smoother_process_at(smoother, utils_timestamp_us(), dx, dy, discrete,
+                                      smoothed_dx, smoothed_dy);
+}
+
+int scroll_smoother_process_at(struct scroll_state *smoother,
+                               uint64_t timestamp_us,
+                               double dx, double dy,
+                               bool discrete,
+                               double *smoothed_dx, double *smoothed_dy) {
     if (!smoother || !smoothed_dx || !smoothed_dy) {
         return -1;
     }
     
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    uint64_t now_us = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+    uint64_t now_us = timestamp_us;
     
-    double dt = (now_us - smoother->last_update_us) / 1000000.0;  /* Convert to seconds */
-    if (dt <= 0.0) {
-        dt = 0.001;  /* Minimum 1ms */
+    /* New scroll input takes over from a fling; only fingers on the pad feed the next one */
+    smoother->flinging = false;
+    if (discrete) {
+        smoother->sample_count = 0;
+    } else if (dx != 0.0 || dy != 0.0) {
+        scroll_smoother_record(smoother, timestamp_us, dx, dy);
+    }
+    
+    double dt = 0.001;  /* Minimum 1ms */
+    if (now_us > smoother->last_update_us) {
+        dt = (now_us - smoother->last_update_us) / 1000000.0;  /* Convert to seconds */
     }
     
     if (discrete) {
@@ -124,3 +218,129 @@ int scroll_smoother_process(struct scroll_state *smoother,
     return 0;
 }
 
+int scroll_smoother_set_kinetic(struct scroll_state *smoother,
+                                const struct scroll_kinetic_config *config) {
+    if (!smoother) {
+        return -1;
+    }
+    
+    if (!config) {
+        smoother->kinetic_enabled = false;
+        smoother->flinging = false;
+        return 0;
+    }
+    
+    /* Something must slow the fling down, or it would never stop */
+    if (config->friction < 0.0 || config->deceleration < 0.0 || config->stop_velocity < 0.0 ||
+        (config->friction == 0.0 && config->deceleration == 0.0) ||
+        (config->deceleration == 0.0 && config->stop_velocity == 0.0)) {
+        return -1;
+    }
+    
+    smoother->kinetic = *config;
+    smoother->kinetic_enabled = true;
+    return 0;
+}
+
+int scroll_smoother_release(struct scroll_state *smoother, uint64_t timestamp_us) {
+    if (!smoother) {
+        return -1;
+    }
+    
+    smoother->flinging = false;
+    size_t count = smoother->sample_count;
+    smoother->sample_count = 0;
+    if (!smoother->kinetic_enabled || count < 2) {
+        return 0;
+    }
+    
+    /* Fingers resting before the lift mean there is no fling */
+    const struct scroll_sample *last =
+        &smoother->samples[(smoother->sample_head + count - 1) % SCROLL_KINETIC_SAMPLES];
+    if (timestamp_us < last->timestamp_us ||
+        timestamp_us - last->timestamp_us > SCROLL_KINETIC_SAMPLE_WINDOW_US) {
+        return 0;
+    }
+    
+    /* Average velocity over the recent samples (the oldest one only anchors the interval) */
+    size_t first = count - 1;
+    while (first > 0) {
+        const struct scroll_sample *sample =
+            &smoother->samples[(smoother->sample_head + first - 1) % SCROLL_KINETIC_SAMPLES];
+        if (last->timestamp_us - sample->timestamp_us > SCROLL_KINETIC_SAMPLE_WINDOW_US) {
+            break;
+        }
+        first--;
+    }
+    const struct scroll_sample *anchor =
+        &smoother->samples[(smoother->sample_head + first) % SCROLL_KINETIC_SAMPLES];
+    if (last->timestamp_us <= anchor->timestamp_us) {
+        return 0;
+    }
+    
+    double sum_dx = 0.0, sum_dy = 0.0;
+    for (size_t i = first + 1; i < count; i++) {
+        const struct scroll_sample *sample =
+            &smoother->samples[(smoother->sample_head + i) % SCROLL_KINETIC_SAMPLES];
+        sum_dx += sample->dx;
+        sum_dy += sample->dy;
+    }
+    double span_s = (last->timestamp_us - anchor->timestamp_us) / 1000000.0;
+    double vx = sum_dx / span_s;
+    double vy = sum_dy / span_s;
+    double speed = sqrt(vx * vx + vy * vy);
+    if (speed < smoother->kinetic.min_fling_velocity || speed <= smoother->kinetic.stop_velocity) {
+        return 0;
+    }
+    
+    smoother->flinging = true;
+    smoother->fling_start_us = timestamp_us;
+    smoother->fling_speed = speed;
+    smoother->fling_dir_x = vx / speed;
+    smoother->fling_dir_y = vy / speed;
+    smoother->fling_duration_s = kinetic_duration(&smoother->kinetic, speed);
+    smoother->fling_emitted = 0.0;
+    return 1;
+}
+
+int scroll_smoother_frame(struct scroll_state *smoother,
+                          uint64_t frame_time_us,
+                          double *dx, double *dy) {
+    if (!smoother || !dx || !dy) {
+        return -1;
+    }
+    
+    *dx = 0.0;
+    *dy = 0.0;
+    if (!smoother->flinging || frame_time_us <= smoother->fling_start_us) {
+        return 0;
+    }
+    
+    double t = (frame_time_us - smoother->fling_start_us) / 1000000.0;
+    if (t >= smoother->fling_duration_s) {
+        t = smoother->fling_duration_s;
+        smoother->flinging = false;
+    }
+    
+    double distance = kinetic_distance(&smoother->kinetic, smoother->fling_speed, t);
+    double step = distance - smoother->fling_emitted;
+    if (step <= 0.0) {
+        return 0;  /* Repeated frame time */
+    }
+    smoother->fling_emitted = distance;
+    
+    *dx = smoother->fling_dir_x * step;
+    *dy = smoother->fling_dir_y * step;
+    return 1;
+}
+
+void scroll_smoother_cancel(struct scroll_state *smoother) {
+    if (smoother) {
+        smoother->flinging = false;
+        smoother->sample_count = 0;
+    }
+}
+
+bool scroll_smoother_is_flinging(const struct scroll_state *smoother) {
+    return smoother && smoother->flinging;
+}
@@ -0,0 +1,208 @@
+#include "rust_predictor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/**
+ * C velocity predictor
+ *
+ * Port of the Rust VelocityTracker (rust/input_predictor) behind the same
+ * ABI, for builds without the Rust library. The arithmetic follows the
+ * Rust code operation for operation so both backends produce identical
+ * results.
+ *
+ * Interval velocities (change in delta over elapsed time) of the most
+ * recent samples sit in a fixed ring with running sums: insertion and
+ * prediction are O(1), and intervals that start before the prediction
+ * window are evicted as newer samples arrive.
+ *
+ * Keep this file in sync with rust/input_predictor/src/lib.rs.
+ */
+
+#define VELOCITY_PREDICTOR_MAX_SAMPLES 10
+#define VELOCITY_PREDICTOR_INTERVALS (VELOCITY_PREDICTOR_MAX_SAMPLES - 1)
+#define VELOCITY_PREDICTOR_RESYNC 1024   /* Recompute running sums to cancel drift */
+
+struct velocity_interval {
+    double start;
+    double vx;
+    double vy;
+};
+
+struct velocity_tracker {
+    struct velocity_interval intervals[VELOCITY_PREDICTOR_INTERVALS];
+    size_t head;
+    size_t len;
+    double sum_vx;
+    double sum_vy;
+    bool has_last;
+    double last_timestamp;
+    double last_dx;
+    double last_dy;
+    uint32_t pushes_since_resync;
+};
+
+struct velocity_predictor {
+    struct velocity_tracker pointer;
+    struct velocity_tracker scroll;
+    double window_s;
+    double smoothing_factor;    /* Accepted for ABI parity; unused, as in Rust */
+    double velocity_decay;
+};
+
+static void tracker_pop_front(struct velocity_tracker *tracker) {
+    const struct velocity_interval *interval = &tracker->intervals[tracker->head];
+    tracker->head = (tracker->head + 1) % VELOCITY_PREDICTOR_INTERVALS;
+    tracker->len--;
+    if (tracker->len == 0) {
+        tracker->sum_vx = 0.0;
+        tracker->sum_vy = 0.0;
+    } else {
+        tracker->sum_vx -= interval->vx;
+        tracker->sum_vy -= interval->vy;
+    }
+}
+
+static void tracker_resync(struct velocity_tracker *tracker) {
+    tracker->sum_vx = 0.0;
+    tracker->sum_vy = 0.0;
+    for (size_t i = 0; i < tracker->len; i++) {
+        const struct velocity_interval *interval =
+            &tracker->intervals[(tracker->head + i) % VELOCITY_PREDICTOR_INTERVALS];
+        tracker->sum_vx += interval->vx;
+        tracker->sum_vy += interval->vy;
+    }
+    tracker->pushes_since_resync = 0;
+}
+
+static void tracker_push(struct velocity_tracker *tracker, struct velocity_interval interval) {
+    if (tracker->len == VELOCITY_PREDICTOR_INTERVALS) {
+        tracker_pop_front(tracker);
+    }
+
+    tracker->intervals[(tracker->head + tracker->len) % VELOCITY_PREDICTOR_INTERVALS] = interval;
+    tracker->len++;
+    tracker->sum_vx += interval.vx;
+    tracker->sum_vy += interval.vy;
+
+    if (++tracker->pushes_since_resync >= VELOCITY_PREDICTOR_RESYNC) {
+        tracker_resync(tracker);
+    }
+}
+
+static void tracker_add_sample(struct velocity_tracker *tracker, double window_s,
+                               double timestamp, double dx, double dy) {
+    if (tracker->has_last) {
+        double dt = timestamp - tracker->last_timestamp;
+        if (dt > 0.0) {
+            tracker_push(tracker, (struct velocity_interval){
+                .start = tracker->last_timestamp,
+                .vx = (dx - tracker->last_dx) / dt,
+                .vy = (dy - tracker->last_dy) / dt,
+            });
+        }
+    }
+    tracker->has_last = true;
+    tracker->last_timestamp = timestamp;
+    tracker->last_dx = dx;
+    tracker->last_dy = dy;
+
+    /* Evict intervals that start before the prediction window */
+    double cutoff = timestamp - window_s;
+    while (tracker->len > 0 && tracker->intervals[tracker->head].start < cutoff) {
+        tracker_pop_front(tracker);
+    }
+}
+
+static void tracker_predict(const struct velocity_tracker *tracker, double window_s,
+                            double *out_dx, double *out_dy) {
+    if (tracker->len == 0) {
+        *out_dx = 0.0;
+        *out_dy = 0.0;
+        return;
+    }
+
+    /* Average velocity over the intervals in the window, projected ahead */
+    double n = (double)tracker->len;
+    *out_dx = tracker->sum_vx / n * window_s;
+    *out_dy = tracker->sum_vy / n * window_s;
+}
+
+rust_input_predictor_t *velocity_predictor_create(uint32_t window_ms,
+                                                  double smoothing_factor,
+                                                  double velocity_decay) {
+    struct velocity_predictor *predictor = calloc(1, sizeof(struct velocity_predictor));
+    if (!predictor) {
+        return NULL;
+    }
+
+    predictor->window_s = (double)window_ms / 1000.0;
+    predictor->smoothing_factor = smoothing_factor;
+    predictor->velocity_decay = velocity_decay;
+    return predictor;
+}
+
+void velocity_predictor_destroy(rust_input_predictor_t *predictor) {
+    free(predictor);
+}
+
+int velocity_predictor_predict_pointer(rust_input_predictor_t *predictor,
+                                       double timestamp,
+                                       double dx, double dy,
+                                       double *predicted_dx,
+                                       double *predicted_dy) {
+    if (!predictor || !predicted_dx || !predicted_dy) {
+        return -1;
+    }
+
+    struct velocity_predictor *vp = predictor;
+    tracker_add_sample(&vp->pointer, vp->window_s, timestamp, dx, dy);
+    tracker_predict(&vp->pointer, vp->window_s, predicted_dx, predicted_dy);
+    return 0;
+}
+
+int velocity_predictor_predict_pointer_batch(rust_input_predictor_t *predictor,
+                                             const uint64_t *timestamps_us,
+                                             const double *dx, const double *dy,
+                                             size_t count,
+                                             double *predicted_dx,
+                                             double *predicted_dy) {
+    if (!predictor || (count > 0 && (!timestamps_us || !dx || !dy ||
+                                     !predicted_dx || !predicted_dy))) {
+        return -1;
+    }
+
+    struct velocity_predictor *vp = predictor;
+    for (size_t i = 0; i < count; i++) {
+        double timestamp = (double)timestamps_us[i] / 1000000.0;
+        tracker_add_sample(&vp->pointer, vp->window_s, timestamp, dx[i], dy[i]);
+        tracker_predict(&vp->pointer, vp->window_s, &predicted_dx[i], &predicted_dy[i]);
+    }
+    return 0;
+}
+
+int velocity_predictor_predict_scroll(rust_input_predictor_t *predictor,
+                                      double timestamp,
+                                      double dx, double dy,
+                                      double *predicted_dx,
+                                      double *predicted_dy) {
+    if (!predictor || !predicted_dx || !predicted_dy) {
+        return -1;
+    }
+
+    struct velocity_predictor *vp = predictor;
+    tracker_add_sample(&vp->scroll, vp->window_s, timestamp, dx, dy);
+    tracker_predict(&vp->scroll, vp->window_s, predicted_dx, predicted_dy);
+    return 0;
+}
+
+int velocity_predictor_reset(rust_input_predictor_t *predictor) {
+    if (!predictor) {
+        return -1;
+    }
+
+    struct velocity_predictor *vp = predictor;
+    memset(&vp->pointer, 0, sizeof(vp->pointer));
+    memset(&vp->scroll, 0, sizeof(vp->scroll));
+    return 0;
+}
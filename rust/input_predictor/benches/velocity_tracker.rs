@@ -0,0 +1,112 @@
+//! VelocityTracker benchmark
+//!
+//! Criterion-style report without the criterion dependency (the crate
+//! must build offline with only libc). Run with:
+//!
+//!     cargo bench --bench velocity_tracker
+//!
+//! Each case feeds an 8 kHz pointer stream through add_sample + predict
+//! and reports the median time per event over several batches, next to
+//! the previous Vec-shifting implementation for comparison.
+
+use input_predictor::VelocityTracker;
+use std::hint::black_box;
+use std::time::Instant;
+
+const EVENTS_PER_BATCH: usize = 100_000;
+const BATCHES: usize = 15;
+const SAMPLE_INTERVAL_S: f64 = 1.0 / 8000.0;
+
+/// The tracker as it was before the ring buffer: Vec::remove(0) on insert,
+/// full rescan on predict
+struct VecTracker {
+    samples: Vec<(f64, f64, f64)>,
+    max_samples: usize,
+}
+
+impl VecTracker {
+    fn new(max_samples: usize) -> Self {
+        Self {
+            samples: Vec::with_capacity(max_samples),
+            max_samples,
+        }
+    }
+
+    fn add_sample(&mut self, timestamp: f64, dx: f64, dy: f64) {
+        self.samples.push((timestamp, dx, dy));
+        if self.samples.len() > self.max_samples {
+            self.samples.remove(0);
+        }
+    }
+
+    fn predict(&self, window_ms: u32) -> (f64, f64) {
+        if self.samples.len() < 2 {
+            return (0.0, 0.0);
+        }
+        let window_s = window_ms as f64 / 1000.0;
+        let cutoff = self.samples.last().unwrap().0 - window_s;
+        let (mut vx, mut vy, mut total_dt) = (0.0, 0.0, 0.0);
+        for i in 1..self.samples.len() {
+            let (t1, x1, y1) = self.samples[i - 1];
+            let (t2, x2, y2) = self.samples[i];
+            if t1 < cutoff {
+                continue;
+            }
+            let dt = t2 - t1;
+            if dt > 0.0 {
+                vx += (x2 - x1) / dt;
+                vy += (y2 - y1) / dt;
+                total_dt += dt;
+            }
+        }
+        if total_dt > 0.0 {
+            let n = (self.samples.len() - 1) as f64;
+            (vx / n * window_s, vy / n * window_s)
+        } else {
+            (0.0, 0.0)
+        }
+    }
+}
+
+fn stream(i: usize) -> (f64, f64, f64) {
+    let t = i as f64 * SAMPLE_INTERVAL_S;
+    (t, (t * 7.0).sin() * 3.0, (t * 5.0).cos() * 2.0)
+}
+
+fn bench<F: FnMut(usize)>(name: &str, mut run: F) {
+    let mut per_event_ns: Vec<f64> = (0..BATCHES)
+        .map(|batch| {
+            let start = Instant::now();
+            for i in 0..EVENTS_PER_BATCH {
+                run(batch * EVENTS_PER_BATCH + i);
+            }
+            start.elapsed().as_nanos() as f64 / EVENTS_PER_BATCH as f64
+        })
+        .collect();
+    per_event_ns.sort_by(|a, b| a.partial_cmp(b).unwrap());
+    println!(
+        "{:<36} time: [{:>8.2} ns {:>8.2} ns {:>8.2} ns]",
+        name,
+        per_event_ns[0],
+        per_event_ns[BATCHES / 2],
+        per_event_ns[BATCHES - 1]
+    );
+}
+
+fn main() {
+    for &(max_samples, window_ms) in &[(10usize, 16u32), (64, 16), (256, 33)] {
+        let mut ring = VelocityTracker::new(max_samples, window_ms);
+        bench(&format!("ring/{}samples/{}ms", max_samples, window_ms), |i| {
+            let (t, dx, dy) = stream(i);
+            ring.add_sample(t, dx, dy);
+            black_box(ring.predict());
+        });
+
+        let mut vec = VecTracker::new(max_samples);
+        bench(&format!("vec_shift/{}samples/{}ms", max_samples, window_ms), |i| {
+            let (t, dx, dy) = stream(i);
+            vec.add_sample(t, dx, dy);
+            black_box(vec.predict(window_ms));
+        });
+    }
+}
@@ -24,71 +24,135 @@ pub struct PredictionParams {
     pub velocity_decay: c_double,
 }
 
+/// Velocity of one sample interval: change in delta over elapsed time
+#[derive(Clone, Copy, Default)]
+struct Interval {
+    start: f64,
+    vx: f64,
+    vy: f64,
+}
+
+/// Running sums are recomputed from the ring this often to cancel drift
+const RESYNC_INTERVAL: u32 = 1024;
+
 /// Velocity tracker for motion prediction
+///
+/// Keeps the interval velocities of the most recent samples in a
+/// fixed-capacity ring with running sums, so insertion and prediction are
+/// both O(1). Intervals starting before the prediction window are evicted
+/// as newer samples arrive; timestamps are expected to be monotonic.
+///
+/// input/velocity_predictor.c is a C port of this type and must stay
+/// numerically identical.
 pub struct VelocityTracker {
-    samples: Vec<(f64, f64, f64)>, // (timestamp, dx, dy)
-    max_samples: usize,
+    intervals: Vec<Interval>,
+    head: usize,
+    len: usize,
+    sum_vx: f64,
+    sum_vy: f64,
+    last: Option<(f64, f64, f64)>, // (timestamp, dx, dy)
+    window_s: f64,
+    pushes_since_resync: u32,
 }
 
 impl VelocityTracker {
-    pub fn new(max_samples: usize) -> Self {
+    /// Track up to `max_samples` samples (`max_samples - 1` intervals)
+    pub fn new(max_samples: usize, window_ms: u32) -> Self {
+        let capacity = max_samples.max(2) - 1;
         Self {
-            samples: Vec::with_capacity(max_samples),
-            max_samples,
+            intervals: vec![Interval::default(); capacity],
+            head: 0,
+            len: 0,
+            sum_vx: 0.0,
+            sum_vy: 0.0,
+            last: None,
+            window_s: window_ms as f64 / 1000.0,
+            pushes_since_resync: 0,
         }
     }
 
     pub fn add_sample(&mut self, timestamp: f64, dx: f64, dy: f64) {
-        self.samples.push((timestamp, dx, dy));
-        if self.samples.len() > self.max_samples {
-            self.samples.remove(0);
+        if let Some((t1, x1, y1)) = self.last {
+            let dt = timestamp - t1;
+            if dt > 0.0 {
+                self.push(Interval {
+                    start: t1,
+                    vx: (dx - x1) / dt,
+                    vy: (dy - y1) / dt,
+                });
+            }
+        }
+        self.last = Some((timestamp, dx, dy));
+
+        // Evict intervals that start before the prediction window
+        let cutoff = timestamp - self.window_s;
+        while self.len > 0 && self.intervals[self.head].start < cutoff {
+            self.pop_front();
         }
     }
 
-    pub fn predict(&self, prediction_window_ms: u32) -> (f64, f64) {
-        if self.samples.len() < 2 {
+    pub fn predict(&self) -> (f64, f64) {
+        if self.len == 0 {
             return (0.0, 0.0);
         }
 
-        // Calculate velocity from recent samples
-        let window_ms = prediction_window_ms as f64;
-        let now = self.samples.last().unwrap().0;
-        let cutoff = now - (window_ms / 1000.0);
+        // Average velocity over the intervals in the window, projected ahead
+        let n = self.len as f64;
+        (
+            self.sum_vx / n * self.window_s,
+            self.sum_vy / n * self.window_s,
+        )
+    }
 
-        let mut total_dx = 0.0;
-        let mut total_dy = 0.0;
-        let mut total_dt = 0.0;
+    pub fn clear(&mut self) {
+        self.head = 0;
+        self.len = 0;
+        self.sum_vx = 0.0;
+        self.sum_vy = 0.0;
+        self.last = None;
+        self.pushes_since_resync = 0;
+    }
 
-        for i in 1..self.samples.len() {
-            let (t1, x1, y1) = self.samples[i - 1];
-            let (t2, x2, y2) = self.samples[i];
+    fn push(&mut self, interval: Interval) {
+        let capacity = self.intervals.len();
+        if self.len == capacity {
+            self.pop_front();
+        }
 
-            if t1 < cutoff {
-                continue;
-            }
+        self.intervals[(self.head + self.len) % capacity] = interval;
+        self.len += 1;
+        self.sum_vx += interval.vx;
+        self.sum_vy += interval.vy;
 
-            let dt = t2 - t1;
-            if dt > 0.0 {
-                total_dx += (x2 - x1) / dt;
-                total_dy += (y2 - y1) / dt;
-                total_dt += dt;
-            }
+        self.pushes_since_resync += 1;
+        if self.pushes_since_resync >= RESYNC_INTERVAL {
+            self.resync();
         }
+    }
 
-        if total_dt > 0.0 {
-            let avg_vx = total_dx / (self.samples.len() - 1) as f64;
-            let avg_vy = total_dy / (self.samples.len() - 1) as f64;
-
-            // Predict future position
-            let prediction_dt = window_ms / 1000.0;
-            (avg_vx * prediction_dt, avg_vy * prediction_dt)
+    fn pop_front(&mut self) {
+        let interval = self.intervals[self.head];
+        self.head = (self.head + 1) % self.intervals.len();
+        self.len -= 1;
+        if self.len == 0 {
+            self.sum_vx = 0.0;
+            self.sum_vy = 0.0;
         } else {
-            (0.0, 0.0)
+            self.sum_vx -= interval.vx;
+            self.sum_vy -= interval.vy;
         }
     }
 
-    pub fn clear(&mut self) {
-        self.samples.clear();
+    fn resync(&mut self) {
+        let capacity = self.intervals.len();
+        self.sum_vx = 0.0;
+        self.sum_vy = 0.0;
+        for i in 0..self.len {
+            let interval = self.intervals[(self.head + i) % capacity];
+            self.sum_vx += interval.vx;
+            self.sum_vy += interval.vy;
+        }
+        self.pushes_since_resync = 0;
     }
 }
 
@@ -96,15 +160,13 @@ impl VelocityTracker {
 pub struct InputPredictor {
     pointer_tracker: VelocityTracker,
     scroll_tracker: VelocityTracker,
-    params: PredictionParams,
 }
 
 impl InputPredictor {
     pub fn new(params: PredictionParams) -> Self {
         Self {
-            pointer_tracker: VelocityTracker::new(10),
-            scroll_tracker: VelocityTracker::new(10),
-            params,
+            pointer_tracker: VelocityTracker::new(10, params.window_ms),
+            scroll_tracker: VelocityTracker::new(10, params.window_ms),
         }
     }
 
@@ -115,7 +177,7 @@ impl InputPredictor {
         dy: f64,
     ) -> (f64, f64) {
         self.pointer_tracker.add_sample(timestamp, dx, dy);
-        self.pointer_tracker.predict(self.params.window_ms)
+        self.pointer_tracker.predict()
     }
 
     pub fn predict_scroll(
@@ -125,7 +187,7 @@ impl InputPredictor {
         dy: f64,
     ) -> (f64, f64) {
         self.scroll_tracker.add_sample(timestamp, dx, dy);
-        self.scroll_tracker.predict(self.params.window_ms)
+        self.scroll_tracker.predict()
     }
 
     pub fn reset(&mut self) {
@@ -182,6 +244,54 @@ pub extern "C" fn rust_input_predictor_predict_pointer(
     0
 }
 
+/// Predict a burst of pointer samples in one call (SoA, microsecond timestamps)
+///
+/// Equivalent to calling `rust_input_predictor_predict_pointer` for each
+/// sample in order.
+#[no_mangle]
+pub extern "C" fn rust_input_predictor_predict_pointer_batch(
+    predictor: *mut InputPredictor,
+    timestamps_us: *const c_ulonglong,
+    dx: *const c_double,
+    dy: *const c_double,
+    count: size_t,
+    predicted_dx: *mut c_double,
+    predicted_dy: *mut c_double,
+) -> c_int {
+    if predictor.is_null() {
+        return -1;
+    }
+    if count == 0 {
+        return 0;
+    }
+    if timestamps_us.is_null()
+        || dx.is_null()
+        || dy.is_null()
+        || predicted_dx.is_null()
+        || predicted_dy.is_null()
+    {
+        return -1;
+    }
+
+    unsafe {
+        let predictor = &mut *predictor;
+        let timestamps_us = std::slice::from_raw_parts(timestamps_us, count);
+        let dx = std::slice::from_raw_parts(dx, count);
+        let dy = std::slice::from_raw_parts(dy, count);
+        let predicted_dx = std::slice::from_raw_parts_mut(predicted_dx, count);
+        let predicted_dy = std::slice::from_raw_parts_mut(predicted_dy, count);
+
+        for i in 0..count {
+            let timestamp = timestamps_us[i] as f64 / 1_000_000.0;
+            let (pdx, pdy) = predictor.predict_pointer_motion(timestamp, dx[i], dy[i]);
+            predicted_dx[i] = pdx;
+            predicted_dy[i] = pdy;
+        }
+    }
+
+    0
+}
+
 #[no_mangle]
 pub extern "C" fn rust_input_predictor_predict_scroll(
     predictor: *mut InputPredictor,
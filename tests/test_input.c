@@ -1,7 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "../input/input.h"
+#include "../input/rust_predictor.h"
+#include "../input/input_queue.h"
+#include "../input/input_resampler.h"
+#include "../input/input_trace.h"
+#include "../core/utils.h"
 
 /* Test input proxy creation */
 void test_input_proxy_create(void) {
@@ -72,12 +82,1223 @@ void test_input_event_processing(void) {
     printf("✓ test_input_event_processing passed\n");
 }
 
+/* Test allocation-free processing into caller storage */
+void test_input_process_into(void) {
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(true, 16, true, &proxy) == 0);
+    
+    /* Acks are checked against the proxy clock, on the events' time base */
+    struct utils_clock clock;
+    utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 1000);
+    input_proxy_set_clock(proxy, &clock);
+    
+    struct input_event event = {
+        .type = INPUT_EVENT_POINTER_MOTION,
+        .timestamp_us = 1000,
+        .pointer_motion = { .dx = 10.0, .dy = -4.0, .absolute = false }
+    };
+    struct input_event out;
+    memset(&out, 0, sizeof(out));
+    assert(input_proxy_process_into(proxy, &event, &out) == 1);
+    assert(out.type == INPUT_EVENT_POINTER_MOTION);
+    assert(out.timestamp_us > event.timestamp_us);  /* Stamped one window ahead */
+    
+    /* Buttons produce nothing */
+    struct input_event button = {
+        .type = INPUT_EVENT_POINTER_BUTTON,
+        .pointer_button = { .button = 272, .pressed = true }
+    };
+    assert(input_proxy_process_into(proxy, &button, &out) == 0);
+    
+    /* Far more predictions than the tracking ring holds, acks never arrive */
+    for (int i = 0; i < 5000; i++) {
+        assert(input_proxy_process_into(proxy, &event, NULL) == 1);
+    }
+    
+    prediction_state_t state;
+    assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+    assert(state.events_predicted == 5001);
+    assert(state.pending_overflows == 5001 - INPUT_PROXY_PENDING_CAPACITY);
+    
+    /* Frame 1 was overwritten: late ack. Frame 5001 is still tracked */
+    assert(input_proxy_reconcile(proxy, 1, NULL) == 0);
+    assert(input_proxy_reconcile(proxy, 5001, NULL) == 0);
+    assert(input_proxy_reconcile(proxy, 5001, NULL) == 0);  /* Duplicate: ignored */
+    assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+    assert(state.late_acks == 1);
+    assert(state.events_reconciled == 3);
+    
+    input_proxy_destroy(proxy);
+    
+    printf("✓ test_input_process_into passed\n");
+}
+
+/* Test adaptive motion predictor and its error feedback */
+void test_motion_predictor(void) {
+    struct motion_predictor *mp = NULL;
+    assert(motion_predictor_create(16, &mp) == 0);
+    
+    /* Constant velocity (1000 px/s at 125 Hz): predicts the same delta */
+    double pdx = 0.0, pdy = 0.0;
+    for (int i = 0; i < 50; i++) {
+        assert(motion_predictor_predict(mp, 1000000 + (uint64_t)i * 8000, 8.0, 0.0, &pdx, &pdy) == 0);
+    }
+    assert(fabs(pdx - 8.0) < 0.01);
+    assert(fabs(pdy) < 0.01);
+    
+    /* Accelerating: leads the measurement */
+    double dx = 8.0;
+    for (int i = 50; i < 60; i++) {
+        dx += 1.0;
+        assert(motion_predictor_predict(mp, 1000000 + (uint64_t)i * 8000, dx, 0.0, &pdx, &pdy) == 0);
+    }
+    assert(pdx > dx);
+    
+    /* Consistent overshoot shrinks the effective horizon */
+    struct motion_predictor_stats stats;
+    motion_predictor_get_stats(mp, &stats);
+    assert(stats.corrections == 0);
+    assert(stats.effective_window_ms == 16.0);
+    for (int i = 0; i < 20; i++) {
+        motion_predictor_correct(mp, 2.0, 0.0, 1.0, 0.0);
+    }
+    motion_predictor_get_stats(mp, &stats);
+    assert(stats.corrections == 20);
+    assert(stats.effective_window_ms < 16.0);
+    assert(fabs(stats.error_mean - 1.0) < 1e-9);
+    assert(stats.alpha > 0.0 && stats.alpha < 1.0);
+    
+    /* Large errors relative to the lead raise the filter gain */
+    double alpha = stats.alpha;
+    for (int i = 0; i < 20; i++) {
+        motion_predictor_correct(mp, 0.1, 0.0, -3.0, 0.0);
+    }
+    motion_predictor_get_stats(mp, &stats);
+    assert(stats.alpha > alpha);
+    assert(stats.effective_window_ms > 0.0);
+    
+    motion_predictor_destroy(mp);
+    
+    /* Through the proxy: reconciling with the actual event feeds the model */
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(true, 16, false, &proxy) == 0);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_ADAPTIVE) == 0);
+    struct utils_clock clock;
+    utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 0);
+    input_proxy_set_clock(proxy, &clock);
+    struct input_event event = {
+        .type = INPUT_EVENT_POINTER_MOTION,
+        .pointer_motion = { .dx = 4.0, .dy = 0.0, .absolute = false }
+    };
+    for (int i = 1; i <= 3; i++) {
+        event.timestamp_us = (uint64_t)i * 8000;
+        assert(input_proxy_process_into(proxy, &event, NULL) == 1);
+    }
+    struct input_event actual = event;
+    actual.pointer_motion.dx = 6.0;
+    utils_clock_set(&clock, event.timestamp_us + 16000);  /* Presented one window later */
+    assert(input_proxy_reconcile(proxy, 3, &actual) == 0);
+    
+    prediction_state_t state;
+    assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+    assert(state.corrections == 3);  /* Frames 1 and 2 were scored against the motion that followed */
+    assert(state.mispredictions == 1);
+    assert(state.error_mean > 0.0 && state.error_rms > state.error_mean);
+    input_proxy_destroy(proxy);
+    
+    printf("✓ test_motion_predictor passed\n");
+}
+
+/* Test scoring predictions against the motion that follows, as production reconciles */
+void test_prediction_scoring(void) {
+    static const input_predictor_backend_t backends[] = {
+        INPUT_PREDICTOR_VELOCITY,
+        INPUT_PREDICTOR_ADAPTIVE,
+    };
+    
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+        struct input_proxy *proxy = NULL;
+        assert(input_proxy_create(true, 16, false, &proxy) == 0);
+        assert(input_proxy_set_predictor(proxy, backends[b]) == 0);
+        struct utils_clock clock;
+        utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 0);
+        input_proxy_set_clock(proxy, &clock);
+        
+        /* Steady motion, acknowledged without an actual event */
+        struct input_event event = {
+            .type = INPUT_EVENT_POINTER_MOTION,
+            .pointer_motion = { .dx = 4.0, .dy = 0.0, .absolute = false }
+        };
+        for (int i = 1; i <= 20; i++) {
+            event.timestamp_us = (uint64_t)i * 8000;
+            utils_clock_set(&clock, event.timestamp_us);
+            assert(input_proxy_process_into(proxy, &event, NULL) == 1);
+            assert(input_proxy_reconcile(proxy, (uint64_t)i, NULL) == 0);
+        }
+        
+        prediction_state_t state;
+        assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+        assert(state.corrections == 18);  /* Targets of the last two are still ahead */
+        assert(state.mispredictions == 0);
+        uint32_t mispredictions = state.mispredictions;
+        
+        /* The pointer reverses; the lead keeps the old trend for a while */
+        event.pointer_motion.dx = -4.0;
+        for (int i = 21; i <= 23; i++) {
+            event.timestamp_us = (uint64_t)i * 8000;
+            utils_clock_set(&clock, event.timestamp_us);
+            assert(input_proxy_process_into(proxy, &event, NULL) == 1);
+            assert(input_proxy_reconcile(proxy, (uint64_t)i, NULL) == 0);
+        }
+        
+        /* The pointer stops; a frame past the last targets scores them */
+        struct input_event out;
+        assert(input_proxy_frame(proxy, event.timestamp_us + 32000, &out) == 0);
+        assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+        assert(state.corrections == 23);
+        assert(state.mispredictions > mispredictions);
+        assert(state.error_mean > 0.0);
+        assert(state.error_rms >= state.error_mean);
+        
+        /* A velocity lead is a displacement, withdrawn once the pointer stops */
+        struct input_event correction;
+        if (backends[b] == INPUT_PREDICTOR_VELOCITY) {
+            assert(input_proxy_take_correction(proxy, &correction) == 1);
+            assert(correction.type == INPUT_EVENT_POINTER_MOTION);
+            assert(fabs(correction.pointer_motion.dx - 8.0) < 1e-6);  /* 0.5 units/ms over 16 ms */
+        }
+        assert(input_proxy_take_correction(proxy, &correction) == 0);
+        input_proxy_destroy(proxy);
+    }
+    
+    printf("✓ test_prediction_scoring passed\n");
+}
+
+/* Test C velocity predictor against outputs of the Rust VelocityTracker */
+void test_velocity_predictor(void) {
+    /* Produced by rust/input_predictor for the input sequence below */
+    static const double expected[][2] = {
+        { 0e0, 0e0 },
+        { 1.1000000000001211e1, 8.400000000000926e0 },
+        { 6.500000000000716e0, 1.8000000000001983e0 },
+        { 5.000000000000255e0, 3.9999999999991975e0 },
+        { 4.250000000000247e0, 1.7999999999992655e0 },
+        { -2.500000000002492e-1, -1.5000000000010978e0 },
+        { 1.9999999999999987e0, 1.7999999999992655e0 },
+        { 1.9999999999999987e0, -1.499999999999632e0 },
+        { 1.9999999999999987e0, -1.499999999999632e0 },
+        { 4.250000000000247e0, 1.8000000000007308e0 },
+        { -2.500000000002492e-1, -1.4999999999996323e0 },
+        { 1.9999999999989992e0, -1.4999999999996325e0 },
+        { 1.9999999999989992e0, 1.800000000000731e0 },
+        { 0e0, 0e0 },
+        { 0e0, 0e0 },
+        { -6.999999999997662e0, -4.7999999999983975e0 },
+        { 2.0000000000017746e0, -4.7999999999994625e0 },
+        { 2.0000000000012563e0, -3.999999999993336e-1 },
+        { 2.0000000000009974e0, -1.499999999999632e0 },
+        { 4.250000000000246e0, -1.499999999999632e0 },
+        { -2.5000000000025013e-1, 1.8000000000007308e0 },
+        { 1.9999999999999978e0, -1.4999999999996323e0 },
+        { 1.9999999999999978e0, -1.4999999999996325e0 },
+        { 1.9999999999999978e0, 1.7999999999992653e0 },
+    };
+    
+    rust_input_predictor_t *vp = velocity_predictor_create(16, 0.7, 0.9);
+    assert(vp != NULL);
+    
+    /* Irregular deltas, a gap at i == 13 that empties the window, ring wraparound */
+    for (unsigned i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        double t = 10.0 + (double)i * 0.004 + (i == 13 ? 0.05 : 0.0);
+        double dx = 3.0 + (double)i * 0.5 - (i % 5 == 0 ? 2.25 : 0.0);
+        double dy = -1.0 + (double)((i * 7) % 11) * 0.3;
+        double pdx, pdy;
+        assert(velocity_predictor_predict_pointer(vp, t, dx, dy, &pdx, &pdy) == 0);
+        assert(pdx == expected[i][0]);
+        assert(pdy == expected[i][1]);
+    }
+    
+    velocity_predictor_destroy(vp);
+    
+    /* Long 8 kHz stream: window eviction and running-sum resyncs stay in step */
+    vp = velocity_predictor_create(16, 0.7, 0.9);
+    assert(vp != NULL);
+    double sum_x = 0.0, sum_y = 0.0, pdx = 0.0, pdy = 0.0;
+    for (unsigned i = 0; i < 5000; i++) {
+        double t = (double)i * 0.000125;
+        assert(velocity_predictor_predict_pointer(vp, t, sin(t * 7.0) * 3.0, cos(t * 5.0) * 2.0,
+                                                  &pdx, &pdy) == 0);
+        sum_x += pdx;
+        sum_y += pdy;
+    }
+    assert(pdx == -1.127484527089437e-1 && pdy == -3.204606054134226e-3);
+    assert(sum_x == -3.6044641405899773e2 && sum_y == -5.119505704195532e2);
+    
+    assert(velocity_predictor_reset(vp) == 0);
+    assert(velocity_predictor_predict_pointer(vp, 20.0, 1.0, 1.0, &pdx, &pdy) == 0);
+    assert(pdx == 0.0 && pdy == 0.0);
+    velocity_predictor_destroy(vp);
+    
+    /* Backend selection: C-only builds resolve AUTO to the C port */
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(true, 16, false, &proxy) == 0);
+    input_predictor_backend_t backend = input_proxy_get_predictor(proxy);
+    assert(backend == INPUT_PREDICTOR_RUST || backend == INPUT_PREDICTOR_VELOCITY);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_ADAPTIVE) == 0);
+    assert(input_proxy_get_predictor(proxy) == INPUT_PREDICTOR_ADAPTIVE);
+    rust_input_predictor_t *rust = rust_input_predictor_create(16, 0.7, 0.9);
+    if (!rust) {
+        assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_RUST) == -1);
+        assert(input_proxy_get_predictor(proxy) == INPUT_PREDICTOR_ADAPTIVE);
+    }
+    rust_input_predictor_destroy(rust);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_VELOCITY) == 0);
+    input_proxy_destroy(proxy);
+    
+    printf("✓ test_velocity_predictor passed\n");
+}
+
+/* Feed a touchpad scroll gesture and return the total dy forwarded, including the stop */
+static double scroll_gesture(struct input_proxy *proxy, uint64_t start_us, int events, double dy) {
+    struct input_event event = {.type = INPUT_EVENT_SCROLL};
+    struct input_event out;
+    double total = 0.0;
+    
+    for (int i = 0; i <= events; i++) {
+        event.timestamp_us = start_us + (uint64_t)i * 8000;
+        event.scroll.dy = i < events ? dy : 0.0;  /* Zero delta = fingers lifted */
+        int ret = input_proxy_process_into(proxy, &event, &out);
+        assert(ret >= 0);
+        total += ret > 0 ? out.scroll.dy : event.scroll.dy;
+    }
+    return total;
+}
+
+/* Test touchpad scroll prediction and rollback */
+void test_scroll_prediction(void) {
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(false, 16, false, &proxy) == 0);
+    assert(input_proxy_set_scroll_prediction(proxy, true) == -1);
+    input_proxy_destroy(proxy);
+    
+    assert(input_proxy_create(true, 16, false, &proxy) == 0);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_VELOCITY) == 0);
+    struct utils_clock clock;
+    utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 0);
+    input_proxy_set_clock(proxy, &clock);
+    
+    /* Off by default: scroll passes through untouched */
+    struct input_event event = {
+        .type = INPUT_EVENT_SCROLL,
+        .timestamp_us = 1000000,
+        .scroll = {.dy = 10.0},
+    };
+    struct input_event out;
+    assert(input_proxy_process_into(proxy, &event, &out) == 0);
+    
+    assert(input_proxy_set_scroll_prediction(proxy, true) == 0);
+    
+    /* 1250 units/s over a 16 ms window leads by 20; the lead is applied once */
+    double leads[] = {0.0, 20.0, 20.0, 20.0};
+    double shown = 0.0;
+    for (int i = 0; i < 4; i++) {
+        event.timestamp_us = 2000000 + (uint64_t)i * 8000;
+        assert(input_proxy_process_into(proxy, &event, &out) == 1);
+        assert(out.timestamp_us > event.timestamp_us);
+        shown += out.scroll.dy;
+        assert(fabs(shown - (10.0 * (i + 1) + leads[i])) < 1e-6);
+    }
+    
+    /* Lifting the fingers withdraws the outstanding lead */
+    event.timestamp_us += 8000;
+    event.scroll.dy = 0.0;
+    assert(input_proxy_process_into(proxy, &event, &out) == 1);
+    assert(fabs(out.scroll.dy + 20.0) < 1e-6);
+    
+    /* Mispredicted frame: the shown lead is rolled back once */
+    event.scroll.dy = 10.0;
+    event.timestamp_us = 3000000;
+    assert(input_proxy_process_into(proxy, &event, &out) == 1);
+    event.timestamp_us += 8000;
+    assert(input_proxy_process_into(proxy, &event, &out) == 1);
+    assert(fabs(out.scroll.dy - 30.0) < 1e-6);
+    
+    struct input_event correction;
+    assert(input_proxy_take_correction(proxy, &correction) == 0);
+    struct input_event actual = {.type = INPUT_EVENT_SCROLL, .scroll = {.dy = 10.0}};
+    utils_clock_set(&clock, event.timestamp_us + 16000);
+    assert(input_proxy_reconcile(proxy, 6, &actual) == 0);  /* Frames 1-4, then 5 and 6 */
+    assert(input_proxy_take_correction(proxy, &correction) == 1);
+    assert(correction.type == INPUT_EVENT_SCROLL);
+    assert(correction.timestamp_us == event.timestamp_us + 16000);
+    assert(fabs(correction.scroll.dy + 20.0) < 1e-6);
+    assert(input_proxy_take_correction(proxy, &correction) == 0);
+    
+    /* Nothing left to withdraw at the stop */
+    event.timestamp_us += 8000;
+    event.scroll.dy = 0.0;
+    assert(input_proxy_process_into(proxy, &event, &out) == 0);
+    
+    prediction_state_t state;
+    assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+    assert(state.scroll_enabled);
+    assert(state.scroll_predicted == 6);
+    assert(state.scroll_rollbacks == 1);
+    assert(state.mispredictions == 1);
+    
+    /* Every backend forwards exactly the real scroll once the gesture ends */
+    assert(fabs(scroll_gesture(proxy, 4000000, 20, 7.5) - 150.0) < 1e-6);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_ADAPTIVE) == 0);
+    assert(fabs(scroll_gesture(proxy, 5000000, 20, 7.5) - 150.0) < 1e-6);
+    
+    input_proxy_destroy(proxy);
+    
+    /* Acknowledged without actual events: a stall seen after the lead rolls it back */
+    assert(input_proxy_create(true, 16, false, &proxy) == 0);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_VELOCITY) == 0);
+    input_proxy_set_clock(proxy, &clock);
+    assert(input_proxy_set_scroll_prediction(proxy, true) == 0);
+    event.scroll.dy = 10.0;
+    for (int i = 0; i < 4; i++) {
+        event.timestamp_us = 6000000 + (uint64_t)i * 8000;
+        utils_clock_set(&clock, event.timestamp_us);
+        assert(input_proxy_process_into(proxy, &event, &out) == 1);
+        assert(input_proxy_reconcile(proxy, (uint64_t)i + 1, NULL) == 0);
+        assert(input_proxy_take_correction(proxy, &correction) == 0);
+    }
+    utils_clock_set(&clock, event.timestamp_us + 24000);
+    assert(input_proxy_frame(proxy, event.timestamp_us + 24000, &out) == 0);
+    assert(input_proxy_take_correction(proxy, &correction) == 1);
+    assert(fabs(correction.scroll.dy + 20.0) < 1e-6);
+    assert(input_proxy_get_prediction_state(proxy, &state) == 0);
+    assert(state.scroll_rollbacks == 1);
+    assert(state.mispredictions == 1);
+    assert(state.corrections == 4);
+    input_proxy_destroy(proxy);
+    
+    printf("✓ test_scroll_prediction passed\n");
+}
+
+/* Fling 2000 units/s down from a touchpad and return the distance emitted at frame_us steps */
+static double kinetic_fling(struct scroll_state *smoother, uint64_t frame_us, int *frames_out) {
+    double sdx, sdy;
+    for (int i = 0; i < 6; i++) {
+        assert(scroll_smoother_process_at(smoother, 1000000 + (uint64_t)i * 10000,
+                                          0.0, 20.0, false, &sdx, &sdy) == 0);
+    }
+    assert(scroll_smoother_release(smoother, 1055000) == 1);
+    
+    double total = 0.0, previous = INFINITY;
+    int frames = 0;
+    double dx, dy;
+    for (uint64_t t = 1055000 + frame_us; scroll_smoother_frame(smoother, t, &dx, &dy) == 1; t += frame_us) {
+        assert(dx == 0.0 && dy > 0.0 && dy < previous);
+        previous = dy;
+        total += dy;
+        frames++;
+    }
+    assert(!scroll_smoother_is_flinging(smoother));
+    *frames_out = frames;
+    return total;
+}
+
+/* Test time-based kinetic scrolling */
+void test_kinetic_scroll(void) {
+    struct scroll_state *smoother = NULL;
+    assert(scroll_smoother_create(&smoother) == 0);
+    
+    struct scroll_kinetic_config config;
+    scroll_smoother_kinetic_defaults(&config);
+    struct scroll_kinetic_config endless = {.friction = 0.0, .deceleration = 0.0};
+    assert(scroll_smoother_set_kinetic(smoother, &endless) == -1);
+    
+    /* Disabled: lifting the fingers stops dead */
+    double sdx, sdy;
+    assert(scroll_smoother_process_at(smoother, 500000, 0.0, 20.0, false, &sdx, &sdy) == 0);
+    assert(scroll_smoother_process_at(smoother, 510000, 0.0, 20.0, false, &sdx, &sdy) == 0);
+    assert(scroll_smoother_release(smoother, 510000) == 0);
+    
+    /* Distance follows the closed-form curve, whatever the frame rate */
+    assert(scroll_smoother_set_kinetic(smoother, &config) == 0);
+    double c = config.deceleration / config.friction;
+    double duration = log((2000.0 + c) / (config.stop_velocity + c)) / config.friction;
+    double expected = (2000.0 + c) * (1.0 - exp(-config.friction * duration)) / config.friction -
+                      c * duration;
+    int frames_60, frames_144;
+    double total_60 = kinetic_fling(smoother, 16667, &frames_60);
+    double total_144 = kinetic_fling(smoother, 6944, &frames_144);
+    assert(fabs(total_60 - expected) < 1e-6);
+    assert(fabs(total_144 - expected) < 1e-6);
+    assert(frames_144 > 2 * frames_60);
+    
+    /* Fingers resting before the lift, or new input, end the fling */
+    assert(scroll_smoother_process_at(smoother, 2000000, 0.0, 20.0, false, &sdx, &sdy) == 0);
+    assert(scroll_smoother_process_at(smoother, 2010000, 0.0, 20.0, false, &sdx, &sdy) == 0);
+    assert(scroll_smoother_release(smoother, 2100000) == 0);
+    assert(scroll_smoother_process_at(smoother, 3000000, 0.0, 20.0, false, &sdx, &sdy) == 0);
+    assert(scroll_smoother_process_at(smoother, 3010000, 0.0, 20.0, false, &sdx, &sdy) == 0);
+    assert(scroll_smoother_release(smoother, 3010000) == 1);
+    scroll_smoother_cancel(smoother);
+    double dx, dy;
+    assert(scroll_smoother_frame(smoother, 3020000, &dx, &dy) == 0);
+    scroll_smoother_destroy(smoother);
+    
+    /* Through the proxy: a lift starts the fling, a key press stops it */
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(true, 16, true, &proxy) == 0);
+    assert(input_proxy_set_kinetic_scroll(proxy, &config) == 0);
+    struct input_event event = {.type = INPUT_EVENT_SCROLL};
+    struct input_event out;
+    for (int i = 0; i <= 4; i++) {
+        event.timestamp_us = 1000000 + (uint64_t)i * 8000;
+        event.scroll.dy = i < 4 ? 15.0 : 0.0;
+        assert(input_proxy_process_into(proxy, &event, &out) == 1);
+    }
+    assert(input_proxy_frame(proxy, 1040000, &out) == 1);
+    assert(out.type == INPUT_EVENT_SCROLL && out.scroll.dy > 0.0);
+    assert(out.timestamp_us == 1040000);
+    struct input_event key = {
+        .type = INPUT_EVENT_KEY,
+        .timestamp_us = 1041000,
+        .key = {.key = 30, .pressed = true},
+    };
+    assert(input_proxy_process_into(proxy, &key, &out) == 0);
+    assert(input_proxy_frame(proxy, 1056000, &out) == 0);
+    input_proxy_destroy(proxy);
+    
+    assert(input_proxy_create(true, 16, false, &proxy) == 0);
+    assert(input_proxy_set_kinetic_scroll(proxy, &config) == -1);  /* Needs the smoother */
+    input_proxy_destroy(proxy);
+    
+    printf("✓ test_kinetic_scroll passed\n");
+}
+
+/* Test frame-aligned resampling */
+void test_input_resampler(void) {
+    struct input_resampler *resampler = NULL;
+    assert(input_resampler_create(60, &resampler) == 0);
+    
+    /* 1 kHz mouse, one unit per event */
+    struct input_event motion = {
+        .type = INPUT_EVENT_POINTER_MOTION,
+        .pointer_motion = {.dx = 1.0},
+    };
+    for (int i = 0; i <= 50; i++) {
+        motion.timestamp_us = 1000000 + (uint64_t)i * 1000;
+        assert(input_resampler_push(resampler, &motion) == 1);
+    }
+    
+    /* Sampled 5 ms behind the frame: interpolated between device events */
+    struct input_event out[INPUT_RESAMPLER_MAX_OUTPUT];
+    double total = 0.0;
+    assert(input_resampler_frame(resampler, 1020000, out) == 1);
+    assert(out[0].type == INPUT_EVENT_POINTER_MOTION);
+    assert(out[0].timestamp_us == 1015000);
+    assert(fabs(out[0].pointer_motion.dx - 16.0) < 1e-9);
+    total += out[0].pointer_motion.dx;
+    
+    assert(input_resampler_frame(resampler, 1025000, out) == 0);  /* Same frame period */
+    
+    assert(input_resampler_frame(resampler, 1036667, out) == 1);
+    assert(fabs(out[0].pointer_motion.dx - (1.0 + 31.667 - 16.0)) < 1e-9);
+    total += out[0].pointer_motion.dx;
+    
+    /* Once the device is quiet the stream settles on the exact total */
+    for (uint64_t t = 1053334; t < 1120000; t += 16667) {
+        int n = input_resampler_frame(resampler, t, out);
+        assert(n >= 0 && n <= 1);
+        if (n == 1) {
+            total += out[0].pointer_motion.dx;
+        }
+    }
+    assert(fabs(total - 51.0) < 1e-9);
+    
+    struct input_resampler_stats stats;
+    input_resampler_get_stats(resampler, &stats);
+    assert(stats.events_in == 51);
+    assert(stats.samples_out == 4);
+    
+    /* Not resampled: flushed ahead of them instead */
+    struct input_event scroll = {
+        .type = INPUT_EVENT_SCROLL,
+        .timestamp_us = 2000000,
+        .scroll = {.dy = 3.0},
+    };
+    assert(input_resampler_push(resampler, &scroll) == 1);
+    assert(input_resampler_push(resampler, &motion) == 1);
+    struct input_event other = scroll;
+    other.scroll.dy = 0.0;
+    assert(input_resampler_push(resampler, &other) == 0);
+    other.scroll.discrete = true;
+    other.scroll.dy = 1.0;
+    assert(input_resampler_push(resampler, &other) == 0);
+    other = motion;
+    other.pointer_motion.absolute = true;
+    assert(input_resampler_push(resampler, &other) == 0);
+    other.pointer_motion.absolute = false;
+    other.timestamp_us = 0;
+    assert(input_resampler_push(resampler, &other) == 0);
+    assert(input_resampler_flush(resampler, out) == 2);
+    assert(out[0].type == INPUT_EVENT_POINTER_MOTION && out[0].pointer_motion.dx == 1.0);
+    assert(out[1].type == INPUT_EVENT_SCROLL && out[1].scroll.dy == 3.0);
+    assert(input_resampler_flush(resampler, out) == 0);
+    input_resampler_destroy(resampler);
+    
+    /* Measured vsync: 125 Hz mouse on a 144 Hz display is extrapolated, nothing lost */
+    assert(input_resampler_create(0, &resampler) == 0);
+    total = 0.0;
+    int samples = 0;
+    uint64_t next_event = 1000000;
+    for (uint64_t t = 1000000; t < 1300000; t += 6944) {
+        while (next_event <= t && next_event < 1200000) {
+            motion.timestamp_us = next_event;
+            motion.pointer_motion.dx = 8.0;
+            assert(input_resampler_push(resampler, &motion) == 1);
+            next_event += 8000;
+        }
+        int n = input_resampler_frame(resampler, t, out);
+        assert(n >= 0 && n <= 1);
+        if (n == 1) {
+            total += out[0].pointer_motion.dx;
+            samples++;
+        }
+        /* Several surfaces presenting on the same vsync */
+        assert(input_resampler_frame(resampler, t + 100, out) == 0);
+    }
+    assert(fabs(total - 25 * 8.0) < 1e-9);
+    input_resampler_get_stats(resampler, &stats);
+    assert(fabs(stats.frame_interval_us - 6944.0) < 1.0);
+    assert(stats.samples_out == (uint64_t)samples);
+    input_resampler_destroy(resampler);
+    
+    printf("✓ test_input_resampler passed\n");
+}
+
+/* Replay untimed motion on a virtual clock; returns the predicted dx of the last event */
+static double clock_replay(struct utils_clock *clock, prediction_state_t *state_out) {
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(true, 16, false, &proxy) == 0);
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_ADAPTIVE) == 0);
+    input_proxy_set_clock(proxy, clock);
+    
+    struct input_event event = {.type = INPUT_EVENT_POINTER_MOTION};  /* No timestamp */
+    struct input_event out;
+    for (int i = 0; i < 40; i++) {
+        utils_clock_advance(clock, 8000);
+        event.pointer_motion.dx = 2.0 + 0.25 * i;
+        assert(input_proxy_process_into(proxy, &event, &out) == 1);
+        assert(out.timestamp_us == utils_clock_now_us(clock) + 16000);
+        if (i % 4 == 3) {
+            struct input_event actual = event;
+            actual.pointer_motion.dx += 0.5;
+            assert(input_proxy_reconcile(proxy, (uint64_t)i + 1, &actual) == 0);
+        }
+    }
+    
+    assert(input_proxy_get_prediction_state(proxy, state_out) == 0);
+    input_proxy_destroy(proxy);
+    return out.pointer_motion.dx;
+}
+
+struct clock_read {
+    struct utils_clock *clock;
+    uint64_t now_us;
+};
+
+static void *clock_reader(void *arg) {
+    struct clock_read *read = arg;
+    read->now_us = utils_clock_now_us(read->clock);
+    return NULL;
+}
+
+/* Test the clock provider and deterministic replay */
+void test_clock_provider(void) {
+    /* Virtual time only moves when told to */
+    struct utils_clock clock;
+    utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 5000);
+    assert(utils_clock_now_us(&clock) == 5000);
+    utils_clock_advance(&clock, 250);
+    assert(utils_clock_now_us(&clock) == 5250);
+    utils_clock_set(&clock, 9000);
+    assert(utils_clock_now_us(&clock) == 9000);
+    
+    /* One reading per loop iteration */
+    assert(utils_clock_begin_iteration(&clock) == 9000);
+    utils_clock_advance(&clock, 1000);
+    assert(utils_clock_now_us(&clock) == 9000);
+    
+    /* Only the bracketing thread is served the cached reading */
+    pthread_t reader;
+    struct clock_read read = { .clock = &clock };
+    assert(pthread_create(&reader, NULL, clock_reader, &read) == 0);
+    assert(pthread_join(reader, NULL) == 0);
+    assert(read.now_us == 10000);
+    utils_clock_end_iteration(&clock);
+    assert(utils_clock_now_us(&clock) == 10000);
+    
+    struct utils_clock mono;
+    utils_clock_init(&mono, UTILS_CLOCK_MONOTONIC, 0);
+    utils_clock_set(&mono, 1);  /* Ignored */
+    uint64_t cached = utils_clock_begin_iteration(&mono);
+    assert(cached > 1);
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 2000000L };
+    nanosleep(&pause, NULL);
+    assert(utils_clock_now_us(&mono) == cached);
+    utils_clock_end_iteration(&mono);
+    assert(utils_clock_now_us(&mono) >= cached + 2000);
+    assert(utils_clock_now_us(NULL) >= cached + 2000);
+    
+    /* The default (NULL) clock is cached the same way */
+    cached = utils_clock_begin_iteration(NULL);
+    nanosleep(&pause, NULL);
+    assert(utils_clock_now_us(NULL) == cached);
+    assert(utils_clock_now_us(&mono) >= cached + 2000);  /* Another clock reads live */
+    utils_clock_end_iteration(NULL);
+    assert(utils_clock_now_us(NULL) >= cached + 2000);
+    
+    /* Same input on the same virtual timeline: bit-identical predictions */
+    struct utils_clock first, second;
+    utils_clock_init(&first, UTILS_CLOCK_VIRTUAL, 1000000);
+    utils_clock_init(&second, UTILS_CLOCK_VIRTUAL, 1000000);
+    prediction_state_t a, b;
+    double dx_a = clock_replay(&first, &a);
+    double dx_b = clock_replay(&second, &b);
+    assert(dx_a == dx_b);
+    assert(a.events_reconciled == 10 && b.events_reconciled == 10);
+    assert(a.late_acks == 0);
+    assert(a.error_mean == b.error_mean && a.error_rms == b.error_rms);
+    assert(a.last_prediction_us == 1000000 + 40 * 8000);
+    
+    /* Scroll smoothing replays from the event times alone */
+    struct scroll_state *s1 = NULL, *s2 = NULL;
+    assert(scroll_smoother_create(&s1) == 0);
+    struct timespec later = { .tv_sec = 0, .tv_nsec = 3000000L };
+    nanosleep(&later, NULL);
+    assert(scroll_smoother_create(&s2) == 0);
+    for (int i = 0; i < 10; i++) {
+        double dx1, dy1, dx2, dy2;
+        uint64_t t = 2000000 + (uint64_t)i * 8000;
+        assert(scroll_smoother_process_at(s1, t, 0.0, 5.0 + i, false, &dx1, &dy1) == 0);
+        assert(scroll_smoother_process_at(s2, t, 0.0, 5.0 + i, false, &dx2, &dy2) == 0);
+        assert(dx1 == dx2 && dy1 == dy2);
+    }
+    scroll_smoother_destroy(s1);
+    scroll_smoother_destroy(s2);
+    
+    printf("✓ test_clock_provider passed\n");
+}
+
+/* Test input trace round trip and replay */
+void test_input_trace(void) {
+    const char *path = "/tmp/lt_test_input.trace";
+    unlink(path);
+    
+    struct input_event events[] = {
+        {.type = INPUT_EVENT_POINTER_MOTION, .timestamp_us = 1000000,
+         .pointer_motion = {.dx = 1.5, .dy = -2.25}},
+        {.type = INPUT_EVENT_POINTER_MOTION, .timestamp_us = 1001000,
+         .pointer_motion = {.absolute = true, .x = 640.5, .y = 480.0}},
+        {.type = INPUT_EVENT_POINTER_BUTTON, .timestamp_us = 1002000,
+         .pointer_button = {.button = 272, .pressed = true}},
+        {.type = INPUT_EVENT_SCROLL, .timestamp_us = 1003000,
+         .scroll = {.dx = 0.0, .dy = 15.0, .discrete = true, .discrete_dy = 1}},
+        {.type = INPUT_EVENT_KEY, .timestamp_us = 1004000, .key = {.key = 30, .pressed = false}},
+        {.type = INPUT_EVENT_TOUCH, .timestamp_us = 1005000,
+         .touch = {.touch_id = 3, .x = 10.0, .y = 20.0, .pressed = true}},
+    };
+    size_t n = sizeof(events) / sizeof(events[0]);
+    
+    struct input_trace_writer *writer = NULL;
+    assert(input_trace_writer_open(path, &writer) == 0);
+    for (size_t i = 0; i < n; i++) {
+        assert(input_trace_write_event(writer, &events[i]) == 0);
+    }
+    assert(input_trace_write_ack(writer, 42, 1006000) == 0);
+    assert(input_trace_write_frame(writer, 1007000) == 0);
+    assert(input_trace_write_vblank(writer, 1008000, 16667) == 0);
+    assert(input_trace_writer_count(writer) == n + 3);
+    assert(input_trace_writer_close(writer) == 0);
+    
+    struct input_trace_reader *reader = NULL;
+    struct input_trace_record record;
+    assert(input_trace_reader_open(path, &reader) == 0);
+    for (size_t i = 0; i < n; i++) {
+        assert(input_trace_read(reader, &record) == 1);
+        assert(record.kind == INPUT_TRACE_EVENT);
+        assert(record.timestamp_us == events[i].timestamp_us);
+        assert(record.event.type == events[i].type);
+        assert(record.event.timestamp_us == events[i].timestamp_us);
+    }
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.kind == INPUT_TRACE_ACK && record.frame_id == 42 && record.timestamp_us == 1006000);
+    assert(record.refresh_us == 0);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.kind == INPUT_TRACE_FRAME && record.timestamp_us == 1007000);
+    assert(record.refresh_us == 0);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.kind == INPUT_TRACE_FRAME && record.timestamp_us == 1008000);
+    assert(record.refresh_us == 16667 && record.frame_id == 0);
+    assert(input_trace_read(reader, &record) == 0);
+    input_trace_reader_close(reader);
+    
+    /* Field by field: the union is not compared byte-wise */
+    assert(input_trace_reader_open(path, &reader) == 0);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.pointer_motion.dx == 1.5 && record.event.pointer_motion.dy == -2.25);
+    assert(!record.event.pointer_motion.absolute);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.pointer_motion.absolute && record.event.pointer_motion.x == 640.5);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.pointer_button.button == 272 && record.event.pointer_button.pressed);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.scroll.discrete && record.event.scroll.dy == 15.0);
+    assert(record.event.scroll.discrete_dy == 1);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.key.key == 30 && !record.event.key.pressed);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.touch.touch_id == 3 && record.event.touch.y == 20.0 && record.event.touch.pressed);
+    input_trace_reader_close(reader);
+    
+    /* A truncated trailing record ends the trace */
+    FILE *fp = fopen(path, "ab");
+    assert(fp);
+    assert(fwrite("partial", 1, 7, fp) == 7);
+    fclose(fp);
+    assert(input_trace_reader_open(path, &reader) == 0);
+    size_t records = 0;
+    while (input_trace_read(reader, &record) == 1) {
+        records++;
+    }
+    assert(records == n + 3);
+    input_trace_reader_close(reader);
+    
+    /* Not a trace */
+    uint8_t header[INPUT_TRACE_HEADER_SIZE];
+    input_trace_header_encode(header);
+    assert(input_trace_header_decode(header, NULL) == 0);
+    header[0] = 'X';
+    assert(input_trace_header_decode(header, NULL) == -1);
+    fp = fopen(path, "wb");
+    assert(fp);
+    assert(fwrite(header, 1, sizeof(header), fp) == sizeof(header));
+    fclose(fp);
+    assert(input_trace_reader_open(path, &reader) == -1);
+    
+    /* Device fields round-trip, and read as unknown from traces that predate them */
+    struct input_trace_record tagged = {
+        .kind = INPUT_TRACE_EVENT, .timestamp_us = 2000000, .event = events[0],
+        .device = 7, .device_type = 3,
+    };
+    uint8_t bytes[INPUT_TRACE_RECORD_SIZE];
+    input_trace_record_encode(&tagged, bytes);
+    assert(input_trace_record_decode(bytes, &record) == 0);
+    assert(record.device == 7 && record.device_type == 3);
+    input_trace_header_encode(header);
+    header[10] = INPUT_TRACE_RECORD_MIN_SIZE;  /* record_size, little-endian */
+    fp = fopen(path, "wb");
+    assert(fp);
+    assert(fwrite(header, 1, sizeof(header), fp) == sizeof(header));
+    assert(fwrite(bytes, 1, INPUT_TRACE_RECORD_MIN_SIZE, fp) == INPUT_TRACE_RECORD_MIN_SIZE);
+    fclose(fp);
+    assert(input_trace_reader_open(path, &reader) == 0);
+    assert(input_trace_read(reader, &record) == 1);
+    assert(record.event.pointer_motion.dx == 1.5);
+    assert(record.device == 0 && record.device_type == 3);
+    assert(input_trace_read(reader, &record) == 0);
+    input_trace_reader_close(reader);
+    
+    /* Record a live session, replay it on a fresh proxy: identical output */
+    struct utils_clock live_clock, replay_clock;
+    struct input_proxy *live = NULL, *replay = NULL;
+    utils_clock_init(&live_clock, UTILS_CLOCK_VIRTUAL, 0);
+    utils_clock_init(&replay_clock, UTILS_CLOCK_VIRTUAL, 0);
+    assert(input_proxy_create(true, 16, true, &live) == 0);
+    assert(input_proxy_create(true, 16, true, &replay) == 0);
+    input_proxy_set_clock(live, &live_clock);
+    input_proxy_set_clock(replay, &replay_clock);
+    
+    double live_sum = 0.0;
+    assert(input_trace_writer_open(path, &writer) == 0);
+    for (int i = 0; i < 50; i++) {
+        struct input_event motion = {
+            .type = INPUT_EVENT_POINTER_MOTION,
+            .timestamp_us = 2000000 + (uint64_t)i * 4000,
+            .pointer_motion = {.dx = 3.0 + (i % 7), .dy = 1.0},
+        };
+        struct input_event out;
+        assert(input_trace_write_event(writer, &motion) == 0);
+        assert(input_proxy_process_into(live, &motion, &out) == 1);
+        live_sum += out.pointer_motion.dx;
+        if (i % 4 == 3) {
+            utils_clock_set(&live_clock, motion.timestamp_us + 2000);
+            assert(input_trace_write_ack(writer, (uint64_t)i, motion.timestamp_us + 2000) == 0);
+            assert(input_proxy_reconcile(live, (uint64_t)i, NULL) == 0);
+        }
+    }
+    assert(input_trace_writer_close(writer) == 0);
+    
+    double replay_sum = 0.0;
+    assert(input_trace_reader_open(path, &reader) == 0);
+    while (input_trace_read(reader, &record) == 1) {
+        utils_clock_set(&replay_clock, record.timestamp_us);
+        struct input_event out;
+        if (record.kind == INPUT_TRACE_EVENT) {
+            assert(input_proxy_process_into(replay, &record.event, &out) == 1);
+            replay_sum += out.pointer_motion.dx;
+        } else if (record.kind == INPUT_TRACE_ACK) {
+            assert(input_proxy_reconcile(replay, record.frame_id, NULL) == 0);
+        }
+    }
+    input_trace_reader_close(reader);
+    assert(replay_sum == live_sum);
+    
+    prediction_state_t a, b;
+    assert(input_proxy_get_prediction_state(live, &a) == 0);
+    assert(input_proxy_get_prediction_state(replay, &b) == 0);
+    assert(a.events_predicted == b.events_predicted && a.events_reconciled == b.events_reconciled);
+    assert(a.late_acks == 0 && b.late_acks == 0);
+    input_proxy_destroy(live);
+    input_proxy_destroy(replay);
+    unlink(path);
+    
+    printf("✓ test_input_trace passed\n");
+}
+
+/* Accelerating motion; returns the lead of the last prediction */
+static double display_timing_replay(struct input_proxy *proxy, uint64_t last_us,
+                                    struct input_event *out) {
+    double lead = 0.0;
+    for (uint64_t t = 1000000; t <= last_us; t += 1000) {
+        struct input_event e = {.type = INPUT_EVENT_POINTER_MOTION, .timestamp_us = t,
+                                .pointer_motion = {.dx = 1.0 + (double)(t - 1000000) / 2000.0,
+                                                   .dy = 1.0}};
+        assert(input_proxy_process_into(proxy, &e, out) == 1);
+        lead = out->pointer_motion.dx - e.pointer_motion.dx;
+    }
+    return lead;
+}
+
+/* Test predictions aimed at the display's vblanks */
+void test_display_timing(void) {
+    struct input_proxy *plain = NULL, *timed = NULL;
+    assert(input_proxy_create(true, 16, false, &plain) == 0);
+    assert(input_proxy_create(true, 16, false, &timed) == 0);
+    assert(input_proxy_set_predictor(plain, INPUT_PREDICTOR_ADAPTIVE) == 0);
+    assert(input_proxy_set_predictor(timed, INPUT_PREDICTOR_ADAPTIVE) == 0);
+    assert(input_proxy_set_display_timing(NULL, 1000000, 16667) == -1);
+    
+    /* 60 Hz, vblank at 1.0 s: at 1.004 s + 16 ms the next vblank is 1.033334 s */
+    assert(input_proxy_set_display_timing(timed, 1000000, 16667) == 0);
+    struct input_event out_plain, out_timed;
+    double lead_plain = display_timing_replay(plain, 1004000, &out_plain);
+    double lead_timed = display_timing_replay(timed, 1004000, &out_timed);
+    prediction_state_t state;
+    assert(input_proxy_get_prediction_state(timed, &state) == 0);
+    assert(state.horizon_us == 29334);
+    assert(out_timed.timestamp_us == 1004000 + 29334);
+    assert(out_plain.timestamp_us == 1004000 + 16000);
+    assert(lead_plain > 0.0);
+    assert(fabs(lead_timed - lead_plain * 29334.0 / 16000.0) < 1e-9);
+    
+    /* An older vblank does not move the phase back */
+    assert(input_proxy_set_display_timing(timed, 990000, 16667) == 0);
+    struct input_event e = {.type = INPUT_EVENT_POINTER_MOTION, .timestamp_us = 1017000,
+                            .pointer_motion = {.dx = 2.0, .dy = 1.0}};
+    assert(input_proxy_process_into(timed, &e, &out_timed) == 1);
+    assert(input_proxy_get_prediction_state(timed, &state) == 0);
+    assert(state.horizon_us == 1033334 - 1017000);
+    
+    /* Timing a second out of date, or forgotten, falls back to the window */
+    e.timestamp_us = 2500000;
+    assert(input_proxy_process_into(timed, &e, &out_timed) == 1);
+    assert(input_proxy_get_prediction_state(timed, &state) == 0);
+    assert(state.horizon_us == 16000);
+    assert(input_proxy_set_display_timing(timed, 2490000, 16667) == 0);
+    assert(input_proxy_set_display_timing(timed, 0, 0) == 0);
+    e.timestamp_us = 2501000;
+    assert(input_proxy_process_into(timed, &e, &out_timed) == 1);
+    assert(input_proxy_get_prediction_state(timed, &state) == 0);
+    assert(state.horizon_us == 16000);
+    
+    input_proxy_destroy(plain);
+    input_proxy_destroy(timed);
+    
+    printf("✓ test_display_timing passed\n");
+}
+
+/* Test batched prediction of motion bursts */
+void test_input_burst(void) {
+    struct input_event burst[5];
+    for (int i = 0; i < 5; i++) {
+        burst[i] = (struct input_event){
+            .type = INPUT_EVENT_POINTER_MOTION,
+            .timestamp_us = 1000000 + (uint64_t)i * 1000,
+            .pointer_motion = { .dx = 2.0 + i, .dy = -1.0, .absolute = false }
+        };
+    }
+    
+    /* Batch ABI matches per-sample calls */
+    uint64_t ts[5];
+    double dx[5], dy[5], bdx[5], bdy[5];
+    for (int i = 0; i < 5; i++) {
+        ts[i] = burst[i].timestamp_us;
+        dx[i] = burst[i].pointer_motion.dx;
+        dy[i] = burst[i].pointer_motion.dy;
+    }
+    rust_input_predictor_t *batch = velocity_predictor_create(16, 0.7, 0.9);
+    rust_input_predictor_t *single = velocity_predictor_create(16, 0.7, 0.9);
+    assert(velocity_predictor_predict_pointer_batch(batch, ts, dx, dy, 5, bdx, bdy) == 0);
+    for (int i = 0; i < 5; i++) {
+        double sdx, sdy;
+        assert(velocity_predictor_predict_pointer(single, (double)ts[i] / 1000000.0,
+                                                  dx[i], dy[i], &sdx, &sdy) == 0);
+        assert(sdx == bdx[i] && sdy == bdy[i]);
+    }
+    assert(velocity_predictor_predict_pointer_batch(batch, NULL, NULL, NULL, 0, NULL, NULL) == 0);
+    velocity_predictor_destroy(batch);
+    velocity_predictor_destroy(single);
+    
+    /* A burst yields one coalesced event carrying the last sample's lead */
+    struct input_proxy *bursty = NULL;
+    struct input_proxy *stepwise = NULL;
+    assert(input_proxy_create(true, 16, false, &bursty) == 0);
+    assert(input_proxy_create(true, 16, false, &stepwise) == 0);
+    assert(input_proxy_set_predictor(bursty, INPUT_PREDICTOR_VELOCITY) == 0);
+    assert(input_proxy_set_predictor(stepwise, INPUT_PREDICTOR_VELOCITY) == 0);
+    
+    struct input_event out_burst, out_step;
+    assert(input_proxy_process_burst(bursty, burst, 5, &out_burst) == 1);
+    double shown = 0.0;  /* Each step carries only the change in lead */
+    for (int i = 0; i < 5; i++) {
+        assert(input_proxy_process_into(stepwise, &burst[i], &out_step) == 1);
+        shown += out_step.pointer_motion.dx;
+    }
+    assert(fabs(out_burst.pointer_motion.dx - shown) < 1e-9);
+    
+    prediction_state_t state;
+    assert(input_proxy_get_prediction_state(bursty, &state) == 0);
+    assert(state.events_predicted == 1);
+    
+    /* Constant-rate bursts: the lead is shown once, then motion passes unchanged */
+    struct input_proxy *steady = NULL;
+    assert(input_proxy_create(true, 16, false, &steady) == 0);
+    assert(input_proxy_set_predictor(steady, INPUT_PREDICTOR_VELOCITY) == 0);
+    struct input_event chunk[4];
+    for (int b = 0; b < 12; b++) {
+        for (int i = 0; i < 4; i++) {
+            chunk[i] = (struct input_event){
+                .type = INPUT_EVENT_POINTER_MOTION,
+                .timestamp_us = 2000000 + (uint64_t)(b * 4 + i) * 1000,
+                .pointer_motion = { .dx = 5.0, .dy = 0.0, .absolute = false }
+            };
+        }
+        assert(input_proxy_process_burst(steady, chunk, 4, &out_burst) == 1);
+        double expected = b == 0 ? 20.0 + 5.0 * 16 : 20.0;  /* 5 units/ms over a 16 ms window */
+        assert(fabs(out_burst.pointer_motion.dx - expected) < 1e-6);
+    }
+    assert(input_proxy_get_prediction_state(steady, &state) == 0);
+    assert(state.corrections > 0 && state.mispredictions == 0);
+    input_proxy_destroy(steady);
+    
+    /* Bursts must be motion in a single mode */
+    struct input_event mixed[2] = { burst[0], burst[1] };
+    mixed[1].pointer_motion.absolute = true;
+    assert(input_proxy_process_burst(bursty, mixed, 2, &out_burst) == -1);
+    assert(input_proxy_process_burst(bursty, burst, 0, &out_burst) == -1);
+    
+    input_proxy_destroy(bursty);
+    input_proxy_destroy(stepwise);
+    
+    printf("✓ test_input_burst passed\n");
+}
+
+struct queue_sink_record {
+    int events;
+    int synthesized;
+    double motion_dx;
+};
+
+static void queue_sink(void *user_data, const struct input_event *event,
+                       const struct input_event *processed) {
+    struct queue_sink_record *rec = user_data;
+    rec->events++;
+    if (event == processed) {
+        rec->synthesized++;
+    }
+    if (event->type == INPUT_EVENT_POINTER_MOTION) {
+        rec->motion_dx += event->pointer_motion.dx;
+    }
+}
+
+static struct input_event queue_motion(uint64_t timestamp_us, double dx) {
+    struct input_event event = {
+        .type = INPUT_EVENT_POINTER_MOTION,
+        .timestamp_us = timestamp_us,
+        .pointer_motion = { .dx = dx, .dy = 0.0, .absolute = false }
+    };
+    return event;
+}
+
+/* Test SPSC input queue: coalescing, overflow carry, reconcile, thread */
+void test_input_queue(void) {
+    struct input_proxy *proxy = NULL;
+    assert(input_proxy_create(true, 16, true, &proxy) == 0);
+    /* Delta predictions: motion that stops leaves no lead rollback in the counts */
+    assert(input_proxy_set_predictor(proxy, INPUT_PREDICTOR_ADAPTIVE) == 0);
+
+    /* Consumer-side coalescing of a motion backlog */
+    struct queue_sink_record rec = {0};
+    struct input_queue *queue = NULL;
+    assert(input_queue_create(proxy, 64, queue_sink, &rec, &queue) == 0);
+
+    for (int i = 0; i < 10; i++) {
+        struct input_event ev = queue_motion(1000 + (uint64_t)i * 1000, 1.0);
+        assert(input_queue_push(queue, &ev) == 0);
+    }
+    struct input_event button = {
+        .type = INPUT_EVENT_POINTER_BUTTON,
+        .timestamp_us = 20000,
+        .pointer_button = { .button = 272, .pressed = true }
+    };
+    assert(input_queue_push(queue, &button) == 0);
+    assert(input_queue_push_reconcile(queue, 1) == 0);
+
+    /* 10 motions -> 1, then button, then reconcile */
+    assert(input_queue_drain(queue, 0) == 3);
+    assert(rec.events == 2);
+    assert(rec.motion_dx == 10.0);
+
+    struct input_queue_stats stats;
+    input_queue_get_stats(queue, &stats);
+    assert(stats.enqueued == 12);
+    assert(stats.coalesced == 9);
+    assert(stats.processed == 3);
+    assert(stats.depth == 0);
+    assert(stats.dropped == 0);
+    input_queue_destroy(queue);
+
+    /* Full ring: motion is carried, buttons are dropped, nothing is lost */
+    memset(&rec, 0, sizeof(rec));
+    assert(input_queue_create(proxy, 2, queue_sink, &rec, &queue) == 0);
+    assert(input_queue_push(queue, &button) == 0);
+    assert(input_queue_push(queue, &button) == 0);
+    for (int i = 0; i < 5; i++) {
+        struct input_event ev = queue_motion(30000 + (uint64_t)i, 2.0);
+        assert(input_queue_push(queue, &ev) == 0);
+    }
+    assert(input_queue_push(queue, &button) == -1);
+
+    input_queue_get_stats(queue, &stats);
+    assert(stats.dropped == 1);
+    assert(stats.carried == 5);
+    assert(stats.depth == 2);
+
+    /* Room again: the carry goes out ahead of the next event */
+    assert(input_queue_drain(queue, 0) == 2);
+    struct input_event ev = queue_motion(40000, 1.0);
+    assert(input_queue_push(queue, &ev) == 0);
+    assert(input_queue_drain(queue, 0) == 1);
+    assert(rec.motion_dx == 11.0);
+    input_queue_destroy(queue);
+
+    /* The end of a scroll gesture is never merged away; frame ticks drive the fling */
+    memset(&rec, 0, sizeof(rec));
+    struct scroll_kinetic_config kinetic;
+    scroll_smoother_kinetic_defaults(&kinetic);
+    assert(input_proxy_set_kinetic_scroll(proxy, &kinetic) == 0);
+    assert(input_queue_create(proxy, 64, queue_sink, &rec, &queue) == 0);
+    struct input_event scroll = {.type = INPUT_EVENT_SCROLL, .scroll = {.dy = 15.0}};
+    for (int i = 0; i < 4; i++) {
+        scroll.timestamp_us = 50000 + (uint64_t)i * 8000;
+        assert(input_queue_push(queue, &scroll) == 0);
+        assert(input_queue_drain(queue, 0) == 1);
+    }
+    assert(input_queue_push(queue, &scroll) == 0);
+    scroll.timestamp_us += 8000;
+    scroll.scroll.dy = 0.0;
+    assert(input_queue_push(queue, &scroll) == 0);
+    assert(input_queue_push_frame(queue, 90000) == 0);
+    assert(input_queue_push_frame(queue, 90000) == 0);  /* Repeat: nothing new */
+    assert(input_queue_drain(queue, 0) == 4);
+    assert(rec.events == 7);
+    assert(rec.synthesized == 1);
+    
+    /* A cancel entry (input on another device of the seat) stops the fling */
+    assert(input_queue_push_cancel(queue) == 0);
+    assert(input_queue_push_frame(queue, 106667) == 0);
+    assert(input_queue_drain(queue, 0) == 2);
+    assert(rec.events == 7);
+    input_queue_destroy(queue);
+    assert(input_proxy_set_kinetic_scroll(proxy, NULL) == 0);
+    
+    /* Resampled: one motion sample per frame, flushed ahead of a click */
+    memset(&rec, 0, sizeof(rec));
+    struct input_resampler *resampler = NULL;
+    assert(input_resampler_create(60, &resampler) == 0);
+    assert(input_queue_create(proxy, 64, queue_sink, &rec, &queue) == 0);
+    assert(input_queue_set_resampler(queue, resampler) == 0);
+    for (int i = 0; i < 40; i++) {
+        struct input_event ev = queue_motion(100000 + (uint64_t)i * 500, 0.5);
+        assert(input_queue_push(queue, &ev) == 0);
+    }
+    assert(input_queue_push_frame(queue, 116667) == 0);
+    assert(input_queue_drain(queue, 0) == 41);
+    assert(rec.events == 1);
+    button.timestamp_us = 121000;
+    assert(input_queue_push(queue, &button) == 0);
+    assert(input_queue_drain(queue, 0) == 1);
+    assert(rec.events == 3);
+    assert(rec.motion_dx == 20.0);
+    input_queue_destroy(queue);
+    input_resampler_destroy(resampler);
+    
+    /* Dedicated input thread */
+    memset(&rec, 0, sizeof(rec));
+    assert(input_queue_create(proxy, 0, queue_sink, &rec, &queue) == 0);
+    assert(input_queue_start(queue) == 0);
+    assert(input_queue_start(queue) == -1);
+
+    for (int i = 0; i < 100; i++) {
+        ev = queue_motion(50000 + (uint64_t)i * 100, 0.5);
+        assert(input_queue_push(queue, &ev) == 0);
+    }
+
+    struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+    for (int i = 0; i < 1000; i++) {
+        input_queue_get_stats(queue, &stats);
+        if (stats.processed + stats.coalesced == 100) {
+            break;
+        }
+        nanosleep(&pause, NULL);
+    }
+    assert(stats.processed + stats.coalesced == 100);
+
+    input_queue_destroy(queue);
+    assert(rec.motion_dx == 50.0);
+
+    input_proxy_destroy(proxy);
+
+    printf("✓ test_input_queue passed\n");
+}
+
 int main(void) {
     printf("Running input tests...\n\n");
     
     test_input_proxy_create();
     test_scroll_smoothing();
     test_input_event_processing();
+    test_input_process_into();
+    test_motion_predictor();
+    test_velocity_predictor();
+    test_prediction_scoring();
+    test_scroll_prediction();
+    test_kinetic_scroll();
+    test_input_resampler();
+    test_clock_provider();
+    test_input_trace();
+    test_display_timing();
+    test_input_burst();
+    test_input_queue();
     
     printf("\nAll input tests passed!\n");
     return 0;
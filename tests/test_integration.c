@@ -6,7 +6,10 @@
 #include <sys/wait.h>
 #include "../core/telescope.h"
 #include "../input/input.h"
+#include "../input/input_trace.h"
 #include "../compositor/compositor.h"
+#include "../core/metrics.h"
+#include "../core/utils.h"
 
 /**
  * Integration tests for Lunar Telescope
@@ -112,14 +115,295 @@ void test_compositor_hooks(void) {
     int ret = compositor_hooks_init();
     assert(ret == 0);
     
-    /* Test input interception (stub - would need actual device) */
-    /* For now, just verify hooks are initialized */
+    /* Each pipelined device gets its own proxy; addresses are only used as keys */
+    static char seat[8], mouse[8], touchpad[8], keyboard[8], unknown[8];
+    struct input_proxy *global = compositor_get_global_input_proxy();
+    assert(global != NULL);
+    assert(compositor_register_seat_input_device((struct wl_seat *)seat,
+               (struct wl_input_device *)mouse, COMPOSITOR_INPUT_POINTER) == 0);
+    assert(compositor_register_seat_input_device((struct wl_seat *)seat,
+               (struct wl_input_device *)touchpad, COMPOSITOR_INPUT_TOUCHPAD) == 0);
+    assert(compositor_register_input_device((struct wl_input_device *)keyboard,
+                                            COMPOSITOR_INPUT_KEYBOARD) == 0);
+    assert(compositor_register_input_device((struct wl_input_device *)mouse,
+                                            COMPOSITOR_INPUT_POINTER) == 0);
+    
+    struct input_proxy *mouse_proxy = compositor_get_input_proxy((struct wl_input_device *)mouse);
+    struct input_proxy *touchpad_proxy = compositor_get_input_proxy((struct wl_input_device *)touchpad);
+    assert(mouse_proxy != NULL && touchpad_proxy != NULL);
+    assert(mouse_proxy != global && touchpad_proxy != global && mouse_proxy != touchpad_proxy);
+    assert(compositor_get_input_proxy((struct wl_input_device *)keyboard) == global);
+    assert(compositor_get_input_proxy((struct wl_input_device *)unknown) == global);
+    
+    /* Mice and touchpads predict motion with the adaptive filter */
+    assert(input_proxy_get_predictor(mouse_proxy) == INPUT_PREDICTOR_ADAPTIVE);
+    assert(input_proxy_get_predictor(touchpad_proxy) == INPUT_PREDICTOR_ADAPTIVE);
+    
+    /* Keyboard and touch input is intercepted per device too */
+    assert(compositor_input_trace_start("test_hooks.trace") == 0);
+    assert(compositor_intercept_key((struct wl_input_device *)keyboard, 30, true, 0) == 0);
+    assert(compositor_intercept_key((struct wl_input_device *)keyboard, 30, false, 0) == 0);
+    assert(compositor_intercept_touch((struct wl_input_device *)unknown, 0, 0.25, 0.5, true, 0) == 0);
+    assert(compositor_intercept_touch((struct wl_input_device *)unknown, 0, 0.0, 0.0, false, 0) == 0);
+    assert(compositor_intercept_key(NULL, 30, true, 0) < 0);
+    
+    /* Device timestamps pass through; untimed events take the compositor clock */
+    uint64_t before_us = compositor_now_us();
+    assert(compositor_intercept_pointer_motion((struct wl_input_device *)mouse,
+                                               2.0, 1.0, false, 0.0, 0.0, 123456000) == 0);
+    assert(compositor_intercept_button((struct wl_input_device *)mouse, 272, true, 0) == 0);
+    assert(compositor_input_trace_stop() == 0);
+    
+    struct input_trace_reader *reader = NULL;
+    struct input_trace_record record;
+    assert(input_trace_reader_open("test_hooks.trace", &reader) == 0);
+    bool saw_motion = false, saw_button = false;
+    uint32_t mouse_id = 0;
+    while (input_trace_read(reader, &record) == 1) {
+        if (record.kind != INPUT_TRACE_EVENT) {
+            continue;
+        }
+        /* Events are tagged with their device type and pipeline (0 = default) */
+        if (record.event.type == INPUT_EVENT_KEY) {
+            assert(record.device == 0);
+            assert(record.device_type == COMPOSITOR_TRACE_DEVICE_TYPE(COMPOSITOR_INPUT_KEYBOARD));
+        } else if (record.event.type == INPUT_EVENT_TOUCH) {
+            assert(record.device == 0 && record.device_type == 0);
+        } else {
+            assert(record.device != 0);
+            assert(record.device_type == COMPOSITOR_TRACE_DEVICE_TYPE(COMPOSITOR_INPUT_POINTER));
+            assert(mouse_id == 0 || record.device == mouse_id);
+            mouse_id = record.device;
+        }
+        if (record.event.type == INPUT_EVENT_POINTER_MOTION) {
+            assert(record.timestamp_us == 123456000);
+            saw_motion = true;
+        } else if (record.event.type == INPUT_EVENT_POINTER_BUTTON) {
+            assert(record.timestamp_us >= before_us);
+            saw_button = true;
+        }
+    }
+    assert(saw_motion && saw_button);
+    input_trace_reader_close(reader);
+    unlink("test_hooks.trace");
+    
+        /* Ticks and acknowledgments reach every pipeline */
+    assert(compositor_input_frame(1000000) == 0);
+    assert(compositor_input_vblank(1016667, 16667) == 0);
+    
+    compositor_unregister_input_device((struct wl_input_device *)mouse);
+    assert(compositor_get_input_proxy((struct wl_input_device *)mouse) == global);
+    assert(compositor_get_input_proxy((struct wl_input_device *)touchpad) == touchpad_proxy);
+    
+    /* The device table grows and shrinks under many devices */
+    enum { DEVICES = 100 };
+    static char devices[DEVICES][8];
+    for (int i = 0; i < DEVICES; i++) {
+        assert(compositor_register_input_device((struct wl_input_device *)devices[i],
+                                                COMPOSITOR_INPUT_TABLET) == 0);
+    }
+    for (int i = 0; i < DEVICES; i += 2) {
+        compositor_unregister_input_device((struct wl_input_device *)devices[i]);
+    }
+    for (int i = 0; i < DEVICES; i++) {
+        struct input_proxy *proxy = compositor_get_input_proxy((struct wl_input_device *)devices[i]);
+        assert((proxy == global) == (i % 2 == 0));
+    }
+    assert(compositor_get_input_proxy((struct wl_input_device *)touchpad) == touchpad_proxy);
     
     compositor_hooks_cleanup();
+    assert(compositor_get_input_proxy((struct wl_input_device *)touchpad) == NULL);
+    assert(compositor_intercept_touch((struct wl_input_device *)touchpad, 0, 0.5, 0.5, true, 0) < 0);
     
     printf("  ✓ Compositor hooks test passed\n");
 }
 
+void test_surface_tracking(void) {
+    printf("Testing surface tracking...\n");
+    
+    telescope_observability_t obs_config = {
+        .enable_metrics = true,
+        .metrics_interval_ms = 1000,
+        .metrics_file = NULL,
+        .log_level = 2
+    };
+    assert(metrics_collector_init(&obs_config) == 0);
+    assert(compositor_hooks_init() == 0);
+    
+    /* Hundreds of subsurfaces and popups; addresses are only used as keys */
+    enum { SURFACES = 600 };
+    static char surfaces[SURFACES][64];
+    for (int i = 0; i < SURFACES; i++) {
+        assert(compositor_register_surface((struct wl_surface *)surfaces[i]) == 0);
+    }
+    assert(compositor_register_surface((struct wl_surface *)surfaces[7]) == 0);
+    
+    /* Unregister every third surface; the rest must still resolve */
+    for (int i = 0; i < SURFACES; i += 3) {
+        compositor_unregister_surface((struct wl_surface *)surfaces[i]);
+    }
+    for (int i = 0; i < SURFACES; i++) {
+        uint64_t frame_id = compositor_generate_frame_id((struct wl_surface *)surfaces[i]);
+        assert((frame_id == 0) == (i % 3 == 0));
+        if (frame_id && i != 1) {
+            assert(compositor_notify_frame_presented((struct wl_surface *)surfaces[i], frame_id,
+                                                     compositor_now_us()) == 0);
+        }
+    }
+    
+    /* A long session: frame IDs grow, tracking does not */
+    struct wl_surface *s = (struct wl_surface *)surfaces[1];
+    uint64_t frame_id = 0;
+    for (int i = 0; i < 100000; i++) {
+        frame_id = compositor_generate_frame_id(s);
+        assert(compositor_notify_frame_presented(s, frame_id, compositor_now_us()) == 0);
+    }
+    assert(frame_id == 100001);
+    
+    /* Every live surface has its own frame counters */
+    static struct metrics_surface_counters counters[METRICS_MAX_SURFACES];
+    assert(metrics_surface_counters(counters, METRICS_MAX_SURFACES) == SURFACES - SURFACES / 3);
+    assert(metrics_surface_frames_untracked() == 0);
+    
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_dropped == 0);
+    
+    /* Repeated feedback is not in flight any more */
+    assert(compositor_notify_frame_presented(s, frame_id, compositor_now_us()) == -1);
+    
+    /* Commits overtaken by a full queue of newer ones are dropped */
+    uint64_t old_id = compositor_generate_frame_id(s);
+    for (int i = 0; i < 65; i++) {
+        compositor_generate_frame_id(s);
+    }
+    assert(compositor_notify_frame_presented(s, old_id, compositor_now_us()) == -1);
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_dropped == 2);
+    
+    /* Presenting a later commit merges the older ones still in flight
+       (the count also holds the commit issued before the long session) */
+    struct compositor_surface_stats st;
+    assert(compositor_notify_frame_presented(s, old_id + 10, compositor_now_us()) == 0);
+    assert(compositor_get_surface_stats(s, &st) == 0);
+    assert(st.merged == 9 && st.in_flight == 55 && st.dropped == 2);
+    
+    /* Frame done presents the newest commit */
+    assert(compositor_notify_frame_done(s, compositor_now_us()) == 0);
+    assert(compositor_get_surface_stats(s, &st) == 0);
+    assert(st.merged == 63 && st.in_flight == 0);
+    assert(st.presented == 100002);
+    assert(compositor_notify_frame_done(s, compositor_now_us()) == 0);
+    
+    /* Discarded: merged while a newer commit is in flight, dropped otherwise */
+    uint64_t first = compositor_generate_frame_id(s);
+    uint64_t second = compositor_generate_frame_id(s);
+    assert(compositor_notify_frame_discarded(s, first) == 0);
+    assert(compositor_notify_frame_discarded(s, second) == 0);
+    assert(compositor_notify_frame_discarded(s, second) == -1);
+    assert(compositor_get_surface_stats(s, &st) == 0);
+    assert(st.merged == 64 && st.dropped == 3 && st.committed == 100069);
+    
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_dropped == 3);
+    assert(compositor_notify_frame_presented((struct wl_surface *)surfaces[0], 1, 0) == -1);
+    
+    for (int i = 1; i < SURFACES; i++) {
+        compositor_unregister_surface((struct wl_surface *)surfaces[i]);
+    }
+    assert(compositor_generate_frame_id(s) == 0);
+    
+    compositor_hooks_cleanup();
+    metrics_collector_cleanup();
+    
+    printf("  ✓ Surface tracking test passed\n");
+}
+
+void test_presentation_feedback(void) {
+    printf("Testing presentation feedback...\n");
+    
+    telescope_observability_t obs_config = {
+        .enable_metrics = true,
+        .metrics_interval_ms = 1000,
+        .metrics_file = NULL,
+        .log_level = 2
+    };
+    assert(metrics_collector_init(&obs_config) == 0);
+    
+    struct utils_clock clock;
+    utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 1000000);
+    assert(compositor_set_clock(&clock) == 0);
+    assert(compositor_hooks_init() == 0);
+    assert(compositor_set_clock(NULL) == -1);  /* Pipelines are running on it */
+    
+    static char surface_storage[64];
+    struct wl_surface *s = (struct wl_surface *)surface_storage;
+    assert(compositor_register_surface(s) == 0);
+    
+    /* 120 Hz, scanned out 20 ms after the commit (not at frame done) */
+    struct compositor_presentation_feedback feedback = {
+        .present_us = 1020000,
+        .refresh_ns = 8333333,
+        .msc = 100,
+        .flags = COMPOSITOR_PRESENTATION_VSYNC | COMPOSITOR_PRESENTATION_HW_CLOCK |
+                 COMPOSITOR_PRESENTATION_ZERO_COPY,
+    };
+    uint64_t frame_id = compositor_generate_frame_id(s);
+    utils_clock_set(&clock, 1010000);
+    assert(compositor_notify_frame_feedback(s, frame_id, &feedback) == 0);
+    assert(compositor_notify_frame_feedback(s, frame_id, NULL) == -1);
+    
+    struct compositor_surface_stats st;
+    assert(compositor_get_surface_stats(s, &st) == 0);
+    assert(st.presented == 1 && st.zero_copy == 1);
+    assert(st.last_latency_us == 20000);
+    assert(st.last_present_us == 1020000 && st.last_refresh_ns == 8333333);
+    assert(st.last_flags & COMPOSITOR_PRESENTATION_HW_CLOCK);
+    
+    /* Next frame three refreshes later: jank against the real 120 Hz */
+    frame_id = compositor_generate_frame_id(s);
+    feedback.present_us = 1045000;
+    feedback.msc = 103;
+    feedback.flags = COMPOSITOR_PRESENTATION_VSYNC;
+    assert(compositor_notify_frame_feedback(s, frame_id, &feedback) == 0);
+    assert(compositor_get_surface_stats(s, &st) == 0);
+    assert(st.last_latency_us == 35000 && st.zero_copy == 1);
+    
+    struct frame_timing_stats pacing;
+    assert(metrics_frame_pacing(&pacing) == 0);
+    assert(pacing.target_interval_us == 1000000 / 120);
+    assert(pacing.frames == 1 && pacing.jank_count == 1);
+    
+    /* Two surfaces in one output frame: one pacing interval, not two */
+    static char other_storage[64];
+    struct wl_surface *other = (struct wl_surface *)other_storage;
+    assert(compositor_register_surface(other) == 0);
+    frame_id = compositor_generate_frame_id(s);
+    uint64_t other_id = compositor_generate_frame_id(other);
+    feedback.present_us = 1053333;
+    feedback.msc = 104;
+    assert(compositor_notify_frame_feedback(s, frame_id, &feedback) == 0);
+    assert(compositor_notify_frame_feedback(other, other_id, &feedback) == 0);
+    assert(metrics_frame_pacing(&pacing) == 0);
+    assert(pacing.frames == 2 && pacing.jank_count == 1);
+    
+    /* Frame-done mode: each surface's callback reads the clock a little later */
+    frame_id = compositor_generate_frame_id(s);
+    other_id = compositor_generate_frame_id(other);
+    assert(compositor_notify_frame_done(s, 1061667) == 0);
+    assert(compositor_notify_frame_done(other, 1061700) == 0);
+    assert(metrics_frame_pacing(&pacing) == 0);
+    assert(pacing.frames == 3 && pacing.jank_count == 1);
+    
+    compositor_unregister_surface(other);
+    compositor_unregister_surface(s);
+    compositor_hooks_cleanup();
+    assert(compositor_set_clock(NULL) == 0);
+    metrics_collector_cleanup();
+    
+    printf("  ✓ Presentation feedback test passed\n");
+}
+
 void test_metrics_collection(void) {
     printf("Testing metrics collection...\n");
     
@@ -183,6 +467,8 @@ int main(void) {
     test_config_and_session();
     test_input_proxy_integration();
     test_compositor_hooks();
+    test_surface_tracking();
+    test_presentation_feedback();
     test_metrics_collection();
     test_profile_application();
     
@@ -0,0 +1,723 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
+#include "../core/metrics.h"
+#include "../core/histogram.h"
+#include "../core/frame_timing.h"
+#include "../core/metrics_writer.h"
+#include "../core/metrics_sampler.h"
+#include "../core/metrics_shm.h"
+#include "../core/spsc_ring.h"
+#include "../core/utils.h"
+
+#define RECORD_THREADS 4
+#define RECORDS_PER_THREAD 10000
+
+static const telescope_observability_t test_obs = {
+    .enable_metrics = true,
+    .metrics_interval_ms = 1000,
+    .metrics_file = NULL,
+    .log_level = 2
+};
+
+/* Test init/cleanup lifecycle */
+void test_metrics_lifecycle(void) {
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == -ENOENT);
+    assert(metrics_collector_get() == NULL);
+
+    assert(metrics_collector_init(&test_obs) == 0);
+    assert(metrics_collector_init(&test_obs) == -EBUSY);
+    assert(metrics_collector_snapshot(NULL) == -EINVAL);
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_total == 0);
+
+    metrics_collector_cleanup();
+    assert(metrics_collector_snapshot(&m) == -ENOENT);
+
+    printf("✓ test_metrics_lifecycle passed\n");
+}
+
+static void *record_thread(void *arg) {
+    (void)arg;
+    for (int i = 0; i < RECORDS_PER_THREAD; i++) {
+        metrics_record_frame(16, (i % 10) == 0);
+        metrics_record_input_event(true, (i % 2) == 0);
+    }
+    return NULL;
+}
+
+/* Test concurrent recording from several threads */
+void test_metrics_concurrent_recording(void) {
+    assert(metrics_collector_init(&test_obs) == 0);
+
+    pthread_t threads[RECORD_THREADS];
+    for (int i = 0; i < RECORD_THREADS; i++) {
+        assert(pthread_create(&threads[i], NULL, record_thread, NULL) == 0);
+    }
+
+    /* Snapshots taken mid-recording must never go backwards */
+    struct telescope_metrics prev = {0};
+    for (int i = 0; i < 1000; i++) {
+        struct telescope_metrics m;
+        assert(metrics_collector_snapshot(&m) == 0);
+        assert(m.frames_total >= prev.frames_total);
+        assert(m.input_events_total >= prev.input_events_total);
+        prev = m;
+    }
+
+    for (int i = 0; i < RECORD_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_total == RECORD_THREADS * RECORDS_PER_THREAD);
+    assert(m.frames_dropped == RECORD_THREADS * RECORDS_PER_THREAD / 10);
+    assert(m.input_events_total == RECORD_THREADS * RECORDS_PER_THREAD);
+    assert(m.input_events_predicted == RECORD_THREADS * RECORDS_PER_THREAD);
+    assert(m.input_events_reconciled == RECORD_THREADS * RECORDS_PER_THREAD / 2);
+    assert(m.frame_delay_ms == 16);
+
+    metrics_collector_cleanup();
+
+    printf("✓ test_metrics_concurrent_recording passed\n");
+}
+
+/* Test windowed bandwidth averaging */
+void test_metrics_bandwidth_window(void) {
+    assert(metrics_collector_init(&test_obs) == 0);
+
+    for (int i = 0; i < 1000; i++) {
+        metrics_record_bandwidth(100, 50);
+    }
+
+    /* 100000 rx / 50000 tx bytes inside a 1 second window */
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.bandwidth_rx_bps == 100000ULL * 8);
+    assert(m.bandwidth_tx_bps == 50000ULL * 8);
+
+    metrics_collector_cleanup();
+
+    printf("✓ test_metrics_bandwidth_window passed\n");
+}
+
+/* Test log-linear bucket mapping and percentile extraction */
+void test_histogram_percentiles(void) {
+    /* Exact region and bucket bounds */
+    assert(histogram_bucket_index(0) == 0);
+    assert(histogram_bucket_index(31) == 31);
+    assert(histogram_bucket_upper_us(histogram_bucket_index(31)) == 31);
+    assert(histogram_bucket_index(HISTOGRAM_MAX_US * 4) == HISTOGRAM_BUCKETS - 1);
+    for (uint64_t v = 1; v < HISTOGRAM_MAX_US; v = v * 3 + 1) {
+        uint64_t upper = histogram_bucket_upper_us(histogram_bucket_index(v));
+        assert(upper >= v);
+        assert(upper - v <= v / HISTOGRAM_SUB_BUCKETS);
+    }
+
+    struct histogram hist;
+    histogram_reset(&hist);
+    assert(histogram_percentile(&hist, 0.99) == 0);
+
+    /* 1..1000 us uniform: p50 ~500, p99 ~990 (within bucket error) */
+    for (uint64_t v = 1; v <= 1000; v++) {
+        histogram_record(&hist, v);
+    }
+    telescope_latency_percentiles_t pct;
+    histogram_percentiles(&hist, &pct);
+    assert(pct.p50_us >= 500 && pct.p50_us <= 500 + 500 / HISTOGRAM_SUB_BUCKETS);
+    assert(pct.p99_us >= 990 && pct.p99_us <= 990 + 990 / HISTOGRAM_SUB_BUCKETS);
+    assert(pct.p999_us >= 999);
+    assert(pct.p99_us == histogram_percentile(&hist, 0.99));
+
+    /* Merging a tail shifts the high percentiles only */
+    struct histogram tail;
+    histogram_reset(&tail);
+    for (int i = 0; i < 20; i++) {
+        histogram_record(&tail, 50000);
+    }
+    histogram_merge(&hist, &tail);
+    assert(hist.total_count == 1020);
+    histogram_percentiles(&hist, &pct);
+    assert(pct.p50_us < 1000);
+    assert(pct.p99_us >= 50000);
+
+    printf("✓ test_histogram_percentiles passed\n");
+}
+
+/* Test collector latency histograms and window take */
+void test_metrics_latency_histograms(void) {
+    assert(metrics_collector_init(&test_obs) == 0);
+
+    for (int i = 0; i < 99; i++) {
+        metrics_record_latency_us(10000, 2000);
+        metrics_record_frame_us(8000, false);
+    }
+    metrics_record_latency_us(80000, 2000);
+    metrics_record_frame_us(0, true);  /* Dropped frames carry no latency */
+
+    telescope_latency_percentiles_t pct;
+    assert(metrics_latency_percentiles(METRICS_LATENCY_END_TO_END, &pct) == 0);
+    assert(pct.p50_us >= 10000 && pct.p50_us < 10400);
+    assert(pct.p999_us >= 80000);
+
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.end_to_end_latency.p50_us == pct.p50_us);
+    assert(m.input_lag.p99_us >= 2000 && m.input_lag.p99_us < 2100);
+    assert(m.frame_delay.p50_us >= 8000 && m.frame_delay.p50_us < 8300);
+
+    struct histogram window;
+    assert(metrics_latency_take(METRICS_LATENCY_FRAME_DELAY, &window) == 0);
+    assert(window.total_count == 99);
+    assert(metrics_latency_percentiles(METRICS_LATENCY_FRAME_DELAY, &pct) == 0);
+    assert(pct.p50_us == 0);
+
+    metrics_collector_cleanup();
+
+    printf("✓ test_metrics_latency_histograms passed\n");
+}
+
+/* Test SPSC ring ordering, capacity and wraparound */
+void test_spsc_ring(void) {
+    struct spsc_ring ring;
+    assert(spsc_ring_init(&ring, 3, sizeof(uint64_t)) == 0);
+    assert(ring.capacity == 4);
+
+    uint64_t v;
+    assert(!spsc_ring_pop(&ring, &v));
+    assert(spsc_ring_peek(&ring) == NULL);
+
+    for (uint64_t round = 0; round < 10; round++) {
+        for (uint64_t i = 0; i < 4; i++) {
+            uint64_t in = round * 4 + i;
+            assert(spsc_ring_push(&ring, &in));
+        }
+        uint64_t extra = 99;
+        assert(!spsc_ring_push(&ring, &extra));
+        assert(spsc_ring_size(&ring) == 4);
+        assert(*(const uint64_t *)spsc_ring_peek(&ring) == round * 4);
+        for (uint64_t i = 0; i < 4; i++) {
+            assert(spsc_ring_pop(&ring, &v));
+            assert(v == round * 4 + i);
+        }
+    }
+    assert(spsc_ring_size(&ring) == 0);
+
+    spsc_ring_destroy(&ring);
+
+    printf("✓ test_spsc_ring passed\n");
+}
+
+/* Test binary record round trip through the async writer */
+void test_metrics_writer_binary(void) {
+    const char *path = "/tmp/lt_test_metrics.bin";
+    unlink(path);
+
+    struct metrics_writer *writer = NULL;
+    assert(metrics_writer_create(path, TELESCOPE_METRICS_FORMAT_BINARY, &writer) == 0);
+
+    struct telescope_metrics in[3];
+    memset(in, 0, sizeof(in));
+    for (int i = 0; i < 3; i++) {
+        in[i].timestamp_us = 1000000ULL * (i + 1);
+        in[i].frames_total = 60 * (i + 1);
+        in[i].bandwidth_rx_bps = 0x123456789ULL + i;
+        in[i].input_lag.p99_us = 4000 + i;
+        in[i].frame_delay.p999_us = 16000 + i;
+        assert(metrics_writer_submit(writer, &in[i]) == 0);
+    }
+    metrics_writer_destroy(writer);
+
+    FILE *fp = fopen(path, "rb");
+    assert(fp != NULL);
+    uint8_t header[METRICS_BINARY_HEADER_SIZE];
+    assert(fread(header, 1, sizeof(header), fp) == sizeof(header));
+    uint16_t record_size = 0;
+    assert(metrics_binary_header_decode(header, &record_size) == 0);
+    assert(record_size == METRICS_BINARY_RECORD_SIZE);
+
+    uint8_t record[METRICS_BINARY_RECORD_SIZE];
+    for (int i = 0; i < 3; i++) {
+        struct telescope_metrics out;
+        assert(fread(record, 1, sizeof(record), fp) == sizeof(record));
+        metrics_record_decode(record, &out);
+        assert(memcmp(&out, &in[i], sizeof(out)) == 0);
+    }
+    assert(fread(record, 1, sizeof(record), fp) == 0);
+    fclose(fp);
+    unlink(path);
+
+    printf("✓ test_metrics_writer_binary passed\n");
+}
+
+/* Test that collector flushes reach the JSON file via the writer thread */
+void test_metrics_flush_json(void) {
+    const char *path = "/tmp/lt_test_metrics.json";
+    unlink(path);
+
+    telescope_observability_t obs = test_obs;
+    obs.metrics_file = (char *)path;
+    assert(metrics_collector_init(&obs) == 0);
+
+    for (int i = 0; i < 5; i++) {
+        metrics_record_frame(16, false);
+        assert(metrics_collector_flush() == 0);
+    }
+    metrics_collector_cleanup();
+
+    FILE *fp = fopen(path, "r");
+    assert(fp != NULL);
+    char line[METRICS_JSON_LINE_MAX];
+    int lines = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lines++;
+        char expect[64];
+        snprintf(expect, sizeof(expect), "\"frames_total\":%d,", lines);
+        assert(strstr(line, expect) != NULL);
+    }
+    assert(lines == 5);
+    fclose(fp);
+    unlink(path);
+
+    printf("✓ test_metrics_flush_json passed\n");
+}
+
+/* Test interval deltas and timer-driven sampling */
+void test_metrics_sampler(void) {
+    struct metrics_counters prev = { .frames_total = 100, .frames_dropped = 2,
+                                     .input_events_total = 50, .input_events_predicted = 10,
+                                     .rx_bytes = 1000, .tx_bytes = 0,
+                                     .timestamp_us = 1000000 };
+    struct metrics_counters cur = { .frames_total = 160, .frames_dropped = 5,
+                                    .input_events_total = 150, .input_events_predicted = 60,
+                                    .rx_bytes = 501000, .tx_bytes = 250000,
+                                    .timestamp_us = 1500000 };
+    struct metrics_interval iv;
+
+    assert(metrics_interval_compute(&cur, &prev, &iv) == -EINVAL);
+    assert(metrics_interval_compute(&prev, &cur, &iv) == 0);
+    assert(iv.frames == 60);
+    assert(iv.frames_dropped == 3);
+    assert(iv.frames_per_second > 119.9 && iv.frames_per_second < 120.1);
+    assert(iv.drop_rate > 0.049 && iv.drop_rate < 0.051);
+    assert(iv.bandwidth_rx_bps == 8000000);
+    assert(iv.bandwidth_tx_bps == 4000000);
+    assert(iv.input_events == 100);
+    assert(iv.predictions_per_second > 99.9 && iv.predictions_per_second < 100.1);
+    assert(iv.prediction_rate > 0.49 && iv.prediction_rate < 0.51);
+
+    struct metrics_sampler *sampler = NULL;
+    assert(metrics_sampler_create(NULL, 0, &sampler) == -EINVAL);
+    assert(metrics_collector_init(&test_obs) == 0);
+    assert(metrics_sampler_create(NULL, 10, &sampler) == 0);
+    assert(metrics_sampler_last_interval(sampler, &iv) == -ENOENT);
+
+    /* Event-loop mode: wait on the exposed fd */
+    for (int i = 0; i < 30; i++) {
+        metrics_record_frame_us(1000, i == 0);
+    }
+    metrics_record_input_event(true, false);
+    metrics_record_input_event(false, false);
+
+    struct pollfd pfd = { .fd = metrics_sampler_get_fd(sampler), .events = POLLIN };
+    assert(poll(&pfd, 1, 1000) == 1);
+    assert(metrics_sampler_dispatch(sampler) == 1);
+    assert(metrics_sampler_dispatch(sampler) == 0);
+
+    assert(metrics_sampler_last_interval(sampler, &iv) == 0);
+    assert(iv.frames == 30);
+    assert(iv.frames_dropped == 1);
+    assert(iv.input_events == 2);
+    assert(iv.prediction_rate > 0.49 && iv.prediction_rate < 0.51);
+    assert(iv.frames_per_second > 0.0);
+
+    /* The snapshot now carries the interval rate */
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_per_second == (uint32_t)(iv.frames_per_second + 0.5));
+
+    /* Thread mode */
+    assert(metrics_sampler_start_thread(sampler) == 0);
+    assert(metrics_sampler_start_thread(sampler) == -EALREADY);
+    for (int i = 0; i < 10; i++) {
+        metrics_record_frame_us(1000, false);
+    }
+    struct timespec wait = { .tv_sec = 0, .tv_nsec = 50 * 1000000L };
+    nanosleep(&wait, NULL);
+    metrics_sampler_destroy(sampler);
+
+    metrics_collector_cleanup();
+
+    printf("✓ test_metrics_sampler passed\n");
+}
+
+/* Test windowed frame pacing statistics */
+void test_frame_timing(void) {
+    struct frame_timing ft;
+    struct frame_timing_stats st;
+
+    frame_timing_init(&ft, 60);
+    frame_timing_stats(&ft, &st);
+    assert(st.frames == 0 && st.mean_fps == 0.0);
+
+    /* Steady 60 Hz with one 50 ms stall */
+    uint64_t t = 1000000;
+    assert(frame_timing_record(&ft, t) == 0);
+    for (int i = 0; i < 9; i++) {
+        t += 16667;
+        assert(frame_timing_record(&ft, t) == 0);
+    }
+    t += 50000;
+    assert(frame_timing_record(&ft, t) == 0);
+    assert(frame_timing_record(&ft, t) == -EINVAL);
+
+    frame_timing_stats(&ft, &st);
+    assert(st.frames == 10);
+    assert(st.jank_count == 1);
+    assert(st.jank_total == 1);
+    assert(st.longest_stall_us == 50000);
+    assert(st.target_interval_us == 16666);
+    assert(st.mean_frame_time_us > 19999.0 && st.mean_frame_time_us < 20001.0);
+    assert(st.mean_fps > 49.9 && st.mean_fps < 50.1);
+    assert(st.frame_time_variance_us2 > 0.0);
+
+    /* Old intervals slide out of the window; the cumulative count stays */
+    for (int i = 0; i < FRAME_TIMING_WINDOW; i++) {
+        t += 16667;
+        assert(frame_timing_record(&ft, t) == 0);
+    }
+    frame_timing_stats(&ft, &st);
+    assert(st.frames == FRAME_TIMING_WINDOW);
+    assert(st.jank_count == 0);
+    assert(st.jank_total == 1);
+    assert(st.longest_stall_us == 16667);
+    assert(st.frame_time_variance_us2 < 1.0);
+    assert(st.mean_fps > 59.9 && st.mean_fps < 60.1);
+
+    /* Adaptive target follows the window mean */
+    frame_timing_init(&ft, 0);
+    t = 1000000;
+    for (int i = 0; i <= 20; i++) {
+        t += 8333;
+        assert(frame_timing_record(&ft, t) == 0);
+    }
+    t += 20000;
+    assert(frame_timing_record(&ft, t) == 0);
+    frame_timing_stats(&ft, &st);
+    assert(st.jank_total == 1);
+
+    /* Collector: snapshot fps comes from presentation timestamps */
+    assert(metrics_collector_init(&test_obs) == 0);
+    metrics_set_target_frame_rate(100);
+    t = 5000000;
+    for (int i = 0; i < 50; i++) {
+        t += 10000;
+        metrics_record_frame_presented(t, 2000, false);
+    }
+    metrics_record_frame_presented(t + 5000, 0, true);
+
+    struct telescope_metrics m;
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_total == 51);
+    assert(m.frames_dropped == 1);
+    assert(m.frames_per_second == 100);
+
+    assert(metrics_frame_pacing(NULL) == -EINVAL);
+    assert(metrics_frame_pacing(&st) == 0);
+    assert(st.frames == 49);
+    assert(st.jank_count == 0);
+
+    metrics_collector_cleanup();
+    assert(metrics_frame_pacing(&st) == -ENOENT);
+
+    printf("✓ test_frame_timing passed\n");
+}
+
+/* Test per-lens/per-surface counters and the shared-memory export */
+void test_metrics_shm_export(void) {
+    telescope_observability_t obs = test_obs;
+    obs.metrics_shm = true;
+    assert(metrics_collector_init(&obs) == 0);
+
+    /* Lens attribution follows switches */
+    metrics_set_active_lens(TELESCOPE_LENS_WAYPIPE);
+    for (int i = 0; i < 5; i++) {
+        metrics_record_frame_us(1000, false);
+    }
+    metrics_record_bandwidth(100, 10);
+    metrics_set_active_lens(TELESCOPE_LENS_SUNSHINE);
+    for (int i = 0; i < 3; i++) {
+        metrics_record_frame_us(1000, i == 0);
+    }
+
+    struct metrics_counters lc;
+    bool active = true;
+    assert(metrics_lens_counters(TELESCOPE_LENS_AUTO, &lc, NULL) == -EINVAL);
+    assert(metrics_lens_counters(TELESCOPE_LENS_WAYPIPE, &lc, &active) == 0);
+    assert(!active);
+    assert(lc.frames_total == 5 && lc.rx_bytes == 100 && lc.tx_bytes == 10);
+    assert(metrics_lens_counters(TELESCOPE_LENS_SUNSHINE, &lc, &active) == 0);
+    assert(active);
+    assert(lc.frames_total == 3 && lc.frames_dropped == 1);
+
+    /* Surfaces */
+    metrics_record_surface_frame(0xA0, 1500, false);
+    metrics_record_surface_frame(0xA0, 0, true);
+    metrics_record_surface_frame(0xB0, 2500, false);
+    struct metrics_surface_counters sc[METRICS_MAX_SURFACES];
+    assert(metrics_surface_counters(sc, METRICS_MAX_SURFACES) == 2);
+    metrics_surface_release(0xB0);
+    assert(metrics_surface_counters(sc, METRICS_MAX_SURFACES) == 1);
+    assert(sc[0].surface_id == 0xA0);
+    assert(sc[0].frames_total == 2 && sc[0].frames_dropped == 1);
+    assert(sc[0].last_latency_us == 1500);
+    
+    /* Past METRICS_MAX_SURFACES, frames are counted as untracked until a slot frees up */
+    assert(metrics_surface_frames_untracked() == 0);
+    for (uint64_t id = 1; id < METRICS_MAX_SURFACES; id++) {
+        metrics_record_surface_frame(0x1000 + id, 1000, false);
+    }
+    metrics_record_surface_frame(0xC0, 1000, false);
+    metrics_record_surface_frame(0xC0, 1000, false);
+    assert(metrics_surface_frames_untracked() == 2);
+    assert(metrics_surface_counters(sc, METRICS_MAX_SURFACES) == METRICS_MAX_SURFACES);
+    metrics_surface_release(0x1001);
+    metrics_record_surface_frame(0xC0, 1000, false);
+    assert(metrics_surface_frames_untracked() == 2);
+    assert(metrics_surface_counters(sc, METRICS_MAX_SURFACES) == METRICS_MAX_SURFACES);
+    for (uint64_t id = 2; id < METRICS_MAX_SURFACES; id++) {
+        metrics_surface_release(0x1000 + id);
+    }
+    metrics_surface_release(0xC0);
+    assert(metrics_surface_counters(sc, METRICS_MAX_SURFACES) == 1);
+    assert(sc[0].surface_id == 0xA0 && sc[0].frames_total == 2);
+
+    /* Readers see the flushed payload */
+    char name[METRICS_SHM_NAME_MAX];
+    assert(metrics_shm_default_name(getpid(), name, sizeof(name)) == 0);
+    struct metrics_shm_reader *reader = NULL;
+    assert(metrics_shm_attach(name, &reader) == 0);
+    assert(metrics_shm_reader_pid(reader) == getpid());
+
+    struct metrics_shm_payload payload;
+    uint64_t count = 1;
+    assert(metrics_shm_read(reader, &payload, &count) == 0);
+    assert(count == 0);
+
+    assert(metrics_collector_flush() == 0);
+    assert(metrics_shm_read(reader, &payload, &count) == 0);
+    assert(count == 1);
+    assert(payload.metrics.frames_total == 8);
+    assert(payload.lens_count == METRICS_SHM_LENS_SLOTS);
+    assert(payload.lenses[TELESCOPE_LENS_WAYPIPE].frames_total == 5);
+    assert(payload.lenses[TELESCOPE_LENS_SUNSHINE].active);
+    assert(payload.surface_count == 1);
+    assert(payload.surfaces[0].surface_id == 0xA0);
+    assert(payload.surfaces_tracked == 1 && payload.surface_frames_untracked == 2);
+
+    metrics_shm_detach(reader);
+    metrics_collector_cleanup();
+
+    /* The region is unlinked with the collector */
+    assert(metrics_shm_attach(name, &reader) == -ENOENT);
+
+    printf("✓ test_metrics_shm_export passed\n");
+}
+
+/* Test per-session collectors and the aggregate view */
+void test_metrics_registry(void) {
+    int session_a, session_b;
+    struct metrics_collector *a = NULL, *b = NULL, *dup = NULL;
+
+    assert(metrics_collector_create(NULL, &test_obs, &a) == -EINVAL);
+    assert(metrics_collector_create(&session_a, &test_obs, &a) == 0);
+    assert(metrics_collector_create(&session_b, &test_obs, &b) == 0);
+    assert(a && b && a != b);
+    assert(metrics_collector_create(&session_a, &test_obs, &dup) == -EEXIST);
+    assert(metrics_registry_count() == 2);
+    assert(metrics_registry_lookup(&session_a) == a);
+    assert(metrics_registry_lookup(&session_b) == b);
+
+    /* Default collector coexists with sessions */
+    assert(metrics_collector_init(&test_obs) == 0);
+
+    metrics_bind(a);
+    assert(metrics_bound() == a);
+    for (int i = 0; i < 10; i++) {
+        metrics_record_frame_us(1000, false);
+    }
+    metrics_record_latency_us(5000, 1000);
+
+    metrics_bind(b);
+    for (int i = 0; i < 4; i++) {
+        metrics_record_frame_us(1000, true);
+    }
+    metrics_record_latency_us(80000, 2000);
+
+    metrics_bind(NULL);
+    metrics_record_frame_us(1000, false);
+
+    struct telescope_metrics m;
+    assert(metrics_session_snapshot(NULL, &m) == -ENOENT);
+    assert(metrics_session_snapshot(a, &m) == 0);
+    assert(m.frames_total == 10 && m.frames_dropped == 0);
+    assert(metrics_session_snapshot(b, &m) == 0);
+    assert(m.frames_total == 4 && m.frames_dropped == 4);
+    assert(metrics_collector_snapshot(&m) == 0);
+    assert(m.frames_total == 1);
+
+    assert(metrics_registry_snapshot(&m) == 0);
+    assert(m.frames_total == 15);
+    assert(m.frames_dropped == 4);
+    assert(m.end_to_end_latency_ms == 80);
+    assert(m.end_to_end_latency.p50_us >= 5000 && m.end_to_end_latency.p50_us < 5200);
+    assert(m.end_to_end_latency.p99_us >= 80000);
+
+    /* Destroying the bound collector unbinds the thread */
+    metrics_bind(a);
+    metrics_collector_destroy(a);
+    assert(metrics_bound() == NULL);
+    assert(metrics_registry_lookup(&session_a) == NULL);
+    assert(metrics_registry_count() == 1);
+
+    metrics_collector_destroy(b);
+    metrics_collector_cleanup();
+    assert(metrics_registry_count() == 0);
+    assert(metrics_registry_snapshot(&m) == -ENOENT);
+
+    printf("✓ test_metrics_registry passed\n");
+}
+
+struct session_thread_ctx {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stage;  /* 1 = recorded, 2 = collector destroyed */
+    struct metrics_collector *collector;
+};
+
+static void *session_record_thread(void *arg) {
+    struct session_thread_ctx *ctx = arg;
+
+    /* Unbound: no default collector, so nothing is attributed to the session */
+    metrics_record_frame_us(1000, false);
+    assert(metrics_bound() == NULL);
+
+    metrics_bind(ctx->collector);
+    for (int i = 0; i < 5; i++) {
+        metrics_record_frame_us(1000, false);
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    ctx->stage = 1;
+    pthread_cond_signal(&ctx->cond);
+    while (ctx->stage < 2) {
+        pthread_cond_wait(&ctx->cond, &ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    /* Destroyed on another thread: this record lets go of it and is dropped */
+    metrics_record_frame_us(1000, false);
+    assert(metrics_bound() == NULL);
+    return NULL;
+}
+
+/* Test threads bound to a session recording while it is destroyed elsewhere */
+void test_metrics_session_threads(void) {
+    int session = 0;
+    struct metrics_collector *c = NULL;
+    struct session_thread_ctx ctx = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+    };
+
+    assert(metrics_collector_create(&session, &test_obs, &c) == 0);
+    assert(metrics_bound() == NULL);
+    ctx.collector = c;  /* Owner's reference held until the thread has bound */
+
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, session_record_thread, &ctx) == 0);
+    pthread_mutex_lock(&ctx.lock);
+    while (ctx.stage < 1) {
+        pthread_cond_wait(&ctx.cond, &ctx.lock);
+    }
+    pthread_mutex_unlock(&ctx.lock);
+
+    struct telescope_metrics m;
+    assert(metrics_session_snapshot(c, &m) == 0);
+    assert(m.frames_total == 5);
+
+    /* The recording thread still holds a reference */
+    metrics_collector_destroy(c);
+    assert(metrics_registry_count() == 0);
+
+    pthread_mutex_lock(&ctx.lock);
+    ctx.stage = 2;
+    pthread_cond_signal(&ctx.cond);
+    pthread_mutex_unlock(&ctx.lock);
+    pthread_join(thread, NULL);
+
+    printf("✓ test_metrics_session_threads passed\n");
+}
+
+/* Test collector timestamps and bandwidth expiry on a virtual clock */
+void test_metrics_virtual_clock(void) {
+    int session;
+    struct metrics_collector *c = NULL;
+    struct utils_clock clock;
+    utils_clock_init(&clock, UTILS_CLOCK_VIRTUAL, 50000000);
+
+    assert(metrics_collector_create(&session, &test_obs, &c) == 0);
+    metrics_collector_set_clock(c, &clock);
+    metrics_bind(c);
+
+    for (int i = 0; i < 100; i++) {
+        metrics_record_bandwidth(1000, 500);
+        utils_clock_advance(&clock, 1000);
+    }
+
+    struct telescope_metrics m;
+    assert(metrics_session_snapshot(c, &m) == 0);
+    assert(m.timestamp_us == 50100000);
+    assert(m.bandwidth_rx_bps == 100000ULL * 8);
+    assert(m.bandwidth_tx_bps == 50000ULL * 8);
+
+    /* Idle for longer than the window: the average decays without sleeping */
+    utils_clock_advance(&clock, 2000000);
+    assert(metrics_session_snapshot(c, &m) == 0);
+    assert(m.timestamp_us == 52100000);
+    assert(m.bandwidth_rx_bps == 0 && m.bandwidth_tx_bps == 0);
+
+    metrics_collector_destroy(c);
+
+    printf("✓ test_metrics_virtual_clock passed\n");
+}
+
+int main(void) {
+    printf("Running metrics tests...\n\n");
+
+    test_metrics_lifecycle();
+    test_metrics_concurrent_recording();
+    test_metrics_bandwidth_window();
+    test_histogram_percentiles();
+    test_metrics_latency_histograms();
+    test_frame_timing();
+    test_spsc_ring();
+    test_metrics_writer_binary();
+    test_metrics_flush_json();
+    test_metrics_sampler();
+    test_metrics_shm_export();
+    test_metrics_registry();
+    test_metrics_session_threads();
+    test_metrics_virtual_clock();
+
+    printf("\nAll metrics tests passed!\n");
+    return 0;
+}
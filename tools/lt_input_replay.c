@@ -0,0 +1,538 @@
+#include "../input/input.h"
+#include "../input/input_trace.h"
+#include "../compositor/compositor.h"
+#include "../core/histogram.h"
+#include "../core/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * lt-input-replay: replay an input trace through the predictors
+ *
+ * Usage: lt-input-replay [-p BACKEND] [-w MS] TRACE
+ *
+ * Traces are recorded with compositor_input_trace_start(). Each backend
+ * (profile, auto, rust, velocity, adaptive, or all) gets a fresh input
+ * proxy per traced device, driven by a virtual clock that follows the
+ * trace, so every run sees exactly the recorded session. A device's
+ * proxy is configured like the compositor pipeline of its type
+ * (compositor_input_proxy_create()), with the backend's predictor; the
+ * "profile" row keeps the predictor of each type. Acknowledgments and
+ * frame ticks go to every proxy. The pipelines' resampling is not
+ * replayed: events reach the proxies as recorded. Two passes are made
+ * per backend: an untimed one for throughput, and one that times every
+ * event and scores each relative motion prediction.
+ *
+ * A prediction is the motion expected one prediction window ahead (or
+ * at the targeted vblank, when the trace carries presentation timing),
+ * over an interval as long as the one the event covers; it is scored against
+ * the motion the trace really shows on that device over that interval (the same
+ * comparison input_proxy_reconcile() makes with an actual event).
+ * Overshoot is the part of the error that runs past the real motion
+ * along its direction. The "none" row scores forwarding each event
+ * unchanged, i.e. no prediction. MISPRED is the proxy's own count:
+ * acknowledgments are reconciled as in production, without an actual
+ * event, so each prediction is scored against the input that follows it
+ * in the trace.
+ */
+
+#define REPLAY_MIN_TRAVEL_PX 0.5   /* Direction of travel is undefined below this */
+
+struct replay_backend {
+    const char *name;
+    input_predictor_backend_t backend;
+    bool profile;               /* Keep each device type's own predictor */
+};
+
+static const struct replay_backend backends[] = {
+    {"profile", INPUT_PREDICTOR_AUTO, true},
+    {"auto", INPUT_PREDICTOR_AUTO, false},
+    {"rust", INPUT_PREDICTOR_RUST, false},
+    {"velocity", INPUT_PREDICTOR_VELOCITY, false},
+    {"adaptive", INPUT_PREDICTOR_ADAPTIVE, false},
+};
+
+/* Accumulated relative motion, for ground truth */
+struct motion_point {
+    uint64_t timestamp_us;
+    double x, y;
+};
+
+/* A traced device: one input pipeline in the recorded session */
+struct replay_device {
+    uint32_t id;                /* Trace device ID (0 = default pipeline) */
+    compositor_input_type_t type;
+    uint32_t window_ms;         /* Prediction window its proxy uses */
+    struct motion_point *track;
+    size_t track_count;
+};
+
+struct replay_trace {
+    struct input_trace_record *records;
+    size_t count;
+    size_t events;
+    struct replay_device *devices;
+    size_t device_count;
+    size_t *device_index; /* Per record: device of an event */
+    size_t *track_index;  /* Per record: point in its device's track of a relative motion event */
+};
+
+struct replay_score {
+    size_t predictions;
+    double sum_sq;
+    size_t overshoots;
+    double overshoot_sum;
+    double overshoot_max;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool is_relative_motion(const struct input_trace_record *r) {
+    return r->kind == INPUT_TRACE_EVENT && r->event.type == INPUT_EVENT_POINTER_MOTION &&
+           !r->event.pointer_motion.absolute && r->event.timestamp_us != 0;
+}
+
+/* Device slot of an event, added on first sight; device_count if out of memory */
+static size_t find_device(struct replay_trace *trace, const struct input_trace_record *r) {
+    for (size_t d = 0; d < trace->device_count; d++) {
+        if (trace->devices[d].id == r->device) {
+            return d;
+        }
+    }
+
+    struct replay_device *grown = realloc(trace->devices, (trace->device_count + 1) * sizeof(*grown));
+    if (!grown) {
+        return trace->device_count;
+    }
+    trace->devices = grown;
+
+    /* The default pipeline, and devices of types this build does not know, get the default configuration */
+    compositor_input_type_t type = COMPOSITOR_INPUT_KEYBOARD;
+    if (r->device != 0 && r->device_type >= COMPOSITOR_TRACE_DEVICE_TYPE(COMPOSITOR_INPUT_POINTER) &&
+        r->device_type <= COMPOSITOR_TRACE_DEVICE_TYPE(COMPOSITOR_INPUT_TABLET)) {
+        type = (compositor_input_type_t)(r->device_type - COMPOSITOR_TRACE_DEVICE_TYPE(0));
+    }
+    trace->devices[trace->device_count] = (struct replay_device){.id = r->device, .type = type};
+    return trace->device_count++;
+}
+
+static int load_trace(const char *path, struct replay_trace *trace) {
+    struct input_trace_reader *reader = NULL;
+    if (input_trace_reader_open(path, &reader) < 0) {
+        return -1;
+    }
+
+    size_t capacity = 0;
+    struct input_trace_record record;
+    int ret;
+    while ((ret = input_trace_read(reader, &record)) == 1) {
+        if (trace->count == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            struct input_trace_record *grown = realloc(trace->records, capacity * sizeof(*grown));
+            if (!grown) {
+                ret = -1;
+                break;
+            }
+            trace->records = grown;
+        }
+        trace->records[trace->count++] = record;
+        trace->events += record.kind == INPUT_TRACE_EVENT;
+    }
+    input_trace_reader_close(reader);
+    if (ret < 0) {
+        return -1;
+    }
+
+    trace->device_index = calloc(trace->count + 1, sizeof(*trace->device_index));
+    trace->track_index = calloc(trace->count + 1, sizeof(*trace->track_index));
+    if (!trace->device_index || !trace->track_index) {
+        return -1;
+    }
+    for (size_t i = 0; i < trace->count; i++) {
+        const struct input_trace_record *r = &trace->records[i];
+        if (r->kind != INPUT_TRACE_EVENT) {
+            continue;
+        }
+        size_t d = find_device(trace, r);
+        if (d == trace->device_count) {
+            return -1;
+        }
+        trace->device_index[i] = d;
+    }
+
+    /* Position after each relative motion event, per device */
+    for (size_t d = 0; d < trace->device_count; d++) {
+        struct replay_device *device = &trace->devices[d];
+        device->track = malloc((trace->count + 1) * sizeof(*device->track));
+        if (!device->track) {
+            return -1;
+        }
+        double x = 0.0, y = 0.0;
+        for (size_t i = 0; i < trace->count; i++) {
+            const struct input_trace_record *r = &trace->records[i];
+            if (!is_relative_motion(r) || trace->device_index[i] != d) {
+                continue;
+            }
+            x += r->event.pointer_motion.dx;
+            y += r->event.pointer_motion.dy;
+            uint64_t t = r->event.timestamp_us;
+            if (device->track_count > 0 && device->track[device->track_count - 1].timestamp_us >= t) {
+                /* Same or out-of-order timestamp: fold into the previous point */
+                device->track[device->track_count - 1].x = x;
+                device->track[device->track_count - 1].y = y;
+            } else {
+                device->track[device->track_count++] = (struct motion_point){t, x, y};
+            }
+            trace->track_index[i] = device->track_count - 1;
+        }
+    }
+    return 0;
+}
+
+static void free_trace(struct replay_trace *trace) {
+    for (size_t d = 0; d < trace->device_count; d++) {
+        free(trace->devices[d].track);
+    }
+    free(trace->devices);
+    free(trace->records);
+    free(trace->device_index);
+    free(trace->track_index);
+}
+
+/* Real position at time t (the pointer holds still between events); false past the end */
+static bool track_position(const struct replay_device *device, size_t from, uint64_t t,
+                           double *x, double *y) {
+    if (device->track_count == 0 || t > device->track[device->track_count - 1].timestamp_us) {
+        return false;
+    }
+
+    size_t lo = from, hi = device->track_count - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (device->track[mid].timestamp_us <= t) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    const struct motion_point *a = &device->track[lo];
+    if (lo + 1 < device->track_count && t > a->timestamp_us) {
+        /* Interpolate across the gap to the next event */
+        const struct motion_point *b = &device->track[lo + 1];
+        double alpha = (double)(t - a->timestamp_us) / (double)(b->timestamp_us - a->timestamp_us);
+        *x = a->x + (b->x - a->x) * alpha;
+        *y = a->y + (b->y - a->y) * alpha;
+    } else {
+        *x = a->x;
+        *y = a->y;
+    }
+    return true;
+}
+
+static void score_prediction(const struct replay_trace *trace, size_t record, uint64_t horizon_us,
+                             double predicted_x, double predicted_y, struct replay_score *score) {
+    const struct replay_device *device = &trace->devices[trace->device_index[record]];
+    size_t point = trace->track_index[record];
+    if (point == 0) {
+        return;  /* First event: no interval */
+    }
+    const struct motion_point *p = &device->track[point];
+    uint64_t interval_us = p->timestamp_us - device->track[point - 1].timestamp_us;
+    uint64_t end_us = p->timestamp_us + horizon_us;
+
+    double start_x, start_y, end_x, end_y;
+    if (!track_position(device, point - 1, end_us - interval_us, &start_x, &start_y) ||
+        !track_position(device, point - 1, end_us, &end_x, &end_y)) {
+        return;  /* No ground truth past the end of the trace */
+    }
+
+    double travel_x = end_x - start_x;
+    double travel_y = end_y - start_y;
+    double err_x = predicted_x - travel_x;
+    double err_y = predicted_y - travel_y;
+    score->predictions++;
+    score->sum_sq += err_x * err_x + err_y * err_y;
+
+    double travel = sqrt(travel_x * travel_x + travel_y * travel_y);
+    if (travel < REPLAY_MIN_TRAVEL_PX) {
+        return;
+    }
+    double past = (err_x * travel_x + err_y * travel_y) / travel;
+    if (past > 0.0) {
+        score->overshoots++;
+        score->overshoot_sum += past;
+        if (past > score->overshoot_max) {
+            score->overshoot_max = past;
+        }
+    }
+}
+
+static void destroy_proxies(struct input_proxy **proxies, size_t count) {
+    for (size_t d = 0; d < count; d++) {
+        input_proxy_destroy(proxies[d]);
+    }
+    free(proxies);
+}
+
+/* One proxy per traced device, configured like its pipeline */
+static struct input_proxy **create_proxies(const struct replay_trace *trace,
+                                           const struct replay_backend *b, uint32_t window_ms,
+                                           struct utils_clock *clock, uint64_t start_us) {
+    struct input_proxy **proxies = calloc(trace->device_count + 1, sizeof(*proxies));
+    if (!proxies) {
+        return NULL;
+    }
+
+    utils_clock_init(clock, UTILS_CLOCK_VIRTUAL, start_us);
+    for (size_t d = 0; d < trace->device_count; d++) {
+        if (compositor_input_proxy_create(trace->devices[d].type, window_ms, &proxies[d]) < 0 ||
+            (!b->profile && input_proxy_set_predictor(proxies[d], b->backend) < 0)) {
+            destroy_proxies(proxies, trace->device_count);
+            return NULL;
+        }
+        input_proxy_set_clock(proxies[d], clock);
+    }
+    return proxies;
+}
+
+/* Feed one record; returns what input_proxy_process_into() returned for events */
+static int replay_record(const struct replay_trace *trace, size_t i, struct input_proxy **proxies,
+                         struct utils_clock *clock, struct input_event *out) {
+    const struct input_trace_record *r = &trace->records[i];
+    if (r->timestamp_us != 0) {
+        utils_clock_set(clock, r->timestamp_us);
+    }
+
+    if (r->kind == INPUT_TRACE_EVENT) {
+        return input_proxy_process_into(proxies[trace->device_index[i]], &r->event, out);
+    }
+    for (size_t d = 0; d < trace->device_count; d++) {
+        switch (r->kind) {
+            case INPUT_TRACE_ACK:
+                /* As in production: scored against the input that follows */
+                input_proxy_reconcile(proxies[d], r->frame_id, NULL);
+                while (input_proxy_take_correction(proxies[d], out) > 0) {
+                    /* Rollbacks are forwarded, not scored */
+                }
+                break;
+            case INPUT_TRACE_FRAME:
+                if (r->refresh_us) {
+                    input_proxy_set_display_timing(proxies[d], r->timestamp_us, r->refresh_us);
+                }
+                input_proxy_frame(proxies[d], r->timestamp_us, out);
+                break;
+            case INPUT_TRACE_EVENT:
+                break;
+        }
+    }
+    return 0;
+}
+
+static void print_header(void) {
+    printf("%-9s %12s %8s %8s %9s %9s %8s %9s %9s %8s\n",
+           "BACKEND", "EVENTS/S", "P50_NS", "P99_NS", "MAX_NS",
+           "RMSE_PX", "OVER_%", "OVER_PX", "OVER_MAX", "MISPRED");
+}
+
+static void print_score(const struct replay_score *s) {
+    double rmse = s->predictions ? sqrt(s->sum_sq / (double)s->predictions) : 0.0;
+    double over_pct = s->predictions ? 100.0 * (double)s->overshoots / (double)s->predictions : 0.0;
+    double over_mean = s->overshoots ? s->overshoot_sum / (double)s->overshoots : 0.0;
+    printf("%9.3f %8.1f %9.3f %9.3f", rmse, over_pct, over_mean, s->overshoot_max);
+}
+
+static int replay_backend(const struct replay_trace *trace, const struct replay_backend *b,
+                          uint32_t window_ms) {
+    uint64_t start_us = trace->count ? trace->records[0].timestamp_us : 0;
+    struct utils_clock clock;
+    struct input_proxy **proxies = NULL;
+    struct input_event out;
+
+    /* Pass 1: throughput, nothing but the pipeline in the loop */
+    proxies = create_proxies(trace, b, window_ms, &clock, start_us);
+    if (!proxies) {
+        printf("%-9s unavailable in this build\n", b->name);
+        return -1;
+    }
+    uint64_t begin_ns = now_ns();
+    for (size_t i = 0; i < trace->count; i++) {
+        replay_record(trace, i, proxies, &clock, &out);
+    }
+    uint64_t elapsed_ns = now_ns() - begin_ns;
+    destroy_proxies(proxies, trace->device_count);
+
+    /* Pass 2: per-event latency and prediction error (histogram values are ns here) */
+    proxies = create_proxies(trace, b, window_ms, &clock, start_us);
+    if (!proxies) {
+        return -1;
+    }
+    struct histogram *latency = calloc(1, sizeof(*latency));
+    if (!latency) {
+        destroy_proxies(proxies, trace->device_count);
+        return -1;
+    }
+    struct replay_score score = {0};
+    uint64_t max_ns = 0;
+    for (size_t i = 0; i < trace->count; i++) {
+        const struct input_trace_record *r = &trace->records[i];
+        if (r->kind != INPUT_TRACE_EVENT) {
+            replay_record(trace, i, proxies, &clock, &out);
+            continue;
+        }
+
+        uint64_t t0 = now_ns();
+        int ret = replay_record(trace, i, proxies, &clock, &out);
+        uint64_t ns = now_ns() - t0;
+        histogram_record(latency, ns);
+        if (ns > max_ns) {
+            max_ns = ns;
+        }
+
+        if (ret == 1 && is_relative_motion(r)) {
+            /* Scored over the horizon actually predicted (window or next vblank) */
+            uint64_t horizon_us = out.timestamp_us > r->event.timestamp_us ?
+                                  out.timestamp_us - r->event.timestamp_us :
+                                  trace->devices[trace->device_index[i]].window_ms * 1000ULL;
+            score_prediction(trace, i, horizon_us,
+                             out.pointer_motion.dx, out.pointer_motion.dy, &score);
+        }
+    }
+
+    /* A frame well past the end scores the predictions still in flight */
+    uint32_t mispredictions = 0;
+    for (size_t d = 0; d < trace->device_count; d++) {
+        input_proxy_frame(proxies[d], trace->records[trace->count - 1].timestamp_us + 1000000, &out);
+        prediction_state_t state;
+        input_proxy_get_prediction_state(proxies[d], &state);
+        mispredictions += state.mispredictions;
+    }
+    destroy_proxies(proxies, trace->device_count);
+
+    double rate = elapsed_ns ? (double)trace->events * 1e9 / (double)elapsed_ns : 0.0;
+    printf("%-9s %12.0f %8lu %8lu %9lu ", b->name, rate,
+           (unsigned long)histogram_percentile(latency, 0.50),
+           (unsigned long)histogram_percentile(latency, 0.99),
+           (unsigned long)max_ns);
+    print_score(&score);
+    printf(" %8u\n", mispredictions);
+    free(latency);
+    return 0;
+}
+
+static void replay_baseline(const struct replay_trace *trace) {
+    struct replay_score score = {0};
+    for (size_t i = 0; i < trace->count; i++) {
+        const struct input_trace_record *r = &trace->records[i];
+        if (is_relative_motion(r)) {
+            score_prediction(trace, i, trace->devices[trace->device_index[i]].window_ms * 1000ULL,
+                             r->event.pointer_motion.dx, r->event.pointer_motion.dy, &score);
+        }
+    }
+    printf("%-9s %12s %8s %8s %9s ", "none", "-", "-", "-", "-");
+    print_score(&score);
+    printf(" %8s\n", "-");
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-p BACKEND] [-w MS] TRACE\n", argv0);
+    fprintf(stderr, "Replay an input trace through the predictors and report throughput,\n"
+                    "per-event latency and prediction error.\n\n"
+                    "  -p BACKEND  profile, auto, rust, velocity, adaptive or all (default: all)\n"
+                    "  -w MS       prediction window in milliseconds (default: each device type's)\n");
+}
+
+int main(int argc, char **argv) {
+    const char *backend = "all";
+    uint32_t window_ms = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:w:h")) != -1) {
+        switch (opt) {
+            case 'p':
+                backend = optarg;
+                break;
+            case 'w': {
+                char *end = NULL;
+                long ms = strtol(optarg, &end, 10);
+                if (!end || *end != '\0' || ms <= 0 || ms > 1000) {
+                    fprintf(stderr, "%s: invalid window: %s\n", argv[0], optarg);
+                    return 2;
+                }
+                window_ms = (uint32_t)ms;
+                break;
+            }
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const char *path = argv[optind];
+    struct replay_trace trace = {0};
+    if (load_trace(path, &trace) < 0) {
+        fprintf(stderr, "%s: cannot read input trace\n", path);
+        free_trace(&trace);
+        return 1;
+    }
+
+    /* The window each device's proxy predicts over, for the "none" row and unaimed predictions */
+    for (size_t d = 0; d < trace.device_count; d++) {
+        struct input_proxy *proxy = NULL;
+        prediction_state_t state;
+        if (compositor_input_proxy_create(trace.devices[d].type, window_ms, &proxy) < 0) {
+            fprintf(stderr, "%s: cannot create an input proxy\n", argv[0]);
+            free_trace(&trace);
+            return 1;
+        }
+        input_proxy_get_prediction_state(proxy, &state);
+        trace.devices[d].window_ms = state.window_ms;
+        input_proxy_destroy(proxy);
+    }
+
+    size_t acks = 0, frames = 0;
+    for (size_t i = 0; i < trace.count; i++) {
+        acks += trace.records[i].kind == INPUT_TRACE_ACK;
+        frames += trace.records[i].kind == INPUT_TRACE_FRAME;
+    }
+    double duration_s = trace.count > 1 ?
+        (double)(trace.records[trace.count - 1].timestamp_us - trace.records[0].timestamp_us) / 1e6 : 0.0;
+    printf("%s: %zu events from %zu devices, %zu acks, %zu frames over %.1f s",
+           path, trace.events, trace.device_count, acks, frames, duration_s);
+    if (window_ms) {
+        printf(", window %u ms", window_ms);
+    }
+    printf("\n\n");
+
+    print_header();
+    int matched = 0;
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcmp(backend, "all") == 0 || strcmp(backend, backends[i].name) == 0) {
+            replay_backend(&trace, &backends[i], window_ms);
+            matched++;
+        }
+    }
+    if (matched == 0) {
+        fprintf(stderr, "%s: unknown backend: %s\n", argv[0], backend);
+        free_trace(&trace);
+        return 2;
+    }
+    replay_baseline(&trace);
+
+    free_trace(&trace);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "../core/metrics_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/**
+ * lt-metrics-decode: convert binary metrics files to JSON lines
+ *
+ * Usage: lt-metrics-decode [FILE]   (reads stdin when FILE is omitted or "-")
+ *
+ * Output matches the JSON line format written with metrics_format "json",
+ * so existing tooling can consume either.
+ */
+
+static int decode_stream(FILE *in, const char *name) {
+    uint8_t header[METRICS_BINARY_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), in) != sizeof(header)) {
+        fprintf(stderr, "%s: truncated header\n", name);
+        return 1;
+    }
+
+    uint16_t record_size = 0;
+    int ret = metrics_binary_header_decode(header, &record_size);
+    if (ret == -EINVAL) {
+        fprintf(stderr, "%s: not a lunar-telescope binary metrics file\n", name);
+        return 1;
+    }
+    if (ret < 0 || record_size < METRICS_BINARY_RECORD_SIZE) {
+        fprintf(stderr, "%s: unsupported format version\n", name);
+        return 1;
+    }
+
+    /* Newer writers may append fields; skip what we do not understand */
+    uint8_t *record = malloc(record_size);
+    if (!record) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        return 1;
+    }
+
+    char line[METRICS_JSON_LINE_MAX];
+    size_t n;
+    while ((n = fread(record, 1, record_size, in)) == record_size) {
+        struct telescope_metrics m;
+        metrics_record_decode(record, &m);
+        if (metrics_format_json(&m, line, sizeof(line)) > 0) {
+            fputs(line, stdout);
+        }
+    }
+    free(record);
+
+    if (n != 0) {
+        fprintf(stderr, "%s: ignoring truncated trailing record (%zu bytes)\n", name, n);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 2 || (argc == 2 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))) {
+        fprintf(stderr, "Usage: %s [FILE]\n", argv[0]);
+        fprintf(stderr, "Decode a binary metrics file (metrics_format \"binary\") to JSON lines.\n");
+        return argc > 2 ? 2 : 0;
+    }
+
+    if (argc < 2 || strcmp(argv[1], "-") == 0) {
+        return decode_stream(stdin, "<stdin>");
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+        return 1;
+    }
+
+    int ret = decode_stream(in, argv[1]);
+    fclose(in);
+    return ret;
+}
@@ -0,0 +1,193 @@
+#include "../core/metrics_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+
+/**
+ * lt-top: live view of shared-memory metrics
+ *
+ * Usage: lt-top [-1] [-i MS] [PID | /NAME]
+ *
+ * Without a target, every lunar-telescope region under /dev/shm is
+ * listed one per line. With a PID, that process's regions (one per
+ * session) are shown with their lens and surface breakdown; /NAME shows
+ * a single region. Regions are published by collectors with
+ * observability.metrics_shm enabled.
+ */
+
+#define LT_TOP_SHM_DIR "/dev/shm"
+#define LT_TOP_SHM_PREFIX "lunar-telescope."
+#define LT_TOP_DEFAULT_INTERVAL_MS 1000
+
+static const char *lens_name(uint32_t lens) {
+    switch (lens) {
+        case TELESCOPE_LENS_WAYPIPE: return "waypipe";
+        case TELESCOPE_LENS_SUNSHINE: return "sunshine";
+        case TELESCOPE_LENS_MOONLIGHT: return "moonlight";
+        default: return "?";
+    }
+}
+
+static void print_summary_header(void) {
+    printf("%-12s %6s %10s %8s %9s %9s %9s %12s %12s\n",
+           "SESSION", "FPS", "FRAMES", "DROPPED", "E2E_P50", "E2E_P99", "LAG_P99",
+           "RX_BPS", "TX_BPS");
+}
+
+static void print_summary(const char *label, const struct telescope_metrics *m) {
+    printf("%-12s %6u %10u %8u %7.1fms %7.1fms %7.1fms %12lu %12lu\n",
+           label, m->frames_per_second, m->frames_total, m->frames_dropped,
+           m->end_to_end_latency.p50_us / 1000.0, m->end_to_end_latency.p99_us / 1000.0,
+           m->input_lag.p99_us / 1000.0,
+           (unsigned long)m->bandwidth_rx_bps, (unsigned long)m->bandwidth_tx_bps);
+}
+
+static void print_detail(const struct metrics_shm_payload *p) {
+    printf("\n%-10s %6s %10s %8s %12s %12s\n",
+           "LENS", "ACTIVE", "FRAMES", "DROPPED", "RX_BYTES", "TX_BYTES");
+    for (uint32_t i = 0; i < p->lens_count && i < METRICS_SHM_LENS_SLOTS; i++) {
+        const struct metrics_shm_lens *l = &p->lenses[i];
+        printf("%-10s %6s %10lu %8lu %12lu %12lu\n",
+               lens_name(l->lens), l->active ? "*" : "",
+               (unsigned long)l->frames_total, (unsigned long)l->frames_dropped,
+               (unsigned long)l->rx_bytes, (unsigned long)l->tx_bytes);
+    }
+
+    printf("\n%-18s %10s %8s %12s\n", "SURFACE", "FRAMES", "DROPPED", "LAST_LAT_US");
+    for (uint32_t i = 0; i < p->surface_count && i < METRICS_SHM_SURFACE_SLOTS; i++) {
+        const struct metrics_shm_surface *s = &p->surfaces[i];
+        printf("0x%016lx %10lu %8lu %12lu\n",
+               (unsigned long)s->surface_id, (unsigned long)s->frames_total,
+               (unsigned long)s->frames_dropped, (unsigned long)s->last_latency_us);
+    }
+    if (p->surfaces_tracked > p->surface_count) {
+        printf("(%u more surfaces not shown)\n", p->surfaces_tracked - p->surface_count);
+    }
+    if (p->surface_frames_untracked) {
+        printf("(%lu frames of untracked surfaces)\n", (unsigned long)p->surface_frames_untracked);
+    }
+}
+
+static int show_region(const char *name, bool detail) {
+    struct metrics_shm_reader *reader = NULL;
+    int ret = metrics_shm_attach(name, &reader);
+    if (ret < 0) {
+        return ret;
+    }
+
+    struct metrics_shm_payload payload;
+    ret = metrics_shm_read(reader, &payload, NULL);
+    if (ret == 0) {
+        /* "<pid>" or "<pid>.<session>" */
+        const char *label = name;
+        if (strncmp(name, "/" LT_TOP_SHM_PREFIX, strlen("/" LT_TOP_SHM_PREFIX)) == 0) {
+            label = name + strlen("/" LT_TOP_SHM_PREFIX);
+        }
+        print_summary(label, &payload.metrics);
+        if (detail) {
+            print_detail(&payload);
+        }
+    }
+
+    metrics_shm_detach(reader);
+    return ret;
+}
+
+/* Show regions whose object name starts with prefix */
+static int show_matching(const char *prefix, bool detail) {
+    DIR *dir = opendir(LT_TOP_SHM_DIR);
+    if (!dir) {
+        return -errno;
+    }
+
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (strncmp(de->d_name, prefix, strlen(prefix)) != 0) {
+            continue;
+        }
+        /* "<prefix>" itself or "<prefix>.<session>", not "<prefix>7" */
+        char next = de->d_name[strlen(prefix)];
+        if (detail && next != '\0' && next != '.') {
+            continue;
+        }
+        char name[METRICS_SHM_NAME_MAX];
+        if (snprintf(name, sizeof(name), "/%s", de->d_name) >= (int)sizeof(name)) {
+            continue;
+        }
+        (void)show_region(name, detail);  /* Skip stale or foreign regions */
+    }
+
+    closedir(dir);
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-1] [-i MS] [PID | /NAME]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    bool once = false;
+    unsigned interval_ms = LT_TOP_DEFAULT_INTERVAL_MS;
+    const char *target = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-1") == 0) {
+            once = true;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval_ms = (unsigned)strtoul(argv[++i], NULL, 10);
+            if (interval_ms == 0) {
+                interval_ms = LT_TOP_DEFAULT_INTERVAL_MS;
+            }
+        } else if (argv[i][0] != '-' && !target) {
+            target = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    /* A PID selects all of that process's regions */
+    char prefix[METRICS_SHM_NAME_MAX] = LT_TOP_SHM_PREFIX;
+    bool by_pid = false;
+    if (target && target[0] != '/') {
+        char *end = NULL;
+        long pid = strtol(target, &end, 10);
+        if (!end || *end != '\0' || pid <= 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        snprintf(prefix, sizeof(prefix), "%s%ld", LT_TOP_SHM_PREFIX, pid);
+        by_pid = true;
+        target = NULL;
+    }
+
+    bool tty = isatty(STDOUT_FILENO);
+    for (;;) {
+        if (tty && !once) {
+            printf("\033[H\033[J");
+        }
+        print_summary_header();
+
+        int ret = target ? show_region(target, true) : show_matching(prefix, by_pid);
+        if (ret < 0) {
+            fprintf(stderr, "%s: %s\n", target ? target : LT_TOP_SHM_DIR,
+                    ret == -EPROTO ? "incompatible metrics region" : strerror(-ret));
+            return 1;
+        }
+        fflush(stdout);
+
+        if (once) {
+            return 0;
+        }
+
+        struct timespec ts = {
+            .tv_sec = interval_ms / 1000,
+            .tv_nsec = (long)(interval_ms % 1000) * 1000000L,
+        };
+        nanosleep(&ts, NULL);
+    }
+}